@@ -0,0 +1,197 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* ApiBatch.c
+*-------------------------------------------------------------------------
+* Array versions of API2KGM3(), API2KGM3_15(), kgm3_to_API() and
+* API_to_kgm3(). See ApiBatch.h. Reentrant, no global state.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+#include "API.h"
+
+#define APIBATCH_H
+
+#include "ApiBatch.h"
+
+#define API_K0			613.9723			// crude oil K0, as API.c
+#define API_LN_E		0.9996019383350099	// ln(2.7172), the base API.c raises
+#define API_K_GRAVITY	(141.5*999.012)		// API gravity <-> kg/m3
+#define API_OPEN		1.0e30				// API_Batch_Rho_15(): not converged yet
+
+/***************************************************************************
+ * vcfOf() - pow(2.7172, -a*dt - 0.8*(a*dt)^2) with a = K0/rho15^2
+ * Inside the ApiBatch.h domain the exponent stays below 0.5 in magnitude,
+ * where the series to x^14 is good to 1e-16.
+ ***************************************************************************/
+static inline double vcfOf(double rho15, double dt)
+{
+	double a, x, s;
+
+	a = API_K0/(rho15*rho15);
+	x = (-a*dt - 0.8*(a*dt)*(a*dt)) * API_LN_E;
+
+	s = 1.1470745597729725e-11;
+	s = s*x + 1.6059043836821613e-10;
+	s = s*x + 2.08767569878681e-09;
+	s = s*x + 2.505210838544172e-08;
+	s = s*x + 2.755731922398589e-07;
+	s = s*x + 2.7557319223985893e-06;
+	s = s*x + 2.48015873015873e-05;
+	s = s*x + 0.0001984126984126984;
+	s = s*x + 0.001388888888888889;
+	s = s*x + 0.008333333333333333;
+	s = s*x + 0.041666666666666664;
+	s = s*x + 0.16666666666666666;
+	s = s*x + 0.5;
+	s = s*x + 1.0;
+	s = s*x + 1.0;
+
+	return s;
+}
+
+/// '&' rather than '&&' so the loops stay free of branches
+static inline BOOL inDomain(double rho, double tC)
+{
+	return (rho >= API_BATCH_RHO_MIN) & (rho <= API_BATCH_RHO_MAX)
+		 & (tC >= API_BATCH_T_MIN) & (tC <= API_BATCH_T_MAX);
+}
+
+/***************************************************************************
+ * API_Batch_Rho_T() - process density from 15C density, see API2KGM3()
+ * in:  n, rho15[], tC[]
+ * out: rho[], vcf[]
+ ***************************************************************************/
+void API_Batch_Rho_T(API_SOA* b)
+{
+	const double* restrict rho15 = b->rho15;
+	const double* restrict tC = b->tC;
+	double* restrict rho = b->rho;
+	double* restrict vcf = b->vcf;
+	double r, t, v;
+	int i, n;
+
+	n = b->n;
+	if (n < 1) return;
+
+	/// out-of-domain lanes run on safe inputs and are redone below
+	#pragma MUST_ITERATE(1)
+	for (i=0;i<n;i++)
+	{
+		BOOL in = inDomain(rho15[i], tC[i]);
+
+		r = in ? rho15[i] : API_BATCH_RHO_MIN;
+		t = in ? tC[i] : 15.0;
+		v = vcfOf(r, t - 15.0);
+		vcf[i] = v;
+		rho[i] = rho15[i]*v;
+	}
+
+	for (i=0;i<n;i++)
+	{
+		if (inDomain(rho15[i], tC[i])) continue;
+
+		rho[i] = API2KGM3(rho15[i], tC[i]);
+		vcf[i] = (rho15[i] != 0) ? rho[i]/rho15[i] : 0;
+	}
+}
+
+/***************************************************************************
+ * API_Batch_Rho_15() - 15C density from process density, see API2KGM3_15()
+ * in:  n, rho[], tC[]
+ * out: rho15[], vcf[] (vcf[] doubles as the per-sample step while
+ *      iterating). Samples outside the domain give 0 in both.
+ * The whole array is stepped until every sample has moved less than
+ * API_BATCH_TOL, but a sample stops taking steps once it has, so each one
+ * ends on the same iterate as API2KGM3_15().
+ ***************************************************************************/
+void API_Batch_Rho_15(API_SOA* b)
+{
+	const double* restrict rho = b->rho;
+	const double* restrict tC = b->tC;
+	double* restrict rho15 = b->rho15;
+	double* restrict vcf = b->vcf;
+	double r, dt, r2, d;
+	int i, n, pass, open;
+
+	n = b->n;
+	if (n < 1) return;
+
+	#pragma MUST_ITERATE(1)
+	for (i=0;i<n;i++)
+	{
+		BOOL in = inDomain(rho[i], tC[i]);
+
+		r = in ? rho[i] : API_BATCH_RHO_MIN;
+		dt = (in ? tC[i] : 15.0) - 15.0;
+		rho15[i] = r / vcfOf(r, dt);
+		vcf[i] = in ? API_OPEN : 0;
+	}
+
+	for (pass=0;pass<API_BATCH_MAX_PASS;pass++)
+	{
+		open = 0;
+
+		#pragma MUST_ITERATE(1)
+		for (i=0;i<n;i++)
+		{
+			BOOL isOpen = (vcf[i] > API_BATCH_TOL);
+
+			r = isOpen ? rho[i] : API_BATCH_RHO_MIN;
+			dt = (isOpen ? tC[i] : 15.0) - 15.0;
+			r2 = r / vcfOf(rho15[i], dt);
+			d = fabs(r2 - rho15[i]);
+			rho15[i] = isOpen ? r2 : rho15[i];
+			vcf[i] = isOpen ? d : vcf[i];
+			open += (vcf[i] > API_BATCH_TOL);
+		}
+
+		if (open == 0) break;
+	}
+
+	#pragma MUST_ITERATE(1)
+	for (i=0;i<n;i++)
+	{
+		BOOL in = inDomain(rho[i], tC[i]);
+
+		rho15[i] = in ? rho15[i] : 0;
+		vcf[i] = in ? rho[i]/rho15[i] : 0;
+	}
+}
+
+/// kgm3_to_API() over an array
+void API_Batch_To_API(const double* restrict rho, double* restrict api, int n)
+{
+	int i;
+
+	if (n < 1) return;
+
+	#pragma MUST_ITERATE(1)
+	for (i=0;i<n;i++)
+		api[i] = (rho[i] <= 0.0) ? API_error_num : API_K_GRAVITY/rho[i] - 131.5;
+}
+
+/// API_to_kgm3() over an array
+void API_Batch_To_Kgm3(const double* restrict api, double* restrict rho, int n)
+{
+	int i;
+
+	if (n < 1) return;
+
+	#pragma MUST_ITERATE(1)
+	for (i=0;i<n;i++)
+		rho[i] = (api[i] == API_error_num) ? 0.0 : API_K_GRAVITY/(api[i] + 131.5);
+}
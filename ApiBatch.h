@@ -0,0 +1,70 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* ApiBatch.h
+*-------------------------------------------------------------------------
+* Array versions of the oil density routines in API.c, for callers that
+* convert many samples at once (reprocessed logs, several streams). The
+* data is passed as a structure of arrays. Each loop body is free of calls
+* and branches, so the C674x compiler can software-pipeline it and a host
+* compiler can vectorize it. E^x is a Taylor series inline, not pow().
+*
+* Within the domain below the results match the scalar routines to about
+* 1e-15 relative:
+*
+*	density		API_BATCH_RHO_MIN..MAX kg/m3 (the API2KGM3_15() check)
+*	temperature	API_BATCH_T_MIN..MAX C
+*
+* API_Batch_Rho_T() hands samples outside the domain to API2KGM3().
+* API_Batch_Rho_15() returns 0 for them, as API2KGM3_15() does for a bad
+* density. Unlike API2KGM3_15() it never touches DIAGNOSTICS.
+*
+* The routines have no pressure term (API.c has no Cpl), so there is no
+* pressure array either.
+*------------------------------------------------------------------------*/
+#ifndef _APIBATCH
+#define _APIBATCH
+
+#ifdef APIBATCH_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define API_BATCH_RHO_MIN		500.0
+#define API_BATCH_RHO_MAX		1100.0
+#define API_BATCH_T_MIN			-50.0
+#define API_BATCH_T_MAX			150.0
+#define API_BATCH_MAX_PASS		25		// API_Batch_Rho_15() iterations
+#define API_BATCH_TOL			0.01	// kg/m3, as API2KGM3_15()
+
+typedef struct
+{
+	int		n;			// samples
+	double*	rho;		// kg/m3 at process temperature
+	double*	rho15;		// kg/m3 at 15C
+	double*	tC;			// process temperature, C
+	double*	vcf;		// rho / rho15
+} API_SOA;
+
+_EXTERN void API_Batch_Rho_T(API_SOA* b);
+_EXTERN void API_Batch_Rho_15(API_SOA* b);
+_EXTERN void API_Batch_To_API(const double* restrict rho, double* restrict api, int n);
+_EXTERN void API_Batch_To_Kgm3(const double* restrict api, double* restrict rho, int n);
+
+#undef _EXTERN
+#undef APIBATCH_H
+#endif // _APIBATCH
@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* BootProfile.c
+*-------------------------------------------------------------------------
+* Start-up profiler. See BootProfile.h. Everything except
+* Boot_Prof_Publish() runs before BIOS_start(), single threaded.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+
+#define BOOTPROFILE_H
+
+#include "BootProfile.h"
+
+typedef struct
+{
+	Uint32	magic;
+	Uint32	warmBoots;					// resets since the last power-up
+	Uint32	us[BOOT_NUM_PHASES];		// this start-up, us since main()
+	Uint32	prevUs[BOOT_NUM_PHASES];	// the start-up before - shows where a hung start-up stopped
+} BOOT_RECORD;
+
+/// not initialized by the C runtime - survives a warm reset
+#pragma DATA_SECTION(BOOT_REC,"BOOTPROF")
+static far BOOT_RECORD BOOT_REC;
+
+static Types_Timestamp64 bootStart;
+static Uint32 tsFreq = 0;
+static BOOL isWarm = FALSE;
+
+void Boot_Prof_Start(void)
+{
+	Types_FreqHz freq;
+
+	Timestamp_get64(&bootStart);
+	Timestamp_getFreq(&freq);
+	tsFreq = freq.lo;
+
+	isWarm = (BOOT_REC.magic == BOOT_PROF_MAGIC);
+
+	if (isWarm)
+	{
+		memcpy(BOOT_REC.prevUs, BOOT_REC.us, sizeof(BOOT_REC.us));
+		BOOT_REC.warmBoots++;
+	}
+	else
+	{
+		memset(&BOOT_REC, 0, sizeof(BOOT_REC));
+		BOOT_REC.magic = BOOT_PROF_MAGIC;
+	}
+
+	memset(BOOT_REC.us, 0, sizeof(BOOT_REC.us));
+}
+
+void Boot_Prof_Mark(Uint8 phase)
+{
+	Types_Timestamp64 now;
+	unsigned long long t0, t1;
+
+	if ((phase >= BOOT_NUM_PHASES) || (tsFreq == 0)) return;
+
+	Timestamp_get64(&now);
+	t0 = ((unsigned long long)bootStart.hi << 32) | bootStart.lo;
+	t1 = ((unsigned long long)now.hi << 32) | now.lo;
+
+	BOOT_REC.us[phase] = (Uint32)(((t1 - t0) * 1000000ULL) / tsFreq);
+}
+
+/// TRUE if RAM was retained across the last reset (watchdog, not power)
+BOOL Boot_Prof_IsWarm(void)
+{
+	return isWarm;
+}
+
+/// copy the record to the Modbus registers
+void Boot_Prof_Publish(void)
+{
+	int i;
+
+	for (i=0;i<BOOT_NUM_PHASES;i++)
+	{
+		REG_BOOT_MS[i] = BOOT_REC.us[i] / 1000.0;
+		REG_BOOT_PREV_MS[i] = BOOT_REC.prevUs[i] / 1000.0;
+	}
+	REG_BOOT_COUNT = BOOT_REC.warmBoots;
+}
@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* BootProfile.h
+*-------------------------------------------------------------------------
+* Start-up profiler. main() and Init_All() mark the end of every init
+* phase with a CPU timestamp. The marks are kept in a retained (NOINIT)
+* RAM record, so the record survives a watchdog reset. Once the kernel is
+* running, they are published in REG_BOOT_MS[] as milliseconds since
+* reset. The same record tells a warm reset (the record survived) from a
+* power-up, which lets the power-up settle delay be skipped after a
+* watchdog reset.
+*------------------------------------------------------------------------*/
+#ifndef _BOOTPROFILE
+#define _BOOTPROFILE
+
+#ifdef BOOTPROFILE_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define BOOT_PROF_MAGIC			0xB0075EC5
+
+/// phases, in the order a legacy start-up completes them
+#define BOOT_PH_MAIN			0	// entered main()
+#define BOOT_PH_CLOCKS			1	// Init_BoardClocks (incl. settle delay)
+#define BOOT_PH_PSC				2	// Init_PSC
+#define BOOT_PH_PINMUX			3	// Init_PinMux
+#define BOOT_PH_FW_RESUME		4	// Resume_Firmware_Upgrade
+#define BOOT_PH_NAND_RESTORE	5	// Restore_Vars_From_NAND + factory reset
+#define BOOT_PH_I2C				6	// I2C, LCD and buttons
+#define BOOT_PH_MODBUS			7	// UART and Modbus slave
+#define BOOT_PH_SOFTWARE		8	// timer 3, Config_Uart, software objects, clocks
+#define BOOT_PH_BIOS			9	// first SWI after BIOS_start
+#define BOOT_PH_DONE			10	// deferred init finished
+#define BOOT_NUM_PHASES			11
+
+void Boot_Prof_Start(void);
+void Boot_Prof_Mark(Uint8 phase);
+BOOL Boot_Prof_IsWarm(void);
+void Boot_Prof_Publish(void);
+
+#undef _EXTERN
+#undef BOOTPROFILE_H
+#endif // _BOOTPROFILE
@@ -18,14 +18,15 @@
 * Most of the Razor's measurements are interpreted and calculated in this
 * code. Readings are updated in Capture_Sample() once a second, and runs
 * in the context of a priority 15 SWI. However the pulse count corresponding
-* to oscillator frequency is measured by Count_Freq_Pulses().
-* Count_Freq_Pulses() is called twice per second by the Timer module,
-* so the code is run in the context of a HWI (a real-time constraint in
-* measuring high frequencies). We read in the number of pulses counted by
-* the counter of hardware timer 1 and divide by the sample period of 500ms
-* (and multiply back the 80x frequency divider) to arrive at our oscillator
-* frequency. This frequency, along with many other values and measurements,
-* is used to calculate the watercut.
+* to oscillator frequency is captured by Count_Freq_Pulses().
+* Count_Freq_Pulses() is called every 50ms by the Timer module, so the
+* code is run in the context of a HWI (a real-time constraint in
+* measuring high frequencies). It timestamps an edge of the free-running
+* counter of hardware timer 3 (FreqCapture.c); the pulses between the
+* first and last edge of the REG_FREQ_GATE window, divided by the time
+* between them (and multiplied back by the 80x frequency divider), give
+* our oscillator frequency. This frequency, along with many other values
+* and measurements, is used to calculate the watercut.
 *------------------------------------------------------------------------*/
 
 #include <limits.h>
@@ -34,39 +35,29 @@
 
 #include "Globals.h"
 #include "Utils.h"
+#include "Watchdog.h"
+#include "Relay.h"
+#include "EventLog.h"
+#include "StreamProfile.h"
+#include "Totalizer.h"
+#include "FreqCapture.h"
+#include "SchedStats.h"
+#include "Twin.h"
+#include "CurveTable.h"
+#include "History.h"
 
 #define CALCULATE_H
 
 #include "Calculate.h"
 
-static double WC_RAW_AVG = 0;
-
-//// This is a __HWI__ called by Count_Freq_Pulses_Clock.
-//// Currently, it's called once every 0.5 seconds.
+//// This is a __HWI__ called by counterTimerHandle.
+//// Currently, it's called once every 50 ms (FREQ_TICK_US).
 void Count_Freq_Pulses(Uint32 u_sec_elapsed)
 {
-    /// disable counter
-    CSL_FINST(tmr3Regs->TCR,TMR_TCR_ENAMODE_LO,DISABLE); 
-
-    /// stop counter timer
-    Timer_stop(counterTimerHandle); 
-
-    /// update global variables
-    FREQ_PULSE_COUNT_LO = tmr3Regs->CNTLO; //store counter value to global var (lower)
-    FREQ_PULSE_COUNT_HI = tmr3Regs->CNTHI; //store counter value to global var (upper)
-    FREQ_U_SEC_ELAPSED = u_sec_elapsed;
-
-    /// reset counter value to zero (upper & lower)
-    tmr3Regs->CNTLO = 0;
-    tmr3Regs->CNTHI = 0;
+    /// timestamp an edge of the free-running counter
+    if (!Freq_Capture_Tick()) return;
 
-    /// re-enable counter
-    CSL_FINST(tmr3Regs->TCR,TMR_TCR_ENAMODE_LO,ENABLE); 
-
-    /// start counter timer
-    Timer_start(counterTimerHandle);
-
-    /// followed by Swi_Poll below
+    /// followed by Swi_Poll below, every 0.5 seconds
     Swi_post(Swi_Poll);
 }
 
@@ -78,6 +69,11 @@ void Poll(void)
 	Uint8 err_w = FALSE;	// watercut calculation error
 	Uint8 err_d = FALSE;	// density correction error
 
+	WD_Checkin(WD_CTX_POLL);
+
+	/// rebuild the oil curve table if the curves changed
+	Curve_Table_Check();
+
 	/// read frequency
 	err_f = Read_Freq();	
 
@@ -113,6 +109,7 @@ void Poll(void)
 	
 	if ((err_f | err_w | err_d) == FALSE)
 	{
+		if (COIL_AO_ALARM.val) Event_Alarm(EVENT_ALARM_AO, FALSE, WC);
 		COIL_AO_ALARM.val = FALSE;
 
 		/// update REG_WATERCUT here
@@ -126,12 +123,28 @@ void Poll(void)
 	} 
 	else
 	{
+		if (!COIL_AO_ALARM.val) Event_Alarm(EVENT_ALARM_AO, TRUE, DIAGNOSTICS);
 		COIL_AO_ALARM.val = TRUE;
 		if ((!COIL_AO_MANUAL.val) && (REG_AO_ALARM_MODE != 0))
 			(REG_AO_ALARM_MODE == 1) ? (REG_AO_MANUAL_VAL = 20.5) : (REG_AO_MANUAL_VAL = 3.6);
 
 		VAR_NaN(&REG_WATERCUT);
 	}
+
+	/// watercut, phase and errors are fresh - let the relay react now
+	Relay_Notify();
+
+	/// integrate flow over this poll
+	Totalizer_Update();
+
+	/// minute/hour/day trends
+	Hist_Update();
+
+	/// close the SWI/TASK statistics window
+	Sched_Stats_Publish();
+
+	/// process model steps and response times
+	Twin_Update();
 }
 
 
@@ -140,31 +153,20 @@ Uint8 Read_Freq(void)
 	int key;
 	double freq;
 
+	/// #pulses divided by #microseconds between the first and last edge of the gate
+	if (Twin_Is_Active()) freq = Twin_Freq_Get(&FREQ_PULSE_COUNT_LO, &FREQ_PULSE_COUNT_HI, &FREQ_U_SEC_ELAPSED);
+	else freq = Freq_Capture_Get(&FREQ_PULSE_COUNT_LO, &FREQ_PULSE_COUNT_HI, &FREQ_U_SEC_ELAPSED);
+
 	/// check errors
 	if ((FREQ_PULSE_COUNT_HI != 0) || (FREQ_U_SEC_ELAPSED == 0)) // this probably shouldn't happen
 	{
-		if (FREQ_PULSE_COUNT_HI != 0) 
-		{
-			if (DIAGNOSTICS & ERR_FRQ_LO) DIAGNOSTICS &= ~ERR_FRQ_LO;
-			if ((DIAGNOSTICS & ERR_FRQ_HI) == 0) DIAGNOSTICS |= ERR_FRQ_HI;
-		}
-		else if (FREQ_U_SEC_ELAPSED == 0) 
-		{
-			if (DIAGNOSTICS & ERR_FRQ_HI) DIAGNOSTICS &= ~ERR_FRQ_HI;
-			if ((DIAGNOSTICS & ERR_FRQ_LO) == 0) DIAGNOSTICS |= ERR_FRQ_LO;
-		}
-	}
-	else 
-	{
-		if (DIAGNOSTICS & ERR_FRQ_HI) DIAGNOSTICS &= ~ERR_FRQ_HI;
-		if (DIAGNOSTICS & ERR_FRQ_LO) DIAGNOSTICS &= ~ERR_FRQ_LO;
+		if (FREQ_PULSE_COUNT_HI != 0) Event_Diag(ERR_FRQ_HI, ERR_FRQ_LO, FREQ_PULSE_COUNT_HI);
+		else if (FREQ_U_SEC_ELAPSED == 0) Event_Diag(ERR_FRQ_LO, ERR_FRQ_HI, FREQ_U_SEC_ELAPSED);
 	}
+	else Event_Diag(0, ERR_FRQ_HI | ERR_FRQ_LO, FREQ_U_SEC_ELAPSED);
 		
 	key = Swi_disable();
 
-	/// #pulses divided by #microseconds
-	freq = ((double)FREQ_PULSE_COUNT_LO) / ((double)FREQ_U_SEC_ELAPSED); 
-
 	/// oscillator board uses 80x divider
 	freq *= 80;	
 
@@ -195,34 +197,69 @@ void Read_User_Temperature(void)
 }
 
 
-Uint8 Read_WC(float *WC)
+/// cubic of curve <c> of REG_COEFFS_TEMP_OIL at <freq>
+double Oil_Curve_Poly(Uint16 c, double freq)
+{
+	return	REG_COEFFS_TEMP_OIL[c][3]*freq*freq*freq +
+			REG_COEFFS_TEMP_OIL[c][2]*freq*freq +
+			REG_COEFFS_TEMP_OIL[c][1]*freq +
+			REG_COEFFS_TEMP_OIL[c][0];
+}
+
+
+/***************************************************************************
+ * Oil_Curve_WC() - raw oil phase watercut from the temperature curves
+ * Uses the precomputed curves of CurveTable.c when they are current.
+ * @param k		- 0 for the low watercut curves, 3 for the high (cutoff) ones
+ * @param freq	- oscillator frequency
+ * @param temp	- process temperature
+ ***************************************************************************/
+float Oil_Curve_WC(Uint16 k, double freq, double temp)
 {
-	float 	w;
 	float	ot[2];
 	Uint16	i,j;
 
+	///
+	/// find the two data point our temperature falls between
+	///
+	for (i=1;i<REG_TEMP_OIL_NUM_CURVES-3;i++)
+		if (REG_TEMPS_OIL[i+k] > temp) break;
+
+	j = i-1;
+
+	if (!Curve_Table_Get(i+k, freq, &ot[0])) ot[0] = Oil_Curve_Poly(i+k, freq);
+	if (!Curve_Table_Get(j+k, freq, &ot[1])) ot[1] = Oil_Curve_Poly(j+k, freq);
+
+	return Interpolate(ot[0], REG_TEMPS_OIL[i], ot[1], REG_TEMPS_OIL[j], temp);
+}
+
+
+Uint8 Read_WC(float *WC)
+{
+	float 	w;
+
 	REG_OIL_PT = (REG_OIL_P1.calc_val * REG_FREQ.calc_val) + REG_OIL_P0.calc_val;
 
 	///////////////////////////////////////////////
 	// Check Oil/Water Phase, if Water phase, watercut = 100% (always)
 	///////////////////////////////////////////////
 
-	cycles++;
+	SP->cycles++;
 
-	if ((REG_FREQ.calc_val < REG_OIL_FREQ_LOW.calc_val) || (REG_FREQ.calc_val > REG_OIL_FREQ_HIGH.calc_val) || (REG_OIL_RP > REG_OIL_PT)) phase = 0;
-	else phase = 1;
+	if ((REG_FREQ.calc_val < REG_OIL_FREQ_LOW.calc_val) || (REG_FREQ.calc_val > REG_OIL_FREQ_HIGH.calc_val) || (REG_OIL_RP > REG_OIL_PT)) SP->phase = 0;
+	else SP->phase = 1;
 
-	if (cycles == 1) previous_phase = phase;
+	if (SP->cycles == 1) SP->previousPhase = SP->phase;
 		
-    if (phase != previous_phase) phase_rollover_count++;
+    if (SP->phase != SP->previousPhase) SP->rolloverCount++;
         
-    if (cycles > REG_PHASE_HOLD_CYCLES)
+    if (SP->cycles > REG_PHASE_HOLD_CYCLES)
     {
-        cycles = 0;
-        phase_rollover_count = 0;
+        SP->cycles = 0;
+        SP->rolloverCount = 0;
     }
 
-	if ((phase_rollover_count < 2) && (cycles == REG_PHASE_HOLD_CYCLES))
+	if ((SP->rolloverCount < 2) && (SP->cycles == REG_PHASE_HOLD_CYCLES))
 	{
     	if (REG_FREQ.calc_val < REG_OIL_FREQ_LOW.calc_val) COIL_OIL_PHASE.val = FALSE;
 		else 
@@ -234,47 +271,14 @@ Uint8 Read_WC(float *WC)
 
 	if (COIL_OIL_PHASE.val)
 	{
-		///
-		/// find the two data point our temperature falls between
-		///
-		for (i=1;i<REG_TEMP_OIL_NUM_CURVES-3;i++)
-			if ( REG_TEMPS_OIL[i] > REG_TEMP_USER.calc_val ) break;
-
-		j = i-1;
-
-		ot[0] = REG_COEFFS_TEMP_OIL[i][3]*REG_FREQ.calc_val*REG_FREQ.calc_val*REG_FREQ.calc_val +
-				REG_COEFFS_TEMP_OIL[i][2]*REG_FREQ.calc_val*REG_FREQ.calc_val +
-				REG_COEFFS_TEMP_OIL[i][1]*REG_FREQ.calc_val +
-				REG_COEFFS_TEMP_OIL[i][0];
-
-		ot[1] = REG_COEFFS_TEMP_OIL[j][3]*REG_FREQ.calc_val*REG_FREQ.calc_val*REG_FREQ.calc_val +
-				REG_COEFFS_TEMP_OIL[j][2]*REG_FREQ.calc_val*REG_FREQ.calc_val +
-				REG_COEFFS_TEMP_OIL[j][1]*REG_FREQ.calc_val +
-				REG_COEFFS_TEMP_OIL[j][0];
-
-		w = Interpolate(ot[0], REG_TEMPS_OIL[i], ot[1], REG_TEMPS_OIL[j], REG_TEMP_USER.calc_val);
+		w = Oil_Curve_WC(0, REG_FREQ.calc_val, REG_TEMP_USER.calc_val);
 
 		///
 		/// Note: As with the old code, we check for the cutoff using RAW watercut calculation
 		///
 		if ((w > REG_OIL_PHASE_CUTOFF) && (REG_OIL_PHASE_CUTOFF > 0)) // use the second curve (i+3)     
 		{
-			for (i=1;i<REG_TEMP_OIL_NUM_CURVES-3;i++)
-				if (REG_TEMPS_OIL[i+3] > REG_TEMP_USER.calc_val) break;
-
-			j 	  = i-1;
-
-			ot[0] = REG_COEFFS_TEMP_OIL[i+3][3]*REG_FREQ.calc_val*REG_FREQ.calc_val*REG_FREQ.calc_val +
-					REG_COEFFS_TEMP_OIL[i+3][2]*REG_FREQ.calc_val*REG_FREQ.calc_val +
-					REG_COEFFS_TEMP_OIL[i+3][1]*REG_FREQ.calc_val +
-					REG_COEFFS_TEMP_OIL[i+3][0];
-
-			ot[1] = REG_COEFFS_TEMP_OIL[j+3][3]*REG_FREQ.calc_val*REG_FREQ.calc_val*REG_FREQ.calc_val +
-					REG_COEFFS_TEMP_OIL[j+3][2]*REG_FREQ.calc_val*REG_FREQ.calc_val +
-					REG_COEFFS_TEMP_OIL[j+3][1]*REG_FREQ.calc_val +
-					REG_COEFFS_TEMP_OIL[j+3][0];
-
-			w 	  = Interpolate(ot[0], REG_TEMPS_OIL[i], ot[1], REG_TEMPS_OIL[j], REG_TEMP_USER.calc_val);
+			w = Oil_Curve_WC(3, REG_FREQ.calc_val, REG_TEMP_USER.calc_val);
 
 		    REG_WATERCUT_RAW = w;
 
@@ -289,14 +293,16 @@ Uint8 Read_WC(float *WC)
 			///
     		/// average REG_WATERCUT_RAW
 			///
-   			WC_RAW_AVG *= (REG_PROC_AVGING.calc_val-1);
-   			WC_RAW_AVG += w;
-   			WC_RAW_AVG /= REG_PROC_AVGING.calc_val;
+   			if (!SP->isPrimed) SP->wcRawAvg = w;	// first sample of this stream
+   			SP->isPrimed = TRUE;
+   			SP->wcRawAvg *= (REG_PROC_AVGING.calc_val-1);
+   			SP->wcRawAvg += w;
+   			SP->wcRawAvg /= REG_PROC_AVGING.calc_val;
 
 			///
 			/// add REG_OIL_ADJUST
 			///
-            *WC = (float)WC_RAW_AVG + REG_OIL_ADJUST.calc_val;
+            *WC = (float)SP->wcRawAvg + REG_OIL_ADJUST.calc_val;
 		}
 		else
 		{
@@ -305,14 +311,16 @@ Uint8 Read_WC(float *WC)
 			///
     		/// average REG_WATERCUT_RAW
 			///
-   			WC_RAW_AVG *= (REG_PROC_AVGING.calc_val-1);
-   			WC_RAW_AVG += w;
-   			WC_RAW_AVG /= REG_PROC_AVGING.calc_val;
+   			if (!SP->isPrimed) SP->wcRawAvg = w;	// first sample of this stream
+   			SP->isPrimed = TRUE;
+   			SP->wcRawAvg *= (REG_PROC_AVGING.calc_val-1);
+   			SP->wcRawAvg += w;
+   			SP->wcRawAvg /= REG_PROC_AVGING.calc_val;
 
 			///
 			/// add REG_OIL_ADJUST
 			///
-            *WC = (float)WC_RAW_AVG + REG_OIL_ADJUST.calc_val;
+            *WC = (float)SP->wcRawAvg + REG_OIL_ADJUST.calc_val;
 
 			/*
 			/// add oil adjust
@@ -367,61 +375,29 @@ inline float Interpolate(float w1, float t1, float w2, float t2, float t)
 	return w;
 }
 
-void Update_Demo_Values(void)
-{
-	int rand_num;
-	float rand_freq_delta;
-	static int flip = 1;
-
-#ifdef DEMO_MODE
-	rand_num = (rand() % 100) - 51; //between -50 and 50
-	rand_freq_delta = (float)flip * (float)rand_num / 200;
-
-#ifdef DEMO_MODE_FREQ
-		VAR_Update(&REG_FREQ, REG_FREQ.calc_val+rand_freq_delta, 0);
-		if ( (REG_FREQ.calc_val < 560) || (REG_FREQ.calc_val > 590) )
-		{
-			//keep WC within reasonable bounds
-			VAR_Update(&REG_FREQ,REG_FREQ.calc_val-(rand_freq_delta*3), CALC_UNIT); //wc -= rand_freq_delta*3
-			flip *= -1;
-		}
-#endif
-
-#ifdef DEMO_MODE_TEMP
-		rand_temp_delta = rand_freq_delta/-1;
-		VAR_Update(&REG_TEMPERATURE, REG_TEMPERATURE.calc_val+rand_temp_delta, 0);
-		// range check
-			 if (REG_TEMPERATURE.calc_val < 50) VAR_Update(&REG_TEMPERATURE, 50 + abs(rand_temp_delta)*2, 0);
-		else if (REG_TEMPERATURE.calc_val > 60) VAR_Update(&REG_TEMPERATURE, 60 - abs(rand_temp_delta)*2, 0);
-			
-#endif
-
-#endif
-}
-
 
 inline void Init_Data_Buffer(void)
 {
 	//note: .tail is not really necessary for our purposes
-	DATALOG.WC_BUFFER.head		= 0;
-	DATALOG.WC_BUFFER.tail		= 0;
-	DATALOG.WC_BUFFER.n			= 0;
-	DATALOG.WC_BUFFER.buff[0]	= 0;
-
-	DATALOG.T_BUFFER.head		= 0;
-	DATALOG.T_BUFFER.tail		= 0;
-	DATALOG.T_BUFFER.n			= 0;
-	DATALOG.T_BUFFER.buff[0]	= 0;
-
-	DATALOG.F_BUFFER.head		= 0;
-	DATALOG.F_BUFFER.tail		= 0;
-	DATALOG.F_BUFFER.n			= 0;
-	DATALOG.F_BUFFER.buff[0]	= 0;
-
-	DATALOG.RP_BUFFER.head		= 0;
-	DATALOG.RP_BUFFER.tail		= 0;
-	DATALOG.RP_BUFFER.n			= 0;
-	DATALOG.RP_BUFFER.buff[0]	= 0;
+	SP->log.WC_BUFFER.head		= 0;
+	SP->log.WC_BUFFER.tail		= 0;
+	SP->log.WC_BUFFER.n			= 0;
+	SP->log.WC_BUFFER.buff[0]	= 0;
+
+	SP->log.T_BUFFER.head		= 0;
+	SP->log.T_BUFFER.tail		= 0;
+	SP->log.T_BUFFER.n			= 0;
+	SP->log.T_BUFFER.buff[0]	= 0;
+
+	SP->log.F_BUFFER.head		= 0;
+	SP->log.F_BUFFER.tail		= 0;
+	SP->log.F_BUFFER.n			= 0;
+	SP->log.F_BUFFER.buff[0]	= 0;
+
+	SP->log.RP_BUFFER.head		= 0;
+	SP->log.RP_BUFFER.tail		= 0;
+	SP->log.RP_BUFFER.n			= 0;
+	SP->log.RP_BUFFER.buff[0]	= 0;
 }
 
 void Capture_Sample(void)
@@ -432,15 +408,15 @@ void Capture_Sample(void)
     ///
     /// Add new samples to buffer
     ///
-    Bfr_Add(&DATALOG.WC_BUFFER, REG_WATERCUT_RAW);          // raw watercut samples
-    Bfr_Add(&DATALOG.T_BUFFER,  REG_TEMPERATURE.calc_val);  // temperature samples
-    Bfr_Add(&DATALOG.F_BUFFER,  REG_FREQ.calc_val);         // oscillator frequency samples
-    Bfr_Add(&DATALOG.RP_BUFFER, REG_OIL_RP);                // oscillator reflected power samples
+    Bfr_Add(&SP->log.WC_BUFFER, REG_WATERCUT_RAW);          // raw watercut samples
+    Bfr_Add(&SP->log.T_BUFFER,  REG_TEMPERATURE.calc_val);  // temperature samples
+    Bfr_Add(&SP->log.F_BUFFER,  REG_FREQ.calc_val);         // oscillator frequency samples
+    Bfr_Add(&SP->log.RP_BUFFER, REG_OIL_RP);                // oscillator reflected power samples
 
     ///
     /// Numbe of samples 
     ///
-    if (REG_PROC_AVGING.calc_val > DATALOG.WC_BUFFER.n) num_samples = DATALOG.WC_BUFFER.n;
+    if (REG_PROC_AVGING.calc_val > SP->log.WC_BUFFER.n) num_samples = SP->log.WC_BUFFER.n;
     else num_samples = REG_PROC_AVGING.calc_val;
         
     /// 
@@ -449,8 +425,8 @@ void Capture_Sample(void)
     sum = 0;
     for (i=0;i<num_samples;i++)
     {   
-        if ((DATALOG.WC_BUFFER.head-i) < 0) sum += DATALOG.WC_BUFFER.buff[DATALOG.WC_BUFFER.head-i + MAX_BFR_SIZE_F]; // wrap around
-        else sum += DATALOG.WC_BUFFER.buff[DATALOG.WC_BUFFER.head-i];
+        if ((SP->log.WC_BUFFER.head-i) < 0) sum += SP->log.WC_BUFFER.buff[SP->log.WC_BUFFER.head-i + MAX_BFR_SIZE_F]; // wrap around
+        else sum += SP->log.WC_BUFFER.buff[SP->log.WC_BUFFER.head-i];
     }   
     REG_WATERCUT_AVG.calc_val = sum/(double)num_samples;
 
@@ -474,20 +450,20 @@ void Capture_Sample(void)
     sum = 0;
     for (i=0;i<num_samples;i++)
     {   
-        if ((DATALOG.T_BUFFER.head-i) < 0) //wrap around
-            sum += DATALOG.T_BUFFER.buff[DATALOG.T_BUFFER.head - i + MAX_BFR_SIZE_F];
+        if ((SP->log.T_BUFFER.head-i) < 0) //wrap around
+            sum += SP->log.T_BUFFER.buff[SP->log.T_BUFFER.head - i + MAX_BFR_SIZE_F];
         else
-            sum += DATALOG.T_BUFFER.buff[DATALOG.T_BUFFER.head-i];
+            sum += SP->log.T_BUFFER.buff[SP->log.T_BUFFER.head-i];
 
         // In 24HR mode, resets REG_TEMP_AVG between 24:00:00 and 23:59:57 everyday
         // COIL_AVG_MODE = TRUE <--- ondemand
         if (COIL_AVGTEMP_RESET.val || (!COIL_AVGTEMP_MODE.val && (REG_RTC_SEC > 57) && (REG_RTC_MIN == 59) && (REG_RTC_HR == 23)))
         {
             num_samples = 0;
-            DATALOG.T_BUFFER.head    = 0;
-            DATALOG.T_BUFFER.tail    = 0;
-            DATALOG.T_BUFFER.n       = 0;
-            DATALOG.T_BUFFER.buff[0] = 0;
+            SP->log.T_BUFFER.head    = 0;
+            SP->log.T_BUFFER.tail    = 0;
+            SP->log.T_BUFFER.n       = 0;
+            SP->log.T_BUFFER.buff[0] = 0;
             COIL_AVGTEMP_RESET.val = FALSE;
         }
     }
@@ -517,7 +493,7 @@ void Calibrate_Oil(void)
 	///
     if (REG_STREAM.calc_val == TEMP_STREAM)
     {   
-        if (REG_PROC_AVGING.calc_val < DATALOG.WC_BUFFER.n)
+        if (REG_PROC_AVGING.calc_val < SP->log.WC_BUFFER.n)
         {
             if (COIL_OIL_PHASE.val)
             {
@@ -526,11 +502,11 @@ void Calibrate_Oil(void)
 					//t = (REG_OIL_SAMPLE.calc_val*sg) - (REG_WATERCUT_RAW + FC.Dadj); [Jun-02-2020] : Enrique confirmed WATERCUT_RAW_AVG instead of "REG_WATERCUT_RAW"
                     if (REG_OIL_DENS_CORR_MODE != 0)
 					{
-                        t = (REG_OIL_SAMPLE.calc_val*sg) - (WC_RAW_AVG + REG_DENS_CORR);
+                        t = (REG_OIL_SAMPLE.calc_val*sg) - (SP->wcRawAvg + REG_DENS_CORR);
                     }
                     else
                     {
-                        t = REG_OIL_SAMPLE.calc_val*sg - WC_RAW_AVG;  /// [Jun-30-2020] : Enerique correctd equation when there is no density correction 
+                        t = REG_OIL_SAMPLE.calc_val*sg - SP->wcRawAvg;  /// [Jun-30-2020] : Enerique correctd equation when there is no density correction 
                     }
 				}
 
@@ -18,14 +18,15 @@
 * Most of the Razor's measurements are interpreted and calculated in this
 * code. Readings are updated in Capture_Sample() once a second, and runs
 * in the context of a priority 15 SWI. However the pulse count corresponding
-* to oscillator frequency is measured by Count_Freq_Pulses().
-* Count_Freq_Pulses() is called twice per second by the Timer module,
-* so the code is run in the context of a HWI (a real-time constraint in
-* measuring high frequencies). We read in the number of pulses counted by
-* the counter of hardware timer 1 and divide by the sample period of 500ms
-* (and multiply back the 80x frequency divider) to arrive at our oscillator
-* frequency. This frequency, along with many other values and measurements,
-* is used to calculate the watercut.
+* to oscillator frequency is captured by Count_Freq_Pulses().
+* Count_Freq_Pulses() is called every 50ms by the Timer module, so the
+* code is run in the context of a HWI (a real-time constraint in
+* measuring high frequencies). It timestamps an edge of the free-running
+* counter of hardware timer 3 (FreqCapture.c); the pulses between the
+* first and last edge of the REG_FREQ_GATE window, divided by the time
+* between them (and multiplied back by the 80x frequency divider), give
+* our oscillator frequency. This frequency, along with many other values
+* and measurements, is used to calculate the watercut.
 *------------------------------------------------------------------------*/
 #ifndef _CALCULATE
 #define _CALCULATE
@@ -40,12 +41,13 @@ _EXTERN void Poll(void);
 
 inline void Init_Data_Buffer(void);
 void Bfr_Add(FP_BFR* bfr, double val);
-void Update_Demo_Values(void);
 void Count_Freq_Pulses(Uint32 u_sec_elapsed);
 void Read_User_Temperature(void);
 Uint8 Apply_Density_Correction(void);
 Uint8 Read_Freq(void);
 Uint8 Read_WC(float *WC);
+float Oil_Curve_WC(Uint16 k, double freq, double temp);
+double Oil_Curve_Poly(Uint16 c, double freq);
 float Interpolate(float w1, float t1, float w2, float t2, float t);
 
 #undef _EXTERN
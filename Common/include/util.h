@@ -59,6 +59,9 @@ extern far "c" {
 
 #define ENDIAN_SWAP(a) (((a&0xFF)<<24)|((a&0xFF0000)>>8)|((a&0xFF00)<<8)|((a&0xFF000000)>>24))
 
+// Size of the ad-hoc heap behind UTIL_allocMem()
+#define UTIL_MEM_SIZE  (0x00061a80)
+
 
 /***********************************************************
 * Global Typedef declarations                              *
@@ -73,6 +76,8 @@ void *UTIL_getCurrMemPtr(void);
 void UTIL_setCurrMemPtr(void *value);
 void *UTIL_allocMem (Uint32 size);
 void *UTIL_callocMem(Uint32 size);
+Uint32 UTIL_getPeakMem(void);
+Uint32 UTIL_getMemFails(void);
 void UTIL_memcpy(void *dest, void *src, Uint32 size);
 void UTIL_waitLoop(Uint32 loopcnt);
 void UTIL_waitLoopAccurate (Uint32 loopcnt);
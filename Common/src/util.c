@@ -73,8 +73,8 @@ extern __FAR__ Uint32 EXTERNAL_RAM_START, EXTERNAL_RAM_END;
 /************************************************************
 * Local Function Declarations                               *
 ************************************************************/
-#if (0)
 static Uint32 LOCAL_reflectNum(Uint32 inVal, Uint32 num);
+#if (0)
 static Uint8 LOCAL_CalcBitWiseParity(Uint8 val, Uint8 mask);
 #endif
 
@@ -90,6 +90,10 @@ static Uint8 LOCAL_CalcBitWiseParity(Uint8 val, Uint8 mask);
 // Global memory allocation pointer
 static VUint32 currMemPtr;
 
+// Highest currMemPtr seen and refused requests, for the memory monitor
+static VUint32 peakMemPtr;
+static VUint32 failMemCnt;
+
 
 /************************************************************
 * Global Function Definitions                               *
@@ -117,17 +121,31 @@ void *UTIL_allocMem(Uint32 size)
   size_temp = ((size + 4) >> 2 ) << 2;
   
 //if((currMemPtr + size_temp) > ((Uint32) &EXTERNAL_RAM_END))
-  if((currMemPtr + size_temp) > ((Uint32) 0x00061a80))
+  if((currMemPtr + size_temp) > ((Uint32) UTIL_MEM_SIZE))
   {
+    failMemCnt++;
     return NULL;
   }
 
   cPtr = (void *) (((Uint32) &EXTERNAL_RAM_START) + currMemPtr);
   currMemPtr += size_temp;
+  if (currMemPtr > peakMemPtr) peakMemPtr = currMemPtr;
 
   return cPtr;
 }
 
+// Ad-hoc heap high-water mark, bytes
+Uint32 UTIL_getPeakMem(void)
+{
+  return peakMemPtr;
+}
+
+// Ad-hoc heap requests refused for lack of space
+Uint32 UTIL_getMemFails(void)
+{
+  return failMemCnt;
+}
+
 // Allocate memory from the ad-hoc heap
 void *UTIL_callocMem(Uint32 size)
 {
@@ -194,7 +212,6 @@ void UTIL_waitLoopAccurate (Uint32 loopcnt)
 #endif
 }
 
-#if (0)
 // CRC-32 routine (relflected, init xor val = 0xFFFFFFFF, final xor val = 0xFFFFFFFF)
 Uint32 UTIL_calcCRC32(Uint32* lutCRC, Uint8 *data, Uint32 size, Uint32 currCRC)
 {
@@ -243,6 +260,7 @@ void UTIL_buildCRC32Table(Uint32* lutCRC, Uint32 poly)
   }
 }
 
+#if (0)
 // CRC-16 routine (relflected, init xor val = 0xFFFF, final xor val = 0xFFFF)
 Uint16 UTIL_calcCRC16(Uint16* lutCRC, Uint8 *data, Uint32 size, Uint16 currCRC)
 {
@@ -338,7 +356,6 @@ Uint32 UTIL_hammingECC(Uint8 *data, Uint16 cnt)
 /***********************************************************
 * Local Function Definitions                               *
 ***********************************************************/
-#if (0) 
 static Uint32 LOCAL_reflectNum(Uint32 inVal, Uint32 num)
 {
   Uint32 i,outVal = 0x0;
@@ -351,6 +368,7 @@ static Uint32 LOCAL_reflectNum(Uint32 inVal, Uint32 num)
   return outVal;
 }
 
+#if (0) 
 
 static Uint8 LOCAL_calcBitWiseParity(Uint32* bits, Bool isEven, Uint16 chunkSizeInBits, Uint16 lengthInBits)
 {
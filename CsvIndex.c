@@ -0,0 +1,192 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* CsvIndex.c
+*-------------------------------------------------------------------------
+* USB CSV file index. See CsvIndex.h. Csv_Index_Step() is the only writer
+* and runs in logData_task. Readers in SWI or TASK context only look at
+* the index while isReady is set.
+*------------------------------------------------------------------------*/
+
+#include <ti/fs/fatfs/FATFS.h>
+#include "Globals.h"
+#include "Watchdog.h"
+
+#define CSVINDEX_H
+
+#include "CsvIndex.h"
+
+typedef struct
+{
+	char	name[CSV_NAME_LEN];
+	Uint32	size;
+	Uint16	fdate;				// FAT packed date
+	Uint16	ftime;				// FAT packed time
+} CSV_ENTRY;
+
+static CSV_ENTRY INDEX[CSV_INDEX_MAX];
+static DIR dir;
+static FILINFO fno;
+static int numIndexed = 0;
+static int numFound = 0;
+static BOOL isOpen = FALSE;
+static volatile BOOL isReady = FALSE;
+
+/// sorted insert; once full, names past the end are dropped
+static void insert(const FILINFO* f)
+{
+	CSV_ENTRY e;
+	const char* ext;
+	int len, lo, hi, mid;
+
+	memset(&e, 0, sizeof(e));
+	ext = strstr(f->fname, ".csv");
+	len = (int)(ext - f->fname);
+	if (len > CSV_NAME_LEN-1) len = CSV_NAME_LEN-1;
+	memcpy(e.name, f->fname, len);
+	e.size	= f->fsize;
+	e.fdate	= f->fdate;
+	e.ftime	= f->ftime;
+
+	numFound++;
+
+	lo = 0;
+	hi = numIndexed;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (strcmp(INDEX[mid].name, e.name) <= 0) lo = mid + 1;
+		else hi = mid;
+	}
+
+	if (lo >= CSV_INDEX_MAX) return;
+	if (numIndexed < CSV_INDEX_MAX) numIndexed++;
+
+	memmove(&INDEX[lo+1], &INDEX[lo], (numIndexed - 1 - lo) * sizeof(CSV_ENTRY));
+	INDEX[lo] = e;
+}
+
+static BOOL finish(void)
+{
+	if (isOpen) f_closedir(&dir);
+	isOpen = FALSE;
+
+	csvCounter		= numIndexed;
+	REG_CSV_COUNT	= numFound;
+	isScanSuccess	= (numIndexed > 0);
+	isReady			= TRUE;
+	isScanCsvFiles	= FALSE;
+
+	return TRUE;
+}
+
+void Csv_Index_Init(void)
+{
+	memset(INDEX, 0, sizeof(INDEX));
+	numIndexed	= 0;
+	numFound	= 0;
+	isOpen		= FALSE;
+	isReady		= FALSE;
+
+	REG_CSV_COUNT		= 0;
+	REG_CSV_PAGE.val	= 0;
+	REG_CSV_PAGE.swi	= Swi_Csv_Page;
+
+	memset(REG_CSV_WIN, 0, sizeof(REG_CSV_WIN));
+}
+
+/// menu: start a new scan in logData_task
+void Csv_Index_Request(void)
+{
+	isReady = FALSE;
+	isScanSuccess = FALSE;
+	isScanCsvFiles = TRUE;
+
+	WD_Expect(WD_CTX_LOG);
+	Semaphore_post(logData_sem);
+}
+
+/***************************************************************************
+ * Csv_Index_Step() - logData_task, one slice of the directory walk
+ * @return TRUE when the walk is complete (or the stick can't be read)
+ ***************************************************************************/
+BOOL Csv_Index_Step(void)
+{
+	int n;
+
+	if (!isOpen)
+	{
+		isReady		= FALSE;
+		numIndexed	= 0;
+		numFound	= 0;
+
+		if (f_opendir(&dir, "0:") != FR_OK) return finish();
+		isOpen = TRUE;
+	}
+
+	for (n=0;n<CSV_SLICE_ENTRIES;n++)
+	{
+		if ((f_readdir(&dir, &fno) != FR_OK) || (fno.fname[0] == 0)) return finish();
+		if (fno.fattrib & AM_DIR) continue;
+		if (strstr(fno.fname, ".csv") != NULL) insert(&fno);
+	}
+
+	return FALSE;
+}
+
+/// copy the name of entry i (no extension); FALSE if there is none
+BOOL Csv_Index_Name(int i, char* name)
+{
+	name[0] = '\0';
+	if (!isReady || (i < 0) || (i >= numIndexed)) return FALSE;
+
+	memcpy(name, INDEX[i].name, CSV_NAME_LEN);
+	return TRUE;
+}
+
+/***************************************************************************
+ * Csv_Index_Page_Load() - Swi_Csv_Page, posted by writes to REG_CSV_PAGE.
+ * Refreshes REG_CSV_WIN[]; empty slots read as zero.
+ ***************************************************************************/
+void Csv_Index_Page_Load(void)
+{
+	const CSV_ENTRY* e;
+	double* w;
+	Uint32 v;
+	int i, j, k, first;
+
+	memset(REG_CSV_WIN, 0, sizeof(REG_CSV_WIN));
+	if (!isReady) return;
+
+	first = (REG_CSV_PAGE.val > 0) ? (int)REG_CSV_PAGE.val * CSV_PAGE_SIZE : 0;
+
+	for (i=0;(i<CSV_PAGE_SIZE) && (first+i < numIndexed);i++)
+	{
+		e = &INDEX[first+i];
+		w = &REG_CSV_WIN[i*CSV_WORDS];
+
+		/// 3 characters per word stay exact through the float register
+		for (j=0;j<3;j++)
+		{
+			for (v=0,k=0;k<3;k++) v = (v << 8) | (Uint8)e->name[j*3+k];
+			w[CSV_W_NAME+j] = v;
+		}
+
+		w[CSV_W_SIZE] = e->size;
+		w[CSV_W_DATE] = (1980 + (e->fdate >> 9))*10000.0 + ((e->fdate >> 5) & 0xF)*100 + (e->fdate & 0x1F);
+		w[CSV_W_TIME] = (e->ftime >> 11)*10000.0 + ((e->ftime >> 5) & 0x3F)*100 + (e->ftime & 0x1F)*2;
+	}
+}
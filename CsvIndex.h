@@ -0,0 +1,55 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* CsvIndex.h
+*-------------------------------------------------------------------------
+* Index of the profile CSV files in the root of the USB stick, for the
+* upload menu (3.8) and Modbus. The walk runs in logData_task with SWIs
+* enabled, CSV_SLICE_ENTRIES directory entries at a time, and keeps the
+* first CSV_INDEX_MAX names in sorted order with their size and date. The
+* menu reads one name at a time. Modbus writes a page number to
+* REG_CSV_PAGE and reads CSV_PAGE_SIZE entries back from REG_CSV_WIN[].
+*------------------------------------------------------------------------*/
+#ifndef _CSVINDEX
+#define _CSVINDEX
+
+#ifdef CSVINDEX_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define CSV_INDEX_MAX			256		// entries kept, sorted by name
+#define CSV_NAME_LEN			13		// without ".csv", NUL included
+#define CSV_SLICE_ENTRIES		16		// directory entries read per slice
+#define CSV_PAGE_SIZE			4		// entries per REG_CSV_WIN[] page
+
+/// REG_CSV_WIN[] words of one entry
+#define CSV_W_NAME				0		// 3 words, 3 ASCII characters each (first character in the MSB)
+#define CSV_W_SIZE				3		// bytes
+#define CSV_W_DATE				4		// yyyymmdd
+#define CSV_W_TIME				5		// hhmmss
+#define CSV_WORDS				6
+
+void Csv_Index_Init(void);
+void Csv_Index_Request(void);
+BOOL Csv_Index_Step(void);
+BOOL Csv_Index_Name(int i, char* name);
+void Csv_Index_Page_Load(void);
+
+#undef _EXTERN
+#undef CSVINDEX_H
+#endif // _CSVINDEX
@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* CurveTable.c
+*-------------------------------------------------------------------------
+* Oil curve table compiler. See CurveTable.h. Curve_Table_Build() is the
+* Swi_Curve_Build function and runs below Poll. Poll only ever reads the
+* table <active> points to, so the builder never has to lock anything.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+#include "RtcTime.h"
+#include "Calculate.h"
+
+#define CURVETABLE_H
+
+#include "CurveTable.h"
+
+typedef struct
+{
+	Uint32	sig;						// signature() of the inputs it was built from
+	Uint16	numCurves;					// rows 0..numCurves-1 are filled
+	double	fLow[CURVE_MAX_CURVES];		// start of each curve's band
+	double	perStep[CURVE_MAX_CURVES];	// 1 / frequency step, 0 if the curve has no band
+	float	wc[CURVE_MAX_CURVES][CURVE_POINTS];
+} CURVE_TABLE;
+
+static CURVE_TABLE TBL[2];
+static CURVE_TABLE* volatile active = NULL;	// table Poll reads, NULL until the first build
+static Uint32 curSig = 0;					// inputs seen by the current Poll
+static Uint32 wantSig = 0;					// inputs the last Swi_Curve_Build post was for
+static BOOL isSeen = FALSE;
+static unsigned long long changeMs = 0;		// RTC_Time_Mono() when Poll saw the change
+
+/// FNV-1a over every word the curves depend on
+static inline Uint32 hashWords(Uint32 h, const void* p, Uint32 bytes)
+{
+	const Uint32* w = (const Uint32*)p;
+	Uint32 n;
+
+	for (n=0;n<bytes/sizeof(Uint32);n++) h = (h ^ w[n]) * 16777619;
+
+	return h;
+}
+
+/// the rows in use only; the temperatures are applied after the table
+static Uint32 signature(void)
+{
+	Uint32 h = 2166136261;
+	int rows;
+
+	rows = (REG_TEMP_OIL_NUM_CURVES < 0) ? 0 : (int)REG_TEMP_OIL_NUM_CURVES + 1;
+	if (rows > CURVE_MAX_CURVES) rows = CURVE_MAX_CURVES;
+
+	h = hashWords(h, &REG_TEMP_OIL_NUM_CURVES, sizeof(REG_TEMP_OIL_NUM_CURVES));
+	h = hashWords(h, REG_COEFFS_TEMP_OIL, rows*sizeof(REG_COEFFS_TEMP_OIL[0]));
+	h = hashWords(h, &REG_OIL_FREQ_LOW.calc_val, sizeof(REG_OIL_FREQ_LOW.calc_val));
+	h = hashWords(h, &REG_OIL_FREQ_HIGH.calc_val, sizeof(REG_OIL_FREQ_HIGH.calc_val));
+
+	return h;
+}
+
+void Curve_Table_Init(void)
+{
+	TBL[0].sig = 0;
+	TBL[1].sig = 0;
+	active	= NULL;
+	curSig	= 0;
+	wantSig	= 0;
+	isSeen	= FALSE;
+	memset(REG_CURVE, 0, sizeof(REG_CURVE));
+}
+
+/// Poll: note the inputs of this cycle, rebuild in the background if they changed
+void Curve_Table_Check(void)
+{
+	curSig = signature();
+
+	if (isSeen && (curSig == wantSig)) return;
+
+	isSeen	= TRUE;
+	wantSig	= curSig;
+	changeMs = RTC_Time_Mono();
+	REG_CURVE[CURVE_W_STATE] = CURVE_STATE_NONE;
+	Swi_post(Swi_Curve_Build);
+}
+
+/***************************************************************************
+ * curveBand() - frequencies curve <c> is sampled over
+ * Scans fLow..fHigh in CURVE_POINTS steps for the watercuts between
+ * CURVE_WC_MIN and CURVE_WC_MAX and widens that by a scan step each side,
+ * so the band covers every crossing. <step> is 0 if the curve never gets
+ * there.
+ ***************************************************************************/
+static void curveBand(Uint16 c, double fLow, double fHigh, double* start, double* step)
+{
+	double scan, w;
+	Int32 n, first = -1, last = -1;
+
+	scan = (fHigh - fLow) / (CURVE_POINTS-1);
+
+	for (n=0;n<CURVE_POINTS;n++)
+	{
+		w = Oil_Curve_Poly(c, fLow + n*scan);
+		if ((w < CURVE_WC_MIN) || (w > CURVE_WC_MAX)) continue;
+		if (first < 0) first = n;
+		last = n;
+	}
+
+	*start = fLow;
+	*step = 0;
+	if (first < 0) return;
+
+	if (first > 0) first--;
+	if (last < CURVE_POINTS-1) last++;
+
+	*start = fLow + first*scan;
+	*step = (last - first)*scan / (CURVE_POINTS-1);
+}
+
+/***************************************************************************
+ * Curve_Table_Build() - Swi_Curve_Build
+ * Fills the table Poll is not using, each curve over its band, checks it
+ * against the coefficients at 1/4, 1/2 and 3/4 of every step, and swaps it
+ * in if it is good enough and the inputs did not move while it was being
+ * built.
+ ***************************************************************************/
+void Curve_Table_Build(void)
+{
+	CURVE_TABLE* t;
+	Types_FreqHz freq;
+	Uint32 sig, t0, n, q;
+	Uint16 c;
+	double fLow, fHigh, step, f, w, err, maxErr;
+
+	t0 = Timestamp_get32();
+	sig = signature();
+
+	t = (active == &TBL[0]) ? &TBL[1] : &TBL[0];
+	t->sig = 0;
+
+	/// curves 0..NUM_CURVES are reachable from Oil_Curve_WC()
+	c = (REG_TEMP_OIL_NUM_CURVES < 0) ? 0 : (Uint16)REG_TEMP_OIL_NUM_CURVES + 1;
+	t->numCurves = (c > CURVE_MAX_CURVES) ? CURVE_MAX_CURVES : c;
+	fLow = REG_OIL_FREQ_LOW.calc_val;
+	fHigh = REG_OIL_FREQ_HIGH.calc_val;
+
+	if (fHigh <= fLow)
+	{
+		REG_CURVE[CURVE_W_STATE] = CURVE_STATE_REJECTED;
+		return;
+	}
+
+	maxErr = 0;
+	for (c=0;c<t->numCurves;c++)
+	{
+		curveBand(c, fLow, fHigh, &t->fLow[c], &step);
+		t->perStep[c] = (step > 0) ? 1.0 / step : 0;
+		if (step <= 0) continue;
+
+		for (n=0;n<CURVE_POINTS;n++) t->wc[c][n] = Oil_Curve_Poly(c, t->fLow[c] + n*step);
+
+		/// linear interpolation error against the cubic itself
+		for (n=0;n<CURVE_POINTS-1;n++)
+		{
+			for (q=1;q<4;q++)
+			{
+				f = t->fLow[c] + (n + q*0.25)*step;
+				w = t->wc[c][n] + q*0.25*(t->wc[c][n+1] - t->wc[c][n]);
+				err = fabs(Oil_Curve_Poly(c, f) - w);
+				if (err > maxErr) maxErr = err;
+			}
+		}
+	}
+
+	/// Poll has already posted us again if the inputs moved meanwhile
+	if (sig != signature()) return;
+
+	Timestamp_getFreq(&freq);
+	REG_CURVE[CURVE_W_MAX_ERR] = maxErr;
+	REG_CURVE[CURVE_W_BUILDS] += 1;
+	REG_CURVE[CURVE_W_BUILD_US] = (double)(Timestamp_get32() - t0) * 1000000.0 / freq.lo;
+
+	if (maxErr > CURVE_MAX_ERR)
+	{
+		REG_CURVE[CURVE_W_STATE] = CURVE_STATE_REJECTED;
+		return;
+	}
+
+	t->sig = sig;
+	active = t;
+	REG_CURVE[CURVE_W_STATE] = CURVE_STATE_ACTIVE;
+	REG_CURVE[CURVE_W_LATENCY_MS] = (double)(RTC_Time_Mono() - changeMs);
+}
+
+/***************************************************************************
+ * Curve_Table_Get() - curve <c> at <freq> from the table
+ * @return FALSE if there is no table for the inputs of this Poll or <freq>
+ * 		   is outside the curve's band; the caller evaluates the coefficients
+ * 		   instead
+ ***************************************************************************/
+BOOL Curve_Table_Get(Uint16 c, double freq, float* w)
+{
+	const CURVE_TABLE* t = active;
+	double x;
+	Uint32 n;
+
+	if ((t == NULL) || (t->sig != curSig) || (c >= t->numCurves) || (t->perStep[c] == 0)) return FALSE;
+
+	x = (freq - t->fLow[c]) * t->perStep[c];
+	if ((x < 0) || (x > CURVE_POINTS-1)) return FALSE;
+
+	n = (Uint32)x;
+	if (n > CURVE_POINTS-2) n = CURVE_POINTS-2;
+	x -= n;
+
+	*w = t->wc[c][n] + (float)x * (t->wc[c][n+1] - t->wc[c][n]);
+	return TRUE;
+}
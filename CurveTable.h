@@ -0,0 +1,76 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+
+/*------------------------------------------------------------------------
+* CurveTable.h
+*-------------------------------------------------------------------------
+* Precomputed oil curves. Every curve of REG_COEFFS_TEMP_OIL[] in use is
+* sampled at CURVE_POINTS frequencies, so Oil_Curve_WC() interpolates a
+* table instead of evaluating two cubics every Poll.
+*
+* A curve is sampled only over the part of REG_OIL_FREQ_LOW..HIGH where it
+* gives a watercut between CURVE_WC_MIN and CURVE_WC_MAX. A calibrated
+* cubic crosses 0..100 % in a few MHz of a window hundreds of MHz wide and
+* runs to +-1e5 % at its ends; spread over the whole window the samples
+* would be too far apart to follow it. Outside its band the coefficients
+* are used.
+*
+* Curve_Table_Check() runs at the start of every Poll. It hashes the curve
+* inputs and posts Swi_Curve_Build when they change, whoever changed them
+* (Modbus, menu, profile or CSV upload). The table is built in the buffer
+* Poll is not reading and then swapped in. Until that happens, Oil_Curve_WC()
+* falls back to the coefficients. A table whose interpolation error is
+* above CURVE_MAX_ERR is never swapped in.
+*
+* REG_OIL_ADJUST and the density correction are added after the watercut
+* average, so they are not part of the table and take effect on the next
+* Poll as before.
+*------------------------------------------------------------------------*/
+#ifndef _CURVETABLE
+#define _CURVETABLE
+
+#ifdef CURVETABLE_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define CURVE_POINTS					513		// samples per curve
+#define CURVE_MAX_CURVES				10		// REG_COEFFS_TEMP_OIL rows
+#define CURVE_MAX_ERR					0.005	// % watercut, worst interpolation error allowed
+#define CURVE_WC_MIN					-100.0	// % watercut, band a curve is sampled over
+#define CURVE_WC_MAX					200.0
+
+/// REG_CURVE[] words
+#define CURVE_W_STATE					0		// CURVE_STATE_*
+#define CURVE_W_MAX_ERR					1		// worst interpolation error of the last build, % watercut
+#define CURVE_W_BUILDS					2		// tables built since boot
+#define CURVE_W_BUILD_US				3		// time of the last build
+#define CURVE_W_LATENCY_MS				4		// change seen by Poll -> table in use
+#define CURVE_WORDS						5
+
+#define CURVE_STATE_NONE				0		// no table for the current inputs, coefficients are used
+#define CURVE_STATE_ACTIVE				1
+#define CURVE_STATE_REJECTED			2		// error above CURVE_MAX_ERR, coefficients are used
+
+void Curve_Table_Init(void);
+void Curve_Table_Check(void);
+void Curve_Table_Build(void);
+BOOL Curve_Table_Get(Uint16 c, double freq, float* w);
+
+#undef _EXTERN
+#undef CURVETABLE_H
+#endif // _CURVETABLE
@@ -33,7 +33,7 @@ _EXTERN void checkError(double val, double BOUND_LOW, double BOUND_HIGH, int ERR
 ////////////// ERROR HANDLER ////////////////
 /////////////////////////////////////////////
 
-#define MAX_ERRORS 12
+#define MAX_ERRORS 13
 
 enum ERRORS {
 ERR_WAC_HI	= 1 << 0,
@@ -48,6 +48,7 @@ ERR_DNS_HI 	= 1 << 8,
 ERR_DNS_LO 	= 1 << 9,
 ERR_DNS_ADJ_HI 	= 1 << 10,
 ERR_DNS_ADJ_LO 	= 1 << 11,
+ERR_AO_RBK 	= 1 << 12,
 
 };
 
@@ -65,18 +66,13 @@ static char *errorType[MAX_ERRORS] =
 "      Lo Density",
 "     Hi Dens Adj",
 "     Lo Dens Adj",
+"     AO Readback",
 };
 
 /////////////////////////////////////////////
 /////////////////////////////////////////////
 /////////////////////////////////////////////
 
-/// Relay Modes
-#define RELAY_MODE_HI_ONLY		1
-#define RELAY_MODE_LO_ONLY		2
-#define RELAY_MODE_HI_AND_LO	3
-#define RELAY_MODE_MANUAL		4
-
 /// Errors & Malfunctions
 #define	ERROR_I2C_EXPANDER		0x10000
 #define ERROR_MODBUS_CMD		0x20000
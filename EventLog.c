@@ -0,0 +1,219 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* EventLog.c
+*-------------------------------------------------------------------------
+* Timestamped event ring. See EventLog.h. Events are recorded from SWI
+* and TASK context (not HWI). Writers never wait on each other: the only
+* shared step is reserving a slot, which takes a few cycles with HWIs
+* off, and each slot carries its sequence number so that a reader can
+* tell a complete record from one being written or overwritten.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+#include "RtcTime.h"
+#include "Relay.h"
+
+#define EVENTLOG_H
+
+#include "EventLog.h"
+
+typedef struct
+{
+	Uint32	seq;				// 0 while the record is being written
+	Uint32	epoch;
+	Uint16	msec;
+	Uint16	kind;
+	Uint16	code;
+	float	val;
+} EVENT;
+
+typedef struct
+{
+	Uint32	count;
+	Uint32	first;				// epoch seconds
+	Uint32	last;				// epoch seconds
+	unsigned long long activeMs;
+	unsigned long long riseMs;	// RTC_Time_Mono() of the last rising edge
+} ERR_STAT;
+
+static volatile EVENT RING[EVENT_RING_SIZE];
+static volatile Uint32 evtTotal = 0;	// events ever recorded = last sequence number
+static ERR_STAT ERR_STATS[MAX_ERRORS];
+
+/// append one event; O(1) whatever the event rate
+static void record(Uint16 kind, Uint16 code, double val, unsigned long long ms)
+{
+	volatile EVENT* e;
+	Uint32 key, seq;
+
+	key = Hwi_disable();
+	seq = ++evtTotal;
+	Hwi_restore(key);
+
+	e = &RING[(seq - 1) & (EVENT_RING_SIZE - 1)];
+	e->seq   = 0;
+	e->epoch = (Uint32)(ms / 1000ULL);
+	e->msec  = (Uint16)(ms % 1000ULL);
+	e->kind  = kind;
+	e->code  = code;
+	e->val   = (float)val;
+	e->seq   = seq;
+
+	REG_EVENT_TOTAL = (int)evtTotal;
+}
+
+void Event_Init(void)
+{
+	evtTotal = 0;
+	memset((void*)RING, 0, sizeof(RING));
+	memset(ERR_STATS, 0, sizeof(ERR_STATS));
+
+	REG_EVENT_TOTAL		= 0;
+	REG_EVENT_PAGE.val	= 0;
+	REG_EVENT_PAGE.swi	= Swi_Event_Page;
+	REG_EVENT_ERR.val	= 0;
+	REG_EVENT_ERR.swi	= Swi_Event_Page;
+
+	Event_Page_Load();
+}
+
+/***************************************************************************
+ * Event_Diag() - the only place DIAGNOSTICS bits are set or cleared
+ * @param set	- ERR_* bits to raise
+ * @param clr	- ERR_* bits to drop (wins over set)
+ * @param val	- the value that was checked, stored with the event
+ ***************************************************************************/
+void Event_Diag(Uint32 set, Uint32 clr, double val)
+{
+	ERR_STAT* s;
+	Uint32 key, was, now, edges, mask;
+	unsigned long long mono, ms;
+	int bit;
+
+	key = Hwi_disable();
+	was = DIAGNOSTICS;
+	now = (was | set) & ~clr;
+	DIAGNOSTICS = now;
+	Hwi_restore(key);
+
+	edges = was ^ now;
+	if (edges == 0) return;
+
+	/// error mode relays follow the edge, not the next Poll()
+	Relay_Notify();
+
+	mono = RTC_Time_Mono();
+	ms   = RTC_Time_Epoch();
+
+	for (bit=0;bit<MAX_ERRORS;bit++)
+	{
+		mask = (Uint32)1 << bit;
+		if ((edges & mask) == 0) continue;
+
+		s = &ERR_STATS[bit];
+		if (now & mask)
+		{
+			s->last = (Uint32)(ms / 1000ULL);
+			if (s->count == 0) s->first = s->last;
+			s->count++;
+			s->riseMs = mono;
+		}
+		else s->activeMs += mono - s->riseMs;
+
+		if (COIL_LOG_ERRORS.val) record((now & mask) ? EVENT_ERR_SET : EVENT_ERR_CLR, bit, val, ms);
+	}
+}
+
+/// call on an edge of an alarm only
+void Event_Alarm(Uint16 code, BOOL isSet, double val)
+{
+	if (!COIL_LOG_ALARMS.val) return;
+	record(isSet ? EVENT_ALARM_SET : EVENT_ALARM_CLR, code, val, RTC_Time_Epoch());
+}
+
+/// operator change: EVENT_MODBUS with the register, EVENT_COIL with the coil
+/// or EVENT_MENU with the menu id
+void Event_Activity(Uint8 kind, Uint16 code, double val)
+{
+	if (!COIL_LOG_ACTIVITY.val) return;
+	if ((kind == EVENT_MODBUS) && (code == EVENT_REG_PASSWORD)) val = 0;
+	record(kind, code, val, RTC_Time_Epoch());
+}
+
+/// the process values switched to or from the bench model - not gated
+void Event_Source(Uint16 mode, double prev)
+{
+	record(EVENT_SOURCE, mode, prev, RTC_Time_Epoch());
+}
+
+/***************************************************************************
+ * Event_Page_Load() - Swi_Event_Page, posted by writes to REG_EVENT_PAGE
+ * and REG_EVENT_ERR. Refreshes REG_EVENT_WIN[] and REG_EVENT_ERR_STAT[].
+ ***************************************************************************/
+void Event_Page_Load(void)
+{
+	volatile EVENT* e;
+	ERR_STAT* s;
+	Uint32 total, back, seq;
+	unsigned long long active;
+	float f;
+	int i, bit;
+	int* w;
+
+	total = evtTotal;
+	back  = (REG_EVENT_PAGE.val > 0) ? (Uint32)REG_EVENT_PAGE.val * EVENT_PAGE_SIZE : 0;
+
+	for (i=0;i<EVENT_PAGE_SIZE;i++)
+	{
+		w = &REG_EVENT_WIN[i*EVENT_WORDS];
+		memset(w, 0, EVENT_WORDS*sizeof(int));
+
+		if (back + i >= total) continue;					// older than the first event
+		if (back + i >= EVENT_RING_SIZE) continue;			// already overwritten
+		seq = total - back - i;
+
+		e = &RING[(seq - 1) & (EVENT_RING_SIZE - 1)];
+		if (e->seq != seq) continue;
+
+		f = e->val;
+		w[EVENT_W_EPOCH] = (int)e->epoch;
+		w[EVENT_W_MSEC]  = (int)e->msec;
+		w[EVENT_W_CODE]  = ((int)e->kind << 16) | (int)e->code;
+		w[EVENT_W_VALUE] = *(int*)&f;
+
+		// a writer got to the slot while we copied it
+		if (e->seq != seq) memset(w, 0, EVENT_WORDS*sizeof(int));
+		else w[EVENT_W_SEQ] = (int)seq;
+	}
+
+	bit = (int)REG_EVENT_ERR.val;
+	memset(REG_EVENT_ERR_STAT, 0, sizeof(REG_EVENT_ERR_STAT));
+
+	if ((bit >= 0) && (bit < MAX_ERRORS))
+	{
+		s = &ERR_STATS[bit];
+		active = s->activeMs;
+		if (DIAGNOSTICS & ((Uint32)1 << bit)) active += RTC_Time_Mono() - s->riseMs;
+
+		REG_EVENT_ERR_STAT[EVENT_S_COUNT]  = (int)s->count;
+		REG_EVENT_ERR_STAT[EVENT_S_ACTIVE] = (int)(active / 1000ULL);
+		REG_EVENT_ERR_STAT[EVENT_S_FIRST]  = (int)s->first;
+		REG_EVENT_ERR_STAT[EVENT_S_LAST]   = (int)s->last;
+	}
+
+	REG_EVENT_TOTAL = (int)total;
+}
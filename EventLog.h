@@ -0,0 +1,83 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* EventLog.h
+*-------------------------------------------------------------------------
+* Timestamped event ring. Every edge of a DIAGNOSTICS bit, every edge of
+* the analog output alarm and every operator change (Modbus write or
+* menu entry) is recorded with its epoch time and value, gated by
+* COIL_LOG_ERRORS, COIL_LOG_ALARMS and COIL_LOG_ACTIVITY. A switch of the
+* process source between the sensors and the bench model (Twin.c) is
+* always recorded. The ring holds
+* the last EVENT_RING_SIZE events; older ones are overwritten. Per error
+* bit the occurrences, first and last occurrence and total active time
+* are kept regardless of the coils.
+*
+* Over Modbus, writing REG_EVENT_PAGE selects a page of EVENT_PAGE_SIZE
+* events (0 = newest) that is copied into REG_EVENT_WIN[], and writing
+* REG_EVENT_ERR selects the error bit shown in REG_EVENT_ERR_STAT[].
+* REG_EVENT_TOTAL counts every event ever recorded, so a master can tell
+* how many it has missed.
+*------------------------------------------------------------------------*/
+#ifndef _EVENTLOG
+#define _EVENTLOG
+
+#ifdef EVENTLOG_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define EVENT_RING_SIZE			256		// power of 2
+#define EVENT_PAGE_SIZE			4		// events per Modbus page
+#define EVENT_WORDS				5		// REG_EVENT_WIN[] words per event
+
+/// REG_EVENT_WIN[] words of one event
+#define EVENT_W_SEQ				0		// sequence number, 0 = empty
+#define EVENT_W_EPOCH			1		// seconds since 1970-01-01
+#define EVENT_W_MSEC			2		// milliseconds part
+#define EVENT_W_CODE			3		// (kind << 16) | code
+#define EVENT_W_VALUE			4		// value, IEEE-754 float bits
+
+/// REG_EVENT_ERR_STAT[]
+#define EVENT_S_COUNT			0		// occurrences since boot
+#define EVENT_S_ACTIVE			1		// total active time, seconds
+#define EVENT_S_FIRST			2		// first occurrence, epoch seconds
+#define EVENT_S_LAST			3		// last occurrence, epoch seconds
+
+/// event kinds; the code is the error bit, the register, the coil or the menu id
+#define EVENT_ERR_SET			1
+#define EVENT_ERR_CLR			2
+#define EVENT_ALARM_SET			3
+#define EVENT_ALARM_CLR			4
+#define EVENT_MODBUS			5
+#define EVENT_MENU				6
+#define EVENT_COIL				7
+#define EVENT_SOURCE			8		// code = new TWIN_MODE_*, value = the old one
+
+#define EVENT_ALARM_AO			10		// COIL_AO_ALARM
+#define EVENT_REG_PASSWORD		224		// logged, but never with its value
+
+void Event_Init(void);
+void Event_Diag(Uint32 set, Uint32 clr, double val);
+void Event_Alarm(Uint16 code, BOOL isSet, double val);
+void Event_Activity(Uint8 kind, Uint16 code, double val);
+void Event_Source(Uint16 mode, double prev);
+void Event_Page_Load(void);
+
+#undef _EXTERN
+#undef EVENTLOG_H
+#endif // _EVENTLOG
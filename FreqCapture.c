@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* FreqCapture.c
+*-------------------------------------------------------------------------
+* Reciprocal frequency counter. See FreqCapture.h. Freq_Capture_Tick()
+* runs in the counter timer HWI; the readers take a Hwi_disable() copy.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+
+#define FREQCAPTURE_H
+
+#include "FreqCapture.h"
+
+typedef struct
+{
+	unsigned long long	count;	// timer 3, 64-bit, right after an edge
+	unsigned long long	ts;		// CPU timestamp of that edge
+} FREQ_EDGE;
+
+static FREQ_EDGE EDGES[FREQ_RING_SIZE];
+static Uint32 head = 0;			// next slot
+static Uint32 numEdges = 0;
+static Uint32 tickN = 0;
+static double tsPerUs = 0;		// CPU timestamp counts per microsecond
+
+/// result of the last gate
+static unsigned long long gateCount = 0;
+static unsigned long long gateTs = 0;
+
+static inline Uint32 gateTicks(void)
+{
+	int g = REG_FREQ_GATE;
+
+	if (g < FREQ_GATE_MIN) g = FREQ_GATE_MIN;
+	if (g > FREQ_GATE_MAX) g = FREQ_GATE_MAX;
+
+	return ((Uint32)g * 1000 + FREQ_TICK_US/2) / FREQ_TICK_US;
+}
+
+/// wait for the counter to step, then timestamp it
+static void captureEdge(FREQ_EDGE* e)
+{
+	Types_Timestamp64 now;
+	Uint32 lo0, lo;
+	int spin = 0;
+
+	lo0 = tmr3Regs->CNTLO;
+	do { lo = tmr3Regs->CNTLO; } while ((lo == lo0) && (++spin < FREQ_SPIN_MAX));
+
+	Timestamp_get64(&now);
+
+	/// reading CNTLO latched CNTHI (64-bit mode)
+	e->count = ((unsigned long long)tmr3Regs->CNTHI << 32) | lo;
+	e->ts = ((unsigned long long)now.hi << 32) | now.lo;
+}
+
+void Freq_Capture_Init(void)
+{
+	Types_FreqHz freq;
+	Uint32 key;
+
+	Timestamp_getFreq(&freq);
+
+	key = Hwi_disable();
+
+	memset(EDGES, 0, sizeof(EDGES));
+	head = 0;
+	numEdges = 0;
+	tickN = 0;
+	gateCount = 0;
+	gateTs = 0;
+	tsPerUs = (((double)freq.hi * 4294967296.0) + freq.lo) / 1000000.0;
+
+	Hwi_restore(key);
+}
+
+/***************************************************************************
+ * Freq_Capture_Tick() - counter timer HWI, every FREQ_TICK_US
+ * @return TRUE every FREQ_POLL_TICKS captures, when Swi_Poll is due
+ ***************************************************************************/
+BOOL Freq_Capture_Tick(void)
+{
+	FREQ_EDGE* e;
+	FREQ_EDGE* first;
+	Uint32 n;
+
+	e = &EDGES[head];
+	captureEdge(e);
+
+	/// counter was re-initialized - start over
+	if ((numEdges > 0) && (e->count < EDGES[(head - 1) & (FREQ_RING_SIZE-1)].count))
+	{
+		EDGES[0] = *e;
+		e = &EDGES[0];
+		head = 0;
+		numEdges = 0;
+	}
+
+	head = (head + 1) & (FREQ_RING_SIZE-1);
+	if (numEdges < FREQ_RING_SIZE) numEdges++;
+
+	if (++tickN < FREQ_POLL_TICKS) return FALSE;
+	tickN = 0;
+
+	/// first and last edge inside the gate
+	n = gateTicks();
+	if (n > numEdges - 1) n = numEdges - 1;
+
+	if (n == 0)
+	{
+		gateCount = 0;
+		gateTs = 0;
+	}
+	else
+	{
+		first = &EDGES[(head - 1 - n) & (FREQ_RING_SIZE-1)];
+		gateCount = e->count - first->count;
+		gateTs = e->ts - first->ts;
+	}
+
+	return TRUE;
+}
+
+/***************************************************************************
+ * Freq_Capture_Get() - counter input frequency over the last gate
+ * @param countLo/countHi	- edges counted in the gate
+ * @param usElapsed			- time between the first and last edge, us
+ * @return counts per microsecond (MHz), 0 if nothing was measured
+ ***************************************************************************/
+double Freq_Capture_Get(Uint32* countLo, Uint32* countHi, Uint32* usElapsed)
+{
+	unsigned long long count, ts;
+	Uint32 key;
+
+	key = Hwi_disable();
+	count = gateCount;
+	ts = gateTs;
+	Hwi_restore(key);
+
+	*countLo = (Uint32)count;
+	*countHi = (Uint32)(count >> 32);
+	*usElapsed = (tsPerUs > 0) ? (Uint32)(ts / tsPerUs + 0.5) : 0;
+
+	if ((ts == 0) || (tsPerUs <= 0)) return 0;
+
+	return (double)count * tsPerUs / (double)ts;
+}
+
+/***************************************************************************
+ * Freq_Capture_Periods() - mean counter input period of each tick
+ * @param ns	- newest first, in nanoseconds; 0 where no edge was counted
+ * @param n		- slots in ns[]
+ * @return number of periods written
+ ***************************************************************************/
+int Freq_Capture_Periods(double* ns, int n)
+{
+	const FREQ_EDGE* a;
+	const FREQ_EDGE* b;
+	Uint32 key, i;
+
+	key = Hwi_disable();
+
+	if (n > (int)numEdges - 1) n = (int)numEdges - 1;
+
+	for (i=0;(int)i<n;i++)
+	{
+		b = &EDGES[(head - 1 - i) & (FREQ_RING_SIZE-1)];
+		a = &EDGES[(head - 2 - i) & (FREQ_RING_SIZE-1)];
+		ns[i] = (b->count != a->count) ? ((double)(b->ts - a->ts) * 1000.0 / tsPerUs) / (double)(b->count - a->count) : 0;
+	}
+
+	Hwi_restore(key);
+
+	return (n > 0) ? n : 0;
+}
@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* FreqCapture.h
+*-------------------------------------------------------------------------
+* Reciprocal frequency counter on timer 3. The counter counts the 80x
+* divided oscillator and is never stopped. Every FREQ_TICK_US the counter
+* timer HWI waits for the next counter edge and timestamps it with the
+* CPU timestamp counter. The frequency is the number of edges between the
+* oldest and newest capture inside the gate (REG_FREQ_GATE ms), divided by
+* the time between those two edges. Resolution is set by the timestamp,
+* not by +/- one count per gate, and no counts are lost while the counter
+* is re-armed. The capture ring also gives the mean input period of every
+* tick for downstream filtering (Freq_Capture_Periods()).
+*------------------------------------------------------------------------*/
+#ifndef _FREQCAPTURE
+#define _FREQCAPTURE
+
+#ifdef FREQCAPTURE_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define FREQ_TICK_US			50000	// capture period (must match counterTimerHandle in PDI_Razor.cfg)
+#define FREQ_POLL_TICKS			10		// captures per Swi_Poll (0.5 s)
+#define FREQ_GATE_MIN			50		// ms
+#define FREQ_GATE_MAX			5000	// ms
+#define FREQ_RING_SIZE			128		// > FREQ_GATE_MAX*1000/FREQ_TICK_US, power of 2
+#define FREQ_SPIN_MAX			256		// counter reads to wait for an edge
+
+void Freq_Capture_Init(void);
+BOOL Freq_Capture_Tick(void);
+double Freq_Capture_Get(Uint32* countLo, Uint32* countHi, Uint32* usElapsed);
+int Freq_Capture_Periods(double* ns, int n);
+
+#undef _EXTERN
+#undef FREQCAPTURE_H
+#endif // _FREQCAPTURE
@@ -14,8 +14,12 @@
 
 #define GLOBAL_VARS
 
+#include <float.h>
 #include "Globals.h"
 #include "Errors.h"
+#include "Relay.h"
+#include "SigGen.h"
+#include "Totalizer.h"
 
 void resetGlobalVars(void)
 {
@@ -54,8 +58,6 @@ void resetGlobalVars(void)
 
 void storeUserDataToFactoryDefault(void)
 {
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
     // UNLOCK SAFETY GUARD FOR FCT REGISTERS
     COIL_UNLOCKED_FACTORY_DEFAULT.val = TRUE;
 
@@ -90,8 +92,6 @@ void storeUserDataToFactoryDefault(void)
 	FCT_AI_TRIMMED			= REG_AI_TRIMMED;
 	FCT_DENS_ADJ 			= REG_DENS_ADJ;
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
     // REGTYPE_VAR
     VAR_Update(&FCT_SALINITY, REG_SALINITY.calc_val, CALC_UNIT);
     VAR_Update(&FCT_OIL_ADJUST, REG_OIL_ADJUST.calc_val, CALC_UNIT);
@@ -102,8 +102,6 @@ void storeUserDataToFactoryDefault(void)
     VAR_Update(&FCT_OIL_P0, REG_OIL_P0.calc_val, CALC_UNIT);
     VAR_Update(&FCT_OIL_P1, REG_OIL_P1.calc_val, CALC_UNIT);
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
     VAR_Update(&FCT_OIL_FREQ_LOW, REG_OIL_FREQ_LOW.calc_val, CALC_UNIT);
     VAR_Update(&FCT_OIL_FREQ_HIGH, REG_OIL_FREQ_HIGH.calc_val, CALC_UNIT);
 	VAR_Update(&FCT_SAMPLE_PERIOD, REG_SAMPLE_PERIOD.calc_val, CALC_UNIT);
@@ -115,8 +113,6 @@ void storeUserDataToFactoryDefault(void)
     VAR_Update(&FCT_DENSITY_D3, REG_DENSITY_D3.calc_val, CALC_UNIT);
     VAR_Update(&FCT_DENSITY_D2, REG_DENSITY_D2.calc_val, CALC_UNIT);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
     VAR_Update(&FCT_DENSITY_D1, REG_DENSITY_D1.calc_val, CALC_UNIT);
     VAR_Update(&FCT_DENSITY_D0, REG_DENSITY_D0.calc_val, CALC_UNIT);
     VAR_Update(&FCT_DENSITY_CAL_VAL, REG_DENSITY_CAL_VAL.calc_val, CALC_UNIT);
@@ -126,15 +122,11 @@ void storeUserDataToFactoryDefault(void)
     VAR_Update(&FCT_OIL_T0, REG_OIL_T0.calc_val, CALC_UNIT);
     VAR_Update(&FCT_OIL_T1, REG_OIL_T1.calc_val, CALC_UNIT);
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
     // dislable the trigger
     COIL_UPDATE_FACTORY_DEFAULT.val = FALSE;
     COIL_UNLOCKED_FACTORY_DEFAULT.val = FALSE;
 	COIL_UPGRADE_ENABLE.val = FALSE;
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
     // save to nand flash
     Swi_post(Swi_writeNand);
 }
@@ -582,6 +574,21 @@ void initializeAllRegisters(void)
 	FCT_RELAY_MODE 			= 0; // WATERCUT
 
     REG_USB_TRY             = 1000; // (REGPERM_FCT)
+    REG_ADC_OVERSAMPLE      = 4;
+    REG_ADC_MEDIAN          = 3;
+    REG_ADC_BURST           = 1;
+    REG_AO_UPDATE_PERIOD    = 0;
+    REG_AO_VERIFY_CYCLES    = 20;
+    REG_RTC_SYNC_PERIOD     = 60;
+    REG_BOOT_FAST           = 0;    // off until REG_BOOT_MS shows the gain on the target
+    REG_TOT_TIME_BASE       = 3600;
+    REG_TOT_SAVE_PERIOD     = 60;
+    for (i=0;i<TOT_SAVED_WORDS;i++) TOT_SAVED[i] = 0;
+    TOT_SAVED[TOT_SAVED_STAMP] = TOT_SAVED_RESET; // totals restart from zero
+    REG_FREQ_GATE           = 500;
+    REG_SIG_SEED            = 1;
+    SigGen_Default();       // stored by SigGen_Init()
+    REG_RELAY_HYSTERESIS    = 0;
     REG_SN_PIPE             = 0; // (REGPERM_FCT)
 	REG_ANALYZER_MODE 	    = ANA_MODE_MID;
 	REG_AO_DAMPEN			= FCT_AO_DAMPEN;
@@ -1140,6 +1147,15 @@ void initializeAllRegisters(void)
 	VAR_Setup_Unit(&REG_RELAY_SETPOINT, u_ana_percent, 100.0, 0.0, 105.0, -3.0);
 	VAR_Update(&REG_RELAY_SETPOINT, FCT_RELAY_SETPOINT.calc_val, CALC_UNIT);
 	
+	//////////////////////////////////////
+   	/// Totalizer Meter Factor & Shrinkage - 1.0
+	//////////////////////////////////////
+
+	VAR_Initialize(&FC.Meter_Factor, c_analytical, u_mfgr_specific_none, 10000.0, 10000.0, var_no_bound|var_no_alarm);
+	VAR_Update(&FC.Meter_Factor, 1.0, CALC_UNIT);
+	VAR_Initialize(&FC.Shrinkage, c_analytical, u_mfgr_specific_none, 10000.0, 10000.0, var_no_bound|var_no_alarm);
+	VAR_Update(&FC.Shrinkage, 1.0, CALC_UNIT);
+
 	//////////////////////////////////////
    	/// Oil Density @ Process Temperature - 865.443
 	//////////////////////////////////////
@@ -1349,45 +1365,119 @@ void setDemoValues(void)
 	for (i=0;i<4;i++) REG_MODEL_CODE[i] = model_code_int[i];
 }
 
-double Round_N(double v, int n)
-{ /// Round_N to the nth decimal place
-    double a, ai;
+/// exact powers of ten for the rounding helpers below
+static const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+	1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
 
-    if (n>6) return v;
-    else if (n<0) return v;
+/// 1e-8 .. 1e8, for finding the decade of a value without log10()
+static const double DECADE[] = {
+	1e-8, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1e0,
+	1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8
+};
+
+#define ROUND_INT_MAX	9.0e15	// beyond this a double has no fraction left to round
 
-    a = v*pow(10.0, (double)(n+1));
+/// modf() integer part for the range we round in, -0 included
+static inline double intPart(double a)
+{
+	if ((a >= ROUND_INT_MAX) || (a <= -ROUND_INT_MAX)) return a;
 
-    if(v<0.0) a -= 5.0;
-    else a += 5.0;
+	return (a < 0.0) ? -(double)(long long)(-a) : (double)(long long)a;
+}
 
-    a /= 10.0;
-    modf(a, &ai);
+/// half away from zero at the nth decimal; the extra digit absorbs
+/// representation error (0.575 -> 0.58, not 0.57)
+static inline double roundN(double v, int n)
+{
+	double a;
+
+	a = v*POW10[n+1];
 
-    return ai/pow(10.0, (double)n);
+	if(v<0.0) a -= 5.0;
+	else a += 5.0;
+
+	return intPart(a/10.0)/POW10[n];
 }
 
-float Round_N_Float(float v, int n)
+/// a tie is a value within tol (relative) of k + 0.5: 4 ulps for a double,
+/// half an ulp for a value that came from a float register (2.675f is
+/// 2.6749999), which is exact up to the 6 significant digits a float carries
+#define TIE_DBL		(4.0*DBL_EPSILON)
+#define TIE_FLT		(0.5*FLT_EPSILON)
+
+/// nearest integer to y >= 0, ties to even or up
+static inline double roundHalf(double y, double tol, int even)
+{
+	double r, f;
+
+	if (y >= ROUND_INT_MAX) return y;
+
+	r = intPart(y);
+	f = y - r;
+	tol *= y;
+
+	if (f > 0.5 + tol) return r + 1.0;
+	if (f < 0.5 - tol) return r;
+
+	return (!even || ((long long)r & 1)) ? r + 1.0 : r;
+}
+
+/// half to even at the nth decimal
+static inline double roundNEven(double v, int n, double tol)
+{
+	double a = roundHalf(fabs(v)*POW10[n], tol, 1)/POW10[n];
+
+	return (v<0.0) ? -a : a;
+}
+
+/// smallest power of ten above a (a > 0), i.e. 10^(floor(log10(a))+1)
+static inline double decadeAbove(double a)
+{
+	int i;
+
+	if ((a < DECADE[0]) || (a >= DECADE[16])) return pow(10.0, floor(log10(a))+1.0);
+
+	for (i=1;i<16;i++) if (a < DECADE[i]) break;
+
+	return DECADE[i];
+}
+
+double Round_N(double v, int n)
 { /// Round_N to the nth decimal place
-    double a, ai;
+    if (n>6) return v;
+    else if (n<0) return v;
+
+    return roundN(v, n);
+}
 
+float Round_N_Float(float v, int n)
+{ /// Round_N to the nth decimal place
     if (n>6) return v;
     else if (n<0) return v;
 
-    a = v*pow(10.0, (double)(n+1));
+    return (float)roundN(v, n);
+}
+
+double Round_N_Even(double v, int n)
+{ /// Round_N to the nth decimal place, ties to even (0.125 -> 0.12)
+    if (n>6) return v;
+    else if (n<0) return v;
 
-    if(v<0.0) a -= 5.0;
-    else a += 5.0;
+    return roundNEven(v, n, TIE_DBL);
+}
 
-    a /= 10.0;
-    modf(a, &ai);
+float Round_N_Float_Even(float v, int n)
+{ /// Round_N_Float to the nth decimal place, ties to even
+    if (n>6) return v;
+    else if (n<0) return v;
 
-    return (float)(ai/pow(10.0, (double)n));
+    return (float)roundNEven(v, n, TIE_FLT);
 }
 
 double sigfig(double v, int n)
 {
-	int s;
 	double t;
 	double a;
 
@@ -1395,29 +1485,119 @@ double sigfig(double v, int n)
     else if (n>6) return v;
 	else if(v==0.0) return v;
 
-    if(v<0.0) s = -1;
-    else s = 1;
-
     a = fabs(v);
+    t = decadeAbove(a);
+
+    return (v<0.0) ? -Round_N(a/t, n)*t : Round_N(a/t, n)*t;
+}
+
+double sigfig_Even(double v, int n)
+{ /// sigfig, ties to even
+	double t;
+
+    if(n<1) return v;
+    else if (n>6) return v;
+	else if(v==0.0) return v;
 
-    t = pow(10.0, floor(log10(a))+1.0);
+    t = decadeAbove(fabs(v));
 
-    return (s*Round_N(a/t, n)*t);
+    return roundNEven(v/t, n, TIE_DBL)*t;
 }
 
 double truncate(double v, int n)
 {
-    double a, ai;
+    double a;
 
     if (n>6) return v;
     else if (n<1) return v;
 
-    a = v*pow(10.0, (double)(n+1));
-
+    a = v*POW10[n+1];
     a /= 10.0;
-    modf(a, &ai);
 
-    return (ai/pow(10.0, (double)n));
+    return intPart(a)/POW10[n];
+}
+
+/***************************************************************************
+ * fmtDouble() - "%.<sig>g" for the values we log, without the printf engine
+ * Integer-scaled, trailing zeros stripped. Anything that %g would print in
+ * exponent form (or NaN/INF) still goes through sprintf(). Decimal ties
+ * are found within representation error: fmtDouble() rounds them up
+ * (1.005 -> 1.01 at sig 3), fmtDouble_Even() to even (0.125 -> 0.12 at
+ * sig 2).
+ * @param buf	- at least 24 chars
+ * @param sig	- significant digits, 1..9
+ * @return characters written, not counting the terminator
+ ***************************************************************************/
+static int fmtDec(char* buf, double v, int sig, int even)
+{
+	unsigned long long scaled, ip;
+	double a;
+	int dec, len, k;
+	char tmp[20];
+
+	if (sig < 1) sig = 1;
+	if (sig > 9) sig = 9;
+
+	a = fabs(v);
+
+	if ((v != v) || (a >= POW10[sig]) || ((a < 1e-4) && (a != 0.0)))
+		return sprintf(buf, "%.*g", sig, v);
+
+	/// digits after the point = sig - digits before it
+	dec = sig;
+	for (k=0;(k<sig) && (a >= POW10[k]);k++) dec--;
+	for (k=1;(a != 0.0) && (a < DECADE[8-k]) && (k<=4);k++) dec++;
+
+	scaled = (unsigned long long)roundHalf(a*POW10[dec], TIE_DBL, even);
+
+	/// rounding carried into a new digit (9.9999995 -> 10.00000)
+	if (scaled >= (unsigned long long)POW10[sig])
+	{
+		if (dec == 0) return sprintf(buf, "%.*g", sig, v);
+		dec--;
+		scaled = (unsigned long long)roundHalf(a*POW10[dec], TIE_DBL, even);
+	}
+
+	/// drop trailing fraction zeros
+	while ((dec > 0) && (scaled % 10 == 0))
+	{
+		scaled /= 10;
+		dec--;
+	}
+
+	len = 0;
+	if ((v < 0.0) && (scaled != 0)) buf[len++] = '-';
+
+	ip = scaled / (unsigned long long)POW10[dec];
+	scaled -= ip * (unsigned long long)POW10[dec];
+
+	k = 0;
+	do { tmp[k++] = '0' + (char)(ip % 10); ip /= 10; } while (ip > 0);
+	while (k > 0) buf[len++] = tmp[--k];
+
+	if (dec > 0)
+	{
+		buf[len++] = '.';
+		for (k=dec-1;k>=0;k--)
+		{
+			buf[len+k] = '0' + (char)(scaled % 10);
+			scaled /= 10;
+		}
+		len += dec;
+	}
+
+	buf[len] = '\0';
+	return len;
+}
+
+int fmtDouble(char* buf, double v, int sig)
+{
+	return fmtDec(buf, v, sig, 0);
+}
+
+int fmtDouble_Even(char* buf, double v, int sig)
+{
+	return fmtDec(buf, v, sig, 1);
 }
 
 
@@ -1426,7 +1606,7 @@ disableAllClocksAndTimers(void)
 {
 	Timer_stop(counterTimerHandle);
 
-	Clock_stop(Update_Relays_Clock);
+	Relay_Stop();
 	Clock_stop(Capture_Sample_Clock);
 
     Clock_stop(I2C_DS1340_Write_RTC_Clock);
@@ -1455,7 +1635,7 @@ disableAllClocksAndTimers(void)
 
 void stopClocks(void)
 {
-    Clock_stop(Update_Relays_Clock);
+    Relay_Stop();
     Clock_stop(Capture_Sample_Clock);
 
     // Start counter timer
@@ -1463,10 +1643,12 @@ void stopClocks(void)
 }
 void startClocks(void)
 {
-    Clock_start(Update_Relays_Clock);
     Clock_start(Capture_Sample_Clock);
 
     // Start counter timer
     Timer_start(counterTimerHandle);
+
+    // Relay_Stop() dropped the pending on delay; evaluate now, not at the next Poll()
+    Relay_Notify();
 }
 
@@ -41,7 +41,6 @@
 /*-------------------------------------------------------------------------*/
 
 #define BOOL Uint8
-#define DEMO_MODE
 #define GPIO_PINS_PER_BANK 					32
 #define CSL_TMR_TCR_ENAMODE_LO_ENABLE    	(0x00000001u)
 #define TEST_LED1							98
@@ -136,20 +135,15 @@
 //////////////////////////////////////////////////////////
 
 
-_EXTERN unsigned int cycles;             		    /*phase hold over RS*/
-_EXTERN unsigned int previous_phase;         		/*phase hold over RS*/
-_EXTERN unsigned int phase;                  		/*phase hold over RS*/
-_EXTERN unsigned int phase_rollover_count;   		/*phase hold over RS*/
 _EXTERN int TEMP_STREAM;
-_EXTERN char lcdLine0[MAX_LCD_WIDTH];
-_EXTERN char lcdLine1[MAX_LCD_WIDTH];
+_EXTERN char lcdLine0[MAX_LCD_WIDTH+1];	// a full 16 character line plus its terminator
+_EXTERN char lcdLine1[MAX_LCD_WIDTH+1];
 _EXTERN char globalId[MAX_LCD_WIDTH];
 _EXTERN char globalVal[MAX_LCD_WIDTH];
 _EXTERN char CSV_FILES[MAX_CSV_ARRAY_LENGTH];
 _EXTERN int csvCounter;
 _EXTERN int usbStatus;
 _EXTERN Uint32 counter;
-_EXTERN Uint32 delayTimer;
 _EXTERN BOOL isUpdateDisplay;
 _EXTERN BOOL isWriteRTC;
 _EXTERN BOOL isLogData;
@@ -174,7 +168,12 @@ _EXTERN BOOL isUsbMounted;
 _EXTERN double Round_N (double v, int n);
 _EXTERN float Round_N_Float (float v, int n);
 _EXTERN double sigfig (double v, int n);
+_EXTERN double Round_N_Even (double v, int n);
+_EXTERN float Round_N_Float_Even (float v, int n);
+_EXTERN double sigfig_Even (double v, int n);
 _EXTERN double truncate (double v, int n);
+_EXTERN int fmtDouble (char* buf, double v, int sig);
+_EXTERN int fmtDouble_Even (char* buf, double v, int sig);
 _EXTERN void logData(void);
 _EXTERN void usbhMscDriveOpen(void);
 _EXTERN void resetGlobalVars(void);
@@ -224,7 +223,6 @@ typedef struct
 	_EXTERN Uint32 	 FREQ_PULSE_COUNT_LO;
 	_EXTERN Uint32 	 FREQ_PULSE_COUNT_HI;
 	_EXTERN Uint32 	 FREQ_U_SEC_ELAPSED; 	// microseconds - time elapsed since last frequency pulse reading
-	_EXTERN DATA_BFR DATALOG;
 	
 ////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
@@ -563,6 +561,15 @@ typedef struct
 #pragma DATA_SECTION(REG_OIL_PT,"CFG")
     _EXTERN far double REG_OIL_PT;
 
+#pragma DATA_SECTION(REG_RELAY_HYSTERESIS,"CFG")
+    _EXTERN far double REG_RELAY_HYSTERESIS;
+
+    _EXTERN far double REG_TOT_FLOW;    // gross flow rate written by the master (Totalizer.c)
+    _EXTERN far double REG_TWIN_WC;     // process model: watercut, % (Twin.c)
+    _EXTERN far double REG_TWIN_TEMP;   // process model: temperature, C
+    _EXTERN far double REG_TWIN_SALT;   // process model: salinity, %
+    _EXTERN far double REG_TWIN_DENS;   // process model: density, REG_OIL_DENSITY_AI units
+
 ////////////////////////////////////////////////
 ///// FCT VAR/DOUBLE   /////////////////////////
 ////////////////////////////////////////////////
@@ -751,6 +758,39 @@ typedef struct
 
 #pragma DATA_SECTION(REG_USB_TRY,"CFG")
 	_EXTERN far int REG_USB_TRY;
+
+#pragma DATA_SECTION(REG_ADC_OVERSAMPLE,"CFG")
+	_EXTERN far int REG_ADC_OVERSAMPLE;	// ADC samples averaged per result
+
+#pragma DATA_SECTION(REG_ADC_MEDIAN,"CFG")
+	_EXTERN far int REG_ADC_MEDIAN;		// ADC median window (1 = off)
+
+#pragma DATA_SECTION(REG_ADC_BURST,"CFG")
+	_EXTERN far int REG_ADC_BURST;		// ADC back-to-back conversions per visit
+
+#pragma DATA_SECTION(REG_AO_UPDATE_PERIOD,"CFG")
+	_EXTERN far int REG_AO_UPDATE_PERIOD;	// min ms between DAC writes (0 = every pass)
+
+#pragma DATA_SECTION(REG_AO_VERIFY_CYCLES,"CFG")
+	_EXTERN far int REG_AO_VERIFY_CYCLES;	// DAC readback every N AO passes (0 = never)
+
+#pragma DATA_SECTION(REG_RTC_SYNC_PERIOD,"CFG")
+	_EXTERN far int REG_RTC_SYNC_PERIOD;	// seconds between DS1340 reads
+
+#pragma DATA_SECTION(REG_BOOT_FAST,"CFG")
+	_EXTERN far int REG_BOOT_FAST;			// 1 = Modbus first, I2C bring-up after BIOS_start
+
+#pragma DATA_SECTION(REG_TOT_TIME_BASE,"CFG")
+	_EXTERN far int REG_TOT_TIME_BASE;		// seconds per REG_TOT_FLOW rate unit (3600 = per hour)
+
+#pragma DATA_SECTION(REG_TOT_SAVE_PERIOD,"CFG")
+	_EXTERN far int REG_TOT_SAVE_PERIOD;	// minutes between NAND copies of the totals (0 = day change only)
+
+#pragma DATA_SECTION(REG_FREQ_GATE,"CFG")
+	_EXTERN far int REG_FREQ_GATE;			// ms, reciprocal frequency gate (50 - 5000)
+
+#pragma DATA_SECTION(REG_SIG_SEED,"CFG")
+	_EXTERN far int REG_SIG_SEED;			// noise seed of the scripted process model
  
     _EXTERN far int REG_RTC_SEC;        // RTC read-only: seconds
     _EXTERN far int REG_RTC_MIN;        // RTC read-only: minutes
@@ -764,6 +804,32 @@ typedef struct
     _EXTERN far int REG_RTC_DAY_IN;     // RTC read-only: day
     _EXTERN far int REG_RTC_MON_IN;     // RTC read-only: month
     _EXTERN far int REG_RTC_YR_IN;      // RTC read-only: year
+    _EXTERN far int REG_RTC_MSEC;       // RTC read-only: milliseconds (RtcTime.c)
+    _EXTERN far int REG_RTC_EPOCH;      // RTC read-only: seconds since 1970-01-01 (RtcTime.c)
+    _EXTERN far int REG_BOOT_COUNT;     // warm resets since power-up (BootProfile.c)
+    _EXTERN far int REG_WD_STARVED;     // WD_CTX_* bits that starved before the last reset (Watchdog.c)
+    _EXTERN far int REG_RELAY_EPOCH;    // last relay switch, seconds since 1970-01-01 (Relay.c)
+    _EXTERN far int REG_RELAY_MSEC;     // last relay switch, milliseconds part
+    _EXTERN far int REG_RELAY_COUNT;    // relay switches since boot
+    _EXTERN far int REG_USB_CACHE_HIT;  // USB sector cache hits (usb_fatfs_port_usbmsc.c)
+    _EXTERN far int REG_USB_CACHE_MISS; // USB sector cache misses
+    _EXTERN far int REG_USB_CACHE_FLUSH;// dirty sectors written back to the stick
+    _EXTERN far REGSWI REG_EVENT_PAGE;  // event page shown in REG_EVENT_WIN[], 0 = newest (EventLog.c)
+    _EXTERN far REGSWI REG_EVENT_ERR;   // error bit shown in REG_EVENT_ERR_STAT[]
+    _EXTERN far int REG_EVENT_TOTAL;    // events recorded since boot
+    _EXTERN far int REG_EVENT_WIN[20];  // size = 4 x 5 (EVENT_PAGE_SIZE x EVENT_WORDS)
+    _EXTERN far int REG_EVENT_ERR_STAT[4];
+    _EXTERN far REGSWI REG_CSV_PAGE;    // CSV index page shown in REG_CSV_WIN[] (CsvIndex.c)
+    _EXTERN far int REG_CSV_COUNT;      // CSV files found by the last USB scan
+    _EXTERN far int REG_TWIN_MODE;      // TWIN_MODE_*: sensors replaced by the process model (Twin.c)
+    _EXTERN far int REG_SIG_SEGMENT;    // REG_SIG_SCRIPT[] segment playing, -1 = none (SigGen.c)
+    _EXTERN far int REG_HIST_TIER;      // HIST_T_* of the next history query (History.c)
+    _EXTERN far int REG_HIST_QTY;       // HIST_Q_* of the next history query
+    _EXTERN far int REG_HIST_FROM;      // history query start, seconds since 1970-01-01, 0 = newest page
+    _EXTERN far int REG_HIST_TO;        // history query end, seconds since 1970-01-01, 0 = now
+    _EXTERN far int REG_HIST_START;     // epoch seconds the REG_HIST_WIN[] offsets count from
+    _EXTERN far REGSWI REG_HIST_QUERY;  // write to load REG_HIST_WIN[]
+    _EXTERN far int REG_TOT_INT[50];    // size = 5 x 5 x 2 (TOT_NUM_PERIODS x TOT_NUM_QTY x whole/thousandths, Totalizer.c)
 
 	_EXTERN far int REG_DIAGNOSTICS;	// diagnostics 
 /////////////////////////////////////////////////
@@ -912,6 +978,34 @@ typedef struct
 #pragma DATA_SECTION(STREAM_SAMPLES,"CFG")          // 63887 : size = 2 x 60
     _EXTERN far int STREAM_SAMPLES[SMAX];
 
+    _EXTERN far double REG_ADC_ENOB[3];                 // 64007 : size = 2 x 3 (ADC_NUM_CH)
+
+    _EXTERN far double REG_ADC_RATE[3];                 // 64013 : size = 2 x 3 (ADC_NUM_CH)
+
+    _EXTERN far double REG_BOOT_MS[11];                 // 64019 : size = 2 x 11 (BOOT_NUM_PHASES)
+
+    _EXTERN far double REG_BOOT_PREV_MS[11];            // 64041 : size = 2 x 11 (BOOT_NUM_PHASES)
+
+    _EXTERN far double REG_TOT_RATE[5];                 // 64063 : size = 2 x 5 (TOT_NUM_QTY)
+
+    _EXTERN far double REG_CSV_WIN[24];                 // 64073 : size = 2 x 4 x 6 (CSV_PAGE_SIZE x CSV_WORDS)
+
+    _EXTERN far double REG_TWIN[8];                     // 64121 : size = 2 x 8 (TWIN_WORDS)
+
+    _EXTERN far double REG_SIG_SCRIPT[128];             // 64137 : size = 2 x 16 x 8 (SIG_MAX_SEG x SIG_SEG_WORDS), own NAND blocks
+
+    _EXTERN far double REG_MEM[16];                     // 64393 : size = 2 x 16 (MEM_WORDS)
+
+    _EXTERN far double REG_CURVE[5];                    // 64425 : size = 2 x 5 (CURVE_WORDS)
+
+    _EXTERN far double REG_HIST_WIN[65];                // 64435 : size = 2 x 13 x 5 ((1+HIST_PAGE_SIZE) x HIST_WORDS)
+
+    _EXTERN far double REG_SCHED[96];                   // 64565 : size = 2 x 32 x 3 (SCHED_MAX_OBJ x SCHED_WORDS)
+
+    _EXTERN far double REG_CPU[96];                     // 64757 : size = 2 x 32 x 3 (SCHED_MAX_OBJ x SCHED_CPU_WORDS)
+
+    _EXTERN far double TOT_SAVED[26];                   // not on Modbus : totals + date stamp (TOT_SAVED_WORDS), own NAND blocks
+
 
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
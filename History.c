@@ -0,0 +1,288 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* History.c
+*-------------------------------------------------------------------------
+* Minute/hour/day trend store. See History.h. Hist_Update() is the only
+* writer and runs at the end of Poll() (Swi_Poll). Readers may run in
+* another context, so they copy each bucket with SWIs disabled, and so
+* does Hist_Save() for the whole day tier.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+#include "RtcTime.h"
+#include "Watchdog.h"
+
+#define HISTORY_H
+
+#include "History.h"
+
+#define HIST_TOTAL_SLOTS	(HIST_MINUTE_SLOTS + HIST_HOUR_SLOTS + HIST_DAY_SLOTS)
+#define HIST_SAVE_SIZE		(HIST_DAY_SLOTS * sizeof(HIST_BUCKET))	// the day tier goes to NAND
+
+typedef struct
+{
+	Uint32		period;					// seconds since 1970 / tier span
+	HIST_STAT	q[HIST_NUM_QTY];
+} HIST_BUCKET;
+
+typedef struct
+{
+	Uint32		magic;
+	HIST_BUCKET	bkt[HIST_TOTAL_SLOTS];	// minute, hour, then day tier
+} HIST_RECORD;
+
+/// not initialized by the C runtime - survives a warm reset
+#pragma DATA_SECTION(HIST_REC,"HISTREC")
+static far HIST_RECORD HIST_REC;
+
+/// per tier, HIST_T_* order
+static const Uint32 TIER_BASE[HIST_NUM_TIERS]	= {0, HIST_MINUTE_SLOTS, HIST_MINUTE_SLOTS + HIST_HOUR_SLOTS};
+static const Uint32 TIER_SLOTS[HIST_NUM_TIERS]	= {HIST_MINUTE_SLOTS, HIST_HOUR_SLOTS, HIST_DAY_SLOTS};
+static const Uint32 TIER_SECS[HIST_NUM_TIERS]	= {60, 3600, 86400};
+
+static inline Uint8* saveArea(void)
+{
+	return (Uint8*)&HIST_REC.bkt[TIER_BASE[HIST_T_DAY]];
+}
+
+static inline HIST_BUCKET* bucketOf(Uint16 tier, Uint32 period)
+{
+	return &HIST_REC.bkt[TIER_BASE[tier] + period % TIER_SLOTS[tier]];
+}
+
+static BOOL isStatValid(const HIST_STAT* s)
+{
+	if (s->n == 0) return TRUE;
+
+	return !isnan(s->min) && !isnan(s->max) && !isnan(s->mean) && (s->min <= s->max);
+}
+
+static inline void statAdd(HIST_STAT* s, float x)
+{
+	if (s->n == 0)
+	{
+		s->min	= x;
+		s->max	= x;
+		s->mean	= x;
+		s->n	= 1;
+		return;
+	}
+
+	if (x < s->min) s->min = x;
+	if (x > s->max) s->max = x;
+	s->n++;
+	s->mean += (x - s->mean) / s->n;
+}
+
+/// fold <b> into <a>, mean weighted by the sample counts
+static void statMerge(HIST_STAT* a, const HIST_STAT* b)
+{
+	if (b->n == 0) return;
+
+	if (a->n == 0)
+	{
+		*a = *b;
+		return;
+	}
+
+	if (b->min < a->min) a->min = b->min;
+	if (b->max > a->max) a->max = b->max;
+	a->mean = (float)(((double)a->mean * a->n + (double)b->mean * b->n) / ((double)a->n + b->n));
+	a->n += b->n;
+}
+
+/// statistics of <q> in period <period> of <tier>, n = 0 if there is none
+static void statGet(Uint16 tier, Uint16 q, Uint32 period, HIST_STAT* s)
+{
+	const HIST_BUCKET* b = bucketOf(tier, period);
+	Uint32 key;
+
+	key = Swi_disable();
+	if (b->period == period) *s = b->q[q];
+	else s->n = 0;
+	Swi_restore(key);
+}
+
+void Hist_Init(void)
+{
+	HIST_BUCKET* b;
+	Uint32 i;
+	Uint16 t, q;
+
+	if (HIST_REC.magic != HIST_REC_MAGIC)
+	{
+		memset(&HIST_REC, 0, sizeof(HIST_REC));
+		HIST_REC.magic = HIST_REC_MAGIC;
+
+		/// the RAM lost power; the last hourly copy brings the day tier back
+		Restore_Hist_From_NAND(saveArea(), HIST_SAVE_SIZE);
+	}
+
+	/// drop whatever a reset left half written or the RAM lost
+	for (t=0;t<HIST_NUM_TIERS;t++)
+	{
+		for (i=0;i<TIER_SLOTS[t];i++)
+		{
+			b = &HIST_REC.bkt[TIER_BASE[t] + i];
+
+			for (q=0;q<HIST_NUM_QTY;q++) if (!isStatValid(&b->q[q])) break;
+
+			if ((q < HIST_NUM_QTY) || (b->period % TIER_SLOTS[t] != i))
+				memset(b, 0, sizeof(HIST_BUCKET));
+		}
+	}
+
+	REG_HIST_TIER	= HIST_T_MINUTE;
+	REG_HIST_QTY	= HIST_Q_WATERCUT;
+	REG_HIST_FROM	= 0;
+	REG_HIST_TO		= 0;
+	REG_HIST_START	= 0;
+	REG_HIST_QUERY.val	= 0;
+	REG_HIST_QUERY.swi	= Swi_Hist_Page;
+	memset(REG_HIST_WIN, 0, sizeof(REG_HIST_WIN));
+}
+
+/***************************************************************************
+ * Hist_Update() - add this poll's values to the current buckets
+ * Call at the end of Poll() once the measurements are up to date.
+ ***************************************************************************/
+void Hist_Update(void)
+{
+	HIST_BUCKET* b;
+	double x[HIST_NUM_QTY];
+	BOOL isOk[HIST_NUM_QTY];
+	Uint32 now, period;
+	Uint16 t, q;
+
+	if (REG_RTC_EPOCH <= 0) return; // RTC not read yet
+
+	now = (Uint32)(RTC_Time_Epoch() / 1000);
+
+	x[HIST_Q_WATERCUT]	= REG_WATERCUT.calc_val;
+	x[HIST_Q_TEMP]		= REG_TEMP_USER.calc_val;
+	x[HIST_Q_FREQ]		= REG_FREQ.calc_val;
+	x[HIST_Q_RP]		= REG_OIL_RP;
+	x[HIST_Q_DENSITY]	= REG_OIL_DENSITY.calc_val;
+
+	for (q=0;q<HIST_NUM_QTY;q++) isOk[q] = !isnan(x[q]);
+	if (REG_WATERCUT.STAT & var_NaNum) isOk[HIST_Q_WATERCUT] = FALSE;
+	if (REG_OIL_DENS_CORR_MODE == 0) isOk[HIST_Q_DENSITY] = FALSE;
+
+	for (t=0;t<HIST_NUM_TIERS;t++)
+	{
+		period = now / TIER_SECS[t];
+		b = bucketOf(t, period);
+
+		if (b->period != period)
+		{
+			memset(b, 0, sizeof(HIST_BUCKET));
+			b->period = period;
+
+			if (t == HIST_T_HOUR) Swi_post(Swi_Hist_Save);
+		}
+
+		for (q=0;q<HIST_NUM_QTY;q++) if (isOk[q]) statAdd(&b->q[q], (float)x[q]);
+	}
+}
+
+/***************************************************************************
+ * Hist_Range() - aggregate of <q> over [from, to] in <tier>
+ * @param from, to	- seconds since 1970-01-01; clipped to what the tier holds
+ * @return FALSE if there is no sample in the range
+ ***************************************************************************/
+BOOL Hist_Range(Uint16 tier, Uint16 q, Uint32 from, Uint32 to, HIST_STAT* out)
+{
+	HIST_STAT s;
+	Uint32 p, p0, p1;
+
+	out->n = 0;
+	if ((tier >= HIST_NUM_TIERS) || (q >= HIST_NUM_QTY) || (to < from)) return FALSE;
+
+	p0 = from / TIER_SECS[tier];
+	p1 = to / TIER_SECS[tier];
+	if (p1 - p0 >= TIER_SLOTS[tier]) p0 = p1 - TIER_SLOTS[tier] + 1;
+
+	for (p=p0;p<=p1;p++)
+	{
+		statGet(tier, q, p, &s);
+		statMerge(out, &s);
+	}
+
+	return (out->n > 0);
+}
+
+static void putEntry(double* w, Uint32 offset, const HIST_STAT* s)
+{
+	w[HIST_W_OFFSET]	= offset;
+	w[HIST_W_MIN]		= (s->n > 0) ? s->min : 0;
+	w[HIST_W_MAX]		= (s->n > 0) ? s->max : 0;
+	w[HIST_W_MEAN]		= (s->n > 0) ? s->mean : 0;
+	w[HIST_W_COUNT]		= s->n;
+}
+
+/***************************************************************************
+ * Hist_Page_Load() - Swi_Hist_Page, posted by writes to REG_HIST_QUERY.
+ * Refreshes REG_HIST_WIN[] from REG_HIST_TIER/QTY/FROM/TO.
+ ***************************************************************************/
+void Hist_Page_Load(void)
+{
+	HIST_STAT s;
+	Uint32 now, secs, from, to, p0;
+	Uint16 tier, q;
+	int i;
+
+	memset(REG_HIST_WIN, 0, sizeof(REG_HIST_WIN));
+	REG_HIST_START = 0;
+
+	if ((REG_HIST_TIER < 0) || (REG_HIST_TIER >= HIST_NUM_TIERS)) return;
+	if ((REG_HIST_QTY < 0) || (REG_HIST_QTY >= HIST_NUM_QTY)) return;
+	if (REG_RTC_EPOCH <= 0) return;
+
+	tier = (Uint16)REG_HIST_TIER;
+	q	 = (Uint16)REG_HIST_QTY;
+	secs = TIER_SECS[tier];
+	now	 = (Uint32)(RTC_Time_Epoch() / 1000);
+	to	 = (REG_HIST_TO > 0) ? (Uint32)REG_HIST_TO : now;
+	from = (REG_HIST_FROM > 0) ? (Uint32)REG_HIST_FROM : (to / secs - (HIST_PAGE_SIZE-1)) * secs;
+
+	p0 = from / secs;
+	REG_HIST_START = (int)(p0 * secs);
+
+	Hist_Range(tier, q, from, to, &s);
+	putEntry(&REG_HIST_WIN[0], 0, &s);
+
+	for (i=0;i<HIST_PAGE_SIZE;i++)
+	{
+		statGet(tier, q, p0 + i, &s);
+		putEntry(&REG_HIST_WIN[(i+1)*HIST_WORDS], i * secs, &s);
+	}
+}
+
+/***************************************************************************
+ * Hist_Save() - Swi_Hist_Save, posted by Hist_Update() at every new hour.
+ * Copies the day tier to NAND, from where Hist_Init() restores it after
+ * a power loss.
+ ***************************************************************************/
+void Hist_Save(void)
+{
+	Uint32 key;
+
+	key = Swi_disable();
+	WD_Service();
+	Store_Hist_in_NAND(saveArea(), HIST_SAVE_SIZE);
+	Swi_restore(key);
+}
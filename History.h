@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+
+/*------------------------------------------------------------------------
+* History.h
+*-------------------------------------------------------------------------
+* Trend store for the process values. Every Poll() sample goes into the
+* current minute, hour and day bucket of each quantity. Each bucket keeps
+* the min, max, mean and sample count. The tiers are rings indexed by
+* period number, so a bucket is simply reused when its slot comes round
+* again:
+*
+*	tier	buckets		span		bytes
+*	minute	1440		24 hours	120960
+*	hour	720			30 days		60480
+*	day		366			1 year		30744
+*	total							212184 (HIST_BUCKET is 84 bytes)
+*
+* The store sits in a retained RAM section, like the totalizer. It
+* survives a warm or watchdog reset and is validated bucket by bucket at
+* start-up. A power loss clears it, so at every new hour the day tier is
+* copied to NAND (Swi_Hist_Save, blocks past the variable area) and
+* restored from there on a cold start. The minute and hour tiers start
+* empty after a power loss, and the day tier loses up to an hour. Nothing
+* is recorded until the RTC has been read.
+*
+* Over Modbus, write the tier, quantity and range to REG_HIST_TIER/QTY/
+* FROM/TO, then write REG_HIST_QUERY. REG_HIST_WIN[] then holds the
+* aggregate of the whole range, followed by the HIST_PAGE_SIZE buckets
+* starting at REG_HIST_FROM. FROM = 0 means the newest page. TO = 0 means
+* now. Times are seconds since 1970-01-01. They are 32-bit, so FROM, TO
+* and REG_HIST_START (the start of the first bucket) are LONGINT registers.
+* REG_HIST_WIN[] is float32, so each entry carries its start as an offset
+* from REG_HIST_START, which a page keeps below 2^24.
+*------------------------------------------------------------------------*/
+#ifndef _HISTORY
+#define _HISTORY
+
+#ifdef HISTORY_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+/// quantities
+#define HIST_Q_WATERCUT				0		// REG_WATERCUT
+#define HIST_Q_TEMP					1		// REG_TEMP_USER
+#define HIST_Q_FREQ					2		// REG_FREQ
+#define HIST_Q_RP					3		// REG_OIL_RP
+#define HIST_Q_DENSITY				4		// REG_OIL_DENSITY, only with density correction on
+#define HIST_NUM_QTY				5
+
+/// tiers
+#define HIST_T_MINUTE				0
+#define HIST_T_HOUR					1
+#define HIST_T_DAY					2
+#define HIST_NUM_TIERS				3
+
+#define HIST_MINUTE_SLOTS			1440
+#define HIST_HOUR_SLOTS				720
+#define HIST_DAY_SLOTS				366
+#define HIST_REC_MAGIC				0x48495331	// "HIS1"
+
+/// REG_HIST_WIN[] words of one entry
+#define HIST_W_OFFSET				0		// seconds after REG_HIST_START
+#define HIST_W_MIN					1
+#define HIST_W_MAX					2
+#define HIST_W_MEAN					3
+#define HIST_W_COUNT				4		// samples, 0 = no data
+#define HIST_WORDS					5
+#define HIST_PAGE_SIZE				12		// buckets after the range aggregate
+
+typedef struct
+{
+	float	min;
+	float	max;
+	float	mean;
+	Uint32	n;
+} HIST_STAT;
+
+void Hist_Init(void);
+void Hist_Update(void);
+BOOL Hist_Range(Uint16 tier, Uint16 q, Uint32 from, Uint32 to, HIST_STAT* out);
+void Hist_Page_Load(void);
+void Hist_Save(void);
+
+#undef _EXTERN
+#undef HISTORY_H
+#endif // _HISTORY
@@ -34,6 +34,8 @@
 #include "usb_osal.h"
 #include "Globals.h"
 #include "Menu.h"
+#include "Watchdog.h"
+#include "CsvIndex.h"
 
 #define USB3SS_EN
 #define NANDWIDTH_16
@@ -47,7 +49,9 @@
 #define MAX_DATA_SIZE  		USB_BLOCK_SIZE*400 // 200 KB
 #define MAX_CSV_SIZE   		USB_BLOCK_SIZE*24
 
-extern void TimerWatchdogReactivate(unsigned int baseAddr);
+extern uint32_t g_usbCacheHits;
+extern uint32_t g_usbCacheMisses;
+extern uint32_t g_usbCacheFlushes;
 
 static USB_Handle usb_handle;
 static USB_Params usb_host_params;
@@ -76,6 +80,7 @@ static int USB_RTC_YR = 0;
 void usbHostIntrConfig(USB_Params* usbParams);
 void MSCCallback(uint32_t ulInstance, uint32_t ulEvent, void *pvData);
 void usbCoreIntrHandler(uint32_t* pUsbParam);
+void scanCsvFiles(void);
 
 /*****************************************************************************
 *
@@ -300,6 +305,7 @@ void errorUsb(FRESULT fr)
 void logData(void)
 {
 	static int i = 0;
+	static int len;
 	static char entry[MAX_ENTRY_SIZE];
 	static double LOG_REGS[20];
 
@@ -312,6 +318,14 @@ void logData(void)
 	while (1)
 	{
 		Semaphore_pend(logData_sem, BIOS_WAIT_FOREVER);
+		WD_Checkin(WD_CTX_LOG);
+
+		/// USB directory scan for menu 3.8 (CsvIndex.c)
+		if (isScanCsvFiles)
+		{
+			scanCsvFiles();
+			if (!isLogData) continue;
+		}
 		
    		if (REG_RTC_SEC != prev_sec)
 		{
@@ -362,8 +376,6 @@ void logData(void)
        							f_puts(LOG_HEAD,&logWriteObject);
 
        							f_close(&logWriteObject);
-
-								TimerWatchdogReactivate(CSL_TMR_1_REGS);
 							}	
         				}
 		   			}
@@ -397,15 +409,15 @@ void logData(void)
     			/* get data */	
 				for (i=0;i<20;i++) 
 				{
-					sprintf(entry,"%g,",LOG_REGS[i]);
+					len = fmtDouble(entry,LOG_REGS[i],6);
+					entry[len++] = ',';
+					entry[len] = '\0';
 					strcat(TEMP_BUF,entry);
 				}
 
 				strcat(TEMP_BUF,"\n");
 				strcat(DATA_BUF,TEMP_BUF);
 
-				TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 				if (read_counter > 5)
 				{
 					strcat(DATA_BUF,"\0");
@@ -414,9 +426,12 @@ void logData(void)
 					f_puts(DATA_BUF,&logWriteObject);
    					f_close(&logWriteObject);
 
+					REG_USB_CACHE_HIT = g_usbCacheHits;
+					REG_USB_CACHE_MISS = g_usbCacheMisses;
+					REG_USB_CACHE_FLUSH = g_usbCacheFlushes;
+
     				DATA_BUF[0] = '\0';
 					read_counter = 0;
-					TimerWatchdogReactivate(CSL_TMR_1_REGS);
 				}
 				else read_counter++;
 			}
@@ -425,10 +440,8 @@ void logData(void)
 }
 
 
-void downloadCsv(void)
+static void writeCsv(void)
 {
-	isDownloadCsv = FALSE;
-
 	FRESULT fr;	
 	FIL csvWriteObject;
 	char csvFileName[50] = {0};
@@ -441,7 +454,6 @@ void downloadCsv(void)
 
     fr = f_open(&csvWriteObject, csvFileName, FA_WRITE | FA_CREATE_ALWAYS); 
 	usb_osalDelayMs(1000);
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
 	if (fr != FR_OK) return;
 
 	/* model code */
@@ -453,8 +465,6 @@ void downloadCsv(void)
         lcdModelCode[i*4+0] = (REG_MODEL_CODE[i] >> 0)  & 0xFF;
     }
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// integer
     sprintf(CSV_BUF+strlen(CSV_BUF),"Serial,,201,int,1,RW,1,%d\n",REG_SN_PIPE); 
     sprintf(CSV_BUF+strlen(CSV_BUF),"AO Dampen,,203,int,1,RW,1,%d\n",REG_AO_DAMPEN); 
@@ -470,8 +480,6 @@ void downloadCsv(void)
     sprintf(CSV_BUF+strlen(CSV_BUF),"Density Correction Mode,,231,int,1,RW,1,%d\n",REG_OIL_DENS_CORR_MODE);
     sprintf(CSV_BUF+strlen(CSV_BUF),"Relay Mode,,232,int,1,RW,1,%d\n",REG_RELAY_MODE); 
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// float or double
 	sprintf(CSV_BUF+strlen(CSV_BUF),"Oil Adjust,,15,float,1,RW,1,%015.7f\n",REG_OIL_ADJUST.calc_val);
     sprintf(CSV_BUF+strlen(CSV_BUF),"Temp Adjust,,31,float,1,RW,1,%015.7f\n",REG_TEMP_ADJUST.calc_val);
@@ -509,19 +517,13 @@ void downloadCsv(void)
     sprintf(CSV_BUF+strlen(CSV_BUF),"PDI Freq F0,,783,float,1,RW,1,%015.7f\n",PDI_FREQ_F0);
     sprintf(CSV_BUF+strlen(CSV_BUF),"PDI Freq F1,,785,float,1,RW,1,%015.7f\n",PDI_FREQ_F1);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// extended 60K
     sprintf(CSV_BUF+strlen(CSV_BUF),"Number of Oil Temperature Curves,,60001,float,1,RW,1,%015.7f\n",REG_TEMP_OIL_NUM_CURVES);
     sprintf(CSV_BUF+strlen(CSV_BUF),"Oil Temperature List,,60003,float,1,RW,10,%015.7f,%015.7f,%015.7f,%015.7f,%015.7f,%015.7f,%015.7f,%015.7f,%015.7f,%015.7f\n",REG_TEMPS_OIL[0],REG_TEMPS_OIL[1],REG_TEMPS_OIL[2],REG_TEMPS_OIL[3],REG_TEMPS_OIL[4],REG_TEMPS_OIL[5],REG_TEMPS_OIL[6],REG_TEMPS_OIL[7],REG_TEMPS_OIL[8],REG_TEMPS_OIL[9]);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	for (data_index=0;data_index<10;data_index++)
     sprintf(CSV_BUF+strlen(CSV_BUF),"Oil Curve %d,,%d,float,1,RW,4,%015.7f,%015.7f,%015.7f,%015.7f\n",data_index,60023+data_index*8,REG_COEFFS_TEMP_OIL[data_index][0],REG_COEFFS_TEMP_OIL[data_index][1],REG_COEFFS_TEMP_OIL[data_index][2],REG_COEFFS_TEMP_OIL[data_index][3]);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// long int	
     sprintf(CSV_BUF+strlen(CSV_BUF),"SN - Measurement Section,,301,long,1,RW,1,%d\n",REG_MEASSECTION_SN);
     sprintf(CSV_BUF+strlen(CSV_BUF),"SN - Back Board,,303,long,1,RW,1,%d\n",REG_BACKBOARD_SN);
@@ -532,20 +534,14 @@ void downloadCsv(void)
     sprintf(CSV_BUF+strlen(CSV_BUF),"SN - RF Board,,313,long,1,RW,1,%d\n",REG_RF_SN);
     sprintf(CSV_BUF+strlen(CSV_BUF),"SN - Assembly,,315,long,1,RW,1,%d\n",REG_ASSEMBLY_SN);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// hardware part serial number
 	for (data_index=0;data_index<8;data_index++)
     sprintf(CSV_BUF+strlen(CSV_BUF),"Electronic SN %d,,%d,long,1,RW,1,%d\n",data_index,317+2*data_index,REG_ELECTRONICS_SN[data_index]);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// stream dependent data
 	for (data_index=0;data_index<60;data_index++)
     sprintf(CSV_BUF+strlen(CSV_BUF),"Stream Oil Adjust %d,,%d,float,1,RW,1,%015.7f\n",data_index,63647+2*data_index,STREAM_OIL_ADJUST[data_index]);
 	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
 	/// write
 	fr = f_puts(CSV_BUF,&csvWriteObject);
 	if (fr == EOF)
@@ -562,7 +558,7 @@ void downloadCsv(void)
 	}
 
 	for (i=0;i<1000;i++);
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	WD_Checkin(WD_CTX_JOB);
 
 	/// close file
 	fr = f_close(&csvWriteObject);
@@ -574,65 +570,31 @@ void downloadCsv(void)
 
 	/// set global var true
     isCsvDownloadSuccess = TRUE;
-    
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
     return;
 }
 
 
-void scanCsvFiles(void)
+/// Swi_downloadCsv, and the firmware upgrade before it replaces the image
+void downloadCsv(void)
 {
-	isScanCsvFiles = FALSE;
+	isDownloadCsv = FALSE;
 
-	FRESULT fr;
-	int i;
-    static DIR dir;
-    static FILINFO fno;
-	const char path[] = "0:";
-	csvCounter = 0;
-	CSV_FILES[0] = '\0';
+	WD_Job_Begin();
+	writeCsv();
+	WD_Job_End();
+}
 
-	/// disable all interrupts
-	Swi_disable();
-	usb_osalDelayMs(10);
 
-	/// opendir
-	if (f_opendir(&dir, path) != FR_OK) 
+/// logData_task, on Csv_Index_Request() - SWIs stay enabled, the walk is sliced
+void scanCsvFiles(void)
+{
+	CSV_FILES[0] = '\0';
+
+	while (!Csv_Index_Step())
 	{
-		Swi_enable();
-		return;
+		WD_Checkin(WD_CTX_LOG);
+		Task_sleep(1);
 	}
-	usb_osalDelayMs(10);
-
-	/// read file names
-    for (;;) {
-        fr = f_readdir(&dir, &fno);
-        if (fr != FR_OK || fno.fname[0] == 0) break;
-        if (fno.fattrib & AM_DIR) {} // directory
-		else // file
-		{ 
-			if (strstr(fno.fname, ".csv") != NULL) 
-			{
-				strcat(CSV_FILES,fno.fname);
-				csvCounter++;
-				isScanSuccess = TRUE;
-			}
-        }
-		
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
-    }
-
-	usb_osalDelayMs(10);
-
-	/// close dir
-	f_closedir(&dir);
-	usb_osalDelayMs(10);
-
-	/// enable all interrupts back
-	Swi_enable();
-	usb_osalDelayMs(10);
-
-    return;
 }
 
 
@@ -650,7 +612,6 @@ void uploadCsv(void)
 	sprintf(csvFileName,"0:%s.csv",CSV_FILES);
 	fr = f_open(&fil, csvFileName, FA_READ);
 	for (i=0;i<1000;i++);
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
 	if (fr != FR_OK) return;
 
 	disableAllClocksAndTimers();
@@ -689,7 +650,6 @@ void uploadCsv(void)
 			memcpy(model_code,buf,MAX_LCD_WIDTH);
             model_code_int = (int*)model_code;
             for (i=0;i<4;i++) REG_MODEL_CODE[i] = model_code_int[i];
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
         }
 		else if ((id>0) && (id<1000)) updateVars(id,value[6]);
 		else if (id==60001) REG_TEMP_OIL_NUM_CURVES = value[6]; 
@@ -700,25 +660,23 @@ void uploadCsv(void)
         /// reset line[]
 		line[0] = '\0';
 		for (i=0;i<1000;i++);
-	    TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	    WD_Service();
 	}	
 	
 	/// close file
 	f_close(&fil);
 	for (i=0;i<1000;i++);
-    TimerWatchdogReactivate(CSL_TMR_1_REGS);
 	Swi_enable();
 
 	/// update FACTORY DEFAULT
    	storeUserDataToFactoryDefault();
 	for (i=0;i<1000;i++);
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
 
 	/// print status -- we use print as an intended "delay"
 	displayLcd("   RESTARTING   ",LCD1);
 
 	/// force to expire watchdog timer
-    while(1); 
+    WD_Restart();
 }
 
 
@@ -745,7 +703,7 @@ void usbhMscDriveOpen(void)
 	
 	for (i=0;i<5;i++)
 	{
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		WD_Service();
 		usb_osalDelayMs(1000);
 	}
 
@@ -759,7 +717,10 @@ void enumerateUsb(void)
 	char dummy[] = "100";
 	isUsbMounted = FALSE;
 	
+	/// Swi_Poll stops with the counter timer; the tasks are blocked by this SWI
+	WD_Job_Begin();
     stopClocks();
+	WD_Stop(WD_CTX_POLL);
 
 	while(i<10) 
 	{
@@ -778,9 +739,11 @@ void enumerateUsb(void)
 		}
 
 		i++;
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		WD_Checkin(WD_CTX_JOB);
 		snprintf(dummy,2,"%d",USB_RTC_SEC);
     }
 
     startClocks();
+	WD_Start(WD_CTX_POLL);
+	WD_Job_End();
 }
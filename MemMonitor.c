@@ -0,0 +1,97 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* MemMonitor.c
+*-------------------------------------------------------------------------
+* Memory high-water marks. See MemMonitor.h.
+*------------------------------------------------------------------------*/
+
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/heaps/HeapBuf.h>
+#include <xdc/runtime/Memory.h>
+#include "Globals.h"
+#include "util.h"
+
+#define MEMMONITOR_H
+
+#include "MemMonitor.h"
+
+static Uint32 lastTick = 0;
+static Uint32 heapFails = 0;
+static BOOL isDue = TRUE;
+
+void Mem_Monitor_Init(void)
+{
+	int i;
+
+	for (i=0;i<MEM_WORDS;i++) REG_MEM[i] = 0;
+
+	lastTick = Clock_getTicks();
+	isDue = TRUE;
+}
+
+/// Error.raiseHook - count heap exhaustion, print nothing
+void Mem_Error_Hook(Error_Block* eb)
+{
+	if (Error_getId(eb) == Error_E_memory) heapFails++;
+}
+
+static void taskStack(Task_Handle task, int word)
+{
+	Task_Stat stat;
+
+	Task_stat(task, &stat);
+
+	REG_MEM[word]	= stat.stackSize;
+	REG_MEM[word+1]	= stat.used;
+}
+
+/***************************************************************************
+ * Mem_Monitor_Idle() - Idle function (PDI_Razor.cfg)
+ ***************************************************************************/
+void Mem_Monitor_Idle(void)
+{
+	Hwi_StackInfo hwi;
+	HeapBuf_ExtendedStats heap;
+	Memory_Stats mem;
+	Uint32 now;
+
+	now = Clock_getTicks();
+	if (!isDue && ((now - lastTick) < (Uint32)MEM_PERIOD_S*(1000000/Clock_tickPeriod))) return;
+	lastTick = now;
+	isDue = FALSE;
+
+	taskStack(Menu_task, MEM_MENU_STACK);
+	taskStack(logData_task, MEM_LOG_STACK);
+	taskStack(Task_getIdleTask(), MEM_IDLE_STACK);
+
+	Hwi_getStackInfo(&hwi, TRUE);
+	REG_MEM[MEM_HWI_STACK]	= hwi.hwiStackSize;
+	REG_MEM[MEM_HWI_PEAK]	= hwi.hwiStackPeak;
+
+	Memory_getStats(HeapBuf_Handle_upCast(sysHeap), &mem);
+	HeapBuf_getExtendedStats(sysHeap, &heap);
+	REG_MEM[MEM_HEAP_SIZE]	= mem.totalSize;
+	REG_MEM[MEM_HEAP_USED]	= (double)heap.numAllocatedBlocks * MEM_HEAP_BLOCK;
+	REG_MEM[MEM_HEAP_PEAK]	= (double)heap.maxAllocatedBlocks * MEM_HEAP_BLOCK;
+	REG_MEM[MEM_HEAP_FAILS]	= heapFails;
+
+	REG_MEM[MEM_BUMP_SIZE]	= UTIL_MEM_SIZE;
+	REG_MEM[MEM_BUMP_USED]	= (Uint32)UTIL_getCurrMemPtr();
+	REG_MEM[MEM_BUMP_PEAK]	= UTIL_getPeakMem();
+	REG_MEM[MEM_BUMP_FAILS]	= UTIL_getMemFails();
+}
@@ -0,0 +1,66 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* MemMonitor.h
+*-------------------------------------------------------------------------
+* Peak and current use of the memory reservations in PDI_Razor.cfg, in
+* bytes, so the stacks and heaps can be sized from measurements:
+*   - task and HWI stacks: SYS/BIOS paints them at creation (initStackFlag)
+*     and the high-water mark is the deepest word no longer holding paint
+*   - sysHeap (HeapBuf): blocks in use now and at most, plus the requests
+*     that failed, counted through Error.raiseHook
+*   - UTIL_allocMem() bump allocator (Common/src/util.c)
+* The stack scan walks the unused part of each stack, so it runs from the
+* Idle task and only every MEM_PERIOD_S seconds. Results go to REG_MEM[].
+*------------------------------------------------------------------------*/
+#ifndef _MEMMONITOR
+#define _MEMMONITOR
+
+#ifdef MEMMONITOR_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define MEM_PERIOD_S				10
+#define MEM_HEAP_BLOCK				512		// heapBufParams.blockSize in PDI_Razor.cfg
+
+/// REG_MEM[] words
+#define MEM_MENU_STACK				0		// Menu_task stack size
+#define MEM_MENU_PEAK				1		// deepest use
+#define MEM_LOG_STACK				2		// logData_task
+#define MEM_LOG_PEAK				3
+#define MEM_IDLE_STACK				4		// Idle task
+#define MEM_IDLE_PEAK				5
+#define MEM_HWI_STACK				6		// system stack, shared by HWIs and SWIs
+#define MEM_HWI_PEAK				7
+#define MEM_HEAP_SIZE				8		// sysHeap
+#define MEM_HEAP_USED				9
+#define MEM_HEAP_PEAK				10
+#define MEM_HEAP_FAILS				11		// failed allocations since boot
+#define MEM_BUMP_SIZE				12		// UTIL_allocMem()
+#define MEM_BUMP_USED				13
+#define MEM_BUMP_PEAK				14
+#define MEM_BUMP_FAILS				15
+#define MEM_WORDS					16
+
+void Mem_Monitor_Init(void);
+void Mem_Monitor_Idle(void);
+void Mem_Error_Hook(Error_Block* eb);
+
+#undef _EXTERN
+#undef MEMMONITOR_H
+#endif // _MEMMONITOR
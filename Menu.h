@@ -52,6 +52,8 @@
 #define LCD_CURS_OFF					0x2 // hide cursor
 #define LCD_CURS_BLINK					0x4 // blink cursor (ONLY if LCD_CURS_ON)
 #define LCD_CURS_NOBLINK				0x8 // don't blink cursor
+#define MAX_MENU_STATE					2999 // largest MNU_/FXN_ state ID (size of the dispatch index)
+#define MENU_INDEX_NONE					0xFF // state has no MENU_TABLE entry
 
 ///////////////////////////////////////////////////////////////////////////////
 /// HOMESCREEN : WaterCut->(VALUE)->Frequency->(VALUE)->...
@@ -88,7 +90,7 @@
 ///											| (VALUE)
 ///				  					 	1.4 Sample
 ///											| (VALUE)
-///										1.5 Average Temp
+///										1.5 History
 ///////////////////////////////////////////////////////////////////////////////
 
 #define MNU_OPERATION_STREAM			11 	// 1.1 Stream
@@ -105,6 +107,8 @@
 #define FXN_OPERATION_SAMPLE_TIMESTAMP	141	// fxnOperation_Sample_Timestamp() 
 #define FXN_OPERATION_SAMPLE_VALUE		142	// fxnOperation_Sample_Value()
 
+#define MNU_OPERATION_HISTORY			15	// 1.5 History
+
 ///////////////////////////////////////////////////////////////////////////////
 /// LEVEL 2: 2.0 Configuration->(STEP)->2.1 Analyzer
 ///											| (VALUE)
@@ -288,6 +292,8 @@
 ///                                    	2.5.3 Parity 
 ///                                    		| (VALUE)
 ///                                    	2.5.4 Statistics
+///                                    		| (VALUE)
+///                                    	2.5.5 CPU Load
 ///////////////////////////////////////////////////////////////////////////////
 
 #define MNU_CFG_COMM_SLAVEADDR				251		// 2.5.1 Slave Addr
@@ -298,6 +304,7 @@
 #define FXN_CFG_COMM_PARITY					2530  	// Node function
 #define MNU_CFG_COMM_STATISTICS				254		// 2.5.4 Statistics
 #define FXN_CFG_COMM_STATISTICS				2540	// Node function
+#define MNU_CFG_COMM_CPULOAD				255		// 2.5.5 CPU Load
 
 ///////////////////////////////////////////////////////////////////////////////
 /// LEVEL 3: 2.6 Relay->(STEP)->2.6.1 Delay
@@ -368,7 +375,7 @@
 #define MNU_CFG_DNSCORR_MANUAL	 	278
 #define FXN_CFG_DNSCORR_MANUAL 		2780
 #define MNU_CFG_DNSCORR_AILRV	 	2781
-#define FXN_CFG_DNSCORR_AILRV 		27810
+#define FXN_CFG_DNSCORR_AILRV 		2782	// keep every state ID <= MAX_MENU_STATE
 #define MNU_CFG_DNSCORR_AIURV	 	279
 #define FXN_CFG_DNSCORR_AIURV 		2790
 #define MNU_CFG_DNSCORR_AI_TRIMLO	280
@@ -414,6 +421,8 @@ _EXTERN Uint16 mnuOperation_Sample(Uint16 input);
 _EXTERN Uint16 fxnOperation_Sample_Stream(Uint16 input);
 _EXTERN Uint16 fxnOperation_Sample_Timestamp(Uint16 input);
 _EXTERN Uint16 fxnOperation_Sample_Value(Uint16 input);
+// MENU 1.5
+_EXTERN Uint16 mnuOperation_History(Uint16 input);
 
 
 // MENU 2.1
@@ -514,6 +523,8 @@ _EXTERN Uint16 fxnConfig_Comm_Parity(Uint16 input);
 // MENU 2.5.4
 _EXTERN Uint16 mnuConfig_Comm_Statistics(Uint16 input);
 _EXTERN Uint16 fxnConfig_Comm_Statistics(Uint16 input);
+// MENU 2.5.5
+_EXTERN Uint16 mnuConfig_Comm_CpuLoad(Uint16 input);
 
 
 // MENU 2.6.1   
@@ -754,6 +765,7 @@ _EXTERN char STREAM[]							= "1.1 Stream";
 _EXTERN char OILADJUST[]						= "1.2 Oil Adjust";
 _EXTERN char OILCAPTURE[]						= "1.3 Oil Capture";
 _EXTERN char SAMPLE[]							= "1.4 Sample";
+_EXTERN char HISTORY[]							= "1.5 History 24h";
 
 _EXTERN char CFG_ANALYZER[]						= "2.1 Analyzer";
 _EXTERN char CFG_AVGTEMP[]						= "2.2 Avg Temp";
@@ -793,6 +805,7 @@ _EXTERN char CFG_COMM_SLAVEADDR[]				= "2.5.1 Slave Addr";
 _EXTERN char CFG_COMM_BAUDRATE[]				= "2.5.2 Baud Rate";
 _EXTERN char CFG_COMM_PARITY[]					= "2.5.3 Parity";
 _EXTERN char CFG_COMM_STATISTICS[]				= "2.5.4 Statistics";
+_EXTERN char CFG_COMM_CPULOAD[]					= "2.5.5 CPU Load";
 
 _EXTERN char CFG_RELAY_DELAY[]					= "2.6.1 Delay";
 _EXTERN char CFG_RELAY_MODE[]					= "2.6.2 Mode";
@@ -919,6 +932,8 @@ _EXTERN MENU_STATE MENU_TABLE[] = {
 {FXN_OPERATION_SAMPLE_STREAM, 99, 99, fxnOperation_Sample_Stream},
 {FXN_OPERATION_SAMPLE_TIMESTAMP, 99, 99, fxnOperation_Sample_Timestamp},
 {FXN_OPERATION_SAMPLE_VALUE, 99, 99, fxnOperation_Sample_Value},
+// MENU 1.5
+{MNU_OPERATION_HISTORY, 99, 99, mnuOperation_History},
 
 
 // MENU 2.1
@@ -1020,6 +1035,8 @@ _EXTERN MENU_STATE MENU_TABLE[] = {
 // MENU 2.5.4  
 {MNU_CFG_COMM_STATISTICS, 99, 99, mnuConfig_Comm_Statistics},
 {FXN_CFG_COMM_STATISTICS, 99, 99, fxnConfig_Comm_Statistics},
+// MENU 2.5.5  
+{MNU_CFG_COMM_CPULOAD, 99, 99, mnuConfig_Comm_CpuLoad},
 
 
 // MENU 2.6.1   
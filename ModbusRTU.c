@@ -27,6 +27,9 @@
 #include "Pinmux.h"
 #include "Globals.h"
 #include "ModbusTables.h"
+#include "Watchdog.h"
+#include "Twin.h"
+#include "EventLog.h"
 #include <ti/csl/cslr_syscfg.h>
 #include <ti/csl/src/ip/syscfg/V0/cslr_syscfg.h>
 
@@ -39,6 +42,8 @@
 #define MAX_FCT_INT    500
 #define MIN_MB_LONGINT 301
 #define MAX_MB_LONGINT 400
+#define MIN_TOT_LONGINT 501	// totalizer, read-only pairs
+#define MAX_TOT_LONGINT 600
 
 extern void delayInt(Uint32 count);
 extern BOOL updateVars(const int id,double val);
@@ -675,6 +680,8 @@ UART_HWI_ISR(void)
 				if (UART_RXBUF.n >= 1) //need at least 8 bytes for valid frame
 					swi_post_needed = TRUE;
 
+				Twin_Mark_MB_Rx();
+
 				break;
 
 			case LINE_STATUS_INT:
@@ -713,7 +720,10 @@ UART_HWI_ISR(void)
 	}
 
 	if (swi_post_needed)
+	{
+		WD_Expect(WD_CTX_MODBUS);
 		Swi_post(Swi_Modbus_RX); //note: needs to be HIGH priority
+	}
 }
 
 /****************************************************************
@@ -777,7 +787,8 @@ Create_MB_Pkt(MODBUS_PACKET_LIST* pkt_list, Uint8 sl, Uint8 fx, Uint16 st, Uint1
 			pkt->byte_order = MB_BYTE_ORDER_DCBA;
 		else if (reg_offset >= 2000)
 			pkt->byte_order = MB_BYTE_ORDER_CDAB;
-        else if ((pkt->start_reg >= MIN_MB_LONGINT) && (pkt->start_reg < MAX_MB_LONGINT))
+        else if (((pkt->start_reg >= MIN_MB_LONGINT) && (pkt->start_reg < MAX_MB_LONGINT))
+            || ((pkt->start_reg >= MIN_TOT_LONGINT) && (pkt->start_reg < MAX_TOT_LONGINT)))
 			pkt->is_longint	= TRUE;
 	}
 
@@ -868,6 +879,8 @@ Modbus_RX(void)
 	MB_PKT* restrict mb_pkt; 				//modbus packet pointer -- points to a packet in the modbus packet list
 	unsigned int* restrict uart_pkt_ptr; 	//UART RX pointer -- points to the head of RXBUF
 
+	WD_Checkin(WD_CTX_MODBUS);
+
 	//disable SWIs
 	key = Hwi_disableInterrupt(5);
 
@@ -974,7 +987,8 @@ Modbus_RX(void)
 				using_longint_offset = FALSE;
 				reg_offset = 0;		// register offset only applies to float table
 			}
-            else if ( (start_reg >= MIN_MB_LONGINT) && (start_reg < MAX_MB_LONGINT) ) //long integer table
+            else if ( ((start_reg >= MIN_MB_LONGINT) && (start_reg < MAX_MB_LONGINT))
+                || ((start_reg >= MIN_TOT_LONGINT) && (start_reg < MAX_TOT_LONGINT)) ) //long integer table
 			{
 				using_longint_offset = TRUE;
 				using_int_offset = FALSE;
@@ -1202,7 +1216,8 @@ Modbus_RX(void)
 				using_longint_offset = FALSE;
 				reg_offset = 0;		// register offset only applies to float table
 			}
-            else if ( (start_reg >= MIN_MB_LONGINT) && (start_reg < MAX_MB_LONGINT) ) // long integer table
+            else if ( ((start_reg >= MIN_MB_LONGINT) && (start_reg < MAX_MB_LONGINT))
+                || ((start_reg >= MIN_TOT_LONGINT) && (start_reg < MAX_TOT_LONGINT)) ) // long integer table
 			{
 				using_longint_offset = TRUE;
 				using_int_offset = FALSE;
@@ -1585,10 +1600,11 @@ void MB_SendPacket_Int16(void)
 		if (data_type == REGTYPE_DBL)
         {
 			*mbtable_ptr_dbl = (double) mbtable_val;	//write to the double
-            if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand);
+            if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand);
         }
 		else if (data_type == REGTYPE_SWI)
 		{
+			mbtable_ptr_rsw = (REGSWI*) mbtable_ptr_dbl;	//get REGSWI* pointer to data
 			mbtable_ptr_rsw->val = (double) mbtable_val;	//write to the double
 
 			// post any REGSWI-related SWI
@@ -1598,7 +1614,7 @@ void MB_SendPacket_Int16(void)
 		{
 			mbtable_ptr_int = (int*) mbtable_ptr_dbl;	//get int* pointer to data
 			*mbtable_ptr_int = mbtable_val;				//write to the integer
-            if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand);
+            if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand);
 		}
 		else if (data_type == REGTYPE_VAR)
 		{
@@ -1607,9 +1623,11 @@ void MB_SendPacket_Int16(void)
 
 			// post any VAR-related SWI "AFTER" VAR_Update()
 			if (mbtable_ptr_var->swi != (Swi_Handle)NULL) Swi_post(mbtable_ptr_var->swi);
-            if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand);
+            if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand);
 		}
 
+		if (prot != REGPERM_VOLATL) Event_Activity(EVENT_MODBUS, mb_pkt_ptr->start_reg, (double) mbtable_val);
+
 		// send starting register -- note: need to use 0-based addressing
 		BfrPut(&UART_TXBUF,(mb_pkt_ptr->start_reg-1) >> 8);		// MSB
 		BfrPut(&UART_TXBUF,(mb_pkt_ptr->start_reg-1) & 0xFF);	// LSB
@@ -1638,6 +1656,16 @@ void MB_SendPacket_Int16(void)
 			rtn = MB_Tbl_Search_IntRegs(start_reg_no_offset+i,&mbtable_ptr_dbl,&data_type,&prot);
 			if ((rtn == 0) && (mbtable_ptr_dbl != (double*)NULL))
 			{
+				if (isNoPermission(prot,MB_WRITE_QRY)) //crosscheck R/W permission of register with lock status
+				{
+					UART_TXBUF.n 	= old_n; //remove everything we just added to the TX buffer
+					UART_TXBUF.tail	= old_tail;
+					MB_SendException(mb_pkt_ptr->slave, mb_pkt_ptr->fxn, MB_EXCEP_BAD_VALUE);
+					Discard_MB_Pkt_Head(&MB_PKT_LIST); //discard the packet at the head of the list
+					Hwi_restoreInterrupt(5,key);
+					return;
+				}
+
 				mbtable_val  = mb_pkt_ptr->data[i*2] << 8; 		//MSB
 				mbtable_val |= mb_pkt_ptr->data[i*2+1] & 0xFF; 	//LSB
 
@@ -1649,6 +1677,7 @@ void MB_SendPacket_Int16(void)
 					*mbtable_ptr_dbl = (double) mbtable_val;		//write to the double
 				else if (data_type == REGTYPE_SWI)
 				{
+					mbtable_ptr_rsw = (REGSWI*) mbtable_ptr_dbl;	//get REGSWI* pointer to data
 					mbtable_ptr_rsw->val = (double) mbtable_val;	//write to the double
 
 					// post any REGSWI-related SWI
@@ -1669,6 +1698,9 @@ void MB_SendPacket_Int16(void)
 					if (mbtable_ptr_var->swi != (Swi_Handle)NULL)
 						Swi_post(mbtable_ptr_var->swi);
 				}
+
+				if (prot != REGPERM_VOLATL) Event_Activity(EVENT_MODBUS, mb_pkt_ptr->start_reg+i, (double) mbtable_val);
+
 				regs_written++;
 			}
 			else
@@ -1893,7 +1925,7 @@ MB_SendPacket_Coil(void)
 			if (mbtable_ptr->val == FALSE) // if the coil is not already set
             {
 				mbtable_ptr->val = TRUE; 		// set the coil
-                if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand);
+                if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand);
             }
 			BfrPut(&UART_TXBUF,0xFF);
 			BfrPut(&UART_TXBUF,0x00);
@@ -1903,7 +1935,7 @@ MB_SendPacket_Coil(void)
 			if (mbtable_ptr->val == TRUE)		// if the coil is not already reset
             {
 				mbtable_ptr->val = FALSE;			// reset the coil
-                if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand);
+                if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand);
             }
 
 			BfrPut(&UART_TXBUF,0x00);
@@ -1921,6 +1953,8 @@ MB_SendPacket_Coil(void)
 			return;
 		}
 
+		if (prot != REGPERM_VOLATL) Event_Activity(EVENT_COIL, mb_pkt_ptr->start_reg, (double) mbtable_ptr->val);
+
 		//post the relevant SWI, if any
 		if (mbtable_ptr->swi != (Swi_Handle)NULL) Swi_post(mbtable_ptr->swi);// post any COIL-related SWI
 
@@ -2107,7 +2141,9 @@ MB_SendPacket_LongInt(void)
 				//		Here we	decide the appropriate way to write to those variables.	*/
 				mbtable_ptr_int = (int*) mbtable_ptr_dbl;		//get int* pointer to data
 				*mbtable_ptr_int = *(int*)&mbtable_val; 		//read in value as SIGNED 32-bit integer
-                if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand); 
+                if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand); 
+
+				if (prot != REGPERM_VOLATL) Event_Activity(EVENT_MODBUS, mb_pkt_ptr->start_reg+(i*2), (double)*(int*)&mbtable_val);
 	
 				regs_written++;
 			}
@@ -2379,10 +2415,11 @@ MB_SendPacket_Float(void)
 				if (data_type == REGTYPE_DBL)
                 {
 					*mbtable_ptr_dbl = (double)*(float*)&mbtable_val;	//read in value at mbtable_val as a float, then cast to double
-                    if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand); 
+                    if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand); 
                 }
 				else if (data_type == REGTYPE_SWI)
 				{
+					mbtable_ptr_rsw = (REGSWI*) mbtable_ptr_dbl;	//get REGSWI* pointer to data
 					mbtable_ptr_rsw->val = (double)*(float*)&mbtable_val;	//read in value at mbtable_val as a float, then cast to double
 
 					// post any REGSWI-related SWI
@@ -2396,25 +2433,28 @@ MB_SendPacket_Float(void)
 					/// Note: 	Writing to an integer variable using the floating point register is permitted but ill-advised
 					/// 		the float->int typecast effectively truncates the value being written
 					*mbtable_ptr_int = (int) *(float*)&mbtable_val;	//read in value as a floating point, then cast to integer
-                    if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand); 
+                    if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand); 
 				}
 				else if (data_type == REGTYPE_LONGINT)
 				{
 					mbtable_ptr_int = (int*) mbtable_ptr_dbl;		//get int* pointer to data
 					*mbtable_ptr_int = *(int*)&mbtable_val; 		//read in value as SIGNED 32-bit integer
-                    if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand); 
+                    if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand); 
 				}
 				else if (data_type == REGTYPE_VAR)
 				{
 					mbtable_ptr_var = (VAR*) mbtable_ptr_dbl;		//get VAR* pointer to data
 					dbl_val = (double) *(float*)&mbtable_val;
 					VAR_Update(mbtable_ptr_var, dbl_val, 0); 		//write to VAR
-                    if (prot != REGPERM_VOLATL) Swi_post(Swi_writeNand); 
+                    if (REGPERM_IS_SAVED(prot)) Swi_post(Swi_writeNand); 
 
 					if (mbtable_ptr_var->swi != (Swi_Handle)NULL)	// post any VAR-related SWI
 						Swi_post(mbtable_ptr_var->swi);
 				}
 
+				if (prot != REGPERM_VOLATL)
+					Event_Activity(EVENT_MODBUS, mb_pkt_ptr->start_reg+(i*2), (data_type == REGTYPE_LONGINT) ? (double)*(int*)&mbtable_val : (double)*(float*)&mbtable_val);
+
 				regs_written++;
 			}
 			else
@@ -2778,6 +2818,7 @@ MB_PacketDone(void)
 	{
 		MB_TX_IN_PROGRESS = FALSE;
 		ctrlGpioPin(9,GPIO_CTRL_SET_OUT_DATA, FALSE, NULL);
+		Twin_Mark_MB_Tx();
 	}
 	else  //if not, keep checking until it is
 		Clock_start(MB_End_Clock);
@@ -2908,7 +2949,7 @@ MB_Tbl_Search_Extended(Uint16 reg_num, double **mbtable_ptr, Uint8 *data_type, U
 
 	//should we use a binary search?
 	//linear search (for now)
-	while (MB_TBL_EXTENDED[i][1] != 0) //null value = end of table
+	while (MB_TBL_EXTENDED[i][2] != 0) //null value = end of table
 	{
 		//	if address is within the address range of the array
 		if ( (reg_num >= MB_TBL_EXTENDED[i][0]) && (reg_num < MB_TBL_EXTENDED[i+1][0]) )
@@ -2923,10 +2964,10 @@ MB_Tbl_Search_Extended(Uint16 reg_num, double **mbtable_ptr, Uint8 *data_type, U
 	if (addr_found)
 	{
 		*data_type 		= REGTYPE_DBL; //THIS TABLE CANNOT PROPERLY HOLD A REGSWI
-		*prot_status 	= REGPERM_PASSWD;
+		*prot_status 	= (Uint8) MB_TBL_EXTENDED[i][1];
 
 		index = (reg_num - MB_TBL_EXTENDED[i][0]) / 2; // extract array index from register address
-		*mbtable_ptr = (double*) (MB_TBL_EXTENDED[i][1]) + index*sizeof(Uint8); // pointer points to the individual element in array
+		*mbtable_ptr = (double*) (MB_TBL_EXTENDED[i][2]) + index*sizeof(Uint8); // pointer points to the individual element in array
 	}
 	else
 	{
@@ -2944,7 +2985,7 @@ isNoPermission(Uint8 prot, Uint8 isWriteCommand)
 	if (isWriteCommand)
 	{
 			 if (prot == REGPERM_VOLATL) return 0;
-		else if (prot == REGPERM_PASSWD) return (COIL_UNLOCKED.val) ? 0 : 1;
+		else if (prot == REGPERM_PASSWD || prot == REGPERM_PASSWD_VOL) return (COIL_UNLOCKED.val) ? 0 : 1;
         else if (prot == REGPERM_FCT) return (COIL_UNLOCKED_FACTORY_DEFAULT.val && COIL_UNLOCKED.val) ? 0 : 1;
 		else return 1;	
 	}
@@ -3015,7 +3056,7 @@ updateVars(const int id, double val)
 			if (MB_TBL_EXTENDED[i][0] == id)
 			{
 				int* mbtable_ptr;
-				mbtable_ptr = (int*) MB_TBL_EXTENDED[i][1]; 
+				mbtable_ptr = (int*) MB_TBL_EXTENDED[i][2]; 
 				*mbtable_ptr = val;
                 
 				return TRUE;
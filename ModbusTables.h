@@ -11,6 +11,10 @@
 #define	REGPERM_WRITE_O	    3	// No Read permission at all
 #define	REGPERM_FCT	        4	// Locked to protect Factory Default Value
 #define	REGPERM_VOLATL	    5	// Volatile Modbus Register (REG_OIL_DENSITY_MODBUS) 
+#define	REGPERM_PASSWD_VOL  6	// Password like REGPERM_PASSWD, but not saved with the variables (REG_TWIN_*, REG_SIG_SCRIPT)
+
+/// writes to these post Swi_writeNand
+#define REGPERM_IS_SAVED(p) (((p) != REGPERM_VOLATL) && ((p) != REGPERM_PASSWD_VOL))
 
 #define REGTYPE_VAR		    5	// Address of a VAR-type variable
 #define REGTYPE_DBL		    6	// Address of a float-type variable
@@ -138,6 +142,14 @@ const Uint32 MB_TBL_FLOAT[][4] = {
     179 ,   REGTYPE_VAR ,   REGPERM_PASSWD  ,   (Uint32)&REG_OIL_T0,            // T0 for threshold
     181 ,   REGTYPE_VAR ,   REGPERM_PASSWD  ,   (Uint32)&REG_OIL_T1,            // T1 for threshold
     183 ,   REGTYPE_DBL ,   REGPERM_READ_O  ,   (Uint32)&REG_OIL_PT,            // OIL RP THRESHOLD
+    185 ,   REGTYPE_DBL ,   REGPERM_PASSWD  ,   (Uint32)&REG_RELAY_HYSTERESIS,  // watercut relay hysteresis band around the setpoint
+    187 ,   REGTYPE_DBL ,   REGPERM_VOLATL  ,   (Uint32)&REG_TOT_FLOW,          // totalizer: gross flow rate at process conditions
+    189 ,   REGTYPE_VAR ,   REGPERM_PASSWD  ,   (Uint32)&FC.Meter_Factor,       // totalizer: meter factor
+    191 ,   REGTYPE_VAR ,   REGPERM_PASSWD  ,   (Uint32)&FC.Shrinkage,          // totalizer: oil shrinkage factor
+    193 ,   REGTYPE_DBL ,   REGPERM_PASSWD_VOL,   (Uint32)&REG_TWIN_WC,           // process model: watercut
+    195 ,   REGTYPE_DBL ,   REGPERM_PASSWD_VOL,   (Uint32)&REG_TWIN_TEMP,         // process model: temperature
+    197 ,   REGTYPE_DBL ,   REGPERM_PASSWD_VOL,   (Uint32)&REG_TWIN_SALT,         // process model: salinity
+    199 ,   REGTYPE_DBL ,   REGPERM_PASSWD_VOL,   (Uint32)&REG_TWIN_DENS,         // process model: density
 
 	701	, 	REGTYPE_VAR	,	REGPERM_FCT	,	(Uint32)&FCT_SALINITY,			// Salinity
 	703	, 	REGTYPE_VAR	,	REGPERM_FCT	,	(Uint32)&FCT_OIL_ADJUST,		// Oil Adjust
@@ -226,6 +238,30 @@ const Uint32 MB_TBL_FLOAT[][4] = {
     232 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_RELAY_MODE,        // relay mode
     233 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_DIAGNOSTICS,       // diagnostics 
     234 ,   REGTYPE_INT ,   REGPERM_FCT     ,   (Uint32)&REG_USB_TRY,           // MAX_USB_TRY 
+    235 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_ADC_OVERSAMPLE,    // ADC samples averaged per result (1-16)
+    236 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_ADC_MEDIAN,        // ADC median-of-k window (1,3,5)
+    237 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_ADC_BURST,         // ADC back-to-back conversions per visit (1-8)
+    238 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_AO_UPDATE_PERIOD,  // min ms between DAC writes (0 = every pass)
+    239 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_AO_VERIFY_CYCLES,  // DAC readback every N AO passes (0 = never)
+    240 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_RTC_SYNC_PERIOD,   // seconds between DS1340 reads
+    241 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_RTC_MSEC,          // RTC current value, read-only: milliseconds
+    242 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_BOOT_FAST,         // 1 = Modbus first, I2C bring-up deferred
+    243 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_BOOT_COUNT,        // warm resets since power-up, read-only
+    244 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_WD_STARVED,        // contexts that starved the watchdog, read-only
+    245 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_RELAY_MSEC,        // last relay switch, milliseconds part, read-only
+    246 ,   REGTYPE_SWI ,   REGPERM_VOLATL  ,   (Uint32)&REG_EVENT_PAGE,        // event page to load into REG_EVENT_WIN[], 0 = newest
+    247 ,   REGTYPE_SWI ,   REGPERM_VOLATL  ,   (Uint32)&REG_EVENT_ERR,         // error bit to load into REG_EVENT_ERR_STAT[]
+    248 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_TOT_TIME_BASE,     // totalizer: seconds per flow rate unit
+    249 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_TOT_SAVE_PERIOD,   // totalizer: minutes between NAND copies
+    250 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_FREQ_GATE,         // frequency gate, ms (50-5000)
+    251 ,   REGTYPE_SWI ,   REGPERM_VOLATL  ,   (Uint32)&REG_CSV_PAGE,          // USB CSV index page to load into REG_CSV_WIN[]
+    252 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_CSV_COUNT,         // CSV files found by the last USB scan
+    253 ,   REGTYPE_INT ,   REGPERM_PASSWD_VOL,   (Uint32)&REG_TWIN_MODE,         // 1 = run on the process model, 2 = on the script (bench only, password like the script)
+    254 ,   REGTYPE_INT ,   REGPERM_PASSWD  ,   (Uint32)&REG_SIG_SEED,          // process model script: noise seed
+    255 ,   REGTYPE_INT ,   REGPERM_READ_O  ,   (Uint32)&REG_SIG_SEGMENT,       // process model script: segment playing
+    256 ,   REGTYPE_INT ,   REGPERM_VOLATL  ,   (Uint32)&REG_HIST_TIER,         // history query: 0 = minutes, 1 = hours, 2 = days
+    257 ,   REGTYPE_INT ,   REGPERM_VOLATL  ,   (Uint32)&REG_HIST_QTY,          // history query: 0 WC, 1 temp, 2 freq, 3 RP, 4 density
+    260 ,   REGTYPE_SWI ,   REGPERM_VOLATL  ,   (Uint32)&REG_HIST_QUERY,        // history query: write to load REG_HIST_WIN[]
 
     402 ,   REGTYPE_INT ,   REGPERM_FCT     ,   (Uint32)&FCT_AO_DAMPEN,         //
     403 ,   REGTYPE_INT ,   REGPERM_FCT     ,   (Uint32)&FCT_SLAVE_ADDRESS,     //  
@@ -266,6 +302,90 @@ const Uint32 MB_TBL_FLOAT[][4] = {
     327 ,   REGTYPE_LONGINT ,   REGPERM_FCT  ,   (Uint32)&REG_ELECTRONICS_SN[5],     // serial number of electronics[5]
     329 ,   REGTYPE_LONGINT ,   REGPERM_FCT  ,   (Uint32)&REG_ELECTRONICS_SN[6],     // serial number of electronics[6]
     331 ,   REGTYPE_LONGINT ,   REGPERM_FCT  ,   (Uint32)&REG_ELECTRONICS_SN[7],     // serial number of electronics[7]
+    333 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_RTC_EPOCH,          // RTC current value, read-only: seconds since 1970-01-01
+    335 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_USB_CACHE_HIT,      // USB sector cache hits, read-only
+    337 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_USB_CACHE_MISS,     // USB sector cache misses, read-only
+    339 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_USB_CACHE_FLUSH,    // USB sectors written back from the cache, read-only
+    341 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_RELAY_EPOCH,        // last relay switch, read-only: seconds since 1970-01-01
+    343 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_RELAY_COUNT,        // relay switches since boot, read-only
+    345 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_TOTAL,        // events recorded since boot, read-only
+    347 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[0],       // event 0: seq
+    349 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[1],       // event 0: epoch
+    351 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[2],       // event 0: msec
+    353 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[3],       // event 0: kind/code
+    355 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[4],       // event 0: value
+    357 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[5],       // event 1: seq
+    359 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[6],       // event 1: epoch
+    361 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[7],       // event 1: msec
+    363 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[8],       // event 1: kind/code
+    365 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[9],       // event 1: value
+    367 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[10],      // event 2: seq
+    369 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[11],      // event 2: epoch
+    371 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[12],      // event 2: msec
+    373 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[13],      // event 2: kind/code
+    375 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[14],      // event 2: value
+    377 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[15],      // event 3: seq
+    379 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[16],      // event 3: epoch
+    381 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[17],      // event 3: msec
+    383 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[18],      // event 3: kind/code
+    385 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_WIN[19],      // event 3: value
+    387 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_ERR_STAT[0],  // selected error: occurrences
+    389 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_ERR_STAT[1],  // selected error: active seconds
+    391 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_ERR_STAT[2],  // selected error: first epoch
+    393 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_EVENT_ERR_STAT[3],  // selected error: last epoch
+    395 ,   REGTYPE_LONGINT ,   REGPERM_VOLATL  ,   (Uint32)&REG_HIST_FROM,          // history query: start, epoch seconds, 0 = newest page
+    397 ,   REGTYPE_LONGINT ,   REGPERM_VOLATL  ,   (Uint32)&REG_HIST_TO,            // history query: end, epoch seconds, 0 = now
+    399 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_HIST_START,         // history query: start of REG_HIST_WIN[], epoch seconds, read-only
+    501 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[0],         // total lifetime gross: whole units
+    503 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[1],         // total lifetime gross: thousandths
+    505 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[2],         // total lifetime gross oil: whole units
+    507 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[3],         // total lifetime gross oil: thousandths
+    509 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[4],         // total lifetime net oil: whole units
+    511 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[5],         // total lifetime net oil: thousandths
+    513 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[6],         // total lifetime net water: whole units
+    515 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[7],         // total lifetime net water: thousandths
+    517 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[8],         // total lifetime net: whole units
+    519 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[9],         // total lifetime net: thousandths
+    521 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[10],        // total day gross: whole units
+    523 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[11],        // total day gross: thousandths
+    525 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[12],        // total day gross oil: whole units
+    527 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[13],        // total day gross oil: thousandths
+    529 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[14],        // total day net oil: whole units
+    531 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[15],        // total day net oil: thousandths
+    533 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[16],        // total day net water: whole units
+    535 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[17],        // total day net water: thousandths
+    537 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[18],        // total day net: whole units
+    539 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[19],        // total day net: thousandths
+    541 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[20],        // total month gross: whole units
+    543 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[21],        // total month gross: thousandths
+    545 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[22],        // total month gross oil: whole units
+    547 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[23],        // total month gross oil: thousandths
+    549 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[24],        // total month net oil: whole units
+    551 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[25],        // total month net oil: thousandths
+    553 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[26],        // total month net water: whole units
+    555 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[27],        // total month net water: thousandths
+    557 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[28],        // total month net: whole units
+    559 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[29],        // total month net: thousandths
+    561 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[30],        // total previous day gross: whole units
+    563 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[31],        // total previous day gross: thousandths
+    565 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[32],        // total previous day gross oil: whole units
+    567 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[33],        // total previous day gross oil: thousandths
+    569 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[34],        // total previous day net oil: whole units
+    571 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[35],        // total previous day net oil: thousandths
+    573 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[36],        // total previous day net water: whole units
+    575 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[37],        // total previous day net water: thousandths
+    577 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[38],        // total previous day net: whole units
+    579 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[39],        // total previous day net: thousandths
+    581 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[40],        // total previous month gross: whole units
+    583 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[41],        // total previous month gross: thousandths
+    585 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[42],        // total previous month gross oil: whole units
+    587 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[43],        // total previous month gross oil: thousandths
+    589 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[44],        // total previous month net oil: whole units
+    591 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[45],        // total previous month net oil: thousandths
+    593 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[46],        // total previous month net water: whole units
+    595 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[47],        // total previous month net water: thousandths
+    597 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[48],        // total previous month net: whole units
+    599 ,   REGTYPE_LONGINT ,   REGPERM_READ_O  ,   (Uint32)&REG_TOT_INT[49],        // total previous month net: thousandths
 	0	, 	0			, 	0				 , 	0
 };
 
@@ -275,31 +395,44 @@ const Uint32 MB_TBL_FLOAT[][4] = {
 ///			out the rest. [see: MB_Tbl_Search_Extended()]
 ///-----------------------------------------------------------------------------
 /// [60K OFFSET] EXTENDED LARGE ARRAY REGISTERS
-/// Start Register   , Array base address
+/// Start Register   , R/W permission (whole array) , Array base address
 ///-----------------------------------------------------------------------------
-const Uint32 MB_TBL_EXTENDED[][2] = {
+const Uint32 MB_TBL_EXTENDED[][3] = {
 
-       1 , (Uint32)&REG_TEMP_OIL_NUM_CURVES,   // 2*(size = 1)
-       3 , (Uint32)&REG_TEMPS_OIL,             // 2*(size = 10)
-      23 , (Uint32)&REG_COEFFS_TEMP_OIL,       // 2*(size = 4*10)
-     103 , (Uint32)&REG_SALINITY_CURVES,       // 2*(size = 1)  
-     105 , (Uint32)&REG_COEFFS_SALINITY,       // 2*(size = 20)  
-     145 , (Uint32)&REG_WATER_CURVES,          // 2*(size = 1)  
-     147 , (Uint32)&REG_WATER_TEMPS,           // 2*(size = 15)  
-     177 , (Uint32)&REG_COEFFS_TEMP_WATER,     // 2*(size = 4*300)  
-    2577 , (Uint32)&REG_STRING_TAG,            // 1*(size = 8)
-    2585 , (Uint32)&REG_STRING_LONGTAG,        // 1*(size = 32)
-    2617 , (Uint32)&REG_STRING_INITIAL,        // 1*(size = 4)
-    2621 , (Uint32)&REG_STRING_MEAS,           // 1*(size = 2)
-    2623 , (Uint32)&REG_STRING_ASSEMBLY,       // 1*(size = 16)
-    2639 , (Uint32)&REG_STRING_INFO,           // 1*(size = 20)
-    2659 , (Uint32)&REG_STRING_PVNAME,         // 1*(size = 20)
-    2679 , (Uint32)&REG_STRING_PVUNIT,         // 1*(size = 8)
-    2687 , (Uint32)&STREAM_TIMESTAMP,          // 1*(size = 60*16) 
-    3647 , (Uint32)&STREAM_OIL_ADJUST,         // 2*(size = 60) 
-    3767 , (Uint32)&STREAM_WATERCUT_AVG,       // 2*(size = 60) 
-    3887 , (Uint32)&STREAM_SAMPLES,            // 2*(size = 60) 
-    4007 , 0
+       1 , REGPERM_PASSWD  , (Uint32)&REG_TEMP_OIL_NUM_CURVES,   // 2*(size = 1)
+       3 , REGPERM_PASSWD  , (Uint32)&REG_TEMPS_OIL,             // 2*(size = 10)
+      23 , REGPERM_PASSWD  , (Uint32)&REG_COEFFS_TEMP_OIL,       // 2*(size = 4*10)
+     103 , REGPERM_PASSWD  , (Uint32)&REG_SALINITY_CURVES,       // 2*(size = 1)  
+     105 , REGPERM_PASSWD  , (Uint32)&REG_COEFFS_SALINITY,       // 2*(size = 20)  
+     145 , REGPERM_PASSWD  , (Uint32)&REG_WATER_CURVES,          // 2*(size = 1)  
+     147 , REGPERM_PASSWD  , (Uint32)&REG_WATER_TEMPS,           // 2*(size = 15)  
+     177 , REGPERM_PASSWD  , (Uint32)&REG_COEFFS_TEMP_WATER,     // 2*(size = 4*300)  
+    2577 , REGPERM_PASSWD  , (Uint32)&REG_STRING_TAG,            // 1*(size = 8)
+    2585 , REGPERM_PASSWD  , (Uint32)&REG_STRING_LONGTAG,        // 1*(size = 32)
+    2617 , REGPERM_PASSWD  , (Uint32)&REG_STRING_INITIAL,        // 1*(size = 4)
+    2621 , REGPERM_PASSWD  , (Uint32)&REG_STRING_MEAS,           // 1*(size = 2)
+    2623 , REGPERM_PASSWD  , (Uint32)&REG_STRING_ASSEMBLY,       // 1*(size = 16)
+    2639 , REGPERM_PASSWD  , (Uint32)&REG_STRING_INFO,           // 1*(size = 20)
+    2659 , REGPERM_PASSWD  , (Uint32)&REG_STRING_PVNAME,         // 1*(size = 20)
+    2679 , REGPERM_PASSWD  , (Uint32)&REG_STRING_PVUNIT,         // 1*(size = 8)
+    2687 , REGPERM_PASSWD  , (Uint32)&STREAM_TIMESTAMP,          // 1*(size = 60*16) 
+    3647 , REGPERM_PASSWD  , (Uint32)&STREAM_OIL_ADJUST,         // 2*(size = 60) 
+    3767 , REGPERM_PASSWD  , (Uint32)&STREAM_WATERCUT_AVG,       // 2*(size = 60) 
+    3887 , REGPERM_PASSWD  , (Uint32)&STREAM_SAMPLES,            // 2*(size = 60) 
+    4007 , REGPERM_READ_O  , (Uint32)&REG_ADC_ENOB,              // 2*(size = 3) 
+    4013 , REGPERM_READ_O  , (Uint32)&REG_ADC_RATE,              // 2*(size = 3) 
+    4019 , REGPERM_READ_O  , (Uint32)&REG_BOOT_MS,               // 2*(size = 11) 
+    4041 , REGPERM_READ_O  , (Uint32)&REG_BOOT_PREV_MS,          // 2*(size = 11) 
+    4063 , REGPERM_READ_O  , (Uint32)&REG_TOT_RATE,              // 2*(size = 5) 
+    4073 , REGPERM_READ_O  , (Uint32)&REG_CSV_WIN,               // 2*(size = 4*6) 
+    4121 , REGPERM_READ_O  , (Uint32)&REG_TWIN,                  // 2*(size = 8) 
+    4137 , REGPERM_PASSWD_VOL, (Uint32)&REG_SIG_SCRIPT,            // 2*(size = 16*8) 
+    4393 , REGPERM_READ_O  , (Uint32)&REG_MEM,                   // 2*(size = 16) 
+    4425 , REGPERM_READ_O  , (Uint32)&REG_CURVE,                 // 2*(size = 5) 
+    4435 , REGPERM_READ_O  , (Uint32)&REG_HIST_WIN,              // 2*(size = 13*5) 
+    4565 , REGPERM_READ_O  , (Uint32)&REG_SCHED,                 // 2*(size = 32*3) 
+    4757 , REGPERM_READ_O  , (Uint32)&REG_CPU,                   // 2*(size = 32*3) 
+    4949 , 0               , 0
 };
 
 
@@ -315,9 +448,9 @@ const Uint32 MB_TBL_COIL[][4] = {
 	4	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_RELAY[3],				    //unused; hardware not implemented
 	5	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_BEGIN_OIL_CAP,		    //begins oil capture process
 	6	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_UPGRADE_ENABLE,			    //enable USB logging (basic)
-	7	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_LOG_ALARMS,			    //enable USB logging for alarms
-	8	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_LOG_ERRORS,			    //enable USB logging for errors
-	9	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_LOG_ACTIVITY,			    //enable USB logging for configuration changes by user
+	7	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_LOG_ALARMS,			    //enable event logging for alarms
+	8	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_LOG_ERRORS,			    //enable event logging for errors
+	9	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_LOG_ACTIVITY,			    //enable event logging for configuration changes by user
 	10	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_AO_ALARM,				    //??? ask Enrique how this works; unimplemented
 	11	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_PARITY,				    //modbus parity bit enable
 	12	, 	REGTYPE_COIL	,	REGPERM_PASSWD	,	(Uint32)&COIL_WRITE_RTC,			    //initiates write to RTC
@@ -0,0 +1,182 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------
+* Oversample.c
+*-------------------------------------------------------------------------
+* Acquisition filter for the I2C ADC channels. All functions are called
+* from the I2C daisy chain callbacks (Clock SWI context) with SWIs
+* disabled, so the per-channel state needs no further locking.
+*------------------------------------------------------------------------*/
+
+#include <ti/sysbios/knl/Clock.h>
+#include "Globals.h"
+
+#define OVERSAMPLE_H
+
+#include "Oversample.h"
+
+typedef struct
+{
+	double	ring[ADC_MAX_MEDIAN];	// last k raw codes for the median stage
+	Uint8	ringPos;
+	Uint8	ringN;
+	double	acc;					// boxcar decimator sum
+	double	accSq;					// sum of squares, for the noise estimate
+	Uint8	accN;
+	Uint8	burstN;					// conversions taken in the current visit
+	Uint32	lastTick;				// Clock tick of the previous output
+	BOOL	isTicked;
+} ADC_FILTER;
+
+static ADC_FILTER ADC_FLT[ADC_NUM_CH];
+
+static inline Uint8 getOsr(void)
+{
+	if (REG_ADC_OVERSAMPLE < 1) return 1;
+	if (REG_ADC_OVERSAMPLE > ADC_MAX_OSR) return ADC_MAX_OSR;
+	return (Uint8)REG_ADC_OVERSAMPLE;
+}
+
+static inline Uint8 getMedian(void)
+{
+	if (REG_ADC_MEDIAN < 1) return 1;
+	if (REG_ADC_MEDIAN > ADC_MAX_MEDIAN) return ADC_MAX_MEDIAN;
+	return (Uint8)(REG_ADC_MEDIAN | 0x1); // force odd
+}
+
+static inline Uint8 getBurst(void)
+{
+	if (REG_ADC_BURST < 1) return 1;
+	if (REG_ADC_BURST > ADC_MAX_BURST) return ADC_MAX_BURST;
+	return (Uint8)REG_ADC_BURST;
+}
+
+/// median of the <n> newest samples in the ring (n <= ADC_MAX_MEDIAN)
+static double medianOf(const ADC_FILTER* f, Uint8 n)
+{
+	double s[ADC_MAX_MEDIAN];
+	double t;
+	int i, j, pos;
+
+	pos = f->ringPos;
+	for (i=0;i<n;i++)
+	{
+		pos = (pos == 0) ? (ADC_MAX_MEDIAN - 1) : (pos - 1);
+		s[i] = f->ring[pos];
+	}
+
+	// insertion sort - at most 5 elements
+	for (i=1;i<n;i++)
+	{
+		t = s[i];
+		for (j=i-1;(j>=0) && (s[j]>t);j--) s[j+1] = s[j];
+		s[j+1] = t;
+	}
+
+	return s[n/2];
+}
+
+void ADC_Filter_Init(void)
+{
+	int i;
+
+	memset(ADC_FLT, 0, sizeof(ADC_FLT));
+
+	for (i=0;i<ADC_NUM_CH;i++)
+	{
+		REG_ADC_ENOB[i] = 0;
+		REG_ADC_RATE[i] = 0;
+	}
+}
+
+/***************************************************************************
+ * ADC_Filter_Push()
+ * @param ch	- ADC_CH_TEMP, ADC_CH_VREF or ADC_CH_DENS
+ * @param code	- raw ADC code
+ * @param out	- filtered code, written only when TRUE is returned
+ * @return TRUE when the decimator has produced a new result
+ ***************************************************************************/
+BOOL ADC_Filter_Push(Uint8 ch, double code, double* out)
+{
+	ADC_FILTER* f;
+	Uint8 k, osr;
+	Uint32 now;
+	double m, mean, var, q;
+
+	if (ch >= ADC_NUM_CH) return FALSE;
+
+	f = &ADC_FLT[ch];
+	k = getMedian();
+	osr = getOsr();
+
+	/// median-of-k outlier rejection
+	f->ring[f->ringPos] = code;
+	if (++f->ringPos >= ADC_MAX_MEDIAN) f->ringPos = 0;
+	if (f->ringN < ADC_MAX_MEDIAN) f->ringN++;
+
+	m = (k > 1) ? medianOf(f, (f->ringN < k) ? f->ringN : k) : code;
+
+	/// boxcar decimator
+	f->acc   += m;
+	f->accSq += m*m;
+	f->accN++;
+
+	if (f->accN < osr) return FALSE;
+
+	mean = f->acc / f->accN;
+	var  = f->accSq / f->accN - mean*mean;
+	if (var < 0) var = 0;
+
+	/// effective resolution: code noise of the averaged output, but never
+	/// better than the quantization noise of a single code (1/sqrt(12) LSB)
+	q = sqrt(var / f->accN);
+	if (q < 0.288675) q = 0.288675;
+	REG_ADC_ENOB[ch] = log10(ADC_FULL_SCALE / (q * 3.464102)) / log10(2.0);
+
+	/// achieved output rate
+	now = Clock_getTicks();
+	if (f->isTicked && (now != f->lastTick))
+		REG_ADC_RATE[ch] = 1000000.0 / ((double)(now - f->lastTick) * Clock_tickPeriod);
+	f->lastTick = now;
+	f->isTicked = TRUE;
+
+	f->acc   = 0;
+	f->accSq = 0;
+	f->accN  = 0;
+
+	*out = mean;
+	return TRUE;
+}
+
+/***************************************************************************
+ * ADC_Filter_Burst()
+ * Call once per conversion attempt (pass or fail) at the end of a channel
+ * callback.
+ * @return TRUE if the channel should start another conversion right away
+ * 		   rather than handing the bus to the next link of the daisy chain
+ ***************************************************************************/
+BOOL ADC_Filter_Burst(Uint8 ch)
+{
+	ADC_FILTER* f;
+
+	if (ch >= ADC_NUM_CH) return FALSE;
+
+	f = &ADC_FLT[ch];
+
+	if (++f->burstN < getBurst()) return TRUE;
+
+	f->burstN = 0;
+	return FALSE;
+}
@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------
+* Oversample.h
+*-------------------------------------------------------------------------
+* Acquisition filter for the I2C ADC channels (temperature, VREF and
+* density). Every raw ADS1112 code read in the I2C daisy chain callbacks
+* is pushed through a median-of-k outlier rejector and then a boxcar
+* decimator that averages REG_ADC_OVERSAMPLE samples into one result.
+* REG_ADC_BURST lets a channel take several back-to-back conversions per
+* visit of the daisy chain instead of one. The effective resolution and
+* the achieved output rate of each channel are published in REG_ADC_ENOB[]
+* and REG_ADC_RATE[].
+*------------------------------------------------------------------------*/
+#ifndef _OVERSAMPLE
+#define _OVERSAMPLE
+
+#ifdef OVERSAMPLE_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define ADC_CH_TEMP			0
+#define ADC_CH_VREF			1
+#define ADC_CH_DENS			2
+#define ADC_NUM_CH			3
+
+#define ADC_MAX_OSR			16		// max samples averaged into one output
+#define ADC_MAX_MEDIAN		5		// max median window (odd)
+#define ADC_MAX_BURST		8		// max back-to-back conversions per visit
+#define ADC_FULL_SCALE		65536.0	// ADS1112 16-bit
+
+void ADC_Filter_Init(void);
+BOOL ADC_Filter_Push(Uint8 ch, double code, double* out);
+BOOL ADC_Filter_Burst(Uint8 ch);
+
+#undef _EXTERN
+#undef OVERSAMPLE_H
+#endif // _OVERSAMPLE
@@ -162,6 +162,7 @@ void Init_LCD(void);
 void Init_MBVE(void);
 void I2C_SendByte(Uint8 out_byte);
 void displayLcd(const char c[], int line);
+void LCD_invalidateShadow(void);
 void LCD_setcursor(int curs_on, int curs_blink);
 void LCD_setBlinking(int column, int line);
 
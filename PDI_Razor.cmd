@@ -17,10 +17,18 @@ SECTIONS
 	{
 	} > FLASH_BOOT, RUN_START(NANDStart)
 
-	"CFG" > DDR_CFG
+	"CFG" > DDR_CFG, RUN_START(CFG_START), RUN_END(CFG_END)
 
 	"DDR" > DDR
 
+	"BOOTPROF" > DDR, type=NOINIT
+
+	"WDOGREC" > DDR, type=NOINIT
+
+	"TOTREC" > DDR, type=NOINIT
+
+	"HISTREC" > DDR, type=NOINIT
+
 	.ddrram	 :
 	{
 		. += 0x0F000000;
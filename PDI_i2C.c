@@ -42,6 +42,11 @@
 #undef MENU_H
 #include "Globals.h"
 #include "PDI_I2C.h"
+#include "Oversample.h"
+#include "Watchdog.h"
+#include "RtcTime.h"
+#include "EventLog.h"
+#include "Twin.h"
 #include <assert.h>
 #include "Menu.h"
 
@@ -77,7 +82,11 @@
 #define I2C_DENS    	4 
 #define I2C_AO      	5 
 
+#define LCD_NUM_LINES	2
+
 static BOOL isOk = TRUE;
+static char lcdShadow[LCD_NUM_LINES][MAX_LCD_WIDTH];	// copy of what the HD44780 DDRAM currently holds
+static BOOL isLcdShadowValid = FALSE;					// FALSE -> next displayLcd rewrites the whole line
 extern void delayInt(Uint32 count);
 static inline void Pulse_ePin(int read, int write, Uint8 lcd_data);
 static inline void Pulse_ePin_Manual(int read, int write, Uint8 lcd_data);
@@ -334,6 +343,9 @@ int I2C_Recover(void)
 	while(CSL_FEXT(i2cRegs->ICIVR, I2C_ICIVR_INTCODE) != CSL_I2C_ICIVR_INTCODE_NONE);
 	CSL_FINST(i2cRegs->ICMDR,I2C_ICMDR_IRS,ENABLE);  		// bring i2c module out of reset
 
+	// LCD bytes may have been lost while the bus was stuck
+	isLcdShadowValid = FALSE;
+
 	Hwi_restoreInterrupt(6, hwikey);
 	Swi_restore(swikey);
 	return 0;
@@ -358,6 +370,7 @@ void Init_LCD(void)
 	}
 
 	LCD_setcursor(0, 0); //turn off cursor
+	LCD_invalidateShadow(); // DDRAM was just cleared
 	Clock_start(I2C_LCD_Clock);
 	Clock_start(I2C_Start_Pulse_MBVE_Clock);
 	Clock_start(Process_Menu_Clock);
@@ -426,6 +439,7 @@ int LCD_printch(char c, int column, int line)
 
 	//write character to address
 	Pulse_ePin(0,1,c);
+	lcdShadow[line][column] = c;
 
 	return 0;
 }
@@ -462,20 +476,38 @@ void LCD_setBlinking(int column, int line)
 	LCD_setcursor(1,1);
 }
 
+/***************************************************************************
+ * LCD_invalidateShadow()
+ * Forget what we think is on the display so that the next displayLcd()
+ * rewrites every character. Call after anything that may have disturbed
+ * DDRAM behind our back (LCD init, I2C bus recovery).
+ ***************************************************************************/
+void LCD_invalidateShadow(void)
+{
+	isLcdShadowValid = FALSE;
+}
+
 /***************************************************************************
  * displayLcd()
+ * Only the characters that differ from the DDRAM shadow are sent. Each run
+ * of changed characters costs one DDRAM address command followed by the
+ * characters themselves; short gaps of unchanged characters between two runs
+ * are rewritten rather than paying for another address command.
+ *
  * @param c - 		String to print to LCD line. If less than 16
  * 					chars, pad with spaces
  * @param line - 	0=top line 1=bottom line
  ***************************************************************************/
 void displayLcd(const char c[], int line)
 {
-	int i, len;
+	int i, len, first, last;
 	char outstr[MAX_LCD_WIDTH];
+	char *shadow;
 	Uint8 cursor_status;
 	Uint32 key;
 
 	// check bounds
+	if ((line >= LCD_NUM_LINES) || (line < 0)) return;
 	len = strlen(c);
 	if (len > MAX_LCD_WIDTH) len = MAX_LCD_WIDTH;
 	if (len < 1) return;
@@ -488,13 +520,57 @@ void displayLcd(const char c[], int line)
 
 	key = Swi_disable();
 
-	LCD_setaddr(0,line);
+	shadow = lcdShadow[line];
+
+	if (!isLcdShadowValid)
+	{
+		// unknown DDRAM contents -> make both shadow lines mismatch everything
+		for (i=0;i<MAX_LCD_WIDTH;i++)
+		{
+			lcdShadow[0][i] = (char)0xFF;
+			lcdShadow[1][i] = (char)0xFF;
+		}
+		isLcdShadowValid = TRUE;
+	}
+
+	// find the first changed character
+	for (first=0;first<MAX_LCD_WIDTH;first++)
+		if (outstr[first] != shadow[first]) break;
+
+	// nothing changed - leave the bus alone
+	if (first == MAX_LCD_WIDTH)
+	{
+		Swi_restore(key);
+		return;
+	}
 
 	cursor_status = MENU.curStat;
 	if (MENU.curStat & LCD_CURS_ON) LCD_setcursor(0,0);
-		
-	// write line
-	for (i=0;i<MAX_LCD_WIDTH;i++) Pulse_ePin(0,1,outstr[i]);
+
+	/// An address command and a character both cost one Pulse_ePin, so an
+	/// unchanged gap of a single character is just as cheap to rewrite as to
+	/// skip. Anything longer gets a fresh address command.
+	while (first < MAX_LCD_WIDTH)
+	{
+		// extend the run while changed characters are at most one apart
+		last = first;
+		for (i=first+1;i<MAX_LCD_WIDTH;i++)
+		{
+			if (outstr[i] != shadow[i]) last = i;
+			else if (i - last > 1) break;
+		}
+
+		LCD_setaddr(first,line);
+		for (i=first;i<=last;i++)
+		{
+			Pulse_ePin(0,1,outstr[i]);
+			shadow[i] = outstr[i];
+		}
+
+		// find the start of the next run
+		for (first=last+1;first<MAX_LCD_WIDTH;first++)
+			if (outstr[first] != shadow[first]) break;
+	}
 
 	// put cursor back where it was
 	LCD_setaddr(MENU.col,MENU.row);
@@ -1146,6 +1222,9 @@ void I2C_ADC_Read_Temp(void)
 		return;
 	}
 
+	/// the daisy chain starts every round here
+	WD_Checkin(WD_CTX_I2C);
+
 	Uint32 key;
 
 	key = Swi_disable();
@@ -1184,6 +1263,15 @@ void I2C_ADC_Read_Temp(void)
 }
 
 // This function is called after waiting for the ADC conversion. Reads in value.
+/* bench model (Twin.c): ADC code for a modeled reading, clamped to the converter */
+static inline Uint16 twinCode(double code)
+{
+	if (code < 0) code = 0;
+	if (code > 32767) code = 32767;
+
+	return (Uint16)(code + 0.5);
+}
+
 void I2C_ADC_Read_Temp_Callback(void)
 {
 	ctrlGpioPin(TEST_LED1,GPIO_CTRL_SET_OUT_DATA, TRUE, NULL); // LED 1 on DKOH
@@ -1198,8 +1286,6 @@ void I2C_ADC_Read_Temp_Callback(void)
 	Uint32 key;
 	Uint16 temp_val;
 	double temp_dbl;
-	static double temp_prev;
-	static Uint8 tryAgain = 0;
 	Uint8 adc_config;
 	Uint8 isPass = 0;
 
@@ -1241,24 +1327,25 @@ void I2C_ADC_Read_Temp_Callback(void)
 
 	if (isPass)
 	{	
-		temp_dbl = (double)temp_val * 2.048/32768.0; 		// convert from ADC code to voltage
-		temp_dbl = temp_dbl * 2.5;							// account for voltage divider (2.5x)
-		temp_dbl = temp_dbl * 1000.0/12 - 273.15;			// work backward from voltage to current (12.0 kOhm) to K to C
+		/* bench: the RTD reads the process model */
+		if (Twin_Is_Active()) temp_val = twinCode((Twin_Temp() + 273.15) * 12/1000.0 / 2.5 * 32768/2.048);
 
-		/* i2c noise filtering */
-		(temp_prev != temp_dbl) ? (tryAgain++) : (tryAgain = 0);
-		if ((tryAgain > 5) || (temp_prev == 0))
+		/* i2c noise filtering - median + oversampling (Oversample.c) */
+		if (ADC_Filter_Push(ADC_CH_TEMP, (double)temp_val, &temp_dbl))
 		{
+			temp_dbl = temp_dbl * 2.048/32768.0; 				// convert from ADC code to voltage
+			temp_dbl = temp_dbl * 2.5;							// account for voltage divider (2.5x)
+			temp_dbl = temp_dbl * 1000.0/12 - 273.15;			// work backward from voltage to current (12.0 kOhm) to K to C
 			VAR_Update(&REG_TEMPERATURE,temp_dbl,0);
-			temp_prev = temp_dbl;
-			tryAgain = 0;
 		}
 	}
 	else clearI2cSetups();
 
 	setLcdXpandr();
 
-	Clock_start(I2C_ADC_Read_VREF_Clock);
+	/* stay on this channel for the rest of the burst */
+	if (ADC_Filter_Burst(ADC_CH_TEMP)) Clock_start(I2C_ADC_Read_Temp_Clock_Retry);
+	else Clock_start(I2C_ADC_Read_VREF_Clock);
 
 	Swi_restore(key);
 
@@ -1368,15 +1455,23 @@ void I2C_ADC_Read_VREF_Callback(void)
 
 	if (isPass)
 	{
-    	vref_dbl = (double)vref_val * 2.048/32768.0;// convert from ADC code to voltage
-    	vref_dbl = vref_dbl * 2.5; 					// account for voltage divider 2.5
-    	REG_OIL_RP = vref_dbl + (REG_OIL_T1.calc_val * REG_TEMP_USER.calc_val) + REG_OIL_T0.calc_val;
+		/* bench: reflected power of the process model */
+		if (Twin_Is_Active())
+			vref_val = twinCode((Twin_Rp() - REG_OIL_T1.calc_val*REG_TEMP_USER.calc_val - REG_OIL_T0.calc_val) / 2.5 / 2.048 * 32768);
+
+		if (ADC_Filter_Push(ADC_CH_VREF, (double)vref_val, &vref_dbl))
+		{
+    		vref_dbl = vref_dbl * 2.048/32768.0;		// convert from ADC code to voltage
+    		vref_dbl = vref_dbl * 2.5; 					// account for voltage divider 2.5
+    		REG_OIL_RP = vref_dbl + (REG_OIL_T1.calc_val * REG_TEMP_USER.calc_val) + REG_OIL_T0.calc_val;
+		}
 	}
 	else clearI2cSetups();
 
 	setLcdXpandr();
 
-	Clock_start(I2C_DS1340_Read_RTC_Clock);
+	if (ADC_Filter_Burst(ADC_CH_VREF)) Clock_start(I2C_ADC_Read_VREF_Clock_Retry);
+	else Clock_start(I2C_DS1340_Read_RTC_Clock);
 
     Swi_restore(key);
 
@@ -1400,31 +1495,31 @@ void I2C_DS1340_Read_RTC(void)
 
 	key = Swi_disable();
 
-    if (isOk)
+    /// only talk to the DS1340 when the cached time is due for discipline (RtcTime.c)
+    if (isOk && RTC_Time_IsSyncDue())
     {
         isOk = FALSE;
 
         tmp_sec = Hex2Bcd(I2C_DS1340_Read(0x00)&0x7F);   
-     	if ((tmp_sec != REG_RTC_SEC) && (tmp_sec > -1) && (tmp_sec < 60)) REG_RTC_SEC = tmp_sec;
-
        	tmp_min = Hex2Bcd(I2C_DS1340_Read(0x01)&0x7F);
-       	if ((tmp_min != REG_RTC_MIN) && (tmp_min > -1) && (tmp_min < 60)) REG_RTC_MIN = tmp_min;
-
        	tmp_hr  = Hex2Bcd(I2C_DS1340_Read(0x02)&0x3F);   
-       	if ((tmp_hr != REG_RTC_HR) && (tmp_hr > -1) && (tmp_hr < 24)) REG_RTC_HR = tmp_hr;
-
        	tmp_day = Hex2Bcd(I2C_DS1340_Read(0x04)&0x3F);   
-       	if ((tmp_day != REG_RTC_DAY) && (tmp_day > 0) && (tmp_day < 32)) REG_RTC_DAY = tmp_day;
-
        	tmp_mon = Hex2Bcd(I2C_DS1340_Read(0x05)&0x1F);   
-       	if ((tmp_mon != REG_RTC_MON) && (tmp_mon > 0) && (tmp_mon < 13)) REG_RTC_MON = tmp_mon;
-
        	tmp_yr  = Hex2Bcd(I2C_DS1340_Read(0x06)&0xFF);
-       	if ((tmp_yr != REG_RTC_YR) && (tmp_yr > -1) && (tmp_yr < 100)) REG_RTC_YR = tmp_yr;
+
+        /// a bad field means a bad read - try again on the next pass
+     	if ((tmp_sec > -1) && (tmp_sec < 60) && (tmp_min > -1) && (tmp_min < 60) && 
+            (tmp_hr > -1) && (tmp_hr < 24) && (tmp_day > 0) && (tmp_day < 32) && 
+            (tmp_mon > 0) && (tmp_mon < 13) && (tmp_yr > -1) && (tmp_yr < 100))
+        {
+            RTC_Time_Sync(tmp_sec, tmp_min, tmp_hr, tmp_day, tmp_mon, tmp_yr);
+        }
 
         isOk = TRUE;
     }
 
+    RTC_Time_Fields();
+
 	setLcdXpandr();
 
 	Clock_start(I2C_ADC_Read_Density_Clock);
@@ -1599,10 +1694,18 @@ void I2C_ADC_Read_Density_Callback(void)
 
 	if (isPass)
 	{
+		/* bench: loop current of the model density, back through the AI trim and range */
+		if (Twin_Is_Active() && (REG_OIL_DENSITY_AI_URV.calc_val != REG_OIL_DENSITY_AI_LRV.calc_val))
+		{
+			double ma = (Twin_Density()-REG_OIL_DENSITY_AI_LRV.calc_val)*(REG_AI_TRIMHI-REG_AI_TRIMLO)
+						/(REG_OIL_DENSITY_AI_URV.calc_val-REG_OIL_DENSITY_AI_LRV.calc_val) + REG_AI_TRIMLO;
+			vref_val = twinCode(ma*R_AI/1000.0/VREF*(-1*MIN_CODE*PGA)/ADS1112_VREF);
+		}
+
 		// is analog input mode?
-		if (REG_OIL_DENS_CORR_MODE == 1)  		
+		if ((REG_OIL_DENS_CORR_MODE == 1) && ADC_Filter_Push(ADC_CH_DENS, (double)vref_val, &vref_dbl))
 		{
-			vref_dbl = ((double)vref_val*ADS1112_VREF)/(-1*MIN_CODE*PGA); 	// convert from ADC code to voltage
+			vref_dbl = (vref_dbl*ADS1112_VREF)/(-1*MIN_CODE*PGA); 			// convert from ADC code to voltage
    	 		vref_dbl = vref_dbl*VREF; 							 		 	// account for voltage divider
 			REG_AI_MEASURE = vref_dbl*(1000.0/R_AI);			 			// work backward from voltage to current (R = 90.9 Kohm)
 
@@ -1622,7 +1725,8 @@ void I2C_ADC_Read_Density_Callback(void)
 
 	setLcdXpandr();
 
-	if (isWriteRTC) Clock_start(I2C_DS1340_Write_RTC_Clock);
+	if ((REG_OIL_DENS_CORR_MODE == 1) && ADC_Filter_Burst(ADC_CH_DENS)) Clock_start(I2C_ADC_Read_Density_Clock_Retry);
+	else if (isWriteRTC) Clock_start(I2C_DS1340_Write_RTC_Clock);
 	else Clock_start(I2C_Update_AO_Clock);
 
     Swi_restore(key);
@@ -1649,6 +1753,9 @@ void I2C_DS1340_Write_RTC(void)
     I2C_DS1340_Write(0x03,REG_RTC_DAY_IN);
     I2C_DS1340_Write(0x00,REG_RTC_MIN_IN);
 
+    /// the next read steps the cached time to the new setting
+    RTC_Time_Invalidate();
+
 	setLcdXpandr();
 
 	Clock_start(I2C_Update_AO_Clock);
@@ -1716,6 +1823,14 @@ void I2C_DS1340_Write(int RTC_ADDR, int RTC_DATA)
 }
 
 
+/***************************************************************************
+ * I2C_Update_AO()
+ * The DAC is only written when the output code has actually changed, and
+ * no more often than REG_AO_UPDATE_PERIOD ms. Every REG_AO_VERIFY_CYCLES
+ * visits the DAC is read back; a mismatch raises ERR_AO_RBK and forces a
+ * rewrite on the next visit. A visit with nothing to do leaves the bus to
+ * the LCD and goes straight on to the next link of the daisy chain.
+ ***************************************************************************/
 void I2C_Update_AO(void)
 {
 	ctrlGpioPin(TEST_LED1,GPIO_CTRL_SET_OUT_DATA, FALSE, NULL); // LED 1 on DKOH
@@ -1732,14 +1847,15 @@ void I2C_Update_AO(void)
     long double dmin;
     Uint32 out_data;
     Uint32 key;
+    Uint32 now;
     Uint16 in_val;
     Uint16 ctrl_byte;
     Uint8 isPass = 0;
-
-    I2C_START_CLR;
-    I2C_STOP_SET;
-    I2C_Wait_For_Stop();
-    key = Swi_disable();
+    Uint8 isWrite, isVerify;
+    static Uint32 aoCode = 0;           // last code written to the DAC
+    static Uint32 aoWriteTick = 0;      // Clock tick of the last DAC write
+    static Uint16 aoVerifyCount = 0;    // visits since the last readback
+    static BOOL isAoWritten = FALSE;    // FALSE -> DAC content unknown, must write
 
     // is trimming mode?
     if (COIL_AO_TRIM_MODE.val)
@@ -1788,6 +1904,33 @@ void I2C_Update_AO(void)
 	/* menu 2.4 lcd screen */
 	REG_AO_OUTPUT = 16*percent_val + 4;
 
+    /* change detection at the DAC code level, rate limited */
+    now = Clock_getTicks();
+    isWrite = (!isAoWritten || (out_data != aoCode));
+    if (isWrite && isAoWritten && (REG_AO_UPDATE_PERIOD > 0))
+    {
+        if ((now - aoWriteTick) < ((Uint32)REG_AO_UPDATE_PERIOD*1000/Clock_tickPeriod)) isWrite = FALSE;
+    }
+
+    /* low duty cycle readback */
+    isVerify = FALSE;
+    if (isAoWritten && (REG_AO_VERIFY_CYCLES > 0))
+    {
+        if (++aoVerifyCount >= REG_AO_VERIFY_CYCLES) isVerify = TRUE;
+    }
+
+    /* nothing to do - don't touch the bus */
+    if (!isWrite && !isVerify)
+    {
+        Clock_start(I2C_ADC_Read_Temp_Clock);
+        return;
+    }
+
+    I2C_START_CLR;
+    I2C_STOP_SET;
+    I2C_Wait_For_Stop();
+    key = Swi_disable();
+
     /// set Slave Address ////////////////////////////////////////
     i2cRegs->ICSAR = CSL_FMK(I2C_ICSAR_SADDR,I2C_SLAVE_ADDR_DAC);
     //////////////////////////////////////////////////////////////  
@@ -1806,54 +1949,88 @@ void I2C_Update_AO(void)
         return;
     }
 
-	while(CSL_FEXT(i2cRegs->ICIVR, I2C_ICIVR_INTCODE) != CSL_I2C_ICIVR_INTCODE_NONE); //read ICIVR until it's cleared of all flags
-    I2C_START_SET;  // initiate sequence
-
-    //Note: Nested if-statement used so that we abort the write process at the first sign of failure
-    if (!I2C_Wait_For_Start())
+    if (isWrite)
     {
-        i2cRegs->ICDXR = CSL_FMK(I2C_ICDXR_D,I2C_CTRL_BYTE_WL); // control byte: write&load operation
+	    while(CSL_FEXT(i2cRegs->ICIVR, I2C_ICIVR_INTCODE) != CSL_I2C_ICIVR_INTCODE_NONE); //read ICIVR until it's cleared of all flags
+        I2C_START_SET;  // initiate sequence
 
-        if (!I2C_Wait_For_Ack())
+        //Note: Nested if-statement used so that we abort the write process at the first sign of failure
+        if (!I2C_Wait_For_Start())
         {
-            if (!I2C_Wait_To_Send())
-            {
-                i2cRegs->ICDXR = CSL_FMK(I2C_ICDXR_D, ((out_data >> 8) & 0xFF) ); //MSB
+            i2cRegs->ICDXR = CSL_FMK(I2C_ICDXR_D,I2C_CTRL_BYTE_WL); // control byte: write&load operation
 
-                if (!I2C_Wait_For_Ack())
+            if (!I2C_Wait_For_Ack())
+            {
+                if (!I2C_Wait_To_Send())
                 {
-                    I2C_Wait_To_Send();
-                    i2cRegs->ICDXR = CSL_FMK(I2C_ICDXR_D, (out_data & 0xFF)); //LSB
-					isPass = 1;
+                    i2cRegs->ICDXR = CSL_FMK(I2C_ICDXR_D, ((out_data >> 8) & 0xFF) ); //MSB
+
+                    if (!I2C_Wait_For_Ack())
+                    {
+                        I2C_Wait_To_Send();
+                        i2cRegs->ICDXR = CSL_FMK(I2C_ICDXR_D, (out_data & 0xFF)); //LSB
+					    isPass = 1;
+                    }
                 }
             }
         }
+
+        if (isPass)
+        {
+            aoCode = out_data;
+            aoWriteTick = now;
+            isAoWritten = TRUE;
+            Twin_Mark_AO();
+
+            I2C_START_CLR;
+            I2C_STOP_SET;
+            I2C_Wait_For_Stop();
+        }
     }
+    else isPass = 1;
 
-	if (isPass)
+	if (isPass && isVerify)
 	{
-        I2C_START_CLR;
-        I2C_STOP_SET;
-        I2C_Wait_For_Stop();
+        aoVerifyCount = 0;
+        isPass = 0;
 
-        ///////////// Read back the DAC value and control byte (disabled)//////////////
+        ///////////// Read back the DAC value and control byte //////////////
         I2C_RX_MODE;    //put I2C in RX mode
         I2C_CNT_3BYTE;
         CSL_FINST(i2cRegs->ICIMR,I2C_ICIMR_ICRRDY,ENABLE); // ICRRDY interrupt
         while(CSL_FEXT(i2cRegs->ICIVR, I2C_ICIVR_INTCODE) != CSL_I2C_ICIVR_INTCODE_NONE); //read ICIVR until it's cleared of all flags
         I2C_STOP_SET;
         I2C_START_SET;
-        I2C_Wait_For_Start();
-        I2C_Wait_To_Receive();
-        in_val = CSL_FEXT(i2cRegs->ICDRR,I2C_ICDRR_D) << 8; //MSB
-        I2C_Wait_To_Receive();
-        in_val |= CSL_FEXT(i2cRegs->ICDRR,I2C_ICDRR_D);     //LSB
-        I2C_Wait_To_Receive();
-        ctrl_byte = CSL_FEXT(i2cRegs->ICDRR,I2C_ICDRR_D);   //config
+        if (!I2C_Wait_For_Start() && !I2C_Wait_To_Receive())
+        {
+            in_val = CSL_FEXT(i2cRegs->ICDRR,I2C_ICDRR_D) << 8; //MSB
+            if (!I2C_Wait_To_Receive())
+            {
+                in_val |= CSL_FEXT(i2cRegs->ICDRR,I2C_ICDRR_D);     //LSB
+                if (!I2C_Wait_To_Receive())
+                {
+                    ctrl_byte = CSL_FEXT(i2cRegs->ICDRR,I2C_ICDRR_D);   //config
+                    isPass = 1;
+                }
+            }
+        }
         I2C_Wait_For_Stop();
         ////////////////////////////////////////////////////////////////////
+
+        if (isPass)
+        {
+            if (in_val != (Uint16)(aoCode & 0xFFFF))
+            {
+                // DAC doesn't hold what we wrote - flag it, rewrite and recheck on the next visit
+                Event_Diag(ERR_AO_RBK, 0, in_val);
+                isAoWritten = FALSE;
+                aoVerifyCount = REG_AO_VERIFY_CYCLES;
+            }
+            else Event_Diag(0, ERR_AO_RBK, in_val);
+        }
     }
-	else clearI2cSetups();
+
+	if (!isPass) clearI2cSetups();
 
 	setLcdXpandr();
 
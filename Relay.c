@@ -0,0 +1,204 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------
+* Relay.c
+*-------------------------------------------------------------------------
+* Event driven relay engine. See Relay.h. Relay_Notify() is called from
+* SWI and TASK context and Relay_Delay_Expired() from the Clock SWI, so
+* the engine state is guarded with Swi_disable().
+*------------------------------------------------------------------------*/
+
+#include <ti/sysbios/knl/Clock.h>
+#include "Globals.h"
+#include "RtcTime.h"
+#include "Twin.h"
+
+#define RELAY_H
+
+#include "Relay.h"
+
+extern void ctrlGpioPin(uint8_t pinNum, uint8_t ctrlCmd, uint8_t isOn, void *ctrlData);
+
+/// the inputs of the selected mode; the others stay zero
+typedef struct
+{
+	int		mode;
+	int		delay;
+	double	watercut;
+	double	setpoint;
+	double	hysteresis;
+	Uint32	diagnostics;
+	Uint8	isOilPhase;
+	Uint8	isActOil;
+	Uint8	isManual;
+} RELAY_INPUTS;
+
+static RELAY_INPUTS lastIn;
+static BOOL isValid = FALSE;		// FALSE -> the next Relay_Notify() evaluates
+static BOOL isDemand = FALSE;		// relay condition, after hysteresis
+static BOOL isOn = FALSE;			// relay output
+static BOOL isPinKnown = FALSE;		// output written at least once
+static BOOL isDelaying = FALSE;		// Relay_Delay_Clock running
+
+static void readInputs(RELAY_INPUTS* in)
+{
+	memset(in, 0, sizeof(*in));
+
+	in->mode = REG_RELAY_MODE;
+	in->delay = REG_RELAY_DELAY;
+	in->isManual = COIL_RELAY_MANUAL.val; // bypasses the delay in every mode
+
+	switch (in->mode)
+	{
+		case RELAY_MODE_WATERCUT :
+			in->watercut = REG_WATERCUT.calc_val;
+			in->setpoint = REG_RELAY_SETPOINT.calc_val;
+			in->hysteresis = REG_RELAY_HYSTERESIS;
+			break;
+		case RELAY_MODE_PHASE :
+			in->isOilPhase = COIL_OIL_PHASE.val;
+			in->isActOil = COIL_ACT_RELAY_OIL.val;
+			break;
+		case RELAY_MODE_ERROR :
+			in->diagnostics = DIAGNOSTICS;
+			break;
+		default :
+			break;
+	}
+}
+
+/// drive the relay pin; caller holds Swi_disable()
+static void setOutput(BOOL on)
+{
+	unsigned long long ms;
+
+	if (isPinKnown && (on == isOn)) return;
+
+	ctrlGpioPin(RELAY_GPIO_PIN, GPIO_CTRL_SET_OUT_DATA, on, NULL);
+
+	if (isPinKnown)
+	{
+		ms = RTC_Time_Epoch();
+		REG_RELAY_EPOCH = (int)(ms / 1000ULL);
+		REG_RELAY_MSEC = (int)(ms % 1000ULL);
+		REG_RELAY_COUNT++;
+		Twin_Mark_Relay();
+	}
+
+	isOn = on;
+	isPinKnown = TRUE;
+}
+
+/// caller holds Swi_disable()
+static void evaluate(const RELAY_INPUTS* in)
+{
+	BOOL demand;
+
+	switch (in->mode)
+	{
+		case RELAY_MODE_WATERCUT :
+			if (in->watercut != in->watercut) demand = FALSE; // NaN
+			else if (in->watercut > in->setpoint) demand = TRUE;
+			else if (in->watercut <= in->setpoint - in->hysteresis) demand = FALSE;
+			else demand = isDemand;	// inside the band - hold
+			break;
+		case RELAY_MODE_PHASE :
+			demand = (in->isActOil) ? in->isOilPhase : !in->isOilPhase;
+			break;
+		case RELAY_MODE_ERROR :
+			demand = (in->diagnostics > 0);
+			break;
+		case RELAY_MODE_MANUAL :
+			demand = in->isManual;
+			break;
+		default :
+			demand = FALSE;
+			break;
+	}
+
+	isDemand = demand;
+	COIL_RELAY[0].val = demand;
+
+	if (!demand)
+	{
+		if (isDelaying) Clock_stop(Relay_Delay_Clock);
+		isDelaying = FALSE;
+		setOutput(FALSE);
+	}
+	else if (!isOn && !isDelaying)
+	{
+		if ((in->delay <= 0) || in->isManual) setOutput(TRUE);
+		else
+		{
+			Clock_setTimeout(Relay_Delay_Clock, (Uint32)in->delay * (1000000 / Clock_tickPeriod));
+			Clock_start(Relay_Delay_Clock);
+			isDelaying = TRUE;
+		}
+	}
+}
+
+void Relay_Init(void)
+{
+	isValid = FALSE;
+	isDemand = FALSE;
+	isOn = FALSE;
+	isPinKnown = FALSE;
+	isDelaying = FALSE;
+	REG_RELAY_EPOCH = 0;
+	REG_RELAY_MSEC = 0;
+	REG_RELAY_COUNT = 0;
+}
+
+void Relay_Notify(void)
+{
+	RELAY_INPUTS in;
+	Uint32 key;
+
+	readInputs(&in);
+
+	key = Swi_disable();
+
+	if (!isValid || (memcmp(&in, &lastIn, sizeof(in)) != 0))
+	{
+		memcpy(&lastIn, &in, sizeof(in));
+		isValid = TRUE;
+		evaluate(&in);
+	}
+
+	Swi_restore(key);
+}
+
+/// Relay_Delay_Clock, Clock SWI context
+void Relay_Delay_Expired(void)
+{
+	Uint32 key;
+
+	key = Swi_disable();
+	isDelaying = FALSE;
+	if (isDemand) setOutput(TRUE);
+	Swi_restore(key);
+}
+
+/// the delay timer is stopped with the other clocks; re-evaluate when they restart
+void Relay_Stop(void)
+{
+	Uint32 key;
+
+	key = Swi_disable();
+	Clock_stop(Relay_Delay_Clock);
+	isDelaying = FALSE;
+	isValid = FALSE;
+	Swi_restore(key);
+}
@@ -0,0 +1,53 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------
+* Relay.h
+*-------------------------------------------------------------------------
+* Event driven relay engine. Relay_Notify() is called whenever the inputs
+* may have changed: at the end of every Poll(), after the watercut, phase
+* and errors are updated, on every DIAGNOSTICS edge (Event_Diag()), when
+* the clocks restart (startClocks()) and by the menu. The relay is
+* re-evaluated only if an input of the selected REG_RELAY_MODE actually
+* changed. The on delay (REG_RELAY_DELAY, seconds) runs on the one-shot
+* Relay_Delay_Clock instead of being counted in polls. Watercut mode
+* switches on above REG_RELAY_SETPOINT and off at or below the setpoint
+* minus REG_RELAY_HYSTERESIS. Every transition of the relay output is
+* timestamped in REG_RELAY_EPOCH/REG_RELAY_MSEC and counted in
+* REG_RELAY_COUNT.
+*------------------------------------------------------------------------*/
+#ifndef _RELAY
+#define _RELAY
+
+#ifdef RELAY_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define RELAY_GPIO_PIN			37
+
+#define RELAY_MODE_WATERCUT		0
+#define RELAY_MODE_PHASE		1
+#define RELAY_MODE_ERROR		2
+#define RELAY_MODE_MANUAL		3
+
+void Relay_Init(void);
+void Relay_Notify(void);
+void Relay_Delay_Expired(void);
+void Relay_Stop(void);
+
+#undef _EXTERN
+#undef RELAY_H
+#endif // _RELAY
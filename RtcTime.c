@@ -0,0 +1,208 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------
+* RtcTime.c
+*-------------------------------------------------------------------------
+* Cached time service on top of the DS1340 RTC. See RtcTime.h.
+* Callable from SWI and TASK context (not HWI); the 64-bit state is
+* guarded with Swi_disable().
+*------------------------------------------------------------------------*/
+
+#include <ti/sysbios/knl/Clock.h>
+#include "Globals.h"
+
+#define RTCTIME_H
+
+#include "RtcTime.h"
+
+static Uint32 lastTick = 0;					// Clock_getTicks() at the last extension
+static unsigned long long monoTicks = 0;	// ticks since boot, 64-bit
+static long long epochOffsetMs = 0;			// epoch ms = mono ms + offset
+static unsigned long long lastEpochMs = 0;	// never hand out less than this
+static unsigned long long lastSyncMs = 0;	// mono ms of the last RTC read
+static BOOL isSynced = FALSE;				// FALSE -> next RTC read steps the time
+
+/// days since 1970-01-01 for a proleptic Gregorian date
+static long daysFromCivil(int y, int m, int d)
+{
+	long era, yoe, doy, doe;
+
+	y -= (m <= 2);
+	era = (y >= 0 ? y : y-399) / 400;
+	yoe = y - era * 400;
+	doy = (153*(m + (m > 2 ? -3 : 9)) + 2)/5 + d-1;
+	doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+/// inverse of daysFromCivil()
+static void civilFromDays(long z, int* y, int* m, int* d)
+{
+	long era, doe, yoe, doy, mp;
+
+	z += 719468;
+	era = (z >= 0 ? z : z - 146096) / 146097;
+	doe = z - era * 146097;
+	yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+	doy = doe - (365*yoe + yoe/4 - yoe/100);
+	mp  = (5*doy + 2)/153;
+	*d  = (int)(doy - (153*mp+2)/5 + 1);
+	*m  = (int)(mp < 10 ? mp+3 : mp-9);
+	*y  = (int)(yoe + era * 400) + (*m <= 2);
+}
+
+/// extend the 32-bit Clock tick into monoTicks - caller holds Swi_disable()
+static inline unsigned long long monoMs(void)
+{
+	Uint32 now = Clock_getTicks();
+
+	monoTicks += (Uint32)(now - lastTick); // unsigned difference survives the 32-bit wrap
+	lastTick = now;
+
+	return (monoTicks * Clock_tickPeriod) / 1000;
+}
+
+void RTC_Time_Init(void)
+{
+	lastTick		= Clock_getTicks();
+	monoTicks		= 0;
+	epochOffsetMs	= 0;
+	lastEpochMs		= 0;
+	lastSyncMs		= 0;
+	isSynced		= FALSE;
+	REG_RTC_MSEC	= 0;
+	REG_RTC_EPOCH	= 0;
+}
+
+/// the RTC was just written - accept the next reading as-is
+void RTC_Time_Invalidate(void)
+{
+	isSynced = FALSE;
+}
+
+BOOL RTC_Time_IsSyncDue(void)
+{
+	Uint32 key;
+	BOOL isDue;
+	unsigned long long period;
+
+	if (!isSynced) return TRUE;
+
+	period = (REG_RTC_SYNC_PERIOD > 0) ? (unsigned long long)REG_RTC_SYNC_PERIOD*1000 : 0;
+
+	key = Swi_disable();
+	isDue = ((monoMs() - lastSyncMs) >= period);
+	Swi_restore(key);
+
+	return isDue;
+}
+
+/***************************************************************************
+ * RTC_Time_Sync() - discipline the time with a fresh DS1340 reading
+ * The RTC only resolves whole seconds, so the reading says the true time
+ * lies somewhere in [rtc, rtc+999] ms. If our estimate is inside that
+ * window it is left alone; otherwise it is pulled to the nearest edge.
+ ***************************************************************************/
+void RTC_Time_Sync(int sec, int min, int hr, int day, int mon, int yr)
+{
+	Uint32 key;
+	unsigned long long mono;
+	long long rtcMs, estMs, err;
+
+	rtcMs = (long long)daysFromCivil(RTC_BASE_YEAR + yr, mon, day) * 86400000LL
+		  + ((long long)hr*3600 + (long long)min*60 + sec) * 1000LL;
+
+	key = Swi_disable();
+
+	mono  = monoMs();
+	estMs = (long long)mono + epochOffsetMs;
+
+	if (!isSynced)
+	{
+		epochOffsetMs = rtcMs - (long long)mono;
+		lastEpochMs = 0;	// stepping is allowed here
+		isSynced = TRUE;
+	}
+	else
+	{
+		if (estMs < rtcMs) err = rtcMs - estMs;				// running slow
+		else if (estMs > rtcMs + 999) err = rtcMs + 999 - estMs;	// running fast
+		else err = 0;
+
+		if ((err > RTC_STEP_LIMIT_MS) || (err < -RTC_STEP_LIMIT_MS)) lastEpochMs = 0;
+
+		// a negative correction just holds RTC_Time_Epoch() until it catches up
+		epochOffsetMs += err;
+	}
+
+	lastSyncMs = mono;
+
+	Swi_restore(key);
+}
+
+/// milliseconds since boot, never adjusted
+unsigned long long RTC_Time_Mono(void)
+{
+	Uint32 key;
+	unsigned long long ms;
+
+	key = Swi_disable();
+	ms = monoMs();
+	Swi_restore(key);
+
+	return ms;
+}
+
+/// disciplined milliseconds since 1970-01-01 00:00:00, monotonic between steps
+unsigned long long RTC_Time_Epoch(void)
+{
+	Uint32 key;
+	long long ms;
+
+	key = Swi_disable();
+
+	ms = (long long)monoMs() + epochOffsetMs;
+	if (ms < 0) ms = 0;
+	if ((unsigned long long)ms < lastEpochMs) ms = (long long)lastEpochMs;
+	lastEpochMs = (unsigned long long)ms;
+
+	Swi_restore(key);
+
+	return (unsigned long long)ms;
+}
+
+/// refresh REG_RTC_* from the disciplined time
+void RTC_Time_Fields(void)
+{
+	unsigned long long ms;
+	long days, secs;
+	int y, m, d;
+
+	if (!isSynced) return; // keep whatever we had until the first RTC read
+
+	ms   = RTC_Time_Epoch();
+	days = (long)(ms / 86400000ULL);
+	secs = (long)((ms / 1000ULL) % 86400ULL);
+	civilFromDays(days, &y, &m, &d);
+
+	REG_RTC_MSEC  = (int)(ms % 1000ULL);
+	REG_RTC_EPOCH = (int)(ms / 1000ULL);
+	REG_RTC_SEC   = secs % 60;
+	REG_RTC_MIN   = (secs / 60) % 60;
+	REG_RTC_HR    = secs / 3600;
+	REG_RTC_DAY   = d;
+	REG_RTC_MON   = m;
+	REG_RTC_YR    = y - RTC_BASE_YEAR;
+}
@@ -0,0 +1,49 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------
+* RtcTime.h
+*-------------------------------------------------------------------------
+* Cached time service on top of the DS1340 RTC. The RTC is only read over
+* I2C every REG_RTC_SYNC_PERIOD seconds. In between, time is carried
+* forward by a 64-bit monotonic counter extended from the SYS/BIOS Clock
+* tick. Every RTC read disciplines that counter: it is nudged forward if it
+* runs slow and held if it runs fast, so it never goes backwards. The one
+* exception is a deliberate time change (Write_RTC, or an error of more than
+* RTC_STEP_LIMIT_MS), which steps it. The broken-down REG_RTC_* fields,
+* REG_RTC_MSEC and REG_RTC_EPOCH are all derived from the disciplined time.
+*------------------------------------------------------------------------*/
+#ifndef _RTCTIME
+#define _RTCTIME
+
+#ifdef RTCTIME_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+#define RTC_STEP_LIMIT_MS		2000	// errors beyond this are stepped, not slewed
+#define RTC_BASE_YEAR			2000	// DS1340 year register is 00-99
+
+void RTC_Time_Init(void);
+void RTC_Time_Invalidate(void);
+BOOL RTC_Time_IsSyncDue(void);
+void RTC_Time_Sync(int sec, int min, int hr, int day, int mon, int yr);
+void RTC_Time_Fields(void);
+unsigned long long RTC_Time_Mono(void);
+unsigned long long RTC_Time_Epoch(void);
+
+#undef _EXTERN
+#undef RTCTIME_H
+#endif // _RTCTIME
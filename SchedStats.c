@@ -0,0 +1,328 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* SchedStats.c
+*-------------------------------------------------------------------------
+* Hwi/Swi/Task execution statistics. See SchedStats.h. The hooks run on
+* every interrupt, every SWI and every task switch, so they only read the
+* 32-bit timestamp (the CPU cycle counter) and add; the division happens in
+* Sched_Stats_Publish().
+*
+* The 1 s/10 s/60 s loads are running sums over the window history: each
+* Publish adds the new window and takes out the one that just left each
+* span. The history starts zeroed, so the spans fill up from boot without
+* special cases.
+*------------------------------------------------------------------------*/
+
+#include <ti/sysbios/family/c64p/Hwi.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/knl/Task.h>
+#include "Globals.h"
+#include "FreqCapture.h"
+
+#define SCHEDSTATS_H
+
+#include "SchedStats.h"
+
+typedef struct
+{
+	Uint32	runs;
+	Uint32	busy;				// timestamp counts charged in the window
+	Uint32	max;				// longest single run, timestamp counts
+} SCHED_ACC;
+
+typedef struct
+{
+	Uint32	busy[SCHED_NUM_OBJ];
+	Uint32	window;
+} SCHED_WINDOW;
+
+static SCHED_ACC ACC[SCHED_NUM_OBJ];
+static SCHED_WINDOW HIST[SCHED_CPU_SLOTS];	// closed windows, oldest overwritten
+static unsigned long long SUM_BUSY[SCHED_CPU_WORDS][SCHED_NUM_OBJ];
+static unsigned long long SUM_WINDOW[SCHED_CPU_WORDS];
+static Uint32 histPos = 0;
+static SCHED_ACC* stack[SCHED_MAX_DEPTH];	// [0] = running task, then nested SWIs
+static Uint32 runBusy[SCHED_MAX_DEPTH];		// exclusive time of the run at each level
+static Uint32 depth = 0;
+static Uint32 lastTs = 0;
+static Uint32 windowTs = 0;
+static double tsPerUs = 0;
+static int swiHookId = 0;
+static int taskHookId = 0;
+static int hwiHookId = 0;
+
+/// Publish windows per REG_CPU[] span, SCHED_CPU_W_* order
+static const Uint32 CPU_SPAN[SCHED_CPU_WORDS] = {
+	1000000 / (FREQ_POLL_TICKS*FREQ_TICK_US),
+	10000000 / (FREQ_POLL_TICKS*FREQ_TICK_US),
+	SCHED_CPU_SLOTS
+};
+
+/// charge the time since the last event to the object on top of the stack
+static inline Uint32 charge(void)
+{
+	Uint32 now = Timestamp_get32();
+	Uint32 dt = now - lastTs;
+
+	stack[depth]->busy += dt;
+	runBusy[depth] += dt;
+	lastTs = now;
+
+	return now;
+}
+
+void Sched_Swi_Register(int id)
+{
+	swiHookId = id;
+}
+
+void Sched_Task_Register(int id)
+{
+	taskHookId = id;
+}
+
+void Sched_Hwi_Register(int id)
+{
+	hwiHookId = id;
+}
+
+/// point the hook context of <swi> at its accumulator
+static inline void bindSwi(Swi_Handle swi, int slot)
+{
+	Swi_setHookContext(swi, swiHookId, &ACC[slot]);
+}
+
+void Sched_Stats_Init(void)
+{
+	Types_FreqHz freq;
+	Uint32 key;
+
+	Timestamp_getFreq(&freq);
+
+	key = Hwi_disable();
+
+	bindSwi(Swi_I2C_RX,						SCHED_SWI_I2C_RX);
+	bindSwi(Swi_I2C_TX,						SCHED_SWI_I2C_TX);
+	bindSwi(Swi_Modbus_RX,					SCHED_SWI_MODBUS_RX);
+	bindSwi(Swi_writeNand,					SCHED_SWI_WRITE_NAND);
+	bindSwi(Swi_Poll,						SCHED_SWI_POLL);
+	bindSwi(Swi_REG_OIL_SAMPLE,				SCHED_SWI_REG_OIL_SAMPLE);
+	bindSwi(Swi_REG_STREAM,					SCHED_SWI_REG_STREAM);
+	bindSwi(Swi_Set_REG_DENSITY_CAL_Unit,	SCHED_SWI_DENSITY_CAL_UNIT);
+	bindSwi(Swi_REG_OIL_ADJUST,				SCHED_SWI_REG_OIL_ADJUST);
+	bindSwi(Swi_Apply_Density_Adj,			SCHED_SWI_APPLY_DENSITY_ADJ);
+	bindSwi(Swi_upgradeFirmware,			SCHED_SWI_UPGRADE_FIRMWARE);
+	bindSwi(Swi_uploadCsv,					SCHED_SWI_UPLOAD_CSV);
+	bindSwi(Swi_downloadCsv,				SCHED_SWI_DOWNLOAD_CSV);
+	bindSwi(Swi_Csv_Page,					SCHED_SWI_CSV_PAGE);
+	bindSwi(Swi_usbhMscDriveOpen,			SCHED_SWI_USB_DRIVE_OPEN);
+	bindSwi(Swi_enumerateUsb,				SCHED_SWI_ENUMERATE_USB);
+	bindSwi(Swi_changeTime,					SCHED_SWI_CHANGE_TIME);
+	bindSwi(Swi_bootDeferred,				SCHED_SWI_BOOT_DEFERRED);
+	bindSwi(Swi_Event_Page,					SCHED_SWI_EVENT_PAGE);
+	bindSwi(Swi_Curve_Build,				SCHED_SWI_CURVE_BUILD);
+	bindSwi(Swi_Hist_Page,					SCHED_SWI_HIST_PAGE);
+	bindSwi(Swi_Hist_Save,					SCHED_SWI_HIST_SAVE);
+	bindSwi(Swi_Tot_Save,					SCHED_SWI_TOT_SAVE);
+	bindSwi(Swi_Sig_Save,					SCHED_SWI_SIG_SAVE);
+
+	Task_setHookContext(Task_getIdleTask(), taskHookId, &ACC[SCHED_IDLE]);
+	Task_setHookContext(Menu_task, taskHookId, &ACC[SCHED_MENU_TASK]);
+	Task_setHookContext(logData_task, taskHookId, &ACC[SCHED_LOG_TASK]);
+
+	Hwi_setHookContext(UART_Hwi, hwiHookId, &ACC[SCHED_HWI_UART]);
+	Hwi_setHookContext(I2C_Hwi, hwiHookId, &ACC[SCHED_HWI_I2C]);
+
+	memset(ACC, 0, sizeof(ACC));
+	memset(HIST, 0, sizeof(HIST));
+	memset(SUM_BUSY, 0, sizeof(SUM_BUSY));
+	memset(SUM_WINDOW, 0, sizeof(SUM_WINDOW));
+	memset(runBusy, 0, sizeof(runBusy));
+	histPos		= 0;
+	depth		= 0;
+	stack[0]	= &ACC[SCHED_TASK_OTHER];	// main() until BIOS_start()
+	lastTs		= Timestamp_get32();
+	windowTs	= lastTs;
+	tsPerUs		= freq.lo / 1000000.0;
+
+	Hwi_restore(key);
+}
+
+/// start a nested run of <a> - caller holds Hwi_disable()
+static inline void push(SCHED_ACC* a)
+{
+	if (depth < SCHED_MAX_DEPTH-1)
+	{
+		stack[++depth] = a;
+		runBusy[depth] = 0;
+	}
+}
+
+/// end the nested run on top of the stack - caller holds Hwi_disable()
+static inline void pop(void)
+{
+	SCHED_ACC* a;
+
+	if (depth > 0)
+	{
+		a = stack[depth];
+		a->runs++;
+		if (runBusy[depth] > a->max) a->max = runBusy[depth];
+		depth--;
+	}
+}
+
+void Sched_Swi_Begin(Swi_Handle swi)
+{
+	SCHED_ACC* a;
+	Uint32 key;
+
+	key = Hwi_disable();
+
+	charge();
+	a = (SCHED_ACC*)Swi_getHookContext(swi, swiHookId);
+	push((a != NULL) ? a : &ACC[SCHED_SWI_OTHER]);
+
+	Hwi_restore(key);
+}
+
+void Sched_Swi_End(Swi_Handle swi)
+{
+	Uint32 key;
+
+	key = Hwi_disable();
+
+	charge();
+	pop();
+
+	Hwi_restore(key);
+}
+
+/// HWIs nest on the same stack as SWIs
+void Sched_Hwi_Begin(Hwi_Handle hwi)
+{
+	SCHED_ACC* a;
+	Uint32 key;
+
+	key = Hwi_disable();
+
+	charge();
+	a = (SCHED_ACC*)Hwi_getHookContext(hwi, hwiHookId);
+	push((a != NULL) ? a : &ACC[SCHED_HWI_OTHER]);
+
+	Hwi_restore(key);
+}
+
+void Sched_Hwi_End(Hwi_Handle hwi)
+{
+	Uint32 key;
+
+	key = Hwi_disable();
+
+	charge();
+	pop();
+
+	Hwi_restore(key);
+}
+
+void Sched_Task_Switch(Task_Handle prev, Task_Handle next)
+{
+	SCHED_ACC* a;
+	Uint32 key;
+
+	key = Hwi_disable();
+
+	charge();
+
+	a = stack[0];
+	if (runBusy[0] > a->max) a->max = runBusy[0];
+
+	a = (SCHED_ACC*)Task_getHookContext(next, taskHookId);
+	stack[0] = (a != NULL) ? a : &ACC[SCHED_TASK_OTHER];
+	stack[0]->runs++;
+	runBusy[0] = 0;
+
+	Hwi_restore(key);
+}
+
+/// move the 1 s/10 s/60 s sums on by one window and refresh REG_CPU[]
+static void rollCpu(const SCHED_ACC* snap, Uint32 window)
+{
+	SCHED_WINDOW* old;
+	int i, w;
+
+	for (w=0;w<SCHED_CPU_WORDS;w++)
+	{
+		old = &HIST[(histPos + SCHED_CPU_SLOTS - CPU_SPAN[w]) % SCHED_CPU_SLOTS];
+		SUM_WINDOW[w] += window;
+		SUM_WINDOW[w] -= old->window;
+		for (i=0;i<SCHED_NUM_OBJ;i++)
+		{
+			SUM_BUSY[w][i] += snap[i].busy;
+			SUM_BUSY[w][i] -= old->busy[i];
+		}
+	}
+
+	// the 60 s span left the slot we are about to overwrite, so it goes last
+	HIST[histPos].window = window;
+	for (i=0;i<SCHED_NUM_OBJ;i++) HIST[histPos].busy[i] = snap[i].busy;
+	if (++histPos >= SCHED_CPU_SLOTS) histPos = 0;
+
+	for (w=0;w<SCHED_CPU_WORDS;w++)
+	{
+		if (SUM_WINDOW[w] == 0) continue;
+		for (i=0;i<SCHED_NUM_OBJ;i++)
+			REG_CPU[i*SCHED_CPU_WORDS+w] = 100.0 * (double)SUM_BUSY[w][i] / (double)SUM_WINDOW[w];
+	}
+}
+
+/***************************************************************************
+ * Sched_Stats_Publish() - close the window and refresh REG_SCHED[], REG_CPU[]
+ * Called from Poll(), so every window is about 0.5 s.
+ ***************************************************************************/
+void Sched_Stats_Publish(void)
+{
+	SCHED_ACC snap[SCHED_NUM_OBJ];
+	Uint32 key, now, window;
+	int i;
+
+	key = Hwi_disable();
+
+	now = charge();
+	window = now - windowTs;
+	windowTs = now;
+	memcpy(snap, ACC, sizeof(ACC));
+	for (i=0;i<SCHED_NUM_OBJ;i++)
+	{
+		ACC[i].runs = 0;
+		ACC[i].busy = 0;
+		ACC[i].max = 0;
+	}
+
+	Hwi_restore(key);
+
+	if ((window == 0) || (tsPerUs <= 0)) return;
+
+	for (i=0;i<SCHED_NUM_OBJ;i++)
+	{
+		REG_SCHED[i*SCHED_WORDS+SCHED_W_RUNS]	= snap[i].runs;
+		REG_SCHED[i*SCHED_WORDS+SCHED_W_LOAD]	= 100.0 * snap[i].busy / window;
+		REG_SCHED[i*SCHED_WORDS+SCHED_W_MAX_US]	= snap[i].max / tsPerUs;
+	}
+
+	rollCpu(snap, window);
+}
@@ -0,0 +1,120 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* SchedStats.h
+*-------------------------------------------------------------------------
+* Per-object execution statistics for the SWIs and TASKs defined in
+* PDI_Razor.cfg, collected by SYS/BIOS Swi and Task hook sets. The
+* accounting is exclusive: a preempted object stops being charged while a
+* higher priority SWI or an HWI runs. The UART and I2C HWIs are told
+* apart through their Hwi hook context; the Clock and timer ISRs, whose
+* Hwi objects the kernel creates, and driver HWIs share SCHED_HWI_OTHER.
+* Sched_Stats_Publish() closes a measurement window and copies runs, load
+* and longest run of every object to REG_SCHED[], in SCHED_* order.
+*
+* Every closed window is also kept in a 60 s history, from which the load
+* of every object over the last 1 s, 10 s and 60 s is published to
+* REG_CPU[] (SCHED_CPU_* words per object). 100 - idle is the CPU load.
+*
+* SCHED_* below mirrors the Swi/Task/Hwi objects of PDI_Razor.cfg and the
+* bind lists in SchedStats.c; keep the three in step. Objects created at
+* run time (USB driver) and the Clock SWI fall into the *_OTHER slots.
+* REG_SCHED[] and REG_CPU[] hold SCHED_MAX_OBJ objects and sit at the end
+* of the extended Modbus table. Every slot is taken: a new object shares
+* an *_OTHER slot unless the Modbus map is allowed to move.
+*------------------------------------------------------------------------*/
+#ifndef _SCHEDSTATS
+#define _SCHEDSTATS
+
+#ifdef SCHEDSTATS_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+/// tasks
+#define SCHED_IDLE						0
+#define SCHED_MENU_TASK					1
+#define SCHED_LOG_TASK					2
+#define SCHED_TASK_OTHER				3
+/// swis, PDI_Razor.cfg order
+#define SCHED_SWI_OTHER					4		// Clock SWI (all Clock functions) and driver SWIs
+#define SCHED_SWI_I2C_RX				5
+#define SCHED_SWI_I2C_TX				6
+#define SCHED_SWI_MODBUS_RX				7
+#define SCHED_SWI_WRITE_NAND			8
+#define SCHED_SWI_POLL					9
+#define SCHED_SWI_REG_OIL_SAMPLE		10
+#define SCHED_SWI_REG_STREAM			11
+#define SCHED_SWI_DENSITY_CAL_UNIT		12
+#define SCHED_SWI_REG_OIL_ADJUST		13
+#define SCHED_SWI_APPLY_DENSITY_ADJ		14
+#define SCHED_SWI_UPGRADE_FIRMWARE		15
+#define SCHED_SWI_UPLOAD_CSV			16
+#define SCHED_SWI_DOWNLOAD_CSV			17
+#define SCHED_SWI_CSV_PAGE				18
+#define SCHED_SWI_USB_DRIVE_OPEN		19
+#define SCHED_SWI_ENUMERATE_USB			20
+#define SCHED_SWI_CHANGE_TIME			21
+#define SCHED_SWI_BOOT_DEFERRED			22
+#define SCHED_SWI_EVENT_PAGE			23
+#define SCHED_SWI_CURVE_BUILD			24
+#define SCHED_SWI_HIST_PAGE				25
+#define SCHED_SWI_HIST_SAVE				26
+#define SCHED_SWI_TOT_SAVE				27
+#define SCHED_SWI_SIG_SAVE				28
+/// hwis
+#define SCHED_HWI_OTHER					29		// Clock and timer ISRs, driver HWIs
+#define SCHED_HWI_UART					30
+#define SCHED_HWI_I2C					31
+#define SCHED_NUM_OBJ					32
+#define SCHED_MAX_OBJ					32		// REG_SCHED[]/REG_CPU[] capacity, fixed so the Modbus map does not move
+
+#if SCHED_NUM_OBJ > SCHED_MAX_OBJ
+#error "SCHED_NUM_OBJ exceeds SCHED_MAX_OBJ - REG_SCHED[] and REG_CPU[] are full"
+#endif
+
+/// REG_SCHED[] words of one object
+#define SCHED_W_RUNS					0		// runs (SWI) or switches in (TASK) in the window
+#define SCHED_W_LOAD					1		// % of the window
+#define SCHED_W_MAX_US					2		// longest single run in the window, us
+#define SCHED_WORDS						3
+
+/// REG_CPU[] words of one object, % load over the last ...
+#define SCHED_CPU_W_1S					0
+#define SCHED_CPU_W_10S					1
+#define SCHED_CPU_W_60S					2
+#define SCHED_CPU_WORDS					3
+#define SCHED_CPU_SLOTS					120		// Publish windows in 60 s (must match Swi_Poll period)
+
+#define SCHED_MAX_DEPTH					24		// task + one level per SWI priority + nested HWIs
+
+void Sched_Stats_Init(void);
+void Sched_Stats_Publish(void);
+
+/// hook functions, registered in PDI_Razor.cfg
+void Sched_Swi_Register(int id);
+void Sched_Swi_Begin(Swi_Handle swi);
+void Sched_Swi_End(Swi_Handle swi);
+void Sched_Task_Register(int id);
+void Sched_Task_Switch(Task_Handle prev, Task_Handle next);
+void Sched_Hwi_Register(int id);
+void Sched_Hwi_Begin(Hwi_Handle hwi);
+void Sched_Hwi_End(Hwi_Handle hwi);
+
+#undef _EXTERN
+#undef SCHEDSTATS_H
+#endif // _SCHEDSTATS
@@ -0,0 +1,223 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* SigGen.c
+*-------------------------------------------------------------------------
+* Script interpreter for the bench model. See SigGen.h. Called from
+* Twin_Update() in the Poll SWI only, so the state needs no locking.
+*------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "Globals.h"
+#include "FreqCapture.h"
+#include "nandwriter.h"
+#include "Watchdog.h"
+
+#define SIGGEN_H
+
+#include "SigGen.h"
+
+#define SIG_DT		((double)FREQ_POLL_TICKS*FREQ_TICK_US/1000000.0)	// s per Poll
+
+static int seg = 0;
+static double t = 0;			// s into the segment
+static double from[3];			// wc, temp, dens at the start of the segment
+static double last[3];			// noiseless values of the previous call
+static Uint32 rng = 1;
+static double saved[SIG_SCRIPT_SIZE];	// the script as last handed to Swi_Sig_Save
+static BOOL isDefault = FALSE;		// SigGen_Default() ran this boot
+
+/// factory process model script: ramp into oil, swing across the curve
+/// cutoff, slug flow, water phase, ramp back out
+static const double SIG_DEMO_SCRIPT[6][SIG_SEG_WORDS] = {
+	/* type        secs   wc     temp  dens   period noiseWC noiseT */
+	{ SIG_RAMP,    120,   15,    40,   850,   0,     0.2,    0.05 },
+	{ SIG_INVERT,  60,    2,     40,   850,   10,    0.1,    0.05 },
+	{ SIG_SLUG,    60,    10,    40,   850,   20,    0.1,    0.05 },
+	{ SIG_STEP,    60,    100,   40,   850,   0,     0,      0.05 },
+	{ SIG_RAMP,    120,   0,     25,   850,   0,     0.2,    0.05 },
+	{ SIG_END,     0,     0,     0,    0,     0,     0,      0    }
+};
+
+/// xorshift32, uniform in [-1,1)
+static double noise(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+
+	return (double)rng / 2147483648.0 - 1.0;
+}
+
+static inline const double* segment(int i)
+{
+	return &REG_SIG_SCRIPT[i*SIG_SEG_WORDS];
+}
+
+/// first playable segment at or after i, -1 if the script is empty
+static int nextSegment(int i)
+{
+	int k;
+
+	for (k=0;k<SIG_MAX_SEG;k++,i++)
+	{
+		if (i >= SIG_MAX_SEG) i = 0;
+		if ((int)segment(i)[SIG_W_TYPE] == SIG_END)
+		{
+			i = -1;		// wrap to the top
+			continue;
+		}
+		if (segment(i)[SIG_W_SECS] > 0) return i;
+	}
+
+	return -1;
+}
+
+/// hand the script to Swi_Sig_Save if it differs from the stored one
+static void save(void)
+{
+	if (memcmp(saved, REG_SIG_SCRIPT, sizeof(saved)) == 0) return;
+
+	memcpy(saved, REG_SIG_SCRIPT, sizeof(saved));
+	Swi_post(Swi_Sig_Save);
+}
+
+/***************************************************************************
+ * SigGen_Default() - load the factory script (initializeAllRegisters)
+ ***************************************************************************/
+void SigGen_Default(void)
+{
+	int i;
+
+	for (i=0;i<SIG_SCRIPT_SIZE;i++) REG_SIG_SCRIPT[i] = (i < sizeof(SIG_DEMO_SCRIPT)/sizeof(double)) ? SIG_DEMO_SCRIPT[i/SIG_SEG_WORDS][i%SIG_SEG_WORDS] : 0;
+	isDefault = TRUE;
+}
+
+/***************************************************************************
+ * SigGen_Init() - REG_SIG_SCRIPT[] from its NAND blocks at start-up
+ * A factory reset this boot, or no intact copy, stores the factory script.
+ ***************************************************************************/
+void SigGen_Init(void)
+{
+	if (!isDefault && (Restore_Sig_From_NAND((Uint8*)saved, sizeof(saved)) == E_PASS))
+	{
+		memcpy(REG_SIG_SCRIPT, saved, sizeof(saved));
+		return;
+	}
+
+	if (!isDefault) SigGen_Default();
+	memset(saved, 0, sizeof(saved));
+	save();
+}
+
+/***************************************************************************
+ * SigGen_Save() - Swi_Sig_Save, posted when a changed script starts
+ ***************************************************************************/
+void SigGen_Save(void)
+{
+	Uint32 key;
+
+	key = Swi_disable();
+	WD_Service();
+	Store_Sig_in_NAND((const Uint8*)saved, sizeof(saved));
+	Swi_restore(key);
+}
+
+/***************************************************************************
+ * SigGen_Start() - rewind the script and reseed
+ * @param wc/temp/dens - where the first RAMP starts from
+ ***************************************************************************/
+void SigGen_Start(double wc, double temp, double dens)
+{
+	rng = (REG_SIG_SEED != 0) ? (Uint32)REG_SIG_SEED : 1;
+	seg = nextSegment(0);
+	t = 0;
+
+	last[0] = from[0] = wc;
+	last[1] = from[1] = temp;
+	last[2] = from[2] = dens;
+
+	REG_SIG_SEGMENT = seg;
+	save();
+}
+
+/***************************************************************************
+ * SigGen_Next() - model inputs for this Poll
+ * @return TRUE when a new segment has begun, i.e. the process stepped
+ ***************************************************************************/
+BOOL SigGen_Next(double* wc, double* temp, double* dens)
+{
+	const double* s;
+	double k, period, w;
+	BOOL isNew = FALSE;
+	int i;
+
+	if (seg < 0)
+	{
+		*wc = last[0];
+		*temp = last[1];
+		*dens = last[2];
+		return FALSE;
+	}
+
+	s = segment(seg);
+
+	if (t >= s[SIG_W_SECS])
+	{
+		for (i=0;i<3;i++) from[i] = last[i];
+		seg = nextSegment(seg+1);
+		t = 0;
+		isNew = TRUE;
+		REG_SIG_SEGMENT = seg;
+		if (seg < 0) return SigGen_Next(wc, temp, dens);
+		s = segment(seg);
+	}
+
+	period = (s[SIG_W_PERIOD] > 0) ? s[SIG_W_PERIOD] : s[SIG_W_SECS];
+
+	switch ((int)s[SIG_W_TYPE])
+	{
+		case SIG_RAMP :
+			k = (t + SIG_DT) / s[SIG_W_SECS];
+			if (k > 1) k = 1;
+			for (i=0;i<3;i++) last[i] = from[i] + k*(s[SIG_W_WC+i] - from[i]);
+			break;
+		case SIG_STEP :
+			for (i=0;i<3;i++) last[i] = s[SIG_W_WC+i];
+			break;
+		case SIG_SLUG :
+			last[0] = (fmod(t, period) < period/2) ? s[SIG_W_WC] : MAX_WATER_PHASE;
+			break;
+		case SIG_INVERT :
+			w = (fmod(t, period) < period/2) ? s[SIG_W_WC] : -s[SIG_W_WC];
+			last[0] = REG_OIL_PHASE_CUTOFF + w;
+			break;
+		default :
+			break;
+	}
+
+	t += SIG_DT;
+
+	/// noise never pushes the watercut outside 0..100, nor out of the water phase
+	w = s[SIG_W_NOISE_WC]*noise();
+	*wc = (last[0] >= MAX_WATER_PHASE) ? MAX_WATER_PHASE : last[0] + w;
+	if (*wc < 0) *wc = 0;
+	if (*wc > MAX_WATER_PHASE) *wc = MAX_WATER_PHASE;
+	*temp = last[1] + s[SIG_W_NOISE_T]*noise();
+	*dens = last[2];
+
+	return isNew;
+}
@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* SigGen.h
+*-------------------------------------------------------------------------
+* Scripted process trajectories for the bench model (Twin.c). With
+* REG_TWIN_MODE = TWIN_MODE_SCRIPT the model inputs are no longer taken
+* from REG_TWIN_*; every Poll they come from SigGen_Next() instead, which
+* walks the segments of REG_SIG_SCRIPT[] and loops at the end. Loading
+* a script, seeding it and starting it all need the password.
+*
+* REG_SIG_SCRIPT[] is not part of the variable area. A Modbus write does
+* not store it; when a changed script starts it is copied to its own
+* NAND blocks (Swi_Sig_Save), and SigGen_Init() reads it back at boot.
+*
+* A segment is SIG_SEG_WORDS doubles:
+*   SIG_W_TYPE		SIG_END, SIG_RAMP, SIG_STEP, SIG_SLUG or SIG_INVERT
+*   SIG_W_SECS		duration, s
+*   SIG_W_WC		RAMP/STEP: target watercut; SLUG: watercut of the oil
+*					slugs; INVERT: swing around REG_OIL_PHASE_CUTOFF
+*   SIG_W_TEMP		RAMP/STEP target temperature
+*   SIG_W_DENS		RAMP/STEP target density
+*   SIG_W_PERIOD	SLUG/INVERT period, s
+*   SIG_W_NOISE_WC	uniform noise on the watercut, +/- %
+*   SIG_W_NOISE_T	uniform noise on the temperature, +/- C
+*
+* Time advances by one Poll per call and the noise comes from a
+* xorshift generator seeded with REG_SIG_SEED, so a given script and seed
+* always produce the same trajectory.
+*------------------------------------------------------------------------*/
+#ifndef _SIGGEN
+#define _SIGGEN
+
+#ifdef SIGGEN_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+/// segment types
+#define SIG_END					0
+#define SIG_RAMP				1		// linear from the previous values
+#define SIG_STEP				2		// jump, then hold
+#define SIG_SLUG				3		// oil slugs alternating with water
+#define SIG_INVERT				4		// square wave across the curve cutoff
+
+/// segment words
+#define SIG_W_TYPE				0
+#define SIG_W_SECS				1
+#define SIG_W_WC				2
+#define SIG_W_TEMP				3
+#define SIG_W_DENS				4
+#define SIG_W_PERIOD			5
+#define SIG_W_NOISE_WC			6
+#define SIG_W_NOISE_T			7
+#define SIG_SEG_WORDS			8
+
+#define SIG_MAX_SEG				16
+#define SIG_SCRIPT_SIZE			(SIG_MAX_SEG*SIG_SEG_WORDS)
+
+void SigGen_Default(void);
+void SigGen_Init(void);
+void SigGen_Save(void);
+void SigGen_Start(double wc, double temp, double dens);
+BOOL SigGen_Next(double* wc, double* temp, double* dens);
+
+#undef _EXTERN
+#undef SIGGEN_H
+#endif // _SIGGEN
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* StreamProfile.c
+*-------------------------------------------------------------------------
+* Per-stream process state. See StreamProfile.h. The profile of the
+* selected stream is used in place by Calculate.c; only the few values
+* that are also Modbus registers or coils are copied on a switch.
+*------------------------------------------------------------------------*/
+
+#include "Globals.h"
+
+#define STREAMPROFILE_H
+
+#include "StreamProfile.h"
+
+#pragma DATA_SECTION(PROFILES,"DDR")
+static STREAM_PROFILE PROFILES[SMAX];
+
+void Stream_Profile_Init(void)
+{
+	int stream = (int)REG_STREAM.calc_val;
+
+	memset(PROFILES, 0, sizeof(PROFILES));
+
+	if ((stream < 1) || (stream > SMAX)) stream = 1;
+	SP = &PROFILES[stream-1];
+}
+
+/***************************************************************************
+ * Stream_Profile_Select() - make <stream> (1..SMAX) the selected stream
+ * A stream that has not been selected since boot starts from the boot
+ * state, the same as the first stream did.
+ ***************************************************************************/
+void Stream_Profile_Select(int stream)
+{
+	STREAM_PROFILE* next;
+	Uint32 key;
+
+	if ((stream < 1) || (stream > SMAX)) return;
+	next = &PROFILES[stream-1];
+
+	key = Swi_disable();
+
+	if (next != SP)
+	{
+		SP->densCorr	= REG_DENS_CORR;
+		SP->wcAvg		= REG_WATERCUT_AVG.calc_val;
+		SP->tempAvg		= REG_TEMP_AVG.calc_val;
+		SP->isOilPhase	= COIL_OIL_PHASE.val;
+
+		SP = next;
+
+		REG_DENS_CORR				= SP->densCorr;
+		REG_WATERCUT_AVG.calc_val	= SP->wcAvg;
+		REG_TEMP_AVG.calc_val		= SP->tempAvg;
+		COIL_OIL_PHASE.val			= SP->isOilPhase;
+	}
+
+	Swi_restore(key);
+}
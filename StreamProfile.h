@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* StreamProfile.h
+*-------------------------------------------------------------------------
+* Per-stream process state. Everything the watercut calculation carries
+* from one poll to the next - the REG_WATERCUT_AVG/REG_TEMP_AVG sample
+* buffers, the raw watercut running average, the phase hold-over state,
+* the held density correction and the oil phase - lives in one profile
+* per stream. SP points at the profile of the selected stream, so that
+* changing REG_STREAM swaps a pointer instead of letting the state of one
+* well bleed into the next. The oil adjust stays in STREAM_OIL_ADJUST[],
+* which is saved to NAND; the profiles are not.
+*------------------------------------------------------------------------*/
+#ifndef _STREAMPROFILE
+#define _STREAMPROFILE
+
+#ifdef STREAMPROFILE_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+typedef struct
+{
+	DATA_BFR		log;			// averaging buffers (Capture_Sample)
+	double			wcRawAvg;		// running average of REG_WATERCUT_RAW (Read_WC)
+	unsigned int	cycles;			// phase hold over RS
+	unsigned int	previousPhase;
+	unsigned int	phase;
+	unsigned int	rolloverCount;
+	BOOL			isPrimed;		// wcRawAvg holds a real sample
+	double			densCorr;		// REG_DENS_CORR while not selected
+	double			wcAvg;			// REG_WATERCUT_AVG while not selected
+	double			tempAvg;		// REG_TEMP_AVG while not selected
+	Uint8			isOilPhase;		// COIL_OIL_PHASE while not selected
+} STREAM_PROFILE;
+
+_EXTERN STREAM_PROFILE* SP;			// profile of the selected stream
+
+void Stream_Profile_Init(void);
+void Stream_Profile_Select(int stream);
+
+#undef _EXTERN
+#undef STREAMPROFILE_H
+#endif // _STREAMPROFILE
@@ -0,0 +1,370 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* Totalizer.c
+*-------------------------------------------------------------------------
+* Net oil totalizer. See Totalizer.h. Totalizer_Update() runs at the end
+* of Poll() (Swi_Poll), so the running state needs no locking. REG_TOT_INT[]
+* and REG_TOT_RATE[] are mirrors for Modbus; TOT_REC is authoritative.
+*------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <limits.h>
+#include <ti/sysbios/knl/Clock.h>
+#include "Globals.h"
+#include "nandwriter.h"
+#include "Watchdog.h"
+#include "ApiBatch.h"
+
+#define TOTALIZER_H
+
+#include "Totalizer.h"
+
+/// Neumaier compensated sum: sum + c holds the total without the rounding
+/// error of adding a small increment to a large total every poll
+typedef struct
+{
+	double	sum;
+	double	c;
+} KSUM;
+
+typedef struct
+{
+	Uint32	magic;
+	KSUM	tot[TOT_NUM_RUNNING][TOT_NUM_QTY];
+	double	prev[TOT_NUM_PERIODS-TOT_NUM_RUNNING][TOT_NUM_QTY];	// PREV_DAY, PREV_MONTH
+	int		stamp;			// yr*10000 + mon*100 + day of the running day, 0 = RTC not read
+	Uint32	check;			// checksum of everything above
+} TOT_RECORD;
+
+/// not initialized by the C runtime - survives a warm reset
+#pragma DATA_SECTION(TOT_REC,"TOTREC")
+static far TOT_RECORD TOT_REC;
+
+static Uint32 lastTick = 0;
+static double saveMs = 0;		// ms since TOT_SAVED[] was last refreshed
+static double lastWc = 0;		// last valid watercut, %
+static BOOL isDirty = FALSE;	// totals moved since the last save
+
+static inline void ksumAdd(KSUM* k, double x)
+{
+	double t = k->sum + x;
+
+	if (fabs(k->sum) >= fabs(x)) k->c += (k->sum - t) + x;
+	else k->c += (x - t) + k->sum;
+
+	k->sum = t;
+}
+
+static inline double ksumValue(const KSUM* k)
+{
+	return k->sum + k->c;
+}
+
+static Uint32 recCheck(void)
+{
+	const Uint32* w = (const Uint32*)&TOT_REC;
+	Uint32 s = TOT_REC_MAGIC;
+	int i;
+
+	for (i=0;i<(int)(offsetof(TOT_RECORD,check)/sizeof(Uint32));i++) s = ((s << 1) | (s >> 31)) ^ w[i];
+
+	return s;
+}
+
+static void recClear(void)
+{
+	memset(&TOT_REC, 0, sizeof(TOT_REC));
+	TOT_REC.magic = TOT_REC_MAGIC;
+}
+
+/// all periods, TOT_P_* x TOT_Q_* order
+static void snapshot(double* dst)
+{
+	int p, q;
+
+	for (p=0;p<TOT_NUM_RUNNING;p++)
+		for (q=0;q<TOT_NUM_QTY;q++) dst[p*TOT_NUM_QTY+q] = ksumValue(&TOT_REC.tot[p][q]);
+
+	for (p=TOT_NUM_RUNNING;p<TOT_NUM_PERIODS;p++)
+		for (q=0;q<TOT_NUM_QTY;q++) dst[p*TOT_NUM_QTY+q] = TOT_REC.prev[p-TOT_NUM_RUNNING][q];
+}
+
+/// read-only Modbus copy: whole units and thousandths in two 32-bit
+/// registers each, so a lifetime total keeps its resolution
+static void publish(void)
+{
+	double tot[TOT_NUM_PERIODS*TOT_NUM_QTY];
+	double v, w;
+	int i;
+
+	snapshot(tot);
+
+	for (i=0;i<TOT_NUM_PERIODS*TOT_NUM_QTY;i++)
+	{
+		v = (tot[i] > 0) ? tot[i] : 0;
+		if (v > (double)INT_MAX) v = (double)INT_MAX;
+		w = floor(v);
+
+		REG_TOT_INT[i*2]	= (int)w;
+		REG_TOT_INT[i*2+1]	= (int)((v - w) * 1000.0);
+	}
+}
+
+static void restore(const double* src)
+{
+	int p, q;
+
+	recClear();
+
+	for (p=0;p<TOT_NUM_RUNNING;p++)
+		for (q=0;q<TOT_NUM_QTY;q++) TOT_REC.tot[p][q].sum = src[p*TOT_NUM_QTY+q];
+
+	for (p=TOT_NUM_RUNNING;p<TOT_NUM_PERIODS;p++)
+		for (q=0;q<TOT_NUM_QTY;q++) TOT_REC.prev[p-TOT_NUM_RUNNING][q] = src[p*TOT_NUM_QTY+q];
+
+	TOT_REC.stamp = (int)src[TOT_SAVED_STAMP];
+}
+
+/// copy the totals to TOT_SAVED[] and store it
+static void save(void)
+{
+	snapshot(TOT_SAVED);
+	TOT_SAVED[TOT_SAVED_STAMP] = TOT_REC.stamp;
+
+	saveMs = 0;
+	isDirty = FALSE;
+
+	Swi_post(Swi_Tot_Save);
+}
+
+/***************************************************************************
+ * Totalizer_Save() - Swi_Tot_Save, posted by save()
+ * Swi_Poll cannot run meanwhile, so TOT_SAVED[] holds still.
+ ***************************************************************************/
+void Totalizer_Save(void)
+{
+	Uint32 key;
+
+	key = Swi_disable();
+	WD_Service();
+	Store_Tot_in_NAND((const Uint8*)TOT_SAVED, sizeof(TOT_SAVED));
+	Swi_restore(key);
+}
+
+/// latch the day/month totals when the RTC date changes
+static BOOL rollover(void)
+{
+	int stamp, q;
+	BOOL isMonth;
+
+	if ((REG_RTC_DAY < 1) || (REG_RTC_MON < 1)) return FALSE; // RTC not read yet
+
+	stamp = REG_RTC_YR*10000 + REG_RTC_MON*100 + REG_RTC_DAY;
+	if (stamp == TOT_REC.stamp) return FALSE;
+
+	if (TOT_REC.stamp > 0)
+	{
+		isMonth = ((stamp / 100) != (TOT_REC.stamp / 100));
+
+		for (q=0;q<TOT_NUM_QTY;q++)
+		{
+			TOT_REC.prev[TOT_P_PREV_DAY-TOT_NUM_RUNNING][q] = ksumValue(&TOT_REC.tot[TOT_P_DAY][q]);
+			TOT_REC.tot[TOT_P_DAY][q].sum = 0;
+			TOT_REC.tot[TOT_P_DAY][q].c = 0;
+
+			if (!isMonth) continue;
+
+			TOT_REC.prev[TOT_P_PREV_MONTH-TOT_NUM_RUNNING][q] = ksumValue(&TOT_REC.tot[TOT_P_MONTH][q]);
+			TOT_REC.tot[TOT_P_MONTH][q].sum = 0;
+			TOT_REC.tot[TOT_P_MONTH][q].c = 0;
+		}
+	}
+
+	TOT_REC.stamp = stamp;
+	return TRUE;
+}
+
+/***************************************************************************
+ * setOilDensity() - density pair for the oil VCF in API_VCF()
+ * REG_OIL_DENSITY is at process temperature. The 15C density comes from
+ * API_Batch_Rho_15(), which iterates as API2KGM3_15() does without its
+ * pow() calls and without touching DIAGNOSTICS; both densities go to
+ * degrees API in one API_Batch_To_API(). Without a usable density, or
+ * outside the ApiBatch.h temperature range, both are set to 1, which
+ * leaves only meter factor and shrinkage.
+ ***************************************************************************/
+static void setOilDensity(double tC)
+{
+	double rho[2], api[2], vcf;
+	API_SOA b;
+
+	FC.density_oil.val = 1.0;
+	FC.density_oilST.val = 1.0;
+
+	rho[0] = Convert(REG_OIL_DENSITY.class, REG_OIL_DENSITY.calc_unit, u_mpv_kg_cm, REG_OIL_DENSITY.calc_val, 0, 0);
+	if (!((rho[0] >= API_BATCH_RHO_MIN) && (rho[0] <= API_BATCH_RHO_MAX)) || isnan(tC)) return;
+
+	/// rho[1] is the 15C density
+	b.n = 1;
+	b.rho = &rho[0];
+	b.rho15 = &rho[1];
+	b.tC = &tC;
+	b.vcf = &vcf;
+	API_Batch_Rho_15(&b);
+	if (!(rho[1] > 0)) return;
+
+	if ((FC.T.unit == u_temp_F) || (FC.T.unit == u_temp_R))
+	{
+		/// API 60F path takes degrees API
+		API_Batch_To_API(rho, api, 2);
+		if ((api[0] <= 0) || (api[1] <= 0)) return;
+
+		FC.density_oil.val = api[0];
+		FC.density_oilST.val = api[1];
+	}
+	else
+	{
+		FC.density_oil.val = rho[0];
+		FC.density_oilST.val = rho[1];
+	}
+}
+
+void Totalizer_Init(void)
+{
+	int i;
+	BOOL isKept;
+
+	if (!(FC.Meter_Factor.calc_val > 0))
+	{
+		VAR_Initialize(&FC.Meter_Factor, c_analytical, u_mfgr_specific_none, 10000.0, 10000.0, var_no_bound|var_no_alarm);
+		VAR_Update(&FC.Meter_Factor, 1.0, CALC_UNIT);
+	}
+
+	if (!(FC.Shrinkage.calc_val > 0))
+	{
+		VAR_Initialize(&FC.Shrinkage, c_analytical, u_mfgr_specific_none, 10000.0, 10000.0, var_no_bound|var_no_alarm);
+		VAR_Update(&FC.Shrinkage, 1.0, CALC_UNIT);
+	}
+
+	/// a first flash or hard reset has just asked for zero totals; else the last copy
+	if (TOT_SAVED[TOT_SAVED_STAMP] != TOT_SAVED_RESET) Restore_Tot_From_NAND((Uint8*)TOT_SAVED, sizeof(TOT_SAVED));
+	for (i=0;i<TOT_SAVED_WORDS;i++) if (isnan(TOT_SAVED[i])) TOT_SAVED[i] = 0;
+
+	isKept = (TOT_REC.magic == TOT_REC_MAGIC) && (TOT_REC.check == recCheck());
+
+	/// the retained record is newer than NAND unless it lost the race with a factory reset
+	if (TOT_SAVED[TOT_SAVED_STAMP] == TOT_SAVED_RESET)
+	{
+		recClear();
+		save();		// else the next boot restores the old totals from NAND
+	}
+	else if (!isKept || (ksumValue(&TOT_REC.tot[TOT_P_LIFE][TOT_Q_GROSS]) < TOT_SAVED[TOT_Q_GROSS])) restore(TOT_SAVED);
+
+	TOT_REC.check = recCheck();
+
+	lastTick = Clock_getTicks();
+	saveMs	 = 0;
+	lastWc	 = 0;
+	isDirty	 = FALSE;
+	REG_TOT_FLOW = 0;
+
+	publish();
+	for (i=0;i<TOT_NUM_QTY;i++) REG_TOT_RATE[i] = 0;
+}
+
+/***************************************************************************
+ * Totalizer_Update() - integrate one poll interval
+ * Call at the end of Poll() once REG_WATERCUT is up to date.
+ ***************************************************************************/
+void Totalizer_Update(void)
+{
+	Uint32 now;
+	double dtMs, wc, tb, flow, k;
+	double rate[TOT_NUM_QTY];
+	BOOL isSaveDue;
+	int p, q;
+
+	now = Clock_getTicks();
+	dtMs = (double)(Uint32)(now - lastTick) * Clock_tickPeriod / 1000.0;
+	lastTick = now;
+	if (dtMs > TOT_MAX_DT_MS) dtMs = TOT_MAX_DT_MS;
+
+	/// factory reset since the last poll
+	if (TOT_SAVED[TOT_SAVED_STAMP] == TOT_SAVED_RESET)
+	{
+		recClear();
+		TOT_SAVED[TOT_SAVED_STAMP] = 0;
+	}
+
+	/// flow computer inputs
+	if (!(REG_WATERCUT.STAT & var_NaNum) && !isnan(REG_WATERCUT.calc_val)) lastWc = REG_WATERCUT.calc_val;
+	wc = (lastWc < 0) ? 0 : ((lastWc > 100) ? 1.0 : lastWc / 100.0);
+
+	FC.watercut = REG_WATERCUT;
+	FC.T = REG_TEMP_USER;
+	FC.salinity = REG_SALINITY;
+	FC.density_water.val = 0;	// water VCF from salinity
+	FC.density_waterST.val = 0;
+	setOilDensity(Convert(FC.T.class, FC.T.calc_unit, u_temp_C, FC.T.calc_val, 0, FC.T.aux));
+
+	API_VCF(&FC.VCFw, &FC.VCFo);
+
+	if (!(FC.VCFw > 0)) FC.VCFw = FC.Meter_Factor.calc_val;
+	if (!(FC.VCFo > 0)) FC.VCFo = FC.Meter_Factor.calc_val * FC.Shrinkage.calc_val;
+	FC.net_watercut = (wc*FC.VCFw + (1-wc)*FC.VCFo > 0) ? 100.0*wc*FC.VCFw / (wc*FC.VCFw + (1-wc)*FC.VCFo) : 0;
+
+	/// rates, volume per REG_TOT_TIME_BASE seconds
+	flow = REG_TOT_FLOW;
+	if (!(flow > 0)) flow = 0;
+
+	rate[TOT_Q_GROSS]		= flow;
+	rate[TOT_Q_GROSS_OIL]	= flow * (1-wc);
+	rate[TOT_Q_NET_OIL]		= rate[TOT_Q_GROSS_OIL] * FC.VCFo;
+	rate[TOT_Q_NET_WATER]	= flow * wc * FC.VCFw;
+	rate[TOT_Q_NET]			= rate[TOT_Q_NET_OIL] + rate[TOT_Q_NET_WATER];
+
+	/// integrate
+	if (flow > 0)
+	{
+		tb = (REG_TOT_TIME_BASE > 0) ? REG_TOT_TIME_BASE : 3600;
+		k = dtMs / (tb * 1000.0);
+
+		for (q=0;q<TOT_NUM_QTY;q++)
+			for (p=0;p<TOT_NUM_RUNNING;p++) ksumAdd(&TOT_REC.tot[p][q], rate[q] * k);
+
+		isDirty = TRUE;
+	}
+
+	/// day/month change and periodic copy to NAND
+	isSaveDue = rollover();
+	saveMs += dtMs;
+	if (isDirty && (REG_TOT_SAVE_PERIOD > 0) && (saveMs >= REG_TOT_SAVE_PERIOD * 60000.0)) isSaveDue = TRUE;
+
+	TOT_REC.check = recCheck();
+
+	/// publish
+	publish();
+	for (q=0;q<TOT_NUM_QTY;q++) REG_TOT_RATE[q] = rate[q];
+	FC.FLOW_TOTAL.calc_val = rate[TOT_Q_GROSS];
+	FC.FLOW_OIL.calc_val = rate[TOT_Q_GROSS_OIL];
+	FC.FLOW_WATER.calc_val = flow * wc;
+	FC.NET_FLOW_OIL.calc_val = rate[TOT_Q_NET_OIL];
+	FC.NET_FLOW_WATER.calc_val = rate[TOT_Q_NET_WATER];
+	FC.NET_FLOW_TOTAL.calc_val = rate[TOT_Q_NET];
+
+	if (isSaveDue) save();
+}
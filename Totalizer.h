@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* Totalizer.h
+*-------------------------------------------------------------------------
+* Net oil totalizer. Every Poll() the gross flow rate written by the
+* master into REG_TOT_FLOW is split by the watercut and corrected to
+* standard conditions with the flow computer struct FC (API_VCF(): meter
+* factor, shrinkage, oil and water VCF). The volumes are integrated with
+* compensated summation into day, month and lifetime totals. The lifetime
+* totals cannot be reset by the operator. At the first poll of a new day
+* or month the running total moves to the previous-period slot.
+*
+* REG_TOT_FLOW is a volume per REG_TOT_TIME_BASE seconds; the totals are
+* in the same volume unit. The state sits in a retained RAM section that
+* survives a warm reset. Every REG_TOT_SAVE_PERIOD minutes and at every
+* day change it is copied (TOT_SAVED[]) to its own round robin of NAND
+* blocks (Swi_Tot_Save), so a save does not rewrite the variable area,
+* and restored from there after a power loss. Modbus reads the
+* totals as read-only LONGINT pairs from 501 (whole units, thousandths),
+* so a lifetime total does not lose resolution in a float32.
+*------------------------------------------------------------------------*/
+#ifndef _TOTALIZER
+#define _TOTALIZER
+
+#ifdef TOTALIZER_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+/// quantities
+#define TOT_Q_GROSS				0		// total volume at process conditions
+#define TOT_Q_GROSS_OIL			1		// oil volume at process conditions
+#define TOT_Q_NET_OIL			2		// oil volume at standard conditions
+#define TOT_Q_NET_WATER			3		// water volume at standard conditions
+#define TOT_Q_NET				4		// net oil + net water
+#define TOT_NUM_QTY				5
+
+/// periods, REG_TOT_INT[(period*TOT_NUM_QTY + quantity)*2] whole units, +1 thousandths
+#define TOT_P_LIFE				0
+#define TOT_P_DAY				1
+#define TOT_P_MONTH				2
+#define TOT_P_PREV_DAY			3
+#define TOT_P_PREV_MONTH		4
+#define TOT_NUM_RUNNING			3		// LIFE, DAY and MONTH integrate
+#define TOT_NUM_PERIODS			5
+
+#define TOT_SAVED_STAMP			25		// TOT_SAVED[] slot of the period stamp
+#define TOT_SAVED_WORDS			(TOT_SAVED_STAMP + 1)
+#define TOT_SAVED_RESET			-1.0	// stamp written by a factory reset
+#define TOT_MAX_DT_MS			5000	// longest gap integrated at once
+#define TOT_REC_MAGIC			0x544F5431	// "TOT1"
+
+void Totalizer_Init(void);
+void Totalizer_Update(void);
+void Totalizer_Save(void);
+
+#undef _EXTERN
+#undef TOTALIZER_H
+#endif // _TOTALIZER
@@ -0,0 +1,311 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* Twin.c
+*-------------------------------------------------------------------------
+* Process model and response timing. See Twin.h. The model inputs are
+* latched by Twin_Update() at the end of Poll, so a step takes effect on
+* the next frequency gate exactly as a real change in the pipe would.
+* Step times are Mono milliseconds; the Modbus markers run in the UART HWI
+* and use the 32-bit timestamp instead.
+*------------------------------------------------------------------------*/
+
+#include <ti/sysbios/hal/Hwi.h>
+#include "Globals.h"
+#include "RtcTime.h"
+#include "Calculate.h"
+#include "FreqCapture.h"
+#include "SchedStats.h"
+#include "SigGen.h"
+#include "EventLog.h"
+
+#define TWIN_H
+
+#include "Twin.h"
+
+static BOOL isActive = FALSE;
+static double wc = 0;					// latched model inputs
+static double temp = 0;
+static double salt = 0;
+static double dens = 0;
+static double freqModel = 0;			// last modelFreq()
+static int mode = 0;					// REG_TWIN_MODE the inputs were latched under
+static int source = 0;					// REG_TWIN_MODE at the last Twin_Update()
+static unsigned long long stepMs = 0;	// RTC_Time_Mono() of the last step
+static BOOL isSettled = FALSE;
+static BOOL isAoDone = FALSE;
+static BOOL isRelayDone = FALSE;
+static BOOL isMbPending = FALSE;
+static Uint32 mbStartTs = 0;
+static Uint32 mbLastRxTs = 0;
+static double tsPerUs = 0;
+
+void Twin_Init(void)
+{
+	Types_FreqHz freq;
+	int i;
+
+	Timestamp_getFreq(&freq);
+	tsPerUs = freq.lo / 1000000.0;
+
+	isActive		= FALSE;
+	isMbPending		= FALSE;
+	source			= 0;
+	REG_TWIN_MODE	= 0;
+	REG_TWIN_WC		= 0;
+	REG_TWIN_TEMP	= 25;
+	REG_TWIN_SALT	= 0;
+	REG_TWIN_DENS	= REG_OIL_DENSITY_AI;
+	REG_SIG_SEGMENT	= -1;
+
+	for (i=0;i<TWIN_WORDS;i++) REG_TWIN[i] = 0;
+}
+
+BOOL Twin_Is_Active(void)
+{
+	return isActive;
+}
+
+/// milliseconds since the step - caller is a SWI or TASK
+static inline double sinceStep(void)
+{
+	return (double)(RTC_Time_Mono() - stepMs);
+}
+
+/// oscillator frequency, MHz, after F0/F1 and REG_OIL_INDEX
+static double modelFreq(void)
+{
+	double lo, hi, mid, wLo, wHi, wMid;
+	Uint16 k;
+	int i;
+
+	lo = REG_OIL_FREQ_LOW.calc_val;
+	hi = REG_OIL_FREQ_HIGH.calc_val;
+
+	if (wc >= MAX_WATER_PHASE) return hi + TWIN_WATER_MHZ + TWIN_SALT_MHZ*salt;
+
+	/// Read_WC() switches to the second set of curves above the cutoff
+	k = ((wc > REG_OIL_PHASE_CUTOFF) && (REG_OIL_PHASE_CUTOFF > 0)) ? 3 : 0;
+
+	wLo = Oil_Curve_WC(k, lo, temp);
+	wHi = Oil_Curve_WC(k, hi, temp);
+
+	/// out of the curves' range - the nearest end is the best we can do
+	if ((wc - wLo)*(wc - wHi) > 0)
+	{
+		mid = (fabs(wc - wLo) < fabs(wc - wHi)) ? lo : hi;
+	}
+	else
+	{
+		for (i=0;i<TWIN_BISECT_STEPS;i++)
+		{
+			mid  = (lo + hi) / 2;
+			wMid = Oil_Curve_WC(k, mid, temp);
+
+			if ((wMid - wc)*(wLo - wc) > 0)
+			{
+				lo  = mid;
+				wLo = wMid;
+			}
+			else hi = mid;
+		}
+
+		mid = (lo + hi) / 2;
+	}
+
+	return mid + TWIN_SALT_MHZ*salt;
+}
+
+/***************************************************************************
+ * Twin_Freq_Get() - stands in for Freq_Capture_Get() in Read_Freq()
+ * Works back through the 80x divider, F0/F1 and REG_OIL_INDEX so that
+ * Read_Freq() ends up at the model frequency.
+ ***************************************************************************/
+double Twin_Freq_Get(Uint32* lo, Uint32* hi, Uint32* us)
+{
+	double f;
+	int gate;
+
+	freqModel = modelFreq();
+
+	f  = freqModel;
+	f -= PDI_FREQ_F1*REG_TEMPERATURE.calc_val + PDI_FREQ_F0;
+	f -= REG_OIL_INDEX.calc_val;
+	f /= 80;
+	if (f < 0) f = 0;
+
+	gate = REG_FREQ_GATE;
+	if (gate < FREQ_GATE_MIN) gate = FREQ_GATE_MIN;
+	if (gate > FREQ_GATE_MAX) gate = FREQ_GATE_MAX;
+
+	*us = (Uint32)gate * 1000;
+	*lo = (Uint32)(f * (*us) + 0.5);
+	*hi = 0;
+
+	return f;
+}
+
+/// model temperature, C
+double Twin_Temp(void)
+{
+	return temp;
+}
+
+/// model density, REG_OIL_DENSITY_AI units
+double Twin_Density(void)
+{
+	return dens;
+}
+
+/// reflected power that puts Read_WC() in the model's phase
+double Twin_Rp(void)
+{
+	double pt;
+
+	pt = REG_OIL_P1.calc_val*freqModel + REG_OIL_P0.calc_val;
+
+	return (wc < MAX_WATER_PHASE) ? pt + TWIN_RP_MARGIN : pt - TWIN_RP_MARGIN;
+}
+
+void Twin_Mark_AO(void)
+{
+	if (!isActive || !isSettled || isAoDone) return;
+
+	REG_TWIN[TWIN_M_AO_MS] = sinceStep();
+	isAoDone = TRUE;
+}
+
+void Twin_Mark_Relay(void)
+{
+	if (!isActive || isRelayDone) return;
+
+	REG_TWIN[TWIN_M_RELAY_MS] = sinceStep();
+	isRelayDone = TRUE;
+}
+
+/// UART HWI, bytes received
+void Twin_Mark_MB_Rx(void)
+{
+	Uint32 now;
+
+	if (!isActive) return;
+
+	now = Timestamp_get32();
+	if (!isMbPending || ((now - mbLastRxTs) > TWIN_MB_GAP_US*tsPerUs)) mbStartTs = now;
+	mbLastRxTs = now;
+	isMbPending = TRUE;
+}
+
+/// last response byte has left the shift register
+void Twin_Mark_MB_Tx(void)
+{
+	Uint32 key;
+	double ms;
+
+	if (!isActive) return;
+
+	key = Hwi_disable();
+	ms = isMbPending ? (Timestamp_get32() - mbStartTs) / tsPerUs / 1000.0 : -1;
+	isMbPending = FALSE;
+	Hwi_restore(key);
+
+	if (ms < 0) return;
+
+	REG_TWIN[TWIN_M_MB_MS] = ms;
+	if (ms > REG_TWIN[TWIN_M_MB_MAX_MS]) REG_TWIN[TWIN_M_MB_MAX_MS] = ms;
+}
+
+/// a new operating point - restart the response timers
+static void step(void)
+{
+	stepMs	= RTC_Time_Mono();
+
+	isSettled	= FALSE;
+	isAoDone	= FALSE;
+	isRelayDone	= FALSE;
+
+	REG_TWIN[TWIN_M_STEPS]++;
+	REG_TWIN[TWIN_M_MEAS_MS]	= -1;
+	REG_TWIN[TWIN_M_AO_MS]		= -1;
+	REG_TWIN[TWIN_M_RELAY_MS]	= -1;
+	REG_TWIN[TWIN_M_MB_MAX_MS]	= 0;
+	REG_TWIN[TWIN_M_CPU_PCT]	= 0;
+	REG_TWIN[TWIN_M_POLL_PCT]	= 0;
+}
+
+/***************************************************************************
+ * Twin_Update() - end of Poll, after Sched_Stats_Publish()
+ ***************************************************************************/
+void Twin_Update(void)
+{
+	double expect, load;
+
+	if (REG_TWIN_MODE != source)
+	{
+		Event_Source((Uint16)REG_TWIN_MODE, (double)source);
+		source = REG_TWIN_MODE;
+	}
+
+	if (REG_TWIN_MODE == TWIN_MODE_OFF)
+	{
+		isActive = FALSE;
+		return;
+	}
+
+	if (REG_TWIN_MODE == TWIN_MODE_SCRIPT)
+	{
+		/// scripted inputs, a step per segment; REG_TWIN_* follow for display
+		if (!isActive || (mode != TWIN_MODE_SCRIPT)) SigGen_Start(REG_TWIN_WC, REG_TWIN_TEMP, REG_TWIN_DENS);
+		if (SigGen_Next(&wc, &temp, &dens) || !isActive || (mode != TWIN_MODE_SCRIPT)) step();
+
+		salt			= REG_TWIN_SALT;
+		REG_TWIN_WC		= wc;
+		REG_TWIN_TEMP	= temp;
+		REG_TWIN_DENS	= dens;
+	}
+	else if (!isActive || (mode != REG_TWIN_MODE) || (REG_TWIN_WC != wc) || (REG_TWIN_TEMP != temp)
+			|| (REG_TWIN_SALT != salt) || (REG_TWIN_DENS != dens))
+	{
+		wc		= REG_TWIN_WC;
+		temp	= REG_TWIN_TEMP;
+		salt	= REG_TWIN_SALT;
+		dens	= REG_TWIN_DENS;
+		step();
+	}
+
+	mode = REG_TWIN_MODE;
+	isActive = TRUE;
+
+	/// measurement latency
+	if (!isSettled)
+	{
+		expect = (wc >= MAX_WATER_PHASE) ? MAX_WATER_PHASE : wc + REG_OIL_ADJUST.calc_val;
+		if ((REG_OIL_DENS_CORR_MODE != 0) && (wc < MAX_WATER_PHASE)) expect += REG_DENS_CORR;
+
+		if (fabs(REG_WATERCUT.calc_val - expect) <= TWIN_SETTLE_PCT)
+		{
+			REG_TWIN[TWIN_M_MEAS_MS] = sinceStep();
+			isSettled = TRUE;
+		}
+	}
+
+	/// CPU budget over the last statistics window
+	load = 100.0 - REG_SCHED[SCHED_IDLE*SCHED_WORDS+SCHED_W_LOAD];
+	if (load > REG_TWIN[TWIN_M_CPU_PCT]) REG_TWIN[TWIN_M_CPU_PCT] = load;
+
+	load = REG_SCHED[SCHED_SWI_POLL*SCHED_WORDS+SCHED_W_LOAD];
+	if (load > REG_TWIN[TWIN_M_POLL_PCT]) REG_TWIN[TWIN_M_POLL_PCT] = load;
+}
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* Twin.h
+*-------------------------------------------------------------------------
+* Bench model of the process the analyzer sits in. With REG_TWIN_MODE set,
+* the oscillator frequency and the RTD, reflected power and density inputs
+* are replaced by what a pipe at REG_TWIN_WC % watercut, REG_TWIN_TEMP C,
+* REG_TWIN_SALT % salinity and REG_TWIN_DENS would produce. In
+* TWIN_MODE_SCRIPT those inputs come from SigGen.c instead. Everything
+* downstream - Poll, Read_WC, density correction, relay, AO DAC, logging
+* and Modbus - runs unchanged on the real hardware. PDI_i2C.c works the
+* ADC codes back from the model values, so the acquisition filters run too.
+*
+* The frequency comes from inverting the meter's own oil curves, so with
+* zero salinity a settled REG_WATERCUT should equal the modeled watercut
+* plus REG_OIL_ADJUST. Salinity shifts the frequency by TWIN_SALT_MHZ per
+* percent and shows up as measurement error. The reflected power sits
+* TWIN_RP_MARGIN above or below the REG_OIL_P0/P1 threshold to match the
+* model's phase.
+*
+* A change of any input is a step. REG_TWIN[] holds the response to the
+* last step, in milliseconds from the step (-1 = not yet):
+*   TWIN_M_MEAS_MS   REG_WATERCUT settled within TWIN_SETTLE_PCT
+*   TWIN_M_AO_MS     first DAC write after the watercut settled
+*   TWIN_M_RELAY_MS  first relay switch
+* plus the Modbus request-to-response time and the CPU load seen since.
+*
+* The relay and the AO really switch: bench use only. REG_TWIN_MODE and
+* the REG_TWIN_* inputs need the password but are never saved
+* (REGPERM_PASSWD_VOL), so a bench run does not wear the NAND and a power
+* cycle always returns to the real process. Every mode switch goes into
+* the event log (EVENT_SOURCE).
+*------------------------------------------------------------------------*/
+#ifndef _TWIN
+#define _TWIN
+
+#ifdef TWIN_H
+#define _EXTERN
+#else
+#define _EXTERN extern
+#endif
+
+/// REG_TWIN_MODE
+#define TWIN_MODE_OFF			0
+#define TWIN_MODE_MANUAL		1		// inputs from REG_TWIN_*
+#define TWIN_MODE_SCRIPT		2		// inputs from REG_SIG_SCRIPT[]
+
+#define TWIN_SETTLE_PCT			0.1		// % watercut band for "settled"
+#define TWIN_SALT_MHZ			(-0.5)	// frequency shift per % salinity
+#define TWIN_WATER_MHZ			1.0		// above REG_OIL_FREQ_HIGH for the water phase
+#define TWIN_RP_MARGIN			0.1		// V, reflected power off the phase threshold
+#define TWIN_BISECT_STEPS		32
+#define TWIN_MB_GAP_US			20000	// RX silence that starts a new request
+
+/// REG_TWIN[] words
+#define TWIN_M_STEPS			0		// steps applied since boot
+#define TWIN_M_MEAS_MS			1
+#define TWIN_M_AO_MS			2
+#define TWIN_M_RELAY_MS			3
+#define TWIN_M_MB_MS			4		// last Modbus request to end of response
+#define TWIN_M_MB_MAX_MS		5		// longest since the step
+#define TWIN_M_CPU_PCT			6		// highest CPU load (100 - idle) since the step
+#define TWIN_M_POLL_PCT			7		// highest Poll SWI load since the step
+#define TWIN_WORDS				8
+
+void Twin_Init(void);
+void Twin_Update(void);
+BOOL Twin_Is_Active(void);
+double Twin_Freq_Get(Uint32* lo, Uint32* hi, Uint32* us);
+double Twin_Temp(void);
+double Twin_Density(void);
+double Twin_Rp(void);
+
+/// response markers, no-ops unless the twin is running
+void Twin_Mark_AO(void);
+void Twin_Mark_Relay(void);
+void Twin_Mark_MB_Rx(void);
+void Twin_Mark_MB_Tx(void);
+
+#undef _EXTERN
+#undef TWIN_H
+#endif // _TWIN
@@ -24,6 +24,7 @@
 #include "nandwriter.h"
 #include "Errors.h"
 #include "Menu.h"
+#include "StreamProfile.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <time.h>
@@ -101,7 +102,7 @@ diagnose(Uint8 * ii, Uint8 * iindex, Uint8 * ierrorCount, Uint8 ierrors[], int *
     if (DIAGNOSTICS != *iDIAGNOSTICS_PREV)    // Keep updating DIAGNOSTICS
     {
         *iDIAGNOSTICS_PREV = DIAGNOSTICS;
-        memset(ierrors,0,sizeof(ierrors));    // Clear array
+        memset(ierrors,0,MAX_ERRORS);          // Clear array
         updateIndex(iindex);                  // Reset index = 0;
         *ierrorCount = 0;
         *ii = 0;
@@ -143,6 +144,9 @@ getStreamData(void)
 {
     int STREAM = (int)REG_STREAM.calc_val;
 
+    // SWAP IN THE PROCESS STATE OF THE NEW STREAM
+    Stream_Profile_Select(STREAM);
+
     // GET STREAM REGISTER DATA TO CURRENT REGISTER 
     VAR_Update(&REG_OIL_ADJUST, STREAM_OIL_ADJUST[STREAM-1], CALC_UNIT);
 }
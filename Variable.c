@@ -41,6 +41,7 @@
 #include "Globals.h"
 #include "Utils.h"
 #include "Variable.h"
+#include "EventLog.h"
 
 /****************************************************************************/
 /* VAR UPDATE																*/
@@ -684,34 +685,35 @@ BOOL VAR_CheckSet_Bounds(VAR* v, double* t)
         {/* t > bound_hi */
             v->STAT &= var_bound_lo ^ 0xFFFFFFFF;
             v->STAT |= var_bound_hi;
-            t[0]     = v->bound_hi_set;
 
             if ((v->STAT & var_no_alarm)==0)
 			{
-            	if ((DIAGNOSTICS & ERR_VAR_HI) == 0) DIAGNOSTICS |= ERR_VAR_HI;
+            	Event_Diag(ERR_VAR_HI, 0, t[0]);
 			}
 
+            t[0]     = v->bound_hi_set;
+
             r = FALSE;
         }
         else if (l_compare(t, v->bound_lo_set, 1)<0)
         {/* t < bound_lo */
             v->STAT &= var_bound_hi ^ 0xFFFFFFFF;
             v->STAT |= var_bound_lo;
-            t[0]     = v->bound_lo_set;
 
 			if ((v->STAT & var_no_alarm)==0)
 			{
-            	if ((DIAGNOSTICS & ERR_VAR_LO) == 0) DIAGNOSTICS |= ERR_VAR_LO;
+            	Event_Diag(ERR_VAR_LO, 0, t[0]);
 			}
 
+            t[0]     = v->bound_lo_set;
+
             r = FALSE;
         }
         else
         {/* t within range */
             v->STAT &= var_bound_lo ^ 0xFFFFFFFF;
             v->STAT &= var_bound_hi ^ 0xFFFFFFFF;
-           	if (DIAGNOSTICS & ERR_VAR_LO) DIAGNOSTICS &= ~ERR_VAR_LO;
-           	if (DIAGNOSTICS & ERR_VAR_HI) DIAGNOSTICS &= ~ERR_VAR_HI;
+           	Event_Diag(0, ERR_VAR_LO | ERR_VAR_HI, t[0]);
         }
     }
     else
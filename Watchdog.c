@@ -12,8 +12,40 @@
 * Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
 *------------------------------------------------------------------------*/
 
-#include "Watchdog.h"
+#include <ti/sysbios/knl/Clock.h>
 #include "Globals.h"
+#include "Watchdog.h"
+
+/// one per WD_CTX_*; single bytes, so HWIs, SWIs and tasks can update them without a lock
+typedef struct
+{
+    volatile Uint8 isArmed;     // the context has to check in
+    volatile Uint8 isSeen;      // checked in since the last supervisor pass
+    volatile Uint8 isOneShot;   // disarmed by its next check-in (WD_Expect)
+    Uint8 misses;               // supervisor passes without a check-in
+} WD_CONTEXT;
+
+typedef struct
+{
+    Uint32  magic;
+    Uint32  starved;            // WD_CTX_* bits that stopped the kicks
+} WD_RECORD;
+
+/// supervisor passes a context may miss before the kicks stop
+static const Uint8 WD_LIMIT[WD_NUM_CTX] = { 3, 2, 5, 3, 3, 5 };
+
+static WD_CONTEXT WD_CTX[WD_NUM_CTX];
+
+/// not initialized by the C runtime - survives the watchdog reset
+#pragma DATA_SECTION(WD_REC,"WDOGREC")
+static far WD_RECORD WD_REC;
+
+static volatile BOOL isHealthy = TRUE;  // FALSE -> a context starved, reset pending
+static volatile BOOL isRestart = FALSE; // deliberate reset, nothing to record
+static Uint32 lastPassTick = 0;
+static Uint32 jobDepth = 0;
+static unsigned long long lastServiceTs = 0;
+static Uint32 serviceMinTs = 0;
 
 void TimerWatchdogReactivate(unsigned int baseAddr)
 {
@@ -72,3 +104,176 @@ void setupWatchdog(void)
     /* Activate Watchdog */
     TimerWatchdogActivate(CSL_TMR_1_REGS);
 }
+
+
+/***************************************************************************
+ * WD_Supervisor_Init() - called once before BIOS_start()
+ * Publishes what starved before the last reset and arms the periodic
+ * contexts. Swi_Modbus_RX is armed per message by the UART HWI.
+ ***************************************************************************/
+void WD_Supervisor_Init(void)
+{
+    Types_FreqHz freq;
+
+    REG_WD_STARVED = (WD_REC.magic == WD_REC_MAGIC) ? (int)WD_REC.starved : 0;
+    WD_REC.magic = WD_REC_MAGIC;
+    WD_REC.starved = 0;
+
+    memset(WD_CTX, 0, sizeof(WD_CTX));
+    WD_Start(WD_CTX_POLL);
+    WD_Start(WD_CTX_MENU);
+    WD_Start(WD_CTX_I2C);
+
+    Timestamp_getFreq(&freq);
+    serviceMinTs = (freq.lo / 1000) * WD_SERVICE_MS;
+
+    lastPassTick = Clock_getTicks();
+    isHealthy = TRUE;
+    isRestart = FALSE;
+
+    Clock_start(WD_Supervise_Clock);
+}
+
+/// the context has to check in from now on
+void WD_Start(Uint8 ctx)
+{
+    WD_CONTEXT* c;
+
+    if (ctx >= WD_NUM_CTX) return;
+    c = &WD_CTX[ctx];
+    if (c->isArmed) return;
+
+    c->isSeen = FALSE;
+    c->isOneShot = FALSE;
+    c->misses = 0;
+    c->isArmed = TRUE;
+}
+
+/// the context is idle or deliberately blocked
+void WD_Stop(Uint8 ctx)
+{
+    if (ctx < WD_NUM_CTX) WD_CTX[ctx].isArmed = FALSE;
+}
+
+/// work was posted to the context - it has to run within its limit
+void WD_Expect(Uint8 ctx)
+{
+    WD_CONTEXT* c;
+
+    if (ctx >= WD_NUM_CTX) return;
+    c = &WD_CTX[ctx];
+    if (c->isArmed) return; // keep counting from the first post
+
+    c->isSeen = FALSE;
+    c->isOneShot = TRUE;
+    c->misses = 0;
+    c->isArmed = TRUE;
+}
+
+void WD_Checkin(Uint8 ctx)
+{
+    WD_CONTEXT* c;
+
+    if (ctx >= WD_NUM_CTX) return;
+    c = &WD_CTX[ctx];
+
+    c->isSeen = TRUE;
+    if (c->isOneShot) c->isArmed = FALSE;
+}
+
+/// a low priority SWI is about to block the tasks; it checks in as WD_CTX_JOB instead
+void WD_Job_Begin(void)
+{
+    Uint32 key;
+
+    key = Swi_disable();
+    if (jobDepth++ == 0)
+    {
+        WD_Stop(WD_CTX_MENU);
+        WD_Stop(WD_CTX_LOG);
+        WD_Start(WD_CTX_JOB);
+    }
+    Swi_restore(key);
+}
+
+void WD_Job_End(void)
+{
+    Uint32 key;
+
+    key = Swi_disable();
+    if ((jobDepth > 0) && (--jobDepth == 0))
+    {
+        WD_Stop(WD_CTX_JOB);
+        WD_Start(WD_CTX_MENU);
+    }
+    Swi_restore(key);
+}
+
+/***************************************************************************
+ * WD_Supervise() - WD_Supervise_Clock, Clock SWI context
+ * The only regular kick of the hardware watchdog.
+ ***************************************************************************/
+void WD_Supervise(void)
+{
+    WD_CONTEXT* c;
+    Uint32 now, starved = 0;
+    int i;
+
+    if (isRestart || !isHealthy) return;
+
+    /// after a long SWI-locked section the Clock catches up in a burst - count it once
+    now = Clock_getTicks();
+    if ((now - lastPassTick) < WD_PASS_TICKS/2) return;
+    lastPassTick = now;
+
+    for (i=0;i<WD_NUM_CTX;i++)
+    {
+        c = &WD_CTX[i];
+
+        if (!c->isArmed) c->misses = 0;
+        else if (c->isSeen)
+        {
+            c->isSeen = FALSE;
+            c->misses = 0;
+        }
+        else if (++c->misses > WD_LIMIT[i]) starved |= (1 << i);
+    }
+
+    if (starved)
+    {
+        /// stop kicking - the watchdog resets the board within ~5 s
+        WD_REC.starved = starved;
+        isHealthy = FALSE;
+        return;
+    }
+
+    TimerWatchdogReactivate(CSL_TMR_1_REGS);
+}
+
+/***************************************************************************
+ * WD_Service() - kick from a section that runs with SWIs disabled
+ * Call once per unit of real progress (a NAND block, a file chunk). It is
+ * rate limited and never overrides a starvation already seen by the
+ * supervisor.
+ ***************************************************************************/
+void WD_Service(void)
+{
+    Types_Timestamp64 ts;
+    unsigned long long now;
+
+    if (isRestart || !isHealthy) return;
+
+    Timestamp_get64(&ts);
+    now = ((unsigned long long)ts.hi << 32) | ts.lo;
+    if ((now - lastServiceTs) < serviceMinTs) return;
+    lastServiceTs = now;
+
+    TimerWatchdogReactivate(CSL_TMR_1_REGS);
+}
+
+/// deliberate reset: stop kicking and wait for the watchdog
+void WD_Restart(void)
+{
+    isRestart = TRUE;
+    while(1);
+}
@@ -14,6 +14,15 @@
 
 /*------------------------------------------------------------------------
 * Watchdog.h
+*-------------------------------------------------------------------------
+* Hardware watchdog (timer 1, ~5 s) and its supervisor. Every critical
+* context checks in with WD_Checkin(). WD_Supervise() runs once a second
+* from WD_Supervise_Clock and kicks the hardware only if every armed
+* context checked in within its limit. Otherwise it stops kicking and
+* records the starved contexts in retained RAM; after the reset they are
+* published in REG_WD_STARVED. Low priority SWIs that block the tasks for
+* a long time bracket the work with WD_Job_Begin()/WD_Job_End(). Sections
+* that run with SWIs disabled call WD_Service() once per unit of progress.
 *-------------------------------------------------------------------------*/
 
 #ifndef WATCHDOG_H_
@@ -63,6 +72,24 @@
 #define TMR_WDTCR_WDKEY             (0xFFFF0000u)
 #define TMR_WDTCR_WDKEY_SHIFT       (0x00000010u)
 
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+/// supervisor
+///////////////////////////////////////////////////
+///////////////////////////////////////////////////
+
+#define WD_CTX_POLL                 0   // Swi_Poll, every 0.5 s
+#define WD_CTX_MODBUS               1   // Swi_Modbus_RX, armed by the UART HWI
+#define WD_CTX_LOG                  2   // logData_task, armed per post (WD_Expect)
+#define WD_CTX_MENU                 3   // Menu_task
+#define WD_CTX_I2C                  4   // I2C daisy chain, once per round
+#define WD_CTX_JOB                  5   // long USB/NAND job in a low priority SWI
+#define WD_NUM_CTX                  6
+
+#define WD_PASS_TICKS               6666        // supervisor period, ~1 s (must match PDI_Razor.cfg)
+#define WD_SERVICE_MS               500         // min interval between WD_Service() kicks
+#define WD_REC_MAGIC                0x57D0C0DE
+
 ///////////////////////////////////////////////////
 ///////////////////////////////////////////////////
 /// function definition
@@ -73,6 +100,17 @@ void TimerWatchdogReactivate(unsigned int baseAddr);
 void TimerWatchdogActivate(unsigned int baseAddr);
 void TimerPeriodSet(unsigned int baseAddr, unsigned int timer, unsigned int period);
 void TimerConfigure(unsigned int baseAddr, unsigned int config);
-void setupwatchdog(void);
+void setupWatchdog(void);
+
+void WD_Supervisor_Init(void);
+void WD_Start(Uint8 ctx);
+void WD_Stop(Uint8 ctx);
+void WD_Expect(Uint8 ctx);
+void WD_Checkin(Uint8 ctx);
+void WD_Job_Begin(void);
+void WD_Job_End(void);
+void WD_Supervise(void);
+void WD_Service(void);
+void WD_Restart(void);
 
 #endif
@@ -0,0 +1,213 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* adc_sim.c
+*-------------------------------------------------------------------------
+* Runs the I2C ADC acquisition (the daisy chain of PDI_i2C.c and the
+* filter of Oversample.c) on the host shim against an RTD input with
+* injected noise, and reports settling time and noise floor against the
+* I2C bus time the ADC takes, for several filter settings.
+*
+*   razor_adc
+*
+* The ADS1112 model (host_i2c.c) adds NOISE_LSB of gaussian noise to
+* every conversion, and the input below adds a spike of SPIKE_LSB to one
+* conversion in SPIKE_EVERY. For each setting of REG_ADC_OVERSAMPLE,
+* REG_ADC_MEDIAN and REG_ADC_BURST the program holds the RTD at 25 C for
+* HOLD_US and samples REG_TEMPERATURE: the standard deviation is the
+* noise floor, the largest error shows the spikes that get through. Then
+* it steps the RTD to 60 C; the settling time is the time until
+* REG_TEMPERATURE stays within SETTLE_C. Next to these it prints the
+* conversions per second, the bus time of the ADC transactions per
+* second, and REG_ADC_ENOB and REG_ADC_RATE for the RTD channel.
+*
+* Without a median window the spikes pass, and the settling time is the
+* time of the last one. With one sample per result the filter has no
+* spread to measure, and REG_ADC_ENOB reads the full 16 bits.
+*
+* The program fails if a setting with a median window lets a spike
+* through, if 16x oversampling does not at least halve the noise floor of
+* single samples (both through a median of 5), if a setting never
+* settles, or if REG_ADC_ENOB or REG_ADC_RATE is not published.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "PDI_I2C.h"
+#include "Oversample.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         10000000
+#define HOLD_US         30000000
+#define STEP_US         40000000
+#define SAMPLE_US       50000
+#define NOISE_LSB       8.0
+#define SPIKE_LSB       400
+#define SPIKE_EVERY     50
+#define SETTLE_C        0.2
+#define SPIKE_C         0.5         // error that counts as a spike through
+#define CONFIG_RTD      0xFC        // PDI_i2C.c, I2C_ADC_Read_Temp()
+#define BYTE_BITS       9           // host_i2c.c bus accounting
+#define XFER_BITS       11
+#define BIT_NS          2500
+
+typedef struct
+{
+    int     osr;
+    int     median;
+    int     burst;
+} SETTING;
+
+static const SETTING settings[] =
+{
+    { 1, 1, 1},
+    { 4, 1, 1},
+    { 1, 5, 1},
+    { 4, 3, 1},                     // factory default
+    {16, 5, 1},
+    { 4, 3, 4},
+    {16, 5, 8},
+};
+
+#define NUM_SETTINGS    (sizeof(settings) / sizeof(settings[0]))
+
+static double rtdC = 25.0;
+static int failures;
+
+/// the RTD channel at <rtdC>, as the twin computes it; VREF mid-scale
+static Int32 input(UInt8 addr, UInt8 config)
+{
+    Int32 code = 22898;
+
+    if (addr == I2C_SLAVE_ADDR_ADC && config == CONFIG_RTD)
+        code = (Int32)lround((rtdC + 273.15) * 12 / 1000.0 / 2.5 * 32768 / 2.048);
+
+    if (rand() % SPIKE_EVERY == 0) code += SPIKE_LSB;
+
+    return code;
+}
+
+/// bus time of the transactions to the RTD/VREF ADC so far
+static UInt64 adcBusNs(void)
+{
+    Host_I2cDev *d = Host_I2c_find(I2C_SLAVE_ADDR_ADC);
+
+    return ((UInt64)d->xfers * XFER_BITS + (UInt64)d->bytes * BYTE_BITS) * BIT_NS;
+}
+
+static Bool run(const SETTING *s, double *noise)
+{
+    double e, sum = 0, sumSq = 0, worst = 0, sd, settle;
+    UInt64 t, t0, last, busNs;
+    UInt32 n = 0, conv;
+    Bool ok = TRUE;
+
+    REG_ADC_OVERSAMPLE = s->osr;
+    REG_ADC_MEDIAN = s->median;
+    REG_ADC_BURST = s->burst;
+    ADC_Filter_Init();
+    rtdC = 25.0;
+    Host_Run(BOOT_US);
+
+    // noise floor and spikes at a constant input
+    conv = Host_Adc_conversions();
+    busNs = adcBusNs();
+    for (t=0; t<HOLD_US; t+=SAMPLE_US)
+    {
+        Host_Run(SAMPLE_US);
+        e = REG_TEMPERATURE.calc_val - rtdC;
+        sum += e;
+        sumSq += e * e;
+        if (fabs(e) > worst) worst = fabs(e);
+        n++;
+    }
+    conv = Host_Adc_conversions() - conv;
+    busNs = adcBusNs() - busNs;
+    sd = sqrt(sumSq / n - (sum / n) * (sum / n));
+
+    // step response
+    rtdC = 60.0;
+    t0 = last = Host_Now();
+    for (t=0; t<STEP_US; t+=SAMPLE_US)
+    {
+        Host_Run(SAMPLE_US);
+        if (fabs(REG_TEMPERATURE.calc_val - rtdC) > SETTLE_C) last = Host_Now();
+    }
+    settle = (last - t0) / 1e6;
+
+    printf("%4d %6d %5d   %8.1f %9.3f   %7.3f %7.3f %8.2f   %6.1f %7.2f\n",
+        s->osr, s->median, s->burst, conv / (HOLD_US / 1e6), busNs / 1e6 / (HOLD_US / 1e6),
+        sd, worst, settle, REG_ADC_ENOB[ADC_CH_TEMP], REG_ADC_RATE[ADC_CH_TEMP]);
+
+    if (last - t0 > STEP_US - 1000000)
+    {
+        printf("  no settling within %.0f s\n", STEP_US / 1e6);
+        ok = FALSE;
+    }
+    if (s->median > 1 && worst > SPIKE_C)
+    {
+        printf("  a spike got through the median window\n");
+        ok = FALSE;
+    }
+    if (REG_ADC_ENOB[ADC_CH_TEMP] <= 0 || REG_ADC_RATE[ADC_CH_TEMP] <= 0)
+    {
+        printf("  REG_ADC_ENOB or REG_ADC_RATE not published\n");
+        ok = FALSE;
+    }
+
+    *noise = sd;
+    return ok;
+}
+
+int main(void)
+{
+    double noise[NUM_SETTINGS];
+    UInt32 i, single = 0, osr16 = 0;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Adc_input(input);
+    Host_Adc_noise(NOISE_LSB, 1);
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    srand(1);
+    printf("RTD at 25 C then 60 C; %.0f LSB rms noise, %d LSB spikes in 1 of %d conversions\n\n",
+        NOISE_LSB, SPIKE_LSB, SPIKE_EVERY);
+    printf(" osr median burst   conv/s  ADC bus ms/s   noise C  worst C  settle s   ENOB  rate Hz\n");
+    for (i=0; i<NUM_SETTINGS; i++)
+    {
+        if (!run(&settings[i], &noise[i])) failures++;
+        if (settings[i].burst > 1) continue;
+        if (settings[i].osr == 1 && settings[i].median == 5) single = i;
+        if (settings[i].osr == 16 && settings[i].median == 5) osr16 = i;
+    }
+
+    if (noise[osr16] * 2 > noise[single])
+    {
+        printf("  16x oversampling does not halve the noise floor of single samples\n");
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
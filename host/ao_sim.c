@@ -0,0 +1,187 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* ao_sim.c
+*-------------------------------------------------------------------------
+* Runs the AO update of the I2C daisy chain (I2C_Update_AO() in
+* PDI_i2C.c) on the host shim against the DAC model, and reports the DAC
+* transactions per minute and the step-response latency of the output.
+*
+*   razor_ao
+*
+* The AO runs in manual mode (REG_AO_MODE 2), so the program sets the
+* current directly in REG_AO_MANUAL_VAL. For each REG_AO_UPDATE_PERIOD it
+* holds the output for a minute, then ramps it from 4 to 20 mA over a
+* minute in RAMP_STEPS steps, and counts the transactions addressed to
+* the DAC. Before the change detection every visit of the daisy chain
+* wrote the DAC and read it back, two transactions a visit; that figure
+* is printed from the visits counted (runs of I2C_ADC_Read_Temp_Clock,
+* which only I2C_Update_AO starts). Then it steps the output NUM_STEPS
+* times at random phases and measures the time from the step to the DAC
+* write; without a rate limit that is the wait for the next visit, as it
+* was before.
+*
+* Last, the DAC code is upset behind the firmware's back. Within
+* REG_AO_VERIFY_CYCLES visits the readback has to raise ERR_AO_RBK,
+* rewrite the code and clear the flag again.
+*
+* The program fails if a steady output costs more than a tenth of the
+* transactions it did before, if a step is not written within a visit
+* plus the rate limit, or if the upset is not flagged and repaired.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "PDI_I2C.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         10000000
+#define MINUTE_US       60000000
+#define RAMP_STEPS      600
+#define NUM_STEPS       20
+#define STEP_LIMIT_US   3000000
+#define STEADY_GAIN     10
+
+static const int periods[] = {0, 500, 2000};    // REG_AO_UPDATE_PERIOD, ms
+
+#define NUM_PERIODS     (sizeof(periods) / sizeof(periods[0]))
+
+static int failures;
+
+static UInt32 dacXfers(void)
+{
+    return Host_I2c_find(I2C_SLAVE_ADDR_DAC)->xfers;
+}
+
+static UInt32 visits(void)
+{
+    return I2C_ADC_Read_Temp_Clock->st.runs;
+}
+
+/// DAC transactions and AO visits over <us> of virtual time, the output
+/// going from <from> to <to> mA in <steps> steps
+static void window(double from, double to, UInt32 steps, UInt32 *xfers, UInt32 *n)
+{
+    UInt32 i, x = dacXfers(), v = visits();
+
+    for (i=0; i<steps; i++)
+    {
+        REG_AO_MANUAL_VAL = from + (to - from) * i / (steps > 1 ? steps - 1 : 1);
+        Host_Run(MINUTE_US / steps);
+    }
+
+    *xfers = dacXfers() - x;
+    *n = visits() - v;
+}
+
+/// virtual microseconds from a step of the output to its DAC write
+static UInt64 stepLatency(double mA)
+{
+    UInt32 writes = Host_Dac_writes();
+    UInt64 t0 = Host_Now();
+
+    REG_AO_MANUAL_VAL = mA;
+    while (Host_Dac_writes() == writes && Host_Now() - t0 < STEP_LIMIT_US) Host_Run(Clock_tickPeriod);
+
+    return Host_Now() - t0;
+}
+
+static void run(int period)
+{
+    UInt32 steadyX, steadyV, rampX, rampV, i;
+    UInt64 lat, latMax = 0, latSum = 0;
+
+    REG_AO_UPDATE_PERIOD = period;
+    REG_AO_MANUAL_VAL = 12.0;
+    Host_Run(5000000);
+
+    window(12.0, 12.0, 1, &steadyX, &steadyV);
+    window(4.0, 20.0, RAMP_STEPS, &rampX, &rampV);
+
+    for (i=0; i<NUM_STEPS; i++)
+    {
+        Host_Run(1 + (UInt64)i * 104729 % 3000000);
+        lat = stepLatency((i & 1) ? 8.0 : 16.0);
+        if (lat > latMax) latMax = lat;
+        latSum += lat;
+    }
+
+    printf("%9d   %7u %7u   %7u %7u   %8.1f %8.1f\n", period, steadyX, 2 * steadyV, rampX, 2 * rampV,
+        latSum / 1e3 / NUM_STEPS, latMax / 1e3);
+
+    if (steadyX * STEADY_GAIN > 2 * steadyV)
+    {
+        printf("  a steady output costs more than a tenth of the transactions\n");
+        failures++;
+    }
+    if (latMax >= STEP_LIMIT_US || latMax > 1000000 + (UInt64)period * 1000)
+    {
+        printf("  a step took longer than a visit plus the rate limit\n");
+        failures++;
+    }
+}
+
+static void upset(void)
+{
+    UInt16 code = Host_Dac_code();
+    UInt32 v = visits(), flagged = 0, n;
+
+    Host_Dac_upset(code ^ 0x0100);
+    while (visits() - v <= (UInt32)REG_AO_VERIFY_CYCLES + 2)
+    {
+        Host_Run(Clock_tickPeriod);
+        if (!flagged && (DIAGNOSTICS & ERR_AO_RBK)) flagged = visits() - v;
+    }
+    n = visits() - v;
+
+    printf("\nupset: DAC code %u -> %u, ERR_AO_RBK after %u visits, DAC %u and flag %s after %u (REG_AO_VERIFY_CYCLES %d)\n",
+        code, code ^ 0x0100, flagged, Host_Dac_code(), (DIAGNOSTICS & ERR_AO_RBK) ? "set" : "clear", n,
+        REG_AO_VERIFY_CYCLES);
+
+    if (!flagged || Host_Dac_code() != code || (DIAGNOSTICS & ERR_AO_RBK))
+    {
+        printf("  the upset was not flagged and repaired\n");
+        failures++;
+    }
+}
+
+int main(void)
+{
+    UInt32 i;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    REG_AO_MODE = 2;
+    REG_AO_ALARM_MODE = 0;
+
+    printf("DAC transactions per minute, now and before (a write and a readback per visit)\n\n");
+    printf("period ms    steady  before      ramp  before   step ms avg      max\n");
+    for (i=0; i<NUM_PERIODS; i++) run(periods[i]);
+
+    REG_AO_UPDATE_PERIOD = 0;
+    upset();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* api_bench.c
+*-------------------------------------------------------------------------
+* Checks the array routines of ApiBatch.c against golden values and
+* against the scalar routines of API.c, and measures both.
+*
+*   razor_api [-g]
+*
+* The golden table holds API2KGM3() and API2KGM3_15() at points across
+* the ApiBatch.h domain, as API.c computed them when the table was made;
+* -g prints it again from API.c after a deliberate change. The batch
+* results have to match it to GOLDEN_REL, and random samples across the
+* domain have to match the scalar routines to SCALAR_REL. Samples outside
+* the domain have to take the documented fallbacks, and the API gravity
+* conversions have to agree exactly. The program fails on any mismatch.
+*
+* Then it times the scalar and the batch routines over arrays of 1 (as
+* setOilDensity() in Totalizer.c calls them), 16 and 4096 samples. The
+* rates are host rates, not C674x ones; use them to compare builds.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "API.h"
+#include "ApiBatch.h"
+
+#define GOLDEN_REL      1e-12
+#define SCALAR_REL      1e-13
+#define NUM_RANDOM      100000
+#define BENCH_SAMPLES   4000000     // per routine and array size
+#define MAX_N           4096
+
+typedef struct
+{
+    double  rho15;                  // kg/m3 at 15C
+    double  tC;
+    double  rhoT;                   // API2KGM3(rho15, tC)
+    double  back15;                 // API2KGM3_15(rhoT, tC)
+} GOLDEN;
+
+static const GOLDEN golden[] =
+{
+    {   560.0,  -45.0,  622.86163511076541,  560.00049439057386 },
+    {   560.0,   40.0,  532.24026048460451,  560.00039133373491 },
+    {   640.0,  140.0,  515.99579076660348,  639.99837713990541 },
+    {   650.0,    0.0,  664.06600790442894,  650.00004261921629 },
+    {   650.0,   90.0,  577.39548852868609,  649.99842243081548 },
+    {   800.0,  -20.0,  826.56075247732724,  800.00041168985274 },
+    {   800.0,   15.0,  800.00000000000000,  800.00000000000000 },
+    {   800.0,  120.0,  717.52516919213122,  799.99913935390259 },
+    {   900.0,   40.0,  882.85889295972504,  899.99995905149115 },
+    {  1000.0,  -50.0, 1039.37408356647256, 1000.00008636399991 },
+    {  1000.0,   80.0,  959.66987112900870, 1000.00018884773397 },
+    {  1090.0,  150.0, 1012.62880764300735, 1089.99880374731129 },
+};
+
+#define NUM_GOLDEN      (sizeof(golden) / sizeof(golden[0]))
+
+static double rho[MAX_N], rho15[MAX_N], tC[MAX_N], vcf[MAX_N], api[MAX_N];
+static int failures;
+
+static double rel(double a, double b)
+{
+    return (b == 0) ? fabs(a) : fabs(a - b) / fabs(b);
+}
+
+static void check(const char *what, double got, double want, double tol)
+{
+    if (rel(got, want) <= tol) return;
+    if (failures++ < 10) printf("  MISMATCH %s: %.17g, expected %.17g\n", what, got, want);
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * (rand() / (double)RAND_MAX);
+}
+
+static void printGolden(void)
+{
+    UInt32 i;
+    double r;
+
+    for (i=0; i<NUM_GOLDEN; i++)
+    {
+        r = API2KGM3(golden[i].rho15, golden[i].tC);
+        DIAGNOSTICS = 0;
+        printf("    { %7.1f, %6.1f, %19.14f, %19.14f },\n",
+            golden[i].rho15, golden[i].tC, r, API2KGM3_15(r, golden[i].tC));
+    }
+}
+
+static void checkGolden(void)
+{
+    API_SOA b = {NUM_GOLDEN, rho, rho15, tC, vcf};
+    UInt32 i;
+
+    for (i=0; i<NUM_GOLDEN; i++)
+    {
+        rho15[i] = golden[i].rho15;
+        tC[i] = golden[i].tC;
+    }
+    API_Batch_Rho_T(&b);
+    for (i=0; i<NUM_GOLDEN; i++) check("golden API_Batch_Rho_T", rho[i], golden[i].rhoT, GOLDEN_REL);
+
+    for (i=0; i<NUM_GOLDEN; i++) rho[i] = golden[i].rhoT;
+    API_Batch_Rho_15(&b);
+    for (i=0; i<NUM_GOLDEN; i++) check("golden API_Batch_Rho_15", rho15[i], golden[i].back15, GOLDEN_REL);
+}
+
+static void checkScalar(void)
+{
+    API_SOA b = {MAX_N, rho, rho15, tC, vcf};
+    double worstT = 0, worst15 = 0, e;
+    UInt32 i, done;
+
+    for (done=0; done<NUM_RANDOM; done+=MAX_N)
+    {
+        for (i=0; i<MAX_N; i++)
+        {
+            rho15[i] = uniform(API_BATCH_RHO_MIN, API_BATCH_RHO_MAX);
+            tC[i] = uniform(API_BATCH_T_MIN, API_BATCH_T_MAX);
+        }
+        API_Batch_Rho_T(&b);
+        for (i=0; i<MAX_N; i++)
+        {
+            e = rel(rho[i], API2KGM3(rho15[i], tC[i]));
+            if (e > worstT) worstT = e;
+        }
+
+        /// back from process densities that stay inside the domain
+        for (i=0; i<MAX_N; i++) rho[i] = uniform(API_BATCH_RHO_MIN + 60, API_BATCH_RHO_MAX - 60);
+        API_Batch_Rho_15(&b);
+        for (i=0; i<MAX_N; i++)
+        {
+            DIAGNOSTICS = 0;
+            e = rel(rho15[i], API2KGM3_15(rho[i], tC[i]));
+            if (e > worst15) worst15 = e;
+        }
+    }
+
+    check("random API_Batch_Rho_T", worstT, 0, SCALAR_REL);
+    check("random API_Batch_Rho_15", worst15, 0, SCALAR_REL);
+    printf("scalar: %u random samples, worst relative difference %.2g (Rho_T) %.2g (Rho_15)\n",
+        NUM_RANDOM, worstT, worst15);
+}
+
+static void checkEdges(void)
+{
+    static const double outRho[] = {499.0, 1101.0, 800.0, 800.0};
+    static const double outT[] = {20.0, 20.0, -51.0, 151.0};
+    API_SOA b = {4, rho, rho15, tC, vcf};
+    UInt32 i;
+
+    for (i=0; i<4; i++)
+    {
+        rho15[i] = outRho[i];
+        tC[i] = outT[i];
+    }
+    API_Batch_Rho_T(&b);
+    for (i=0; i<4; i++) check("out of domain API_Batch_Rho_T", rho[i], API2KGM3(outRho[i], outT[i]), 0);
+
+    for (i=0; i<4; i++) rho[i] = outRho[i];
+    API_Batch_Rho_15(&b);
+    for (i=0; i<4; i++)
+    {
+        check("out of domain API_Batch_Rho_15", rho15[i], 0, 0);
+        check("out of domain API_Batch_Rho_15 vcf", vcf[i], 0, 0);
+    }
+
+    rho[0] = 0.0;
+    rho[1] = -5.0;
+    for (i=2; i<MAX_N; i++) rho[i] = uniform(API_BATCH_RHO_MIN, API_BATCH_RHO_MAX);
+    API_Batch_To_API(rho, api, MAX_N);
+    for (i=0; i<MAX_N; i++) check("API_Batch_To_API", api[i], kgm3_to_API(rho[i]), 0);
+    API_Batch_To_Kgm3(api, rho15, MAX_N);
+    for (i=0; i<MAX_N; i++) check("API_Batch_To_Kgm3", rho15[i], API_to_kgm3(api[i]), 0);
+}
+
+/// samples per second of <fxn> over arrays of <n>
+static double rate(void (*fxn)(UInt32 n), UInt32 n)
+{
+    UInt64 ns = Host_Ns();
+    UInt32 done;
+
+    for (done=0; done<BENCH_SAMPLES; done+=n) fxn(n);
+    ns = Host_Ns() - ns;
+
+    return ns ? BENCH_SAMPLES * 1e9 / ns : 0.0;
+}
+
+static void scalarRhoT(UInt32 n)
+{
+    UInt32 i;
+
+    for (i=0; i<n; i++) rho[i] = API2KGM3(rho15[i], tC[i]);
+}
+
+static void batchRhoT(UInt32 n)
+{
+    API_SOA b = {n, rho, rho15, tC, vcf};
+
+    API_Batch_Rho_T(&b);
+}
+
+static void scalarRho15(UInt32 n)
+{
+    UInt32 i;
+
+    for (i=0; i<n; i++)
+    {
+        DIAGNOSTICS = 0;
+        rho15[i] = API2KGM3_15(rho[i], tC[i]);
+    }
+}
+
+static void batchRho15(UInt32 n)
+{
+    API_SOA b = {n, rho, rho15, tC, vcf};
+
+    API_Batch_Rho_15(&b);
+}
+
+static void bench(void)
+{
+    static const UInt32 sizes[] = {1, 16, MAX_N};
+    double s, b;
+    UInt32 i, k;
+
+    for (i=0; i<MAX_N; i++)
+    {
+        rho[i] = uniform(API_BATCH_RHO_MIN + 60, API_BATCH_RHO_MAX - 60);
+        rho15[i] = rho[i];
+        tC[i] = uniform(API_BATCH_T_MIN, API_BATCH_T_MAX);
+    }
+
+    printf("\nroutine   samples    scalar Ms/s   batch Ms/s   speed-up\n");
+    for (k=0; k<sizeof(sizes)/sizeof(sizes[0]); k++)
+    {
+        s = rate(scalarRhoT, sizes[k]);
+        b = rate(batchRhoT, sizes[k]);
+        printf("Rho_T     %7u   %11.2f  %11.2f   %7.1fx\n", sizes[k], s / 1e6, b / 1e6, b / s);
+    }
+    for (k=0; k<sizeof(sizes)/sizeof(sizes[0]); k++)
+    {
+        s = rate(scalarRho15, sizes[k]);
+        b = rate(batchRho15, sizes[k]);
+        printf("Rho_15    %7u   %11.2f  %11.2f   %7.1fx\n", sizes[k], s / 1e6, b / 1e6, b / s);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Host_Dev_Init();
+    Host_Cfg_Create();
+    DIAGNOSTICS = 0;
+
+    if (argc == 2 && strcmp(argv[1], "-g") == 0)
+    {
+        printGolden();
+        return 0;
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "usage: razor_api [-g]\n");
+        return 1;
+    }
+
+    srand(1);
+    checkGolden();
+    checkScalar();
+    checkEdges();
+    printf("golden: %u points, %s\n", (UInt32)NUM_GOLDEN, failures ? "FAILED" : "ok");
+
+    bench();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* boot_sim.c
+*-------------------------------------------------------------------------
+* Boots main() on the host shim, with and without fast start
+* (REG_BOOT_FAST), after a power-up and after warm resets, and prints the
+* start-up profile of BootProfile.c for every boot.
+*
+*   razor_boot
+*
+* Every boot is a fork() of a simulator that has not booted yet, so it
+* starts from fresh variables, as the C runtime leaves them. The NAND
+* holds the configuration of a unit in the field, REG_BOOT_FAST set as
+* the boot asks, so Init_All() takes the restore path. The retained
+* profiler record (the "BOOTPROF" section, which the Makefile places on
+* the host too) is zero after a power-up; a warm reset starts with the
+* record the boot before left, as the RAM keeps it over a watchdog reset.
+*
+* Right after main() returns the program sends a Modbus request, which
+* the slave has to answer while a fast start still brings up the I2C.
+* Then it runs the kernel until the profile is published and prints
+* REG_BOOT_MS[] per phase and REG_BOOT_COUNT, and the time from the
+* NAND restore to the Modbus slave: the part of the start-up that fast
+* start takes out of the time the master sees the unit dark. The phases
+* are host CPU time, so they show where the start-up spends its time and
+* in which order, not the time on the target. gcc drops the empty
+* power-up settle loop of Init_BoardClocks(), so the clocks phase of a
+* power-up looks like that of a warm reset here.
+*
+* The program fails if a phase mark is missing or out of order, if fast
+* start does not bring the Modbus slave up before the I2C bring-up and
+* sooner after the NAND restore than without it, if a boot gets no
+* Modbus reply, or if REG_BOOT_COUNT and REG_BOOT_PREV_MS[] do not carry
+* the count and the profile of the boot before.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#define truncate unistd_truncate    // Globals.h has its own truncate()
+#include <unistd.h>
+#undef truncate
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "nandwriter.h"
+#include "BootProfile.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define SLAVE           1           // factory default REG_SLAVE_ADDRESS
+#define MB_WATERCUT     3           // ModbusTables.h
+#define BOOT_US         5000000
+#define MAX_REC         256
+#define NUM_WARM        2
+
+/// BOOT_REC, placed in its own section by the Makefile
+extern UInt8 __start_BOOTPROF[], __stop_BOOTPROF[];
+
+typedef struct
+{
+    double  ms[BOOT_NUM_PHASES];    // REG_BOOT_MS
+    double  prevMs[BOOT_NUM_PHASES];// REG_BOOT_PREV_MS
+    int     count;                  // REG_BOOT_COUNT
+    Bool    reply;                  // the first Modbus request answered
+    UInt8   rec[MAX_REC];           // the retained record at the end
+} BOOT;
+
+static const char *PHASE_NAME[BOOT_NUM_PHASES] =
+{
+    "main", "clocks", "psc", "pinmux", "fw resume", "nand restore",
+    "i2c", "modbus", "software", "bios", "done",
+};
+
+/// the order each start-up completes the phases in
+static const UInt8 ORDER[2][BOOT_NUM_PHASES] =
+{
+    {BOOT_PH_MAIN, BOOT_PH_CLOCKS, BOOT_PH_PSC, BOOT_PH_PINMUX, BOOT_PH_FW_RESUME, BOOT_PH_NAND_RESTORE,
+     BOOT_PH_I2C, BOOT_PH_MODBUS, BOOT_PH_SOFTWARE, BOOT_PH_BIOS, BOOT_PH_DONE},
+    {BOOT_PH_MAIN, BOOT_PH_CLOCKS, BOOT_PH_PSC, BOOT_PH_PINMUX, BOOT_PH_FW_RESUME, BOOT_PH_NAND_RESTORE,
+     BOOT_PH_MODBUS, BOOT_PH_SOFTWARE, BOOT_PH_BIOS, BOOT_PH_I2C, BOOT_PH_DONE},
+};
+
+static const double NONE[BOOT_NUM_PHASES];    // REG_BOOT_PREV_MS after a power-up
+static int failures;
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_boot: %s\n", what);
+    exit(1);
+}
+
+/// in the child: the whole boot, reported through <fd>
+static void boot(int fast, const UInt8 *rec, int fd)
+{
+    BOOT b;
+    float wc;
+    int i;
+
+    memset(&b, 0, sizeof(b));
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+
+    // a unit in the field: its configuration in the NAND
+    initializeAllRegisters();
+    reloadFactoryDefault();
+    REG_BOOT_FAST = fast;
+    Store_Vars_in_NAND();
+
+    memcpy(__start_BOOTPROF, rec, __stop_BOOTPROF - __start_BOOTPROF);
+
+    Razor_main();
+    b.reply = Host_Mb_readFloat(SLAVE, MB_WATERCUT, &wc);
+    Host_Run(BOOT_US);
+
+    for (i=0; i<BOOT_NUM_PHASES; i++)
+    {
+        b.ms[i] = REG_BOOT_MS[i];
+        b.prevMs[i] = REG_BOOT_PREV_MS[i];
+    }
+    b.count = REG_BOOT_COUNT;
+    memcpy(b.rec, __start_BOOTPROF, __stop_BOOTPROF - __start_BOOTPROF);
+
+    if (write(fd, &b, sizeof(b)) != sizeof(b)) _exit(2);
+    _exit(0);
+}
+
+static void run(int fast, const UInt8 *rec, BOOT *b)
+{
+    int fd[2], status;
+    UInt32 got = 0;
+    ssize_t n;
+    pid_t pid;
+
+    fflush(stdout);
+    if (pipe(fd) < 0) fail("pipe");
+    pid = fork();
+    if (pid < 0) fail("fork");
+
+    if (pid == 0)
+    {
+        close(fd[0]);
+        boot(fast, rec, fd[1]);
+    }
+
+    close(fd[1]);
+    while (got < sizeof(*b) && (n = read(fd[0], (UInt8 *)b + got, sizeof(*b) - got)) > 0) got += n;
+    close(fd[0]);
+
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) || got != sizeof(*b))
+        fail("boot crashed");
+}
+
+static void check(int fast, const BOOT *b, const BOOT *before)
+{
+    int i;
+
+    for (i=1; i<BOOT_NUM_PHASES; i++)
+    {
+        if (b->ms[ORDER[fast][i]] >= b->ms[ORDER[fast][i-1]] && b->ms[ORDER[fast][i]] > 0) continue;
+
+        printf("  %s: the %s mark is missing or out of order\n", fast ? "fast" : "normal",
+            PHASE_NAME[ORDER[fast][i]]);
+        failures++;
+        break;
+    }
+
+    if (!b->reply)
+    {
+        printf("  %s: no Modbus reply\n", fast ? "fast" : "normal");
+        failures++;
+    }
+
+    if (b->count != (before ? before->count + 1 : 0) ||
+        memcmp(b->prevMs, before ? before->ms : NONE, sizeof(b->prevMs)))
+    {
+        printf("  %s: REG_BOOT_COUNT %d or REG_BOOT_PREV_MS[] does not carry the boot before\n",
+            fast ? "fast" : "normal", b->count);
+        failures++;
+    }
+}
+
+int main(void)
+{
+    static BOOT boots[2][1+NUM_WARM];
+    UInt8 rec[MAX_REC];
+    int fast, k, i;
+    double window[2];
+
+    if (__stop_BOOTPROF - __start_BOOTPROF > MAX_REC) fail("retained record too large");
+
+    for (fast=0; fast<2; fast++)
+    {
+        memset(rec, 0, sizeof(rec));
+        for (k=0; k<=NUM_WARM; k++)
+        {
+            run(fast, rec, &boots[fast][k]);
+            check(fast, &boots[fast][k], k ? &boots[fast][k-1] : NULL);
+            memcpy(rec, boots[fast][k].rec, sizeof(rec));
+        }
+
+        // Modbus up after the NAND restore, the power-up and the warm resets together
+        window[fast] = 0;
+        for (k=0; k<=NUM_WARM; k++)
+            window[fast] += boots[fast][k].ms[BOOT_PH_MODBUS] - boots[fast][k].ms[BOOT_PH_NAND_RESTORE];
+    }
+
+    printf("REG_BOOT_MS[] in host CPU ms since main(); warm resets carry the retained record\n\n");
+    printf("%-16s", "REG_BOOT_FAST");
+    for (fast=0; fast<2; fast++) for (k=0; k<=NUM_WARM; k++) printf(" %9d", fast);
+    printf("\n%-16s", "start");
+    for (fast=0; fast<2; fast++) for (k=0; k<=NUM_WARM; k++) printf(" %9s", k ? "warm" : "power-up");
+    printf("\n");
+
+    for (i=0; i<BOOT_NUM_PHASES; i++)
+    {
+        printf("%-16s", PHASE_NAME[ORDER[0][i]]);
+        for (fast=0; fast<2; fast++) for (k=0; k<=NUM_WARM; k++) printf(" %9.3f", boots[fast][k].ms[ORDER[0][i]]);
+        printf("\n");
+    }
+    printf("%-16s", "REG_BOOT_COUNT");
+    for (fast=0; fast<2; fast++) for (k=0; k<=NUM_WARM; k++) printf(" %9d", boots[fast][k].count);
+    printf("\n\nModbus up %.3f ms after the NAND restore without fast start, %.3f ms with it\n",
+        window[0] / (1 + NUM_WARM), window[1] / (1 + NUM_WARM));
+
+    for (k=0; k<=NUM_WARM; k++)
+    {
+        if (boots[1][k].ms[BOOT_PH_MODBUS] < boots[1][k].ms[BOOT_PH_I2C]) continue;
+        printf("  fast start brought the Modbus slave up after the I2C bring-up\n");
+        failures++;
+        break;
+    }
+    if (window[1] >= window[0])
+    {
+        printf("  fast start does not bring the Modbus slave up sooner\n");
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* csv_sim.c
+*-------------------------------------------------------------------------
+* Indexes a USB stick of NUM_FILES files with the CSV index (CsvIndex.c)
+* on the host shim, and reports the longest time the SWIs were held off
+* during the scan and whether Modbus kept answering.
+*
+*   razor_csv
+*
+* Boot is main() on a blank NAND and a formatted stick, mounted as the
+* data logger screen does. The program then writes NUM_FILES files into
+* the root of the stick through FatFs, in shuffled order: CSV files of
+* different sizes, other files and a few directories. The stick model
+* (host_usb.c) charges every command a command overhead plus a
+* per-sector time.
+*
+* The scan is what menu 3.8 starts, Csv_Index_Request(), and runs in
+* logData_task. While it runs the program keeps reading the watercut
+* over Modbus. A hook on Swi_disable() times every interval the SWIs are
+* held off, in host time plus the USB bus time inside it.
+*
+* For the baseline the program walks the same directory with the SWIs
+* held off over the whole walk, as scanCsvFiles() did before the index,
+* but without its 10 ms sleep per entry and without the strcat into
+* CSV_FILES, so the old hold-off was longer still.
+*
+* Then it checks the index: REG_CSV_COUNT has to count every CSV file,
+* the index has to hold the CSV_INDEX_MAX first names in order, and the
+* REG_CSV_WIN[] pages have to give their names, sizes and dates.
+*
+* The program fails if a Modbus request goes unanswered during the scan,
+* if the SWIs are held off longer than MAX_OFF_US at a time, if the
+* whole-walk baseline is not MIN_GAIN times longer, or if the index is
+* wrong.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "host_usb.h"
+#include "host_fatfs.h"
+#include "Globals.h"
+#include "CsvIndex.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define SLAVE           1           // factory default REG_SLAVE_ADDRESS
+#define MB_WATERCUT     3           // ModbusTables.h
+#define BOOT_US         10000000
+#define COMMAND_US      500         // host_usb.c defaults
+#define SECTOR_US       25
+#define NUM_FILES       10000
+#define NUM_DIRS        10
+#define OTHER_EVERY     20          // one file in OTHER_EVERY is not a CSV
+#define MAX_SCAN_US     60000000
+#define MAX_OFF_US      1000
+#define MIN_GAIN        100
+
+typedef struct
+{
+    char    name[CSV_NAME_LEN];     // without ".csv"
+    UInt32  size;
+} FILE_REC;
+
+static FILE_REC csv[NUM_FILES];
+static UInt32 numCsv;
+
+/// Swi_disable() intervals
+static struct
+{
+    Bool    on;                     // measuring
+    UInt64  ns;                     // host ns at the lock
+    UInt64  busNs;                  // USB bus time at the lock
+    UInt64  worstNs;
+    UInt32  count;
+} off;
+
+static char buf[512];
+static int failures;
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_csv: %s\n", what);
+    exit(1);
+}
+
+static UInt64 busNs(void)
+{
+    Host_UsbStats usb;
+
+    Host_Usb_stats(&usb);
+    return usb.busNs;
+}
+
+static void onLock(Bool locked)
+{
+    UInt64 ns;
+
+    if (!off.on) return;
+
+    if (locked)
+    {
+        off.ns = Host_Ns();
+        off.busNs = busNs();
+        return;
+    }
+
+    ns = Host_Ns() - off.ns + busNs() - off.busNs;
+    if (ns > off.worstNs) off.worstNs = ns;
+    off.count++;
+}
+
+static void offStart(void)
+{
+    memset(&off, 0, sizeof(off));
+    off.on = TRUE;
+}
+
+static int byName(const void *a, const void *b)
+{
+    return strcmp(((const FILE_REC *)a)->name, ((const FILE_REC *)b)->name);
+}
+
+/// NUM_FILES files in the root, in shuffled order
+static void fill(void)
+{
+    static UInt32 order[NUM_FILES];
+    char path[32];
+    UInt32 i, j, t, n, bw;
+    FIL f;
+
+    for (i=0; i<NUM_FILES; i++) order[i] = i;
+    srand(41);
+    for (i=NUM_FILES-1; i>0; i--)
+    {
+        j = rand() % (i + 1);
+        t = order[i]; order[i] = order[j]; order[j] = t;
+    }
+
+    memset(buf, '7', sizeof(buf));
+
+    for (i=0; i<NUM_FILES; i++)
+    {
+        n = order[i];
+
+        if (n < NUM_DIRS)
+        {
+            sprintf(path, "0:D%04u", n);
+            if (f_mkdir(path) != FR_OK) fail("f_mkdir");
+            continue;
+        }
+
+        if (n % OTHER_EVERY == 0) sprintf(path, "0:N%07u.txt", n);
+        else
+        {
+            sprintf(csv[numCsv].name, "P%07u", n);
+            csv[numCsv].size = (n * 37) % sizeof(buf) + 1;
+            sprintf(path, "0:%s.csv", csv[numCsv].name);
+        }
+
+        if (f_open(&f, path, FA_CREATE_NEW | FA_WRITE) != FR_OK) fail("f_open");
+        if (f_write(&f, buf, n % OTHER_EVERY ? csv[numCsv].size : 1, &bw) != FR_OK) fail("f_write");
+        f_close(&f);
+
+        if (n % OTHER_EVERY) numCsv++;
+    }
+
+    qsort(csv, numCsv, sizeof(csv[0]), byName);
+}
+
+/// the scan as menu 3.8 starts it, Modbus read all along; virtual us
+static UInt64 scan(UInt32 *asked, UInt32 *answered)
+{
+    UInt64 t0 = Host_Now();
+    float wc;
+
+    *asked = *answered = 0;
+    Csv_Index_Request();
+
+    while (isScanCsvFiles && Host_Now() - t0 < MAX_SCAN_US)
+    {
+        (*asked)++;
+        if (Host_Mb_readFloat(SLAVE, MB_WATERCUT, &wc)) (*answered)++;
+    }
+    if (isScanCsvFiles) fail("the scan did not finish");
+
+    return Host_Now() - t0;
+}
+
+/// the same walk with the SWIs held off all along, as before the index
+static void scanHeld(void)
+{
+    UInt32 key;
+
+    key = Swi_disable();
+    while (!Csv_Index_Step());
+    Swi_restore(key);
+}
+
+static void checkIndex(void)
+{
+    char name[CSV_NAME_LEN];
+    double *w;
+    Uint32 v;
+    int i, j, k, page, bad = 0;
+
+    if ((UInt32)REG_CSV_COUNT != numCsv)
+    {
+        printf("  REG_CSV_COUNT %d, %u CSV files on the stick\n", REG_CSV_COUNT, numCsv);
+        failures++;
+    }
+
+    for (i=0; i<CSV_INDEX_MAX; i++)
+    {
+        if (!Csv_Index_Name(i, name) || strcmp(name, csv[i].name)) bad++;
+    }
+    if (Csv_Index_Name(CSV_INDEX_MAX, name)) bad++;
+
+    for (page=0; page<=CSV_INDEX_MAX/CSV_PAGE_SIZE; page++)
+    {
+        REG_CSV_PAGE.val = page;
+        Csv_Index_Page_Load();
+
+        for (i=0; i<CSV_PAGE_SIZE; i++)
+        {
+            w = &REG_CSV_WIN[i*CSV_WORDS];
+            k = page * CSV_PAGE_SIZE + i;
+
+            if (k >= CSV_INDEX_MAX)
+            {
+                for (j=0; j<CSV_WORDS; j++) if (w[j] != 0) bad++;
+                continue;
+            }
+
+            // 3 characters a word, up to CSV_W_SIZE
+            for (j=0; j<3*(CSV_W_SIZE-CSV_W_NAME); j++)
+            {
+                v = (Uint32)w[CSV_W_NAME + j/3];
+                if ((char)(v >> (8 * (2 - j%3))) != csv[k].name[j]) bad++;
+            }
+            if ((UInt32)w[CSV_W_SIZE] != csv[k].size) bad++;
+            if (w[CSV_W_DATE] < 19800101 || w[CSV_W_TIME] > 235959) bad++;
+        }
+    }
+    REG_CSV_PAGE.val = 0;
+
+    if (bad)
+    {
+        printf("  the index or its pages do not hold the first %d names in order (%d mismatches)\n",
+            CSV_INDEX_MAX, bad);
+        failures++;
+    }
+}
+
+int main(void)
+{
+    UInt32 asked, answered;
+    UInt64 us, worstNs, heldNs, t0;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Ff_format();
+    Host_Usb_attach(TRUE);
+    Host_Usb_latency(COMMAND_US, SECTOR_US);
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    // as the data logger screen does
+    Swi_post(Swi_usbhMscDriveOpen);
+    Swi_post(Swi_enumerateUsb);
+    Host_Run(BOOT_US);
+    if (!isUsbMounted) fail("stick not mounted");
+
+    fill();
+    Host_Swi_lockHook(onLock);
+
+    offStart();
+    t0 = busNs();
+    us = scan(&asked, &answered);
+    worstNs = off.worstNs;
+    printf("%u files, %u of them CSV, %d directories; index of %d, %d entries per slice\n\n",
+        NUM_FILES - NUM_DIRS, numCsv, NUM_DIRS, CSV_INDEX_MAX, CSV_SLICE_ENTRIES);
+    printf("scan in logData_task     %8.3f s virtual, %.3f s on the bus, %u SWI hold-offs\n",
+        us / 1e6, (busNs() - t0) / 1e9, off.count);
+    printf("  longest hold-off       %8.3f ms\n", worstNs / 1e6);
+    printf("  Modbus                 %8u of %u requests answered\n", answered, asked);
+    checkIndex();
+
+    offStart();
+    scanHeld();
+    heldNs = off.worstNs;
+    off.on = FALSE;
+    printf("walk with the SWIs held  %8.3f ms hold-off, without the old 10 ms per entry\n", heldNs / 1e6);
+    printf("\nlongest hold-off %.0fx shorter\n", worstNs ? (double)heldNs / worstNs : 0.0);
+    checkIndex();
+
+    if (answered != asked)
+    {
+        printf("  Modbus requests went unanswered during the scan\n");
+        failures++;
+    }
+    if (worstNs > MAX_OFF_US * 1000ull)
+    {
+        printf("  the SWIs were held off longer than %d us\n", MAX_OFF_US);
+        failures++;
+    }
+    if (worstNs * MIN_GAIN > heldNs)
+    {
+        printf("  less than %dx\n", MIN_GAIN);
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,416 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* curve_bench.c
+*-------------------------------------------------------------------------
+* Test and benchmark of the oil curve table (CurveTable.c) on the host
+* shim: its interpolation error against the coefficients, what it costs
+* a Poll, and how soon a calibration takes effect.
+*
+*   razor_curve
+*
+* Error: with the factory curves the program evaluates Oil_Curve_WC()
+* over GRID_F frequencies across REG_OIL_FREQ_LOW..HIGH, off the table's
+* points, and GRID_T temperatures between the breakpoints, for both sets
+* of curves, once with no table (the coefficients) and once with the
+* table built, and again over the few MHz where the first curve reads 0
+* to 100 %, which is where the table's samples lie. Each curve on its own
+* is compared with Oil_Curve_Poly() wherever Curve_Table_Get() has it.
+* Then the middle curve is made a cubic that reads WAVY_WC at both ends
+* and the middle of the window and thousands of % between, so its band is
+* the whole window and its table would be off by more than CURVE_MAX_ERR:
+* the build has to reject it and Oil_Curve_WC() has to give the
+* coefficients' values.
+*
+* Cost: host ns per Oil_Curve_WC() in the band from the table and from
+* the coefficients, per Curve_Table_Check() (which hashes the curves in
+* use every Poll) and per build, best of REPEAT. Then the process model
+* runs RUN_US with the table and RUN_US with Swi_Curve_Build doing
+* nothing, so every Poll takes the coefficient path, REPEAT times in
+* turns, and the best host ns per Swi_Poll are compared. An x86-64 core
+* evaluates a cubic in doubles about as fast as it interpolates the
+* table, so the host shows what the table's bookkeeping costs a Poll,
+* not what the table saves the C674x.
+*
+* Latency: with the process model at TWIN_WC, REG_OIL_ADJUST (what
+* Calibrate_Oil() sets) is raised by SHIFT, and the program steps STEP_US
+* at a time until REG_WATERCUT has moved by SHIFT. Then the constant term
+* of every curve is raised by SHIFT. The process model reads the
+* frequency the curves give for TWIN_WC, so REG_WATERCUT stays; instead
+* the program steps until REG_FREQ has moved and REG_WATERCUT_RAW is what
+* the new curves give at it. It also reports when the table for the new
+* curves was in use (REG_CURVE[CURVE_W_LATENCY_MS]).
+*
+* The program fails if an error exceeds CURVE_MAX_ERR, if the wavy
+* table is not rejected or its fallback differs from the coefficients, if
+* a Poll with the table costs MAX_OVERHEAD more than one without, or if a
+* change takes more than MAX_POLLS Polls to take effect or the table is
+* not rebuilt for it.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "Calculate.h"
+#include "Twin.h"
+#include "CurveTable.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         10000000
+#define RUN_US          30000000
+#define POLL_US         500000
+#define STEP_US         50000
+#define GRID_F          4001
+#define GRID_T          23
+#define CALLS           200000
+#define REPEAT          5
+#define MAX_OVERHEAD    0.20
+#define WAVINESS        1e-4        // MHz^-3
+#define WAVY_WC         50.0
+#define TWIN_WC         8.0
+#define SHIFT           1.0
+#define MAX_POLLS       2
+#define FLOAT_TOL       1e-4        // float rounding of a watercut near 100 %
+
+static float ref[2][GRID_T][GRID_F];
+static double gridLo, gridHi;       // MHz
+static int failures;
+
+static double gridF(int n)
+{
+    // off the table's points
+    return gridLo + (gridHi - gridLo) * (n + 0.37) / GRID_F;
+}
+
+/// the grid over the whole oil window, or over where curve 0 reads 0..100 %
+static void gridOver(Bool band)
+{
+    double f, step;
+
+    gridLo = REG_OIL_FREQ_LOW.calc_val;
+    gridHi = REG_OIL_FREQ_HIGH.calc_val;
+    if (!band) return;
+
+    step = (gridHi - gridLo) / GRID_F;
+    for (f=gridLo; f<gridHi && (Oil_Curve_Poly(0, f) < 0 || Oil_Curve_Poly(0, f) > 100); f+=step);
+    gridLo = f;
+    for (; f<gridHi && Oil_Curve_Poly(0, f) >= 0 && Oil_Curve_Poly(0, f) <= 100; f+=step);
+    gridHi = f;
+}
+
+/// between the breakpoints of curve set <k>
+static double gridT(int k, int n)
+{
+    double lo = REG_TEMPS_OIL[k], hi = REG_TEMPS_OIL[k + (int)REG_TEMP_OIL_NUM_CURVES - 4];
+
+    return lo + (hi - lo) * n / (GRID_T - 1);
+}
+
+/// table built for the current inputs, SWIs held by the caller
+static void build(void)
+{
+    Curve_Table_Check();
+    Curve_Table_Build();
+}
+
+/// worst |Oil_Curve_WC() - ref|
+static double wcError(Bool store)
+{
+    double e, worst = 0;
+    float w;
+    int k, t, n;
+
+    for (k=0; k<2; k++)
+    {
+        for (t=0; t<GRID_T; t++)
+        {
+            for (n=0; n<GRID_F; n++)
+            {
+                w = Oil_Curve_WC(k * 3, gridF(n), gridT(k * 3, t));
+                if (store) ref[k][t][n] = w;
+                e = fabs(w - ref[k][t][n]);
+                if (e > worst) worst = e;
+            }
+        }
+    }
+
+    return worst;
+}
+
+/// worst |table - cubic| of each curve on its own, where it has a table
+static double curveError(UInt32 *points)
+{
+    double e, worst = 0;
+    float w;
+    int c, n;
+
+    for (c=0; c<=REG_TEMP_OIL_NUM_CURVES && c<CURVE_MAX_CURVES; c++)
+    {
+        for (n=0; n<GRID_F; n++)
+        {
+            if (!Curve_Table_Get(c, gridF(n), &w)) continue;
+            e = fabs(w - Oil_Curve_Poly(c, gridF(n)));
+            if (e > worst) worst = e;
+            (*points)++;
+        }
+    }
+
+    return worst;
+}
+
+/// curve 1 through WAVY_WC at both ends and the middle of the window, far out between
+static void bend(double *saved)
+{
+    double lo = REG_OIL_FREQ_LOW.calc_val, hi = REG_OIL_FREQ_HIGH.calc_val, mid = (lo + hi) / 2;
+    double *k = REG_COEFFS_TEMP_OIL[1];
+
+    memcpy(saved, k, 4 * sizeof(double));
+    k[3] = WAVINESS;
+    k[2] = -WAVINESS * (lo + mid + hi);
+    k[1] = WAVINESS * (lo*mid + lo*hi + mid*hi);
+    k[0] = -WAVINESS * lo*mid*hi + WAVY_WC;
+}
+
+/// ns per Oil_Curve_WC() over the grid, best of REPEAT
+static double wcNs(void)
+{
+    volatile float w;
+    double ns, best = 0;
+    UInt64 t0;
+    int i, k;
+
+    for (k=0; k<REPEAT; k++)
+    {
+        t0 = Host_Ns();
+        for (i=0; i<CALLS; i++) w = Oil_Curve_WC(0, gridF(i % GRID_F), REG_TEMPS_OIL[1]);
+        ns = (Host_Ns() - t0) / (double)CALLS;
+        if (k == 0 || ns < best) best = ns;
+    }
+    (void)w;
+
+    return best;
+}
+
+/// ns per Curve_Table_Check(), best of REPEAT
+static double checkNs(void)
+{
+    double ns, best = 0;
+    UInt64 t0;
+    int i, k;
+
+    for (k=0; k<REPEAT; k++)
+    {
+        t0 = Host_Ns();
+        for (i=0; i<CALLS; i++) Curve_Table_Check();
+        ns = (Host_Ns() - t0) / (double)CALLS;
+        if (k == 0 || ns < best) best = ns;
+    }
+
+    return best;
+}
+
+/// host ns per Poll with Swi_Curve_Build running <fxn>
+static double pollNs(Host_Fxn fxn)
+{
+    Host_Stats *st = &Swi_Poll->st;
+    UInt32 key;
+
+    key = Swi_disable();
+    Swi_Curve_Build->fxn = fxn;
+    Curve_Table_Init();
+    Swi_restore(key);
+    Host_Run(2 * POLL_US);
+
+    Host_Stats_reset();
+    Host_Run(RUN_US);
+
+    return st->runs ? (double)st->ns / st->runs : 0;
+}
+
+/// virtual us until REG_WATERCUT has moved to <want>
+static UInt64 adjustEffect(double want)
+{
+    UInt64 t;
+
+    for (t=STEP_US; t<=(MAX_POLLS + 2) * POLL_US; t+=STEP_US)
+    {
+        Host_Run(STEP_US);
+        if (fabs(REG_WATERCUT.val - want) < SHIFT / 10) return t;
+    }
+
+    return ~0ull;
+}
+
+/// virtual us until a Poll has read the curves raised by SHIFT
+static UInt64 curveEffect(void)
+{
+    double freq = REG_FREQ.calc_val;
+    UInt32 key;
+    UInt64 t;
+    int c;
+
+    key = Swi_disable();
+    for (c=0; c<CURVE_MAX_CURVES; c++) REG_COEFFS_TEMP_OIL[c][0] += SHIFT;
+    Swi_restore(key);
+
+    for (t=STEP_US; t<=(MAX_POLLS + 2) * POLL_US; t+=STEP_US)
+    {
+        Host_Run(STEP_US);
+        if (REG_FREQ.calc_val == freq) continue;
+        if (fabs(REG_WATERCUT_RAW - Oil_Curve_WC(0, REG_FREQ.calc_val, REG_TEMP_USER.calc_val)) < FLOAT_TOL)
+            return t;
+    }
+
+    return ~0ull;
+}
+
+static void noBuild(UArg a0, UArg a1)
+{
+}
+
+int main(void)
+{
+    double errWc, errCurve, errBent, nsTable = 0, nsPoly = 0, nsCheck = 0, pollTable = 0, pollPoly = 0, ns;
+    double before, builds, saved[4];
+    Host_Fxn builder;
+    UInt64 usAdjust, usCurve;
+    UInt32 key, points = 0;
+    int state, band, i;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    REG_TWIN_TEMP = REG_TEMPS_OIL[1];
+    REG_TWIN_DENS = 850.0;
+    REG_TWIN_SALT = 0.0;
+    REG_TWIN_WC = TWIN_WC;
+    REG_TWIN_MODE = TWIN_MODE_MANUAL;
+    VAR_Update(&REG_PROC_AVGING, 1, CALC_UNIT);
+    Host_Run(BOOT_US);
+
+    // Poll shares the table; keep it out while the table is switched
+    key = Swi_disable();
+
+    printf("%d curves, %.1f to %.1f MHz, %d points; %d x %d grid off the points\n\n",
+        (int)REG_TEMP_OIL_NUM_CURVES + 1, REG_OIL_FREQ_LOW.calc_val, REG_OIL_FREQ_HIGH.calc_val, CURVE_POINTS,
+        GRID_F, GRID_T);
+    printf("worst error, %% watercut        Oil_Curve_WC()   per curve   limit %.3f\n", CURVE_MAX_ERR);
+
+    for (band=0; band<2; band++)
+    {
+        gridOver(band);
+        Curve_Table_Init();
+        wcError(TRUE);
+        if (band) nsPoly = wcNs();
+
+        build();
+        errWc = wcError(FALSE);
+        errCurve = curveError(&points);
+        if (band)
+        {
+            nsTable = wcNs();
+            nsCheck = checkNs();
+        }
+
+        printf("%7.1f to %6.1f MHz          %14.6f  %10.6f   state %d\n", gridLo, gridHi, errWc, errCurve,
+            (int)REG_CURVE[CURVE_W_STATE]);
+        if (REG_CURVE[CURVE_W_STATE] != CURVE_STATE_ACTIVE || errWc > CURVE_MAX_ERR + FLOAT_TOL ||
+            errCurve > CURVE_MAX_ERR + FLOAT_TOL)
+        {
+            printf("  no table, or the table is off the coefficients by more than %.3f %%\n", CURVE_MAX_ERR);
+            failures++;
+        }
+    }
+    printf("build: worst error %.6f, %u grid points in the curves' bands\n", REG_CURVE[CURVE_W_MAX_ERR], points);
+    if (points == 0)
+    {
+        printf("  the grid missed the bands\n");
+        failures++;
+    }
+
+    // a curve the table cannot follow
+    gridOver(FALSE);
+    bend(saved);
+    Curve_Table_Init();
+    wcError(TRUE);
+    build();
+    state = (int)REG_CURVE[CURVE_W_STATE];
+    errBent = wcError(FALSE);
+    printf("\ncurve 1 wavy                   state %d, build error %.4f, Oil_Curve_WC() off the coefficients by %.6f\n",
+        state, REG_CURVE[CURVE_W_MAX_ERR], errBent);
+    if (state != CURVE_STATE_REJECTED || errBent != 0)
+    {
+        printf("  the wavy table was not rejected, or its fallback is not the coefficients\n");
+        failures++;
+    }
+    memcpy(REG_COEFFS_TEMP_OIL[1], saved, sizeof(saved));
+
+    Swi_restore(key);
+
+    // Poll on the factory curves, with the table and never built, in turns
+    builder = Swi_Curve_Build->fxn;
+    for (i=0; i<REPEAT; i++)
+    {
+        ns = pollNs(noBuild);
+        if (i == 0 || ns < pollPoly) pollPoly = ns;
+        ns = pollNs(builder);
+        if (i == 0 || ns < pollTable) pollTable = ns;
+    }
+
+    printf("\nhost ns   Oil_Curve_WC() in the band: table %.1f, coefficients %.1f   Curve_Table_Check() %.1f\n",
+        nsTable, nsPoly, nsCheck);
+    printf("          build %.0f   Poll with the table %.0f, with the coefficients %.0f\n",
+        REG_CURVE[CURVE_W_BUILD_US] * 1000, pollTable, pollPoly);
+    if (REG_CURVE[CURVE_W_STATE] != CURVE_STATE_ACTIVE || pollTable > pollPoly * (1 + MAX_OVERHEAD))
+    {
+        printf("  no table, or a Poll costs more than %.0f %% more with it\n", MAX_OVERHEAD * 100);
+        failures++;
+    }
+
+    // calibration to effect
+    before = REG_WATERCUT.val;
+    VAR_Update(&REG_OIL_ADJUST, REG_OIL_ADJUST.calc_val + SHIFT, CALC_UNIT);
+    usAdjust = adjustEffect(before + SHIFT);
+
+    builds = REG_CURVE[CURVE_W_BUILDS];
+    usCurve = curveEffect();
+    Host_Run(2 * POLL_US);
+
+    printf("\nREG_OIL_ADJUST +%.0f %% in REG_WATERCUT after %.0f ms; curves +%.0f %% read by Poll after %.0f ms\n",
+        SHIFT, usAdjust / 1e3, SHIFT, usCurve / 1e3);
+    printf("table for the new curves in use %.0f ms after Poll saw them, %.0f build, state %d\n",
+        REG_CURVE[CURVE_W_LATENCY_MS], REG_CURVE[CURVE_W_BUILDS] - builds, (int)REG_CURVE[CURVE_W_STATE]);
+    if (usAdjust > MAX_POLLS * POLL_US || usCurve > MAX_POLLS * POLL_US)
+    {
+        printf("  a calibration took more than %d Polls to take effect\n", MAX_POLLS);
+        failures++;
+    }
+    if (REG_CURVE[CURVE_W_STATE] != CURVE_STATE_ACTIVE || REG_CURVE[CURVE_W_BUILDS] == builds)
+    {
+        printf("  the table was not rebuilt for the new curves\n");
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
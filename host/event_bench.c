@@ -0,0 +1,231 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* event_bench.c
+*-------------------------------------------------------------------------
+* Stress test of the event ring (EventLog.c): the cost of Event_Diag()
+* per event at the highest error-toggle rate there is, an edge on every
+* call, and the ring and counters it leaves behind.
+*
+*   razor_event
+*
+* After the firmware has booted, the program toggles 1, 4 and all
+* MAX_ERRORS error bits on every call of Event_Diag(), with
+* COIL_LOG_ERRORS on and off. The calls run with the SWIs held, as from
+* the SWI of Poll(), so the posts they make run after each batch. For
+* every pattern it times BATCH calls right after Event_Init(), with the
+* ring empty, and again after FILL_EVENTS more events, the ring long
+* wrapped; the best of REPEAT batches counts. It prints the host ns per
+* call and per event.
+*
+* Then it checks what the ring holds: REG_EVENT_TOTAL has to count every
+* edge, the EVENT_RING_SIZE newest events have to come out of the
+* REG_EVENT_PAGE pages newest first with consecutive sequence numbers,
+* the page past them has to be empty, and REG_EVENT_ERR_STAT[] has to
+* count every rising edge of each bit, with the coil on or off.
+*
+* The program fails if the cost per event with a wrapped ring exceeds
+* MAX_GROWTH times that with an empty one, if an event costs more when
+* all bits toggle than when one does, or if the ring or the counters are
+* wrong.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "EventLog.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         5000000
+#define BATCH           20000       // calls
+#define REPEAT          9
+#define FILL_EVENTS     1000000
+#define MAX_GROWTH      1.5
+#define ALL_ERRORS      ((1u << MAX_ERRORS) - 1)
+
+typedef struct
+{
+    const char  *name;
+    Uint32      mask;
+} PATTERN;
+
+static const PATTERN patterns[] =
+{
+    {"1 bit",           ERR_TMP_HI},
+    {"4 bits",          ERR_WAC_HI | ERR_TMP_LO | ERR_DNS_HI | ERR_AO_RBK},
+    {"all 13 bits",     ALL_ERRORS},
+};
+
+#define NUM_PATTERNS    (sizeof(patterns) / sizeof(patterns[0]))
+
+static Bool up;                     // the toggled bits are set
+static int failures;
+
+static void fail(const char *what)
+{
+    printf("  %s\n", what);
+    failures++;
+}
+
+/// <n> calls, each an edge of every bit of <mask>; host ns
+static UInt64 toggle(Uint32 mask, UInt32 n)
+{
+    UInt64 t0 = Host_Ns();
+    UInt32 i;
+
+    for (i=0; i<n; i++)
+    {
+        up = !up;
+        if (up) Event_Diag(mask, 0, i);
+        else Event_Diag(0, mask, i);
+    }
+
+    return Host_Ns() - t0;
+}
+
+/// the best of REPEAT batches, ns per call
+static double batch(Uint32 mask)
+{
+    double best = 0, ns;
+    int k;
+
+    for (k=0; k<REPEAT; k++)
+    {
+        ns = toggle(mask, BATCH) / (double)BATCH;
+        if (k == 0 || ns < best) best = ns;
+    }
+
+    return best;
+}
+
+static int popcount(Uint32 v)
+{
+    int n = 0;
+
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+/// the ring, page by page, and the counters of the bits of <mask>
+static void checkRing(Uint32 mask, Uint32 rises, Bool logged)
+{
+    Uint32 total = (Uint32)REG_EVENT_TOTAL, want, bit;
+    int page, i, *w, bad = 0;
+
+    for (page=0; page<=EVENT_RING_SIZE/EVENT_PAGE_SIZE; page++)
+    {
+        REG_EVENT_PAGE.val = page;
+        Event_Page_Load();
+
+        for (i=0; i<EVENT_PAGE_SIZE; i++)
+        {
+            w = &REG_EVENT_WIN[i*EVENT_WORDS];
+            want = (UInt32)(page * EVENT_PAGE_SIZE + i) < EVENT_RING_SIZE && logged ?
+                total - page * EVENT_PAGE_SIZE - i : 0;
+            if ((Uint32)w[EVENT_W_SEQ] != want) bad++;
+            if (want && (w[EVENT_W_CODE] >> 16) != EVENT_ERR_SET && (w[EVENT_W_CODE] >> 16) != EVENT_ERR_CLR) bad++;
+        }
+    }
+    REG_EVENT_PAGE.val = 0;
+    if (bad) fail("the pages do not hold the newest events in sequence");
+
+    for (bit=0; bit<MAX_ERRORS; bit++)
+    {
+        REG_EVENT_ERR.val = bit;
+        Event_Page_Load();
+        want = (mask >> bit) & 1 ? rises : 0;
+        if ((Uint32)REG_EVENT_ERR_STAT[EVENT_S_COUNT] != want)
+        {
+            printf("  bit %u: %d rising edges counted, %u made\n", bit, REG_EVENT_ERR_STAT[EVENT_S_COUNT], want);
+            failures++;
+        }
+    }
+    REG_EVENT_ERR.val = 0;
+}
+
+/// ns per event, the ring empty and wrapped
+static void run(const PATTERN *p, Bool logged, double *empty, double *wrapped)
+{
+    int bits = popcount(p->mask);
+    UInt32 calls, events, key;
+    double callEmpty, callWrapped;
+
+    key = Swi_disable();
+    Event_Diag(0, ALL_ERRORS, 0);
+    up = FALSE;
+    COIL_LOG_ERRORS.val = logged;
+    Event_Init();
+
+    callEmpty = batch(p->mask);
+    toggle(p->mask, FILL_EVENTS / bits);
+    callWrapped = batch(p->mask);
+
+    // every call is one edge of each bit, half of them rising
+    calls = 2 * REPEAT * BATCH + FILL_EVENTS / bits;
+    events = (Uint32)REG_EVENT_TOTAL;
+    if (events != (logged ? calls * bits : 0))
+    {
+        printf("  REG_EVENT_TOTAL %u after %u edges\n", events, calls * bits);
+        failures++;
+    }
+    checkRing(p->mask, (calls + 1) / 2, logged);
+
+    Event_Diag(0, ALL_ERRORS, 0);
+    Swi_restore(key);
+
+    *empty = callEmpty / bits;
+    *wrapped = callWrapped / bits;
+    printf("%-12s %5s   %9.1f %9.1f   %9.1f %9.1f   %7u\n", p->name, logged ? "on" : "off",
+        callEmpty, callWrapped, *empty, *wrapped, events);
+}
+
+int main(void)
+{
+    double empty[2][NUM_PATTERNS], wrapped[2][NUM_PATTERNS];
+    UInt32 i;
+    int logged;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    printf("Event_Diag() with an edge of every toggled bit on every call; host ns, best of %d x %d calls\n\n",
+        REPEAT, BATCH);
+    printf("%-12s %5s   %19s   %19s   %7s\n", "", "", "ns per call", "ns per event", "");
+    printf("%-12s %5s   %9s %9s   %9s %9s   %7s\n", "toggling", "coil", "empty", "wrapped", "empty", "wrapped",
+        "events");
+
+    for (logged=1; logged>=0; logged--)
+    {
+        for (i=0; i<NUM_PATTERNS; i++)
+        {
+            run(&patterns[i], logged, &empty[logged][i], &wrapped[logged][i]);
+            if (wrapped[logged][i] > MAX_GROWTH * empty[logged][i])
+                fail("an event costs more once the ring has wrapped");
+        }
+
+        if (wrapped[logged][NUM_PATTERNS-1] > wrapped[logged][0])
+            fail("an event costs more when all bits toggle than when one does");
+    }
+
+    return failures ? 1 : 0;
+}
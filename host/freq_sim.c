@@ -0,0 +1,264 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* freq_sim.c
+*-------------------------------------------------------------------------
+* Feeds timer 3 on the host shim with a simulated pulse train, with edge
+* jitter and frequency drift, and reports the resolution of the
+* reciprocal counter (FreqCapture.c) against the gate time, next to the
+* fixed-gate count the code took before it.
+*
+*   razor_freq
+*
+* The pulse train is the oscillator of OSC_MHZ behind the board's 80x
+* divider. Every edge is moved by a Gaussian jitter of JITTER_NS, the
+* same for an edge whichever time it is read at, so the count never goes
+* backwards. With drift the frequency ramps by DRIFT_PPM_S. Every read of
+* the counter or the timestamp takes READ_NS of device time
+* (Host_DevNs_fixed()), as a register read does on the target; on host
+* time an MMIO read of the shim takes microseconds, and that, not the
+* firmware, would set the resolution.
+*
+* For every REG_FREQ_GATE from 50 ms to 5 s the program runs the kernel
+* and, after each Swi_Poll, reads Freq_Capture_Get() times 80 and
+* compares it with the oscillator. With a steady oscillator the reference
+* is its frequency; with drift, its frequency at that moment, so the
+* error there also holds what a gate lags. The fixed-gate count is the
+* old Count_Freq_Pulses(): the edges of the same train in a gate of the
+* same length ending at the Poll, over the gate. Its resolution is one
+* count per gate. The old code had a gate of 500 ms.
+*
+* At the end the mean of Freq_Capture_Periods() has to give the period of
+* the steady oscillator.
+*
+* The program fails if, with a steady oscillator, the reciprocal counter
+* does not resolve better than the fixed-gate count at every gate, if at
+* the default 500 ms it is not MIN_GAIN times better than the old gate,
+* if a Poll has no result, or if the mean period is off by more than
+* MAX_PERIOD_PPM.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "FreqCapture.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         5000000
+#define POLL_US         (FREQ_TICK_US * FREQ_POLL_TICKS)
+#define SETTLE_US       (FREQ_GATE_MAX * 1000 + 2 * POLL_US)
+#define SAMPLES         100         // Polls per gate
+#define OSC_MHZ         183.7261
+#define DIVIDER         80          // oscillator board
+#define JITTER_NS       20.0
+#define DRIFT_PPM_S     0.5
+#define READ_NS         40
+#define OLD_GATE_MS     500
+#define MIN_GAIN        2.0
+#define MAX_PERIOD_PPM  10.0
+
+static const int gates[] = {50, 100, 200, 500, 1000, 2000, 5000};  // REG_FREQ_GATE, ms
+
+#define NUM_GATES       (sizeof(gates) / sizeof(gates[0]))
+
+/// the pulse train at the counter input
+static struct
+{
+    UInt64  t0;                     // dev ns at the first edge
+    double  hz;                     // at t0
+    double  drift;                  // per second, relative
+    double  jitter;                 // edge jitter in periods
+} train;
+
+static int failures;
+
+/// a Gaussian of edge <k>, always the same one
+static double gauss(UInt64 k)
+{
+    UInt64 a = k * 0x9E3779B97F4A7C15ull, b;
+    double u, v;
+
+    a = (a ^ (a >> 30)) * 0xBF58476D1CE4E5B9ull;
+    a = (a ^ (a >> 27)) * 0x94D049BB133111EBull;
+    b = (a ^ (a >> 31)) * 0x9E3779B97F4A7C15ull;
+    b ^= b >> 29;
+
+    u = ((a >> 11) + 0.5) / 9007199254740992.0;
+    v = ((b >> 11) + 0.5) / 9007199254740992.0;
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/// periods since t0 at <s> seconds since t0
+static double phase(double s)
+{
+    return train.hz * (s + train.drift * s * s / 2);
+}
+
+/// the frequency at <s> seconds since t0, Hz
+static double trainHz(double s)
+{
+    return train.hz * (1 + train.drift * s);
+}
+
+/// edges up to dev time <ns>
+static UInt32 trainEdges(UInt64 ns)
+{
+    double p;
+    UInt64 k;
+
+    if (ns <= train.t0) return 0;
+    p = phase((ns - train.t0) / 1e9);
+    k = (UInt64)p;
+
+    // edge k comes at phase k plus its jitter
+    while (k + 1 + train.jitter * gauss(k + 1) <= p) k++;
+    while (k > 0 && k + train.jitter * gauss(k) > p) k--;
+
+    return (UInt32)k;
+}
+
+static void trainStart(double drift)
+{
+    train.t0 = Host_DevNs();
+    train.hz = OSC_MHZ * 1e6 / DIVIDER;
+    train.drift = drift * 1e-6;
+    train.jitter = JITTER_NS * 1e-9 * train.hz;
+    Host_Tmr3_source(trainEdges);
+}
+
+/// RMS error of the reciprocal counter and of a fixed gate as long, ppm
+static Bool run(int gate, double drift, double *recip, double *fixed)
+{
+    double s, ref, f, e, sumRecip = 0, sumFixed = 0;
+    UInt32 lo, hi, us, i, missing = 0;
+    UInt64 ns;
+
+    REG_FREQ_GATE = gate;
+    trainStart(drift);
+    Host_Run(SETTLE_US);
+
+    for (i=0; i<SAMPLES; i++)
+    {
+        Host_Run(POLL_US);
+
+        ns = Host_Now() * 1000u;
+        s = (ns - train.t0) / 1e9;
+        ref = trainHz(s);
+
+        f = Freq_Capture_Get(&lo, &hi, &us) * 1e6;
+        if (f == 0 || hi) missing++;
+        e = (f - ref) / ref * 1e6;
+        sumRecip += e * e;
+
+        f = (trainEdges(ns) - (double)trainEdges(ns - gate * 1000000ull)) / (gate / 1e3);
+        e = (f - ref) / ref * 1e6;
+        sumFixed += e * e;
+    }
+
+    *recip = sqrt(sumRecip / SAMPLES);
+    *fixed = sqrt(sumFixed / SAMPLES);
+
+    return missing == 0;
+}
+
+static void checkPeriods(void)
+{
+    double ns[FREQ_RING_SIZE], sum = 0, want, err;
+    int n, i;
+
+    REG_FREQ_GATE = FREQ_GATE_MAX;
+    trainStart(0);
+    Host_Run(FREQ_RING_SIZE * FREQ_TICK_US + POLL_US);
+
+    n = Freq_Capture_Periods(ns, FREQ_RING_SIZE);
+    for (i=0; i<n; i++) sum += ns[i];
+
+    want = 1e9 / train.hz;
+    err = n ? (sum / n - want) / want * 1e6 : 0;
+    printf("\nFreq_Capture_Periods(): %d periods, mean %.4f ns, %.2f ppm off %.4f ns\n", n, n ? sum / n : 0,
+        err, want);
+
+    if (n != FREQ_RING_SIZE - 1 || fabs(err) > MAX_PERIOD_PPM)
+    {
+        printf("  the ring does not give the period of the oscillator\n");
+        failures++;
+    }
+}
+
+int main(void)
+{
+    double recip[2][NUM_GATES], fixed[2][NUM_GATES], old = 0;
+    UInt32 i;
+    int drift;
+    Bool ok;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+    Host_DevNs_fixed(READ_NS);
+
+    printf("oscillator %.4f MHz / %d, edge jitter %.0f ns rms, drift %.1f ppm/s; %d Polls per gate\n",
+        OSC_MHZ, DIVIDER, JITTER_NS, DRIFT_PPM_S, SAMPLES);
+    printf("rms error in ppm of the oscillator frequency, %d ns per register read\n\n", READ_NS);
+    printf("%7s   %-21s   %-21s\n", "", "steady", "drifting");
+    printf("%7s   %10s %10s   %10s %10s\n", "gate ms", "reciprocal", "fixed gate", "reciprocal", "fixed gate");
+
+    for (i=0; i<NUM_GATES; i++)
+    {
+        ok = TRUE;
+        for (drift=0; drift<2; drift++)
+            ok &= run(gates[i], drift ? DRIFT_PPM_S : 0, &recip[drift][i], &fixed[drift][i]);
+
+        printf("%7d   %10.4f %10.4f   %10.4f %10.4f\n", gates[i], recip[0][i], fixed[0][i], recip[1][i], fixed[1][i]);
+
+        if (gates[i] == OLD_GATE_MS) old = fixed[0][i];
+        if (!ok)
+        {
+            printf("  a Poll had no frequency\n");
+            failures++;
+        }
+        if (recip[0][i] >= fixed[0][i])
+        {
+            printf("  the reciprocal counter does not resolve better than a fixed gate\n");
+            failures++;
+        }
+    }
+
+    for (i=0; i<NUM_GATES; i++)
+    {
+        if (gates[i] != OLD_GATE_MS) continue;
+
+        printf("\ndefault %d ms gate: %.4f ppm, the old fixed gate %.4f ppm, %.1fx\n", OLD_GATE_MS, recip[0][i],
+            old, recip[0][i] > 0 ? old / recip[0][i] : 0.0);
+        if (recip[0][i] * MIN_GAIN > old)
+        {
+            printf("  less than %.0fx\n", MIN_GAIN);
+            failures++;
+        }
+    }
+
+    checkPeriods();
+
+    return failures ? 1 : 0;
+}
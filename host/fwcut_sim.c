@@ -0,0 +1,326 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* fwcut_sim.c
+*-------------------------------------------------------------------------
+* Cuts the power at every NAND program and erase of a firmware upgrade
+* (nandwriter.c), on the host shim, and reports which image the board
+* starts afterwards.
+*
+*   razor_fwcut
+*
+* Boot is main() on a blank NAND, and the stick is mounted as the upgrade
+* screen does. The old image is flashed into one slot
+* the way a programmer would, the new one is put on the stick, and
+* Swi_upgradeFirmware is posted as the menu does. That is done twice:
+* from slot A to slot B, and back from B to A. For operation k of the
+* upgrade a fork() of the simulator runs it with the power cut at k
+* (Host_Nand_cut), once with the operation dropped and once with a torn
+* page program. At the cut the ROM model picks the image the ROM boot
+* loader would start: the first block from block 1 on whose page 0
+* holds the AIS magic, read over the good blocks that follow. If that is
+* an image, it runs Resume_Firmware_Upgrade() and asks the ROM model
+* again, as after the restart Init_All() then asks for. The upgrade
+* without a cut ends in WD_Restart(), which spins; a wall-time alarm
+* stands for the watchdog reset there.
+*
+* The program fails if the board ever ends up without an image in the
+* A to B direction, or on the new image without the upgrade having
+* been committed, or in the B to A direction other than at the one
+* page program nandwriter.c documents (a torn AIS header).
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#define truncate unistd_truncate    // Globals.h has its own truncate()
+#include <unistd.h>
+#undef truncate
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "host_usb.h"
+#include "host_fatfs.h"
+#include "Globals.h"
+#include "nand.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define FIRMWARE        "0:pdi_razor_firmware.ais"
+#define APP_START_BLK   1           // nandwriter.c
+#define FW_SLOT_BLKS    24
+#define ROM_BLKS        (2 * FW_SLOT_BLKS)
+#define AIS_MAGIC       0x41504954
+#define PAGE            2048
+#define PPB             64
+#define OLD_SIZE        (70 * PAGE + 100)
+#define NEW_SIZE        (90 * PAGE + 300)
+#define BOOT_US         10000000
+#define UPGRADE_US      60000000
+#define SPIN_LIMIT_US   3000000     // wall time WD_Restart() is given to show up
+
+enum { OLD, NEW, BRICK, NUM_IMG };
+static const char *imgName[NUM_IMG] = {"old", "new", "none"};
+
+/* child exit codes */
+#define EXIT_CUT        10          // + 3 * at the cut + after Resume
+#define EXIT_DONE       30          // + image after a complete upgrade
+#define EXIT_NO_CUT     40          // upgrade ended without restart
+
+static UInt8 oldImg[OLD_SIZE], newImg[NEW_SIZE];
+static UInt8 page[PAGE];
+
+typedef struct
+{
+    UInt32  cuts;
+    UInt32  brick;                  // no image at the cut
+    UInt32  old;                    // old image, upgrade lost
+    UInt32  resumed;                // old image at the cut, new after Resume
+    UInt32  updated;                // new image at the cut
+    UInt32  wrong;                  // Resume lost the new image or the board
+    UInt32  brickOp;                // operation of the first brick
+    UInt32  done;                   // image after the complete upgrade
+} SWEEP;
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_fwcut: %s\n", what);
+    exit(1);
+}
+
+static void makeImage(UInt8 *img, UInt32 size, UInt32 seed)
+{
+    UInt32 i, w = AIS_MAGIC;
+
+    for (i=0; i<size; i++)
+    {
+        img[i] = (UInt8)(seed >> 16);
+        seed = seed * 1103515245 + 12345;
+    }
+    memcpy(img, &w, sizeof(w));
+}
+
+/// the image the ROM boot loader would start
+static int rom(void)
+{
+    NAND_InfoHandle h = NAND_open(0x62000000, BUS_16BIT);
+    UInt32 blk, first, p, n, w;
+    Bool isOld = TRUE, isNew = TRUE;
+
+    for (first=APP_START_BLK; first<APP_START_BLK+ROM_BLKS; first++)
+    {
+        if (NAND_badBlockCheck(h, first) != E_PASS) continue;
+        NAND_readPage(h, first, 0, page);
+        memcpy(&w, page, sizeof(w));
+        if (w == AIS_MAGIC) break;
+    }
+    if (first == APP_START_BLK+ROM_BLKS) return BRICK;
+
+    for (blk=first, p=0; (isOld || isNew) && (p*PAGE < NEW_SIZE || p*PAGE < OLD_SIZE); p++)
+    {
+        if (p % PPB == 0 && p)
+        {
+            for (blk++; NAND_badBlockCheck(h, blk) != E_PASS; blk++);
+        }
+        NAND_readPage(h, blk, p % PPB, page);
+
+        if (p*PAGE < OLD_SIZE)
+        {
+            n = (OLD_SIZE - p*PAGE < PAGE) ? OLD_SIZE - p*PAGE : PAGE;
+            if (memcmp(page, oldImg + p*PAGE, n)) isOld = FALSE;
+        }
+        if (p*PAGE < NEW_SIZE)
+        {
+            n = (NEW_SIZE - p*PAGE < PAGE) ? NEW_SIZE - p*PAGE : PAGE;
+            if (memcmp(page, newImg + p*PAGE, n)) isNew = FALSE;
+        }
+    }
+
+    return isNew ? NEW : isOld ? OLD : BRICK;
+}
+
+/// power back on at the cut: the ROM, then Init_All()
+static void onCut(void)
+{
+    NAND_InfoHandle h = NAND_open(0x62000000, BUS_16BIT);
+    int before, after;
+
+    NAND_protectBlocks(h);
+    before = rom();
+    after = before;
+    if (before != BRICK)
+    {
+        Resume_Firmware_Upgrade();
+        after = rom();
+    }
+
+    _exit(EXIT_CUT + 3 * before + after);
+}
+
+/// WD_Restart() is spinning
+static void onSpin(int sig)
+{
+    (void)sig;
+    _exit(EXIT_DONE + rom());
+}
+
+/// flash <img> into <slot> as a programmer would, and erase the other
+/// slot's first block
+static void flash(UInt32 slot, const UInt8 *img, UInt32 size)
+{
+    NAND_InfoHandle h = NAND_open(0x62000000, BUS_16BIT);
+    UInt32 first = APP_START_BLK + slot * FW_SLOT_BLKS;
+    UInt32 p, n;
+
+    NAND_unProtectBlocks(h, APP_START_BLK, ROM_BLKS);
+    NAND_eraseBlocks(h, APP_START_BLK, ROM_BLKS);
+    for (p=0; p*PAGE < size; p++)
+    {
+        n = (size - p*PAGE < PAGE) ? size - p*PAGE : PAGE;
+        memset(page, 0xFF, PAGE);
+        memcpy(page, img + p*PAGE, n);
+        NAND_writePage(h, first + p / PPB, p % PPB, page);
+    }
+    NAND_protectBlocks(h);
+}
+
+static void putOnStick(const UInt8 *img, UInt32 size)
+{
+    FIL f;
+    UINT bw;
+
+    if (f_open(&f, FIRMWARE, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) fail("cannot create the image on the stick");
+    if (f_write(&f, img, size, &bw) != FR_OK || bw != size) fail("cannot write the image on the stick");
+    f_close(&f);
+}
+
+/// one upgrade per cut point, each in a fork of the booted simulator
+static void sweep(Bool torn, SWEEP *s)
+{
+    static const struct itimerval limit = {{0, 0}, {SPIN_LIMIT_US / 1000000, SPIN_LIMIT_US % 1000000}};
+    UInt32 k;
+    pid_t pid;
+    int status, code, before, after;
+
+    memset(s, 0, sizeof(*s));
+    s->done = NUM_IMG;
+
+    for (k=0; ; k++)
+    {
+        fflush(stdout);
+        pid = fork();
+        if (pid < 0) fail("fork");
+
+        if (pid == 0)
+        {
+            Host_Mmio_fork();
+            Host_Nand_cut(k, torn, onCut);
+            signal(SIGALRM, onSpin);
+            setitimer(ITIMER_REAL, &limit, NULL);
+            Swi_post(Swi_upgradeFirmware);
+            Host_Run(UPGRADE_US);
+            _exit(EXIT_NO_CUT);
+        }
+
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) fail("simulator crashed");
+        code = WEXITSTATUS(status);
+
+        if (code >= EXIT_DONE && code < EXIT_DONE + NUM_IMG)
+        {
+            s->done = code - EXIT_DONE;
+            return;
+        }
+        if (code < EXIT_CUT || code >= EXIT_CUT + NUM_IMG * NUM_IMG) fail("upgrade did not complete");
+
+        before = (code - EXIT_CUT) / 3;
+        after = (code - EXIT_CUT) % 3;
+        s->cuts++;
+
+        if (before == BRICK)
+        {
+            if (s->brick++ == 0) s->brickOp = k;
+        }
+        else if (after == BRICK || (before == NEW && after != NEW)) s->wrong++;
+        else if (before == NEW) s->updated++;
+        else if (after == NEW) s->resumed++;
+        else s->old++;
+    }
+}
+
+static void print(const char *dir, const char *mode, const SWEEP *s)
+{
+    printf("%-7s %-8s %5u %7u %8u %8u %6u %6u   %s\n", dir, mode, s->cuts, s->old, s->resumed,
+        s->updated, s->brick, s->wrong, imgName[s->done]);
+}
+
+int main(void)
+{
+    static const char *dir[2] = {"A to B", "B to A"};
+    SWEEP drop[2], torn[2];
+    UInt32 d;
+    int rc = 0;
+
+    makeImage(oldImg, OLD_SIZE, 1);
+    makeImage(newImg, NEW_SIZE, 2);
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Ff_format();
+    Host_Usb_attach(TRUE);
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    // as the upgrade screen does
+    Swi_post(Swi_usbhMscDriveOpen);
+    Swi_post(Swi_enumerateUsb);
+    Host_Run(BOOT_US);
+    if (!isUsbMounted) fail("stick not mounted");
+
+    putOnStick(newImg, NEW_SIZE);
+
+    for (d=0; d<2; d++)
+    {
+        flash(d, oldImg, OLD_SIZE);
+        if (rom() != OLD) fail("old image not flashed");
+
+        sweep(FALSE, &drop[d]);
+        sweep(TRUE, &torn[d]);
+    }
+
+    printf("old image %u pages, new %u pages; for each cut, the image the board runs\n\n",
+        (OLD_SIZE + PAGE - 1) / PAGE, (NEW_SIZE + PAGE - 1) / PAGE);
+    printf("slots   cut       ops     old  resumed      new   none  wrong   no cut\n");
+    for (d=0; d<2; d++)
+    {
+        print(dir[d], "dropped", &drop[d]);
+        print(dir[d], "torn", &torn[d]);
+    }
+    printf("\nold: upgrade lost; resumed: old at the cut, new after Resume_Firmware_Upgrade();\n"
+           "none: the ROM finds no image; wrong: Resume lost the new image or the board\n");
+    if (torn[1].brick) printf("B to A torn: first no-image cut at operation %u\n", torn[1].brickOp);
+
+    for (d=0; d<2; d++)
+    {
+        if (drop[d].done != NEW || torn[d].done != NEW) rc = 1;
+        if (drop[d].wrong || torn[d].wrong || drop[d].brick) rc = 1;
+    }
+    if (torn[0].brick || torn[1].brick > 1) rc = 1;
+
+    return rc;
+}
@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+#-------------------------------------------------------------------------
+# gen_cfg.py
+#-------------------------------------------------------------------------
+# Mirrors the static SYS/BIOS objects of PDI_Razor.cfg for the host build.
+#
+#   gen_cfg.py <PDI_Razor.cfg> <outdir> [firmware source dirs...]
+#
+# writes
+#   <outdir>/cfg_objects.c          one static object per Task, Clock,
+#                                   Semaphore, Swi, Hwi, Timer and HeapBuf,
+#                                   Host_Cfg_Create() that constructs them
+#                                   with the cfg parameters, and weak no-op
+#                                   stand-ins for every function the cfg
+#                                   names, so any subset of the firmware
+#                                   links
+#   <outdir>/include/xdc/cfg/global.h
+#                                   extern handles, as the XDC tools emit
+#   <outdir>/include/...            one forwarding header for every TI
+#                                   header the firmware sources include
+#                                   (SYS/BIOS and XDC -> host_bios.h,
+#                                   CSL, board and c6x.h -> host_csl.h,
+#                                   FatFs -> host_fatfs.h, the USB and
+#                                   UART drivers -> host_usb.h), and for
+#                                   every quoted header that is not in the
+#                                   source dirs: a case-insensitive match
+#                                   there if one exists, else host_usb.h
+#                                   (the TI USB library headers)
+#
+# Only the cfg statements the firmware uses are understood: Params
+# objects and their fields, <Module>.create() into Program.global, hook
+# sets, Clock.tickPeriod and Clock.swiPriority. Defaults are the SYS/BIOS
+# ones. Anything else in the cfg is ignored.
+#-------------------------------------------------------------------------
+
+import os
+import re
+import sys
+
+TI_INCLUDE = re.compile(r'^\s*#\s*include\s*<((?:xdc|ti)/[^>]+|c6x\.h)>', re.M)
+QUOTED     = re.compile(r'^\s*#\s*include\s*"([^"/]+)"', re.M)
+C_LIBRARY  = ('stdio.h', 'stdlib.h', 'string.h')
+
+DEFAULTS = {
+    'Task':      {'priority': 1, 'stackSize': 0, 'arg0': 0, 'arg1': 0},
+    'Clock':     {'period': 0, 'startFlag': 0, 'arg': 0},
+    'Semaphore': {'mode': 'Mode_COUNTING'},
+    'Swi':       {'priority': 15, 'arg0': 0, 'arg1': 0},
+    'Hwi':       {'arg': 0, 'enableInt': 1},
+    'Timer':     {'period': 0, 'arg': 0, 'intNum': -1,
+                  'runMode': 'RunMode_CONTINUOUS', 'startMode': 'StartMode_AUTO'},
+    'HeapBuf':   {},
+}
+
+def strip_comments(text):
+    text = re.sub(r'/\*.*?\*/', '', text, flags=re.S)
+    return re.sub(r'//[^\n]*', '', text)
+
+def value(v):
+    """cfg right-hand side -> int, or the last identifier for enums"""
+    v = v.strip()
+    if v in ('null', 'false'): return 0
+    if v == 'true': return 1
+    if re.fullmatch(r'-?(0x[0-9a-fA-F]+|\d+)', v): return int(v, 0)
+    if v.startswith('"') or v.startswith("'"): return v.strip('"\'')
+    return re.split(r'[.\s]', v.rstrip(')'))[-1]
+
+def split_args(s):
+    args, depth, cur = [], 0, ''
+    for c in s:
+        if c in '({[': depth += 1
+        if c in ')}]': depth -= 1
+        if c == ',' and depth == 0:
+            args.append(cur.strip())
+            cur = ''
+        else:
+            cur += c
+    if cur.strip(): args.append(cur.strip())
+    return args
+
+def fxn_name(arg):
+    name = value(arg)
+    if not isinstance(name, str) or not name.startswith('&'):
+        sys.exit('gen_cfg.py: expected a "&function", got %s' % arg)
+    return name[1:]
+
+def parse(text):
+    text    = strip_comments(text)
+    params  = {}
+    objects = []
+    hooks   = []
+    clock   = {'tickPeriod': 1000, 'swiPriority': 15}
+
+    for m in re.finditer(r'var\s+(\w+)\s*=\s*new\s+(\w+)\.Params\(\)', text):
+        params[m.group(1)] = {'_module': m.group(2)}
+
+    for m in re.finditer(r'\b(\w+)\.(instance\.name|\w+)\s*=\s*([^;]+);', text):
+        var, field, rhs = m.groups()
+        if var in params: params[var][field] = value(rhs)
+        if var == 'Clock' and field in clock: clock[field] = value(rhs)
+
+    for m in re.finditer(r'Program\.global\.(\w+)\s*=\s*(\w+)\.create\(([^;]*)\)\s*;', text):
+        handle, module, args = m.group(1), m.group(2), split_args(m.group(3))
+        if module not in DEFAULTS: continue
+        p = dict(DEFAULTS[module])
+        if args and args[-1] in params: p.update(params[args[-1]])
+        obj = {'handle': handle, 'module': module, 'params': p,
+               'name': p.get('instance.name', handle)}
+
+        if module == 'Task' or module == 'Swi':
+            obj['fxn'] = fxn_name(args[0])
+        elif module == 'Clock':
+            obj['fxn'], obj['timeout'] = fxn_name(args[0]), value(args[1])
+        elif module == 'Semaphore':
+            obj['count'] = value(args[0])
+        elif module == 'Hwi':
+            obj['intNum'], obj['fxn'] = value(args[0]), fxn_name(args[1])
+        elif module == 'Timer':
+            tid = value(args[0])
+            obj['id'], obj['fxn'] = (tid if isinstance(tid, int) else -1), fxn_name(args[1])
+        objects.append(obj)
+
+    for m in re.finditer(r'\b(Swi|Task|Hwi)\.addHookSet\(\{([^}]*)\}\)', text):
+        fxns = dict((k, v[1:]) for k, v in re.findall(r'(\w+)\s*:\s*[\'"](&\w+)[\'"]', m.group(2)))
+        hooks.append((m.group(1), fxns))
+
+    return clock, objects, hooks
+
+HOOK_SIGNATURE = {
+    'registerFxn': 'void %s(Int id)',
+    'beginFxn':    'void %s(%s_Handle h)',
+    'endFxn':      'void %s(%s_Handle h)',
+    'switchFxn':   'void %s(Task_Handle prev, Task_Handle next)',
+}
+
+def write_objects(path, clock, objects, hooks):
+    out  = []
+    fxns = []
+    for o in objects:
+        if 'fxn' in o and o['fxn'] not in fxns: fxns.append(o['fxn'])
+
+    out.append('/* generated by gen_cfg.py from PDI_Razor.cfg - do not edit */')
+    out.append('#include "host_bios.h"')
+    out.append('')
+    out.append('/* weak stand-ins, replaced by the firmware modules that are linked */')
+    for f in fxns:
+        out.append('__attribute__((weak)) void %s(void) {}' % f)
+    for module, hs in hooks:
+        for kind, f in hs.items():
+            sig = HOOK_SIGNATURE[kind]
+            sig = sig % ((f, module) if sig.count('%s') == 2 else f)
+            out.append('__attribute__((weak)) %s { %s}' % (sig, ''.join('(void)%s; ' % a for a in re.findall(r'(\w+)(?=[,)])', sig))))
+    out.append('')
+
+    for o in objects:
+        out.append('static %s_Struct %s_obj;' % (o['module'], o['handle']))
+        out.append('%s_Handle %s = &%s_obj;' % (o['module'], o['handle'], o['handle']))
+    out.append('')
+
+    out.append('void Host_Cfg_Create(void)')
+    out.append('{')
+    out.append('    Host_Clock_Config(%d, %d);' % (clock['tickPeriod'], clock['swiPriority']))
+    for module, hs in hooks:
+        if module == 'Task':
+            out.append('    Host_Task_addHookSet(%s, %s);' % (hs.get('registerFxn', 'NULL'), hs.get('switchFxn', 'NULL')))
+        else:
+            out.append('    Host_%s_addHookSet(%s, %s, %s);' % (module, hs.get('registerFxn', 'NULL'),
+                       hs.get('beginFxn', 'NULL'), hs.get('endFxn', 'NULL')))
+    for o in objects:
+        p, h = o['params'], '&%s_obj' % o['handle']
+        if o['module'] == 'Task':
+            out.append('    Host_Task_Construct(%s, "%s", (Host_Fxn)%s, %d, %d, %d, %d);'
+                       % (h, o['name'], o['fxn'], p['priority'], p['stackSize'], p['arg0'], p['arg1']))
+        elif o['module'] == 'Clock':
+            out.append('    Host_Clock_Construct(%s, "%s", (Host_Fxn)%s, %d, %d, %d, %d);'
+                       % (h, o['name'], o['fxn'], o['timeout'], p['period'], p['startFlag'], p['arg']))
+        elif o['module'] == 'Semaphore':
+            out.append('    Host_Semaphore_Construct(%s, "%s", %d, %d);'
+                       % (h, o['name'], o['count'], p['mode'] == 'Mode_BINARY'))
+        elif o['module'] == 'Swi':
+            out.append('    Host_Swi_Construct(%s, "%s", (Host_Fxn)%s, %d, %d, %d);'
+                       % (h, o['name'], o['fxn'], p['priority'], p['arg0'], p['arg1']))
+        elif o['module'] == 'Hwi':
+            out.append('    Host_Hwi_Construct(%s, "%s", %d, (Host_Fxn)%s, %d, %d);'
+                       % (h, o['name'], o['intNum'], o['fxn'], p['enableInt'], p['arg']))
+        elif o['module'] == 'Timer':
+            out.append('    Host_Timer_Construct(%s, "%s", %d, %d, (Host_Fxn)%s, %d, %d, %d, %d);'
+                       % (h, o['name'], o['id'], p['intNum'], o['fxn'], p['period'],
+                          p['runMode'] == 'RunMode_ONESHOT', p['startMode'] == 'StartMode_AUTO', p['arg']))
+    out.append('}')
+    write(path, '\n'.join(out) + '\n')
+
+def write_global(path, objects):
+    out = ['/* generated by gen_cfg.py from PDI_Razor.cfg - do not edit */',
+           '#ifndef _XDC_CFG_GLOBAL',
+           '#define _XDC_CFG_GLOBAL',
+           '#include "host_bios.h"', '']
+    for o in objects:
+        out.append('extern %s_Handle %s;' % (o['module'], o['handle']))
+    out.append('')
+    out.append('#endif')
+    write(path, '\n'.join(out) + '\n')
+
+def forward_target(h):
+    if h.startswith('ti/csl/') or h.startswith('ti/board/') or h == 'c6x.h': return 'host_csl.h'
+    if h.startswith('ti/fs/'): return 'host_fatfs.h'
+    if h.startswith('ti/drv/'): return 'host_usb.h'
+    return 'host_bios.h'
+
+def write_forwarders(incdir, srcdirs):
+    headers = set()
+    quoted  = set()
+    present = {}
+    for d in srcdirs:
+        for f in sorted(os.listdir(d)):
+            if not f.endswith(('.c', '.h')): continue
+            present[f.lower()] = f
+            with open(os.path.join(d, f), errors='replace') as fh:
+                text = fh.read()
+            headers.update(TI_INCLUDE.findall(text))
+            quoted.update(QUOTED.findall(text))
+    headers.discard('xdc/cfg/global.h')
+
+    for h in sorted(headers):
+        write(os.path.join(incdir, h), '/* generated by gen_cfg.py - forwards <%s> to the host shim */\n'
+                                       '#include "%s"\n' % (h, forward_target(h)))
+
+    for h in sorted(quoted):
+        if present.get(h.lower()) == h or h in C_LIBRARY: continue
+        target = present.get(h.lower(), 'host_usb.h')
+        write(os.path.join(incdir, h), '/* generated by gen_cfg.py - forwards "%s" to "%s" */\n'
+                                       '#include "%s"\n' % (h, target, target))
+
+def write(path, text):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    # leave an unchanged file alone so make does not rebuild everything
+    if os.path.exists(path):
+        with open(path) as fh:
+            if fh.read() == text: return
+    with open(path, 'w') as fh:
+        fh.write(text)
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: gen_cfg.py <PDI_Razor.cfg> <outdir> [firmware source dirs...]')
+
+    with open(sys.argv[1]) as fh:
+        clock, objects, hooks = parse(fh.read())
+
+    outdir = sys.argv[2]
+    write_objects(os.path.join(outdir, 'cfg_objects.c'), clock, objects, hooks)
+    write_global(os.path.join(outdir, 'include', 'xdc', 'cfg', 'global.h'), objects)
+    write_forwarders(os.path.join(outdir, 'include'), sys.argv[3:])
+
+if __name__ == '__main__':
+    main()
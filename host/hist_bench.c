@@ -0,0 +1,392 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* hist_bench.c
+*-------------------------------------------------------------------------
+* Benchmark of the trend store (History.c) on the host shim: what an
+* insert costs a Poll, what a query over a whole tier costs, and how much
+* memory each tier takes.
+*
+*   razor_hist
+*
+* After the firmware has booted, the program fills the store with
+* FILL_DAYS of samples, one every SAMPLE_S, so every tier has wrapped. For
+* each sample it steps the disciplined time there (RTC_Time_Sync() after
+* RTC_Time_Invalidate(), as a clock set does), sets the five process
+* values from a daily cycle with noise and calls Hist_Update(), with the
+* SWIs held off so Poll leaves them alone. An insert into a new minute
+* is timed on its own; inserts into the current one are timed CALLS at a
+* time, best of REPEAT, before the fill at a time a year earlier whose
+* buckets the fill takes over, and compared with the mean Poll of a
+* normal run.
+*
+* Queries: Hist_Range() over the whole of each tier ending now, and
+* Hist_Page_Load() for the last 24 hours of minutes, in host ns, best of
+* REPEAT. Each aggregate is checked against the same samples summed up
+* here. Then the 24 hour query goes over Modbus, as a DCS would send it,
+* and the aggregate read back from MB_HIST_WIN has to be the same.
+*
+* Memory: the size of the HISTREC section, where the Makefile places the
+* store, less its magic word, split into the tiers by their slot counts,
+* next to the table in History.h, and the day tier that Hist_Save()
+* copies to NAND.
+*
+* The program fails if the inserts cost a Poll more than MAX_SHARE, with
+* a new minute every POLLS_PER_MIN Polls, if an aggregate is wrong, if
+* the Modbus query does not return it, or if the store is not the size
+* History.h gives.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "RtcTime.h"
+#include "History.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define SLAVE           1           // factory default REG_SLAVE_ADDRESS
+#define MB_HIST_TIER    256         // ModbusTables.h
+#define MB_HIST_QTY     257
+#define MB_HIST_QUERY   260
+#define MB_HIST_FROM    395
+#define MB_HIST_TO      397
+#define MB_HIST_WIN     64435
+#define BOOT_US         10000000
+#define RUN_US          30000000
+#define START_EPOCH     1704067200u // 2024-01-01 00:00:00
+#define FILL_DAYS       (HIST_DAY_SLOTS + 2)
+#define SAMPLE_S        20
+#define CALLS           200000
+#define REPEAT          5
+#define MAX_SHARE       0.10
+#define POLLS_PER_MIN   120
+#define MEAN_TOL        1e-4        // relative, float means of up to a year
+#define STORE_BYTES     212184      // History.h, the buckets
+#define BUCKET_BYTES    84
+
+/// HIST_REC, placed in its own section by the Makefile
+extern UInt8 __start_HISTREC[], __stop_HISTREC[];
+
+static const char *TIER_NAME[HIST_NUM_TIERS] = {"minute", "hour", "day"};
+static const char *QTY_NAME[HIST_NUM_QTY] = {"watercut", "temp", "freq", "rp", "density"};
+static const UInt32 TIER_SLOTS[HIST_NUM_TIERS] = {HIST_MINUTE_SLOTS, HIST_HOUR_SLOTS, HIST_DAY_SLOTS};
+static const UInt32 TIER_SECS[HIST_NUM_TIERS] = {60, 3600, 86400};
+
+static int failures;
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_hist: %s\n", what);
+    exit(1);
+}
+
+/// a uniform in [-1, 1) of <t> and <q>, always the same one
+static double noise(UInt32 t, int q)
+{
+    UInt64 a = ((UInt64)t << 3 | q) * 0x9E3779B97F4A7C15ull;
+
+    a = (a ^ (a >> 30)) * 0xBF58476D1CE4E5B9ull;
+    a = (a ^ (a >> 27)) * 0x94D049BB133111EBull;
+
+    return (a >> 11) / 4503599627370496.0 - 1.0;
+}
+
+/// quantity <q> at epoch second <t>, as Hist_Update() stores it
+static float value(UInt32 t, int q)
+{
+    static const double BASE[HIST_NUM_QTY] = {12.0, 45.0, 275.0, 1.2, 850.0};
+    static const double SWING[HIST_NUM_QTY] = {4.0, 8.0, 3.0, 0.2, 10.0};
+    double day = sin(2 * M_PI * (t % 86400) / 86400.0);
+
+    return (float)(BASE[q] + SWING[q] * (day + 0.25 * noise(t, q)));
+}
+
+/// the disciplined time to <t>, as a clock set does
+static void setTime(UInt32 t)
+{
+    time_t s = t;
+    struct tm tm;
+
+    gmtime_r(&s, &tm);
+    RTC_Time_Invalidate();
+    RTC_Time_Sync(tm.tm_sec, tm.tm_min, tm.tm_hour, tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900 - RTC_BASE_YEAR);
+}
+
+static void setValues(UInt32 t)
+{
+    REG_WATERCUT.calc_val = value(t, HIST_Q_WATERCUT);
+    REG_TEMP_USER.calc_val = value(t, HIST_Q_TEMP);
+    REG_FREQ.calc_val = value(t, HIST_Q_FREQ);
+    REG_OIL_RP = value(t, HIST_Q_RP);
+    REG_OIL_DENSITY.calc_val = value(t, HIST_Q_DENSITY);
+}
+
+/// FILL_DAYS of samples; host ns per insert into a new minute
+static double fill(UInt32 *end)
+{
+    UInt64 t0, ns = 0, empty;
+    UInt32 t, n = 0;
+
+    t0 = Host_Ns();
+    empty = Host_Ns() - t0;
+
+    for (t=START_EPOCH; t<START_EPOCH + FILL_DAYS * 86400u; t+=SAMPLE_S)
+    {
+        setTime(t);
+        setValues(t);
+
+        t0 = Host_Ns();
+        Hist_Update();
+        if (t % 60 < SAMPLE_S)
+        {
+            ns += Host_Ns() - t0 - empty;
+            n++;
+        }
+        *end = t;
+    }
+
+    return n ? (double)ns / n : 0;
+}
+
+/// host ns per insert into the current minute, best of REPEAT
+static double insertNs(void)
+{
+    double ns, best = 0;
+    UInt64 t0;
+    int i, k;
+
+    for (k=0; k<REPEAT; k++)
+    {
+        t0 = Host_Ns();
+        for (i=0; i<CALLS; i++) Hist_Update();
+        ns = (Host_Ns() - t0) / (double)CALLS;
+        if (k == 0 || ns < best) best = ns;
+    }
+
+    return best;
+}
+
+/// the samples of <q> in [from, to], summed up here
+static void reference(int q, UInt32 from, UInt32 to, UInt32 end, HIST_STAT *s)
+{
+    double sum = 0;
+    UInt32 t;
+    float x;
+
+    memset(s, 0, sizeof(*s));
+    if (from < START_EPOCH) from = START_EPOCH;
+    from = START_EPOCH + (from - START_EPOCH + SAMPLE_S - 1) / SAMPLE_S * SAMPLE_S;
+    if (to > end) to = end;
+
+    for (t=from; t<=to; t+=SAMPLE_S)
+    {
+        x = value(t, q);
+        if (s->n == 0 || x < s->min) s->min = x;
+        if (s->n == 0 || x > s->max) s->max = x;
+        sum += x;
+        s->n++;
+    }
+    s->mean = s->n ? (float)(sum / s->n) : 0;
+}
+
+static Bool same(const HIST_STAT *a, const HIST_STAT *b)
+{
+    return a->n == b->n && a->min == b->min && a->max == b->max &&
+        fabs(a->mean - b->mean) <= MEAN_TOL * fabs(b->mean);
+}
+
+/// host ns per Hist_Range() over the whole of <tier>, best of REPEAT; checked for every quantity
+static double rangeNs(int tier, UInt32 end, UInt32 *from)
+{
+    HIST_STAT got, want;
+    double ns, best = 0;
+    UInt64 t0;
+    int q, k;
+
+    *from = (end / TIER_SECS[tier] - TIER_SLOTS[tier] + 1) * TIER_SECS[tier];
+
+    for (k=0; k<REPEAT; k++)
+    {
+        t0 = Host_Ns();
+        Hist_Range(tier, HIST_Q_WATERCUT, *from, end, &got);
+        ns = (double)(Host_Ns() - t0);
+        if (k == 0 || ns < best) best = ns;
+    }
+
+    for (q=0; q<HIST_NUM_QTY; q++)
+    {
+        Hist_Range(tier, q, *from, end, &got);
+        reference(q, *from, end, end, &want);
+        if (same(&got, &want)) continue;
+
+        printf("  %s tier, %s: n %u min %g max %g mean %g, summed up here n %u min %g max %g mean %g\n",
+            TIER_NAME[tier], QTY_NAME[q], got.n, got.min, got.max, got.mean, want.n, want.min, want.max, want.mean);
+        failures++;
+    }
+
+    return best;
+}
+
+/// host ns per Hist_Page_Load() of the last 24 hours of minutes, best of REPEAT
+static double pageNs(UInt32 from, UInt32 end)
+{
+    double ns, best = 0;
+    UInt64 t0;
+    int k;
+
+    REG_HIST_TIER = HIST_T_MINUTE;
+    REG_HIST_QTY = HIST_Q_WATERCUT;
+    REG_HIST_FROM = from;
+    REG_HIST_TO = end;
+
+    for (k=0; k<REPEAT; k++)
+    {
+        t0 = Host_Ns();
+        Hist_Page_Load();
+        ns = (double)(Host_Ns() - t0);
+        if (k == 0 || ns < best) best = ns;
+    }
+
+    return best;
+}
+
+/// the 24 hour query over Modbus; virtual us from the query to the last word read
+static UInt64 modbusQuery(UInt32 from, UInt32 end)
+{
+    HIST_STAT want;
+    float w[HIST_WORDS];
+    UInt64 t0;
+    int i;
+
+    t0 = Host_Now();
+    if (!Host_Mb_writeInt(SLAVE, MB_HIST_TIER, HIST_T_MINUTE) || !Host_Mb_writeInt(SLAVE, MB_HIST_QTY, HIST_Q_WATERCUT) ||
+        !Host_Mb_write32(SLAVE, MB_HIST_FROM, from) || !Host_Mb_write32(SLAVE, MB_HIST_TO, end) ||
+        !Host_Mb_writeInt(SLAVE, MB_HIST_QUERY, 1))
+        fail("history query not accepted");
+
+    for (i=0; i<HIST_WORDS; i++)
+    {
+        if (!Host_Mb_readFloat(SLAVE, MB_HIST_WIN + 2*i, &w[i])) fail("no Modbus reply");
+    }
+
+    reference(HIST_Q_WATERCUT, from, end, end, &want);
+    if (w[HIST_W_COUNT] != want.n || w[HIST_W_MIN] != want.min || w[HIST_W_MAX] != want.max ||
+        fabs(w[HIST_W_MEAN] - want.mean) > MEAN_TOL * want.mean)
+    {
+        printf("  Modbus: n %.0f min %g max %g mean %g, summed up here n %u min %g max %g mean %g\n",
+            w[HIST_W_COUNT], w[HIST_W_MIN], w[HIST_W_MAX], w[HIST_W_MEAN], want.n, want.min, want.max, want.mean);
+        failures++;
+    }
+
+    return Host_Now() - t0;
+}
+
+static void footprint(void)
+{
+    UInt32 bytes = __stop_HISTREC - __start_HISTREC, slots = 0, bucket;
+    int t;
+
+    for (t=0; t<HIST_NUM_TIERS; t++) slots += TIER_SLOTS[t];
+    bucket = (bytes - sizeof(UInt32)) / slots;
+
+    printf("\nmemory, HISTREC section %u bytes: %u buckets of %u, %d quantities each\n", bytes, slots, bucket,
+        HIST_NUM_QTY);
+    printf("%-8s %8s %10s %10s\n", "tier", "buckets", "span", "bytes");
+    for (t=0; t<HIST_NUM_TIERS; t++)
+        printf("%-8s %8u %8.0f %s %10u\n", TIER_NAME[t], TIER_SLOTS[t],
+            t == HIST_T_MINUTE ? TIER_SLOTS[t] / 60.0 : TIER_SLOTS[t] / (t == HIST_T_HOUR ? 24.0 : 1.0),
+            t == HIST_T_MINUTE ? "h" : "d", TIER_SLOTS[t] * bucket);
+    printf("%-8s %8u %10s %10u   History.h %u, plus the magic word\n", "total", slots, "", slots * bucket,
+        STORE_BYTES);
+    printf("the day tier, %u bytes, goes to NAND every hour\n", HIST_DAY_SLOTS * bucket);
+
+    if (bytes != STORE_BYTES + sizeof(UInt32) || bucket != BUCKET_BYTES)
+    {
+        printf("  the store is not the size History.h gives\n");
+        failures++;
+    }
+}
+
+int main(void)
+{
+    double newNs, curNs, poll, ns;
+    Host_Stats *st = &Swi_Poll->st;
+    UInt32 key, end, from, dayFrom = 0;
+    UInt64 us;
+    int densMode, t;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    Host_Stats_reset();
+    Host_Run(RUN_US);
+    poll = st->runs ? (double)st->ns / st->runs : 0;
+
+    // Poll writes the process values and the store; keep it out
+    key = Swi_disable();
+    densMode = REG_OIL_DENS_CORR_MODE;
+    REG_OIL_DENS_CORR_MODE = 1;
+    REG_WATERCUT.STAT &= ~var_NaNum;
+
+    // into buckets the fill then takes over
+    setTime(START_EPOCH - FILL_DAYS * 86400u);
+    curNs = insertNs();
+    newNs = fill(&end);
+
+    printf("%d days, a sample every %d s; %d quantities\n\n", FILL_DAYS, SAMPLE_S, HIST_NUM_QTY);
+    // a new minute once every POLLS_PER_MIN Polls
+    ns = curNs + (newNs - curNs) / POLLS_PER_MIN;
+    printf("host ns   Hist_Update() into the current minute %.1f, into a new one %.1f   Poll %.0f\n", curNs, newNs,
+        poll);
+    printf("          %.1f a Poll on average, %.2f %%\n", ns, poll > 0 ? ns / poll * 100 : 0.0);
+    if (ns > MAX_SHARE * poll)
+    {
+        printf("  an insert costs more than %.0f %% of a Poll\n", MAX_SHARE * 100);
+        failures++;
+    }
+
+    printf("\n%-8s %8s %12s\n", "tier", "buckets", "Hist_Range()");
+    for (t=0; t<HIST_NUM_TIERS; t++)
+    {
+        ns = rangeNs(t, end, &from);
+        if (t == HIST_T_MINUTE) dayFrom = from;
+        printf("%-8s %8u %9.0f ns\n", TIER_NAME[t], TIER_SLOTS[t], ns);
+    }
+    ns = pageNs(dayFrom, end);
+    printf("Hist_Page_Load(), 24 h of minutes %.0f ns\n", ns);
+
+    REG_OIL_DENS_CORR_MODE = densMode;
+
+    // the DS1340 at the same time, so the next sync does not step it back
+    Host_Rtc_set(end, 0);
+    Swi_restore(key);
+
+    us = modbusQuery(dayFrom, end);
+    printf("the same over Modbus, query to aggregate read back %.1f ms\n", us / 1e3);
+
+    footprint();
+
+    return failures ? 1 : 0;
+}
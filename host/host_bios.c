@@ -0,0 +1,1044 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_bios.c
+*-------------------------------------------------------------------------
+* Single-threaded scheduler behind host_bios.h. The host main context plays
+* the SYS/BIOS idle loop: Host_Run() runs whatever is ready at the current
+* virtual instant, then jumps to the next deadline (clock tick, timer,
+* task timeout). SWIs and HWIs run as plain nested calls on the stack of
+* whoever posted them; tasks are ucontext coroutines that switch back to
+* the idle context whenever they block or a higher priority task becomes
+* ready at task level.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_bios.h"
+
+#define MAX_OBJ             128
+#define MAX_NEST            64
+#define STACK_FILL          0xBE    // same fill byte as SYS/BIOS task stacks
+#define MIN_STACK           0x40000 // host frames (printf, libc) are bigger than on the C674x
+#define MAX_EVENT           256
+
+UInt32 Clock_tickPeriod = 1000;
+
+static UInt64 nowUs;                // virtual time
+static UInt64 stepNs;               // Host_Ns() when nowUs last moved
+static UInt64 devNs;                // last Host_DevNs()
+static UInt32 seconds0;             // Seconds_set() base
+
+static Bool started;                // BIOS_start(): interrupts, SWIs and tasks run
+static Int hwiLock;                 // Hwi_disable()
+static Int hwiDepth;                // >0 inside a dispatched HWI
+static Int swiLock;                 // Swi_disable()
+static Int curSwiPri = -1;          // priority of the running SWI, -1 at task level
+static UInt16 intMask = 0xFFFF;     // per-interrupt enables
+
+static Task_Struct *curTask;        // NULL: idle (host main context)
+static Task_Struct idleTask;
+static ucontext_t idleCtx;
+
+static Swi_Struct  *swis[MAX_OBJ];     static Int numSwi;
+static Clock_Struct *clocks[MAX_OBJ];  static Int numClock;
+static Task_Struct *tasks[MAX_OBJ];    static Int numTask;
+static Hwi_Struct  *hwis[MAX_OBJ];     static Int numHwi;
+static Timer_Struct *timers[MAX_OBJ];  static Int numTimer;
+
+/// Host_At() events, unordered; there are only ever a few outstanding
+typedef struct
+{
+    UInt64  us;
+    void    (*fxn)(UArg);
+    UArg    arg;
+} Host_Event;
+
+static Host_Event events[MAX_EVENT];
+static Int numEvent;
+
+static Semaphore_Struct *sems;
+static Semaphore_Struct *semsTail;
+static Host_Stats *statsHead;
+static Host_Stats *statsTail;
+
+static Swi_Struct clockSwi;         // runs the due Clock objects
+
+static void (*swiBegin)(Swi_Handle);
+static void (*swiEnd)(Swi_Handle);
+static void (*taskSwitch)(Task_Handle, Task_Handle);
+static void (*hwiBegin)(Hwi_Handle);
+static void (*hwiEnd)(Hwi_Handle);
+
+static void schedule(void);
+
+/*============================================================================*/
+/*                            EXECUTION STATISTICS                            */
+/*============================================================================*/
+
+/// Stack of the objects currently executing. Only the top one is charged,
+/// so a preempted object does not pay for the SWI or HWI that preempted it.
+static Host_Stats *running[MAX_NEST];
+static Int runTop;
+static UInt64 mark;
+
+UInt64 Host_Ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UInt64)ts.tv_sec * 1000000000ull + (UInt64)ts.tv_nsec;
+}
+
+static void statsEnter(Host_Stats *st)
+{
+    UInt64 now = Host_Ns();
+
+    if (runTop > 0) running[runTop-1]->curNs += now - mark;
+    if (runTop >= MAX_NEST) { fprintf(stderr, "host_bios: nesting overflow\n"); abort(); }
+    running[runTop++] = st;
+    mark = now;
+}
+
+static void statsLeave(Host_Stats *st, Bool done)
+{
+    UInt64 now = Host_Ns();
+
+    st->curNs += now - mark;
+    runTop--;
+    mark = now;
+
+    if (!done) return;
+
+    st->runs++;
+    st->ns += st->curNs;
+    if (st->curNs > st->maxNs) st->maxNs = st->curNs;
+    st->curNs = 0;
+}
+
+static void statsAdd(Host_Stats *st, const char *name, Int kind, Int priority)
+{
+    memset(st, 0, sizeof(*st));
+    st->name     = name;
+    st->kind     = kind;
+    st->priority = priority;
+
+    if (statsTail) statsTail->next = st;
+    else statsHead = st;
+    statsTail = st;
+}
+
+Host_Stats *Host_Stats_first(void)
+{
+    return statsHead;
+}
+
+void Host_Stats_reset(void)
+{
+    Host_Stats *st;
+
+    for (st = statsHead; st; st = st->next)
+    {
+        st->runs  = 0;
+        st->ns    = 0;
+        st->maxNs = 0;
+    }
+}
+
+/*============================================================================*/
+/*                                    HWI                                     */
+/*============================================================================*/
+
+static Bool hwiEnabled(Hwi_Struct *hwi)
+{
+    if (hwiLock) return FALSE;
+    if (hwi->intNum < 0) return TRUE;
+    return (intMask >> hwi->intNum) & 1;
+}
+
+static void hwiDispatch(Hwi_Struct *hwi)
+{
+    hwi->pending = FALSE;
+    hwiDepth++;
+    statsEnter(&hwi->st);
+    if (hwiBegin && hwi->intNum >= 0) hwiBegin(hwi);
+    hwi->fxn(hwi->arg, 0);
+    if (hwiEnd && hwi->intNum >= 0) hwiEnd(hwi);
+    statsLeave(&hwi->st, TRUE);
+    hwiDepth--;
+}
+
+/// run every pending interrupt that is no longer masked, then the SWIs
+/// they posted
+static void hwiDispatchPending(void)
+{
+    Int i;
+    Bool again = TRUE;
+
+    while (again && started && !hwiLock)
+    {
+        again = FALSE;
+
+        for (i=0; i<numHwi; i++)
+        {
+            if (hwis[i]->pending && hwiEnabled(hwis[i]))
+            {
+                hwiDispatch(hwis[i]);
+                again = TRUE;
+            }
+        }
+    }
+
+    schedule();
+}
+
+void Host_Hwi_raise(Int intNum)
+{
+    Int i;
+
+    for (i=0; i<numHwi; i++)
+        if (hwis[i]->intNum == intNum) hwis[i]->pending = TRUE;
+
+    hwiDispatchPending();
+}
+
+void Host_Hwi_pend(Int intNum)
+{
+    Int i;
+
+    for (i=0; i<numHwi; i++)
+        if (hwis[i]->intNum == intNum) hwis[i]->pending = TRUE;
+}
+
+UInt Hwi_disable(void)
+{
+    UInt key = hwiLock;
+
+    hwiLock = 1;
+    return key;
+}
+
+UInt Hwi_enable(void)
+{
+    UInt key = hwiLock;
+
+    hwiLock = 0;
+    hwiDispatchPending();
+    return key;
+}
+
+void Hwi_restore(UInt key)
+{
+    hwiLock = key;
+    if (!hwiLock) hwiDispatchPending();
+}
+
+UInt Hwi_disableInterrupt(UInt intNum)
+{
+    UInt key = (intMask >> intNum) & 1;
+
+    intMask &= ~(1u << intNum);
+    return key;
+}
+
+UInt Hwi_enableInterrupt(UInt intNum)
+{
+    UInt key = (intMask >> intNum) & 1;
+
+    intMask |= (1u << intNum);
+    hwiDispatchPending();
+    return key;
+}
+
+void Hwi_restoreInterrupt(UInt intNum, UInt key)
+{
+    if (key) Hwi_enableInterrupt(intNum);
+    else Hwi_disableInterrupt(intNum);
+}
+
+Bool Hwi_getStackInfo(Hwi_StackInfo *info, Bool computeStackDepth)
+{
+    (void)computeStackDepth;
+    memset(info, 0, sizeof(*info));
+    return FALSE;
+}
+
+Ptr Hwi_getHookContext(Hwi_Handle hwi, Int id)
+{
+    (void)id;
+    return hwi->hookCtx;
+}
+
+void Hwi_setHookContext(Hwi_Handle hwi, Int id, Ptr ctx)
+{
+    (void)id;
+    hwi->hookCtx = ctx;
+}
+
+/*============================================================================*/
+/*                                    SWI                                     */
+/*============================================================================*/
+
+/// run the posted SWIs above the current priority, highest first
+static void runSwis(void)
+{
+    Int i, best, savedPri;
+    Swi_Struct *swi;
+
+    for (;;)
+    {
+        if (!started || swiLock || hwiLock || hwiDepth) return;
+
+        swi  = NULL;
+        best = curSwiPri;
+
+        for (i=0; i<numSwi; i++)
+        {
+            if (swis[i]->posted && swis[i]->st.priority > best)
+            {
+                swi  = swis[i];
+                best = swi->st.priority;
+            }
+        }
+
+        if (swi == NULL) return;
+
+        savedPri    = curSwiPri;
+        curSwiPri   = best;
+        swi->posted = FALSE;
+
+        statsEnter(&swi->st);
+        if (swiBegin && swi != &clockSwi) swiBegin(swi);
+        swi->fxn(swi->arg0, swi->arg1);
+        if (swiEnd && swi != &clockSwi) swiEnd(swi);
+        statsLeave(&swi->st, TRUE);
+
+        curSwiPri = savedPri;
+    }
+}
+
+void Swi_post(Swi_Handle swi)
+{
+    swi->posted = TRUE;
+    schedule();
+}
+
+static void (*swiLockFxn)(Bool locked);   // Host_Swi_lockHook()
+
+void Host_Swi_lockHook(void (*fxn)(Bool locked))
+{
+    swiLockFxn = fxn;
+}
+
+UInt Swi_disable(void)
+{
+    UInt key = swiLock;
+
+    if (!swiLock && swiLockFxn) swiLockFxn(TRUE);
+    swiLock = 1;
+    return key;
+}
+
+void Swi_restore(UInt key)
+{
+    if (swiLock && !key && swiLockFxn) swiLockFxn(FALSE);
+    swiLock = key;
+    if (!swiLock) schedule();
+}
+
+void Swi_enable(void)
+{
+    if (swiLock && swiLockFxn) swiLockFxn(FALSE);
+    swiLock = 0;
+    schedule();
+}
+
+Ptr Swi_getHookContext(Swi_Handle swi, Int id)
+{
+    (void)id;
+    return swi->hookCtx;
+}
+
+void Swi_setHookContext(Swi_Handle swi, Int id, Ptr ctx)
+{
+    (void)id;
+    swi->hookCtx = ctx;
+}
+
+/*============================================================================*/
+/*                                   TASK                                     */
+/*============================================================================*/
+
+static Task_Struct *nextReadyTask(void)
+{
+    Int i;
+    Task_Struct *best = NULL;
+
+    for (i=0; i<numTask; i++)
+    {
+        if (tasks[i]->state != HOST_TASK_READY) continue;
+        if (best == NULL || tasks[i]->st.priority > best->st.priority) best = tasks[i];
+    }
+
+    return best;
+}
+
+/// give the CPU back to the idle context; returns when this task is
+/// switched in again
+static void taskSwitchOut(Bool done)
+{
+    Task_Struct *self = curTask;
+
+    statsLeave(&self->st, done);
+    curTask = NULL;
+    swapcontext(&self->ctx, &idleCtx);
+}
+
+static void taskEntry(void)
+{
+    Task_Struct *self = curTask;
+
+    self->fxn(self->arg0, self->arg1);
+
+    self->state = HOST_TASK_TERMINATED;
+    taskSwitchOut(TRUE);
+}
+
+/// idle side of the task switch: run ready tasks until none is left
+static void runTasks(void)
+{
+    Task_Struct *next;
+    Task_Struct *prev = &idleTask;
+
+    while ((next = nextReadyTask()) != NULL)
+    {
+        if (taskSwitch) taskSwitch(prev, next);
+        curTask = next;
+        statsEnter(&next->st);
+        swapcontext(&idleCtx, &next->ctx);
+        prev = next;
+        schedule();
+    }
+
+    if (prev != &idleTask && taskSwitch) taskSwitch(prev, &idleTask);
+}
+
+/// SWIs first, then preempt the running task if a higher one is ready
+static void schedule(void)
+{
+    Task_Struct *next;
+
+    runSwis();
+
+    if (curTask == NULL || curSwiPri >= 0 || swiLock || hwiLock || hwiDepth) return;
+
+    next = nextReadyTask();
+    if (next && next->st.priority > curTask->st.priority) taskSwitchOut(FALSE);
+}
+
+static void taskBlock(Task_Struct *self, UInt32 timeout)
+{
+    self->state    = HOST_TASK_BLOCKED;
+    self->timedOut = FALSE;
+    self->timed    = (timeout != BIOS_WAIT_FOREVER);
+    self->wake     = Clock_getTicks() + timeout;
+    taskSwitchOut(TRUE);
+}
+
+void Task_sleep(UInt32 ticks)
+{
+    if (curTask == NULL || curSwiPri >= 0 || hwiDepth) return;
+    if (ticks == 0) return;
+
+    curTask->sem = NULL;
+    taskBlock(curTask, ticks);
+}
+
+Task_Handle Task_self(void)
+{
+    return curTask ? curTask : &idleTask;
+}
+
+Task_Handle Task_getIdleTask(void)
+{
+    return &idleTask;
+}
+
+void Task_stat(Task_Handle task, Task_Stat *stat)
+{
+    SizeT i;
+
+    memset(stat, 0, sizeof(*stat));
+    stat->priority  = task->st.priority;
+    stat->stack     = task->stack;
+    stat->stackSize = task->stackSize;
+
+    // stacks grow down: the untouched fill sits at the low end
+    for (i=0; i<task->stackSize && (UInt8)task->stack[i] == STACK_FILL; i++);
+    stat->used = task->stackSize - i;
+}
+
+Ptr Task_getHookContext(Task_Handle task, Int id)
+{
+    (void)id;
+    return task->hookCtx;
+}
+
+void Task_setHookContext(Task_Handle task, Int id, Ptr ctx)
+{
+    (void)id;
+    task->hookCtx = ctx;
+}
+
+/*============================================================================*/
+/*                                 SEMAPHORE                                  */
+/*============================================================================*/
+
+static void semUnlink(Semaphore_Struct *sem, Task_Struct *task)
+{
+    Task_Struct **pp;
+
+    for (pp = &sem->head; *pp; pp = &(*pp)->next)
+    {
+        if (*pp == task)
+        {
+            *pp = task->next;
+            break;
+        }
+    }
+
+    sem->tail = NULL;
+    for (task = sem->head; task; task = task->next) sem->tail = task;
+}
+
+Bool Semaphore_pend(Semaphore_Handle sem, UInt32 timeout)
+{
+    Task_Struct *self = curTask;
+
+    sem->pends++;
+
+    if (sem->count > 0)
+    {
+        sem->count--;
+        return TRUE;
+    }
+
+    // only a task at task level may block, as on the target
+    if (timeout == BIOS_NO_WAIT || self == NULL || curSwiPri >= 0 || hwiDepth) return FALSE;
+
+    sem->blocks++;
+    self->sem  = sem;
+    self->next = NULL;
+    if (sem->tail) sem->tail->next = self;
+    else sem->head = self;
+    sem->tail = self;
+
+    taskBlock(self, timeout);
+
+    return !self->timedOut;
+}
+
+void Semaphore_post(Semaphore_Handle sem)
+{
+    Task_Struct *task = sem->head;
+
+    sem->posts++;
+
+    if (task)
+    {
+        sem->head = task->next;
+        if (sem->head == NULL) sem->tail = NULL;
+        task->sem   = NULL;
+        task->state = HOST_TASK_READY;
+    }
+    else if (sem->binary) sem->count = 1;
+    else sem->count++;
+
+    schedule();
+}
+
+Int Semaphore_getCount(Semaphore_Handle sem)
+{
+    return sem->count;
+}
+
+/*============================================================================*/
+/*                                   CLOCK                                    */
+/*============================================================================*/
+
+UInt32 Clock_getTicks(void)
+{
+    return (UInt32)(nowUs / Clock_tickPeriod);
+}
+
+void Clock_start(Clock_Handle clk)
+{
+    clk->due    = Clock_getTicks() + clk->timeout;
+    clk->active = TRUE;
+}
+
+void Clock_stop(Clock_Handle clk)
+{
+    clk->active = FALSE;
+}
+
+void Clock_setTimeout(Clock_Handle clk, UInt32 timeout)
+{
+    clk->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle clk, UInt32 period)
+{
+    clk->period = period;
+}
+
+UInt32 Clock_getTimeout(Clock_Handle clk)
+{
+    return clk->timeout;
+}
+
+Bool Clock_isActive(Clock_Handle clk)
+{
+    return clk->active;
+}
+
+/// body of the Clock SWI: run every clock that is due, in creation order
+static void clockSwiFxn(UArg a0, UArg a1)
+{
+    Int i;
+    UInt32 now = Clock_getTicks();
+    Clock_Struct *clk;
+
+    (void)a0; (void)a1;
+
+    for (i=0; i<numClock; i++)
+    {
+        clk = clocks[i];
+        if (!clk->active || (Int32)(clk->due - now) > 0) continue;
+
+        if (clk->period) clk->due += clk->period;
+        else clk->active = FALSE;
+
+        statsEnter(&clk->st);
+        clk->fxn(clk->arg, 0);
+        statsLeave(&clk->st, TRUE);
+    }
+}
+
+/*============================================================================*/
+/*                                   TIMER                                    */
+/*============================================================================*/
+
+void Timer_start(Timer_Handle timer)
+{
+    timer->dueUs   = nowUs + timer->periodUs;
+    timer->running = TRUE;
+}
+
+void Timer_stop(Timer_Handle timer)
+{
+    timer->running = FALSE;
+}
+
+Bool Timer_setPeriodMicroSecs(Timer_Handle timer, UInt32 microsecs)
+{
+    timer->periodUs = microsecs;
+    return TRUE;
+}
+
+/*============================================================================*/
+/*                          TIMESTAMP, SECONDS, HEAP                          */
+/*============================================================================*/
+
+static UInt32 readNs;                // Host_DevNs_fixed()
+static UInt64 readUs;               // nowUs of the reads counted
+static UInt64 reads;
+
+void Host_DevNs_fixed(UInt32 ns)
+{
+    readNs = ns;
+    reads = 0;
+}
+
+UInt64 Host_DevNs(void)
+{
+    UInt64 ns;
+
+    if (readNs)
+    {
+        if (readUs != nowUs) reads = 0;
+        readUs = nowUs;
+        ns = nowUs * 1000u + ++reads * readNs;
+    }
+    else
+    {
+        if (stepNs == 0) stepNs = Host_Ns();    // first read, before any Host_Run()
+        ns = nowUs * 1000u + (Host_Ns() - stepNs);
+    }
+
+    if (ns > devNs) devNs = ns;
+    return devNs;
+}
+
+Bits32 Timestamp_get32(void)
+{
+    return (Bits32)Host_DevNs();
+}
+
+void Timestamp_get64(Types_Timestamp64 *result)
+{
+    UInt64 ns = Host_DevNs();
+
+    result->hi = (Bits32)(ns >> 32);
+    result->lo = (Bits32)ns;
+}
+
+void Timestamp_getFreq(Types_FreqHz *freq)
+{
+    freq->hi = 0;
+    freq->lo = 1000000000u;
+}
+
+UInt32 Seconds_get(void)
+{
+    return seconds0 + (UInt32)(nowUs / 1000000u);
+}
+
+UInt32 Seconds_set(UInt32 seconds)
+{
+    seconds0 = seconds - (UInt32)(nowUs / 1000000u);
+    return 0;
+}
+
+void Memory_getStats(IHeap_Handle heap, Memory_Stats *stats)
+{
+    (void)heap;
+    memset(stats, 0, sizeof(*stats));
+}
+
+void HeapBuf_getExtendedStats(HeapBuf_Handle heap, HeapBuf_ExtendedStats *stats)
+{
+    (void)heap;
+    memset(stats, 0, sizeof(*stats));
+}
+
+/*============================================================================*/
+/*                                CONSTRUCTION                                */
+/*============================================================================*/
+
+static void *addObj(void **list, Int *num, void *obj)
+{
+    if (*num >= MAX_OBJ) { fprintf(stderr, "host_bios: too many objects\n"); abort(); }
+    list[(*num)++] = obj;
+    return obj;
+}
+
+void Host_Clock_Config(UInt32 tickPeriodUs, Int swiPriority)
+{
+    Clock_tickPeriod = tickPeriodUs;
+
+    statsAdd(&idleTask.st, "ti.sysbios.knl.Task.IdleTask", HOST_KIND_TASK, 0);
+    Host_Swi_Construct(&clockSwi, "ti.sysbios.knl.Clock.Swi", clockSwiFxn, swiPriority, 0, 0);
+}
+
+void Host_Swi_Construct(Swi_Struct *swi, const char *name, Host_Fxn fxn, Int priority, UArg arg0, UArg arg1)
+{
+    memset(swi, 0, sizeof(*swi));
+    statsAdd(&swi->st, name, HOST_KIND_SWI, priority);
+    swi->fxn  = fxn;
+    swi->arg0 = arg0;
+    swi->arg1 = arg1;
+    addObj((void**)swis, &numSwi, swi);
+}
+
+void Host_Clock_Construct(Clock_Struct *clk, const char *name, Host_Fxn fxn, UInt32 timeout, UInt32 period, Bool startFlag, UArg arg)
+{
+    memset(clk, 0, sizeof(*clk));
+    statsAdd(&clk->st, name, HOST_KIND_CLOCK, -1);
+    clk->fxn     = fxn;
+    clk->arg     = arg;
+    clk->timeout = timeout;
+    clk->period  = period;
+    addObj((void**)clocks, &numClock, clk);
+    if (startFlag) Clock_start(clk);
+}
+
+void Host_Semaphore_Construct(Semaphore_Struct *sem, const char *name, Int count, Bool binary)
+{
+    memset(sem, 0, sizeof(*sem));
+    sem->name   = name;
+    sem->count  = (binary && count > 1) ? 1 : count;
+    sem->binary = binary;
+
+    if (semsTail) semsTail->next = sem;
+    else sems = sem;
+    semsTail = sem;
+}
+
+void Host_Task_Construct(Task_Struct *task, const char *name, Host_Fxn fxn, Int priority, SizeT stackSize, UArg arg0, UArg arg1)
+{
+    memset(task, 0, sizeof(*task));
+    statsAdd(&task->st, name, HOST_KIND_TASK, priority);
+    task->fxn       = fxn;
+    task->arg0      = arg0;
+    task->arg1      = arg1;
+    task->stackSize = (stackSize < MIN_STACK) ? MIN_STACK : stackSize;
+    task->stack     = malloc(task->stackSize);
+    task->state     = HOST_TASK_READY;
+
+    if (task->stack == NULL) { fprintf(stderr, "host_bios: no stack for %s\n", name); abort(); }
+    memset(task->stack, STACK_FILL, task->stackSize);
+
+    getcontext(&task->ctx);
+    task->ctx.uc_stack.ss_sp   = task->stack;
+    task->ctx.uc_stack.ss_size = task->stackSize;
+    task->ctx.uc_link          = NULL;
+    makecontext(&task->ctx, taskEntry, 0);
+
+    addObj((void**)tasks, &numTask, task);
+}
+
+void Host_Hwi_Construct(Hwi_Struct *hwi, const char *name, Int intNum, Host_Fxn fxn, Bool enableInt, UArg arg)
+{
+    memset(hwi, 0, sizeof(*hwi));
+    statsAdd(&hwi->st, name, HOST_KIND_HWI, intNum);
+    hwi->fxn    = fxn;
+    hwi->arg    = arg;
+    hwi->intNum = intNum;
+    addObj((void**)hwis, &numHwi, hwi);
+    if (intNum >= 0 && !enableInt) Hwi_disableInterrupt(intNum);
+}
+
+void Host_Timer_Construct(Timer_Struct *tmr, const char *name, Int id, Int intNum, Host_Fxn fxn, UInt32 periodUs, Bool oneShot, Bool autoStart, UArg arg)
+{
+    memset(tmr, 0, sizeof(*tmr));
+    Host_Hwi_Construct(&tmr->hwi, name, intNum, fxn, TRUE, arg);
+    tmr->hwi.st.kind = HOST_KIND_TIMER;
+    tmr->id       = id;
+    tmr->periodUs = periodUs;
+    tmr->oneShot  = oneShot;
+    addObj((void**)timers, &numTimer, tmr);
+    if (autoStart) Timer_start(tmr);
+}
+
+void Host_Swi_addHookSet(void (*registerFxn)(Int), void (*beginFxn)(Swi_Handle), void (*endFxn)(Swi_Handle))
+{
+    swiBegin = beginFxn;
+    swiEnd   = endFxn;
+    if (registerFxn) registerFxn(0);
+}
+
+void Host_Task_addHookSet(void (*registerFxn)(Int), void (*switchFxn)(Task_Handle, Task_Handle))
+{
+    taskSwitch = switchFxn;
+    if (registerFxn) registerFxn(0);
+}
+
+void Host_Hwi_addHookSet(void (*registerFxn)(Int), void (*beginFxn)(Hwi_Handle), void (*endFxn)(Hwi_Handle))
+{
+    hwiBegin = beginFxn;
+    hwiEnd   = endFxn;
+    if (registerFxn) registerFxn(0);
+}
+
+/*============================================================================*/
+/*                                  RUN LOOP                                  */
+/*============================================================================*/
+
+UInt64 Host_Now(void)
+{
+    return nowUs;
+}
+
+void Host_At(UInt64 us, void (*fxn)(UArg), UArg arg)
+{
+    if (numEvent >= MAX_EVENT) { fprintf(stderr, "host_bios: too many device events\n"); abort(); }
+    if (us < nowUs) us = nowUs;
+
+    events[numEvent].us  = us;
+    events[numEvent].fxn = fxn;
+    events[numEvent].arg = arg;
+    numEvent++;
+}
+
+/// run the device events due now, in time order; an event may add more
+static void runEvents(void)
+{
+    Int i, first;
+    Host_Event ev;
+
+    for (;;)
+    {
+        first = -1;
+        for (i=0; i<numEvent; i++)
+            if (events[i].us <= nowUs && (first < 0 || events[i].us < events[first].us)) first = i;
+
+        if (first < 0) return;
+
+        ev = events[first];
+        events[first] = events[--numEvent];
+        ev.fxn(ev.arg);
+    }
+}
+
+/// virtual time of the next thing that can happen, later than now except
+/// for device events added at this instant; tick based deadlines that are
+/// already due wait for the next tick
+static UInt64 nextEvent(void)
+{
+    Int i;
+    UInt32 due;
+    UInt32 soonest = Clock_getTicks() + 1;
+    UInt64 t, next = UINT64_MAX;
+
+    for (i=0; i<numEvent; i++)
+        if (events[i].us < next) next = events[i].us;
+
+    for (i=0; i<numClock; i++)
+    {
+        if (!clocks[i]->active) continue;
+        due = ((Int32)(clocks[i]->due - soonest) > 0) ? clocks[i]->due : soonest;
+        t = (UInt64)due * Clock_tickPeriod;
+        if (t < next) next = t;
+    }
+
+    for (i=0; i<numTask; i++)
+    {
+        if (tasks[i]->state != HOST_TASK_BLOCKED || !tasks[i]->timed) continue;
+        due = ((Int32)(tasks[i]->wake - soonest) > 0) ? tasks[i]->wake : soonest;
+        t = (UInt64)due * Clock_tickPeriod;
+        if (t < next) next = t;
+    }
+
+    for (i=0; i<numTimer; i++)
+    {
+        if (!timers[i]->running) continue;
+        if (timers[i]->dueUs < next) next = timers[i]->dueUs;
+    }
+
+    return next;
+}
+
+/// fire everything due at the current virtual time
+static void fireDue(void)
+{
+    Int i;
+    UInt32 now = Clock_getTicks();
+    Task_Struct *task;
+    Timer_Struct *tmr;
+
+    runEvents();
+
+    for (i=0; i<numTimer; i++)
+    {
+        tmr = timers[i];
+        if (!tmr->running || tmr->dueUs > nowUs) continue;
+
+        if (tmr->oneShot || tmr->periodUs == 0) tmr->running = FALSE;
+        else tmr->dueUs += tmr->periodUs;
+
+        tmr->hwi.pending = TRUE;
+    }
+
+    for (i=0; i<numTask; i++)
+    {
+        task = tasks[i];
+        if (task->state != HOST_TASK_BLOCKED || !task->timed) continue;
+        if ((Int32)(task->wake - now) > 0) continue;
+
+        if (task->sem) semUnlink(task->sem, task);
+        task->sem      = NULL;
+        task->timedOut = TRUE;
+        task->state    = HOST_TASK_READY;
+    }
+
+    for (i=0; i<numClock; i++)
+    {
+        if (clocks[i]->active && (Int32)(clocks[i]->due - now) <= 0)
+        {
+            clockSwi.posted = TRUE;
+            break;
+        }
+    }
+
+    hwiDispatchPending();
+}
+
+void Host_Run(UInt64 us)
+{
+    UInt64 end = nowUs + us;
+    UInt64 next;
+
+    started = TRUE;
+
+    for (;;)
+    {
+        schedule();
+        runTasks();
+
+        next = nextEvent();
+        if (next > end) break;
+
+        nowUs  = next;
+        stepNs = Host_Ns();
+        fireDue();
+    }
+
+    nowUs  = end;
+    stepNs = Host_Ns();
+}
+
+/// returns at once: the host program drives virtual time with Host_Run()
+void BIOS_start(void)
+{
+    started = TRUE;
+    hwiDispatchPending();
+}
+
+/*============================================================================*/
+/*                                   REPORT                                   */
+/*============================================================================*/
+
+static const char *KIND_NAME[] = {"HWI", "SWI", "CLOCK", "TASK", "TIMER"};
+
+void Host_Report(FILE *out)
+{
+    Host_Stats *st;
+    Semaphore_Struct *sem;
+    UInt64 total = 0;
+
+    for (st = statsHead; st; st = st->next) total += st->ns;
+
+    fprintf(out, "%-5s %-44s %4s %10s %12s %10s %10s %6s\n",
+        "kind", "object", "pri", "runs", "total_us", "avg_us", "max_us", "share");
+
+    for (st = statsHead; st; st = st->next)
+    {
+        if (st->runs == 0) continue;
+        fprintf(out, "%-5s %-44s %4d %10u %12.1f %10.2f %10.2f %5.1f%%\n",
+            KIND_NAME[st->kind], st->name, st->priority, st->runs,
+            st->ns / 1000.0, st->ns / 1000.0 / st->runs, st->maxNs / 1000.0,
+            total ? 100.0 * st->ns / total : 0.0);
+    }
+
+    for (sem = sems; sem; sem = sem->next)
+    {
+        if (sem->posts == 0 && sem->pends == 0) continue;
+        fprintf(out, "SEM   %-44s posts %u pends %u blocked %u\n",
+            sem->name, sem->posts, sem->pends, sem->blocks);
+    }
+}
@@ -0,0 +1,363 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_bios.h
+*-------------------------------------------------------------------------
+* Host (Linux, gcc) stand-in for the part of SYS/BIOS and the XDC runtime
+* that the Razor firmware calls. Everything runs on one host thread against
+* a virtual clock, so a run is deterministic and goes as fast as the host
+* can execute the firmware code:
+*
+*  - Swi: priorities 0..15, nested preemption, Swi_disable/restore.
+*  - Clock: one-shot and periodic objects on Clock_tickPeriod ticks, run
+*    from the Clock SWI at Clock.swiPriority, as on the target.
+*  - Semaphore: binary and counting, FIFO wait queue, pend timeouts.
+*  - Task: one ucontext coroutine per task, strict priority, Task_sleep.
+*  - Hwi: global and per-interrupt masks; Host_Hwi_raise() injects an
+*    interrupt, which runs at once or when it is unmasked.
+*  - Timer: period in microseconds of virtual time, ISR in HWI context.
+*
+* As on the target, nothing preempts main(): interrupts stay pending and
+* posted SWIs wait until BIOS_start() (or the first Host_Run()).
+*
+* Virtual time only moves in Host_Run(): code takes no virtual time, so
+* the ISRs, SWIs and tasks due at one instant all run before the clock
+* moves on. Timestamp_get32/64 read the device clock instead: virtual time
+* plus the host time spent since it last moved, never going backwards. A
+* span inside one activation is therefore its real host cost, and a span
+* across activations follows virtual time, which is what the firmware's
+* timing code and the peripheral models (host_dev.h) both need.
+* Host_DevNs_fixed() makes every read of the device clock advance it by a
+* fixed step instead, like a register read on the target, for programs
+* that measure the resolution of the firmware's own timestamps.
+*
+* Peripheral models schedule their own completions with Host_At() (a byte
+* leaving the UART, a conversion finishing) and raise interrupts from
+* there with Host_Hwi_pend(); they never call into firmware code.
+*
+* Objects are plain structs. gen_cfg.py turns PDI_Razor.cfg into one
+* static instance per object plus Host_Cfg_Create(), which constructs them
+* with the cfg parameters. Every activation of an object is charged to its
+* Host_Stats record (exclusive of preemption); Host_Report() prints them.
+*------------------------------------------------------------------------*/
+#ifndef _HOST_BIOS
+#define _HOST_BIOS
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <ucontext.h>
+
+/*============================================================================*/
+/*                         XDC BASE TYPES (xdc/std.h)                         */
+/*============================================================================*/
+
+/// must match tistdtypes.h where the names overlap
+typedef int                 Int;
+typedef unsigned            Uns;
+typedef char                Char;
+typedef char                *String;
+typedef void                *Ptr;
+typedef unsigned short      Bool;
+typedef unsigned int        UInt;
+typedef unsigned char       UChar;
+typedef short               Short;
+typedef unsigned short      UShort;
+typedef long                Long;
+typedef unsigned long       ULong;
+typedef float               Float;
+typedef double              Double;
+typedef void                Void;
+typedef const char          *CString;
+typedef short               Int16;
+typedef int                 Int32;
+typedef unsigned char       UInt8;
+typedef unsigned short      UInt16;
+typedef unsigned int        UInt32;
+typedef unsigned long long  UInt64;
+typedef uint8_t             Bits8;
+typedef uint16_t            Bits16;
+typedef uint32_t            Bits32;
+typedef size_t              SizeT;
+typedef uintptr_t           UArg;
+typedef intptr_t            IArg;
+typedef void                (*Fxn)();
+
+#ifndef TRUE
+#define TRUE                ((Bool)1)
+#endif
+#ifndef FALSE
+#define FALSE               ((Bool)0)
+#endif
+
+#define BIOS_WAIT_FOREVER   (~(0u))
+#define BIOS_NO_WAIT        (0u)
+
+typedef struct { Bits32 hi; Bits32 lo; } Types_FreqHz;
+typedef struct { Bits32 hi; Bits32 lo; } Types_Timestamp64;
+
+/// firmware entry points are void f(void); the shim calls them as f(a0,a1)
+typedef void (*Host_Fxn)(UArg, UArg);
+
+/*============================================================================*/
+/*                              OBJECT RECORDS                                */
+/*============================================================================*/
+
+#define HOST_KIND_HWI       0
+#define HOST_KIND_SWI       1
+#define HOST_KIND_CLOCK     2
+#define HOST_KIND_TASK      3
+#define HOST_KIND_TIMER     4
+
+/// per-object execution statistics, host CPU time exclusive of preemption
+typedef struct Host_Stats
+{
+    const char          *name;
+    Int                 kind;       // HOST_KIND_*
+    Int                 priority;   // SWI/TASK priority, interrupt number, -1 otherwise
+    UInt32              runs;       // completed activations
+    UInt64              ns;         // total host CPU time
+    UInt64              maxNs;      // longest single activation
+    UInt64              curNs;      // running activation
+    struct Host_Stats   *next;      // registry, creation order
+} Host_Stats;
+
+typedef struct Hwi_Struct
+{
+    Host_Stats          st;
+    Host_Fxn            fxn;
+    UArg                arg;
+    Int                 intNum;     // -1: only the global mask applies
+    Bool                pending;
+    Ptr                 hookCtx;
+} Hwi_Struct, *Hwi_Handle;
+
+typedef struct Swi_Struct
+{
+    Host_Stats          st;
+    Host_Fxn            fxn;
+    UArg                arg0;
+    UArg                arg1;
+    Bool                posted;
+    Ptr                 hookCtx;
+} Swi_Struct, *Swi_Handle;
+
+typedef struct Clock_Struct
+{
+    Host_Stats          st;
+    Host_Fxn            fxn;
+    UArg                arg;
+    UInt32              timeout;    // ticks from Clock_start() to the first run
+    UInt32              period;     // 0: one-shot
+    Bool                active;
+    UInt32              due;        // tick of the next run
+} Clock_Struct, *Clock_Handle;
+
+typedef struct Task_Struct
+{
+    Host_Stats          st;
+    Host_Fxn            fxn;
+    UArg                arg0;
+    UArg                arg1;
+    Int                 state;      // HOST_TASK_*
+    ucontext_t          ctx;
+    char                *stack;
+    SizeT               stackSize;
+    struct Task_Struct  *next;      // semaphore wait queue
+    struct Semaphore_Struct *sem;   // pending on, NULL if sleeping
+    Bool                timed;      // wake at <wake> if still blocked
+    Bool                timedOut;
+    UInt32              wake;
+    Ptr                 hookCtx;
+} Task_Struct, *Task_Handle;
+
+typedef struct Semaphore_Struct
+{
+    const char          *name;
+    Int                 count;
+    Bool                binary;
+    Task_Struct         *head;      // FIFO of blocked tasks
+    Task_Struct         *tail;
+    UInt32              posts;
+    UInt32              pends;
+    UInt32              blocks;     // pends that had to wait
+    struct Semaphore_Struct *next;
+} Semaphore_Struct, *Semaphore_Handle;
+
+typedef struct Timer_Struct
+{
+    Hwi_Struct          hwi;        // the timer ISR
+    Int                 id;
+    UInt32              periodUs;
+    Bool                oneShot;
+    Bool                running;
+    UInt64              dueUs;
+} Timer_Struct, *Timer_Handle;
+
+typedef struct { Int dummy; } HeapBuf_Struct, *HeapBuf_Handle;
+typedef Ptr IHeap_Handle;
+
+/*============================================================================*/
+/*                        SYS/BIOS API (host versions)                        */
+/*============================================================================*/
+
+void    BIOS_start(void);
+
+void    Swi_post(Swi_Handle swi);
+UInt    Swi_disable(void);
+void    Swi_restore(UInt key);
+void    Swi_enable(void);
+Ptr     Swi_getHookContext(Swi_Handle swi, Int id);
+void    Swi_setHookContext(Swi_Handle swi, Int id, Ptr ctx);
+
+extern UInt32 Clock_tickPeriod;     // microseconds per tick
+void    Clock_start(Clock_Handle clk);
+void    Clock_stop(Clock_Handle clk);
+void    Clock_setTimeout(Clock_Handle clk, UInt32 timeout);
+void    Clock_setPeriod(Clock_Handle clk, UInt32 period);
+UInt32  Clock_getTimeout(Clock_Handle clk);
+Bool    Clock_isActive(Clock_Handle clk);
+UInt32  Clock_getTicks(void);
+
+Bool    Semaphore_pend(Semaphore_Handle sem, UInt32 timeout);
+void    Semaphore_post(Semaphore_Handle sem);
+Int     Semaphore_getCount(Semaphore_Handle sem);
+
+typedef struct
+{
+    Int     priority;
+    Ptr     stack;
+    SizeT   stackSize;
+    Ptr     stackHeap;
+    Ptr     env;
+    Int     mode;
+    Ptr     sp;
+    SizeT   used;
+} Task_Stat;
+
+void        Task_sleep(UInt32 ticks);
+Task_Handle Task_self(void);
+Task_Handle Task_getIdleTask(void);
+void        Task_stat(Task_Handle task, Task_Stat *stat);
+Ptr         Task_getHookContext(Task_Handle task, Int id);
+void        Task_setHookContext(Task_Handle task, Int id, Ptr ctx);
+
+typedef struct
+{
+    SizeT   hwiStackPeak;
+    SizeT   hwiStackSize;
+    Ptr     hwiStackBase;
+} Hwi_StackInfo;
+
+UInt    Hwi_disable(void);
+UInt    Hwi_enable(void);
+void    Hwi_restore(UInt key);
+UInt    Hwi_disableInterrupt(UInt intNum);
+UInt    Hwi_enableInterrupt(UInt intNum);
+void    Hwi_restoreInterrupt(UInt intNum, UInt key);
+Bool    Hwi_getStackInfo(Hwi_StackInfo *info, Bool computeStackDepth);
+Ptr     Hwi_getHookContext(Hwi_Handle hwi, Int id);
+void    Hwi_setHookContext(Hwi_Handle hwi, Int id, Ptr ctx);
+
+typedef enum { Timer_Status_INUSE, Timer_Status_FREE } Timer_Status;
+void    Timer_start(Timer_Handle timer);
+void    Timer_stop(Timer_Handle timer);
+Bool    Timer_setPeriodMicroSecs(Timer_Handle timer, UInt32 microsecs);
+
+Bits32  Timestamp_get32(void);
+void    Timestamp_get64(Types_Timestamp64 *result);
+void    Timestamp_getFreq(Types_FreqHz *freq);
+
+UInt32  Seconds_get(void);
+UInt32  Seconds_set(UInt32 seconds);
+
+typedef struct { Int id; } Error_Block;
+#define Error_E_memory      1
+#define Error_init(eb)      ((eb)->id = 0)
+#define Error_getId(eb)     ((eb)->id)
+#define Error_check(eb)     ((eb) != NULL && (eb)->id != 0)
+
+typedef struct
+{
+    SizeT   totalSize;
+    SizeT   totalFreeSize;
+    SizeT   largestFreeSize;
+} Memory_Stats;
+
+typedef struct
+{
+    UInt    maxAllocatedBlocks;
+    UInt    numAllocatedBlocks;
+} HeapBuf_ExtendedStats;
+
+void    Memory_getStats(IHeap_Handle heap, Memory_Stats *stats);
+void    HeapBuf_getExtendedStats(HeapBuf_Handle heap, HeapBuf_ExtendedStats *stats);
+#define HeapBuf_Handle_upCast(h)    ((IHeap_Handle)(h))
+
+#define System_printf       printf
+#define System_flush()      fflush(stdout)
+#define Log_info0(f)                ((void)0)
+#define Log_info1(f,a)              ((void)0)
+#define Log_info2(f,a,b)            ((void)0)
+#define Log_info3(f,a,b,c)          ((void)0)
+#define Log_info4(f,a,b,c,d)        ((void)0)
+#define Log_info5(f,a,b,c,d,e)      ((void)0)
+
+#define Cache_wb(a,s,t,w)           ((void)0)
+#define Cache_inv(a,s,t,w)          ((void)0)
+#define Cache_wbInv(a,s,t,w)        ((void)0)
+#define Cache_wbAll()               ((void)0)
+#define Cache_wbInvAll()            ((void)0)
+#define Cache_Type_ALL              0
+
+/*============================================================================*/
+/*                         HOST CONSTRUCTION AND RUN                          */
+/*============================================================================*/
+
+#define HOST_TASK_READY         0
+#define HOST_TASK_BLOCKED       1
+#define HOST_TASK_TERMINATED    2
+
+/// called by the generated Host_Cfg_Create(), in cfg order
+void    Host_Clock_Config(UInt32 tickPeriodUs, Int swiPriority);
+void    Host_Swi_Construct(Swi_Struct *swi, const char *name, Host_Fxn fxn, Int priority, UArg arg0, UArg arg1);
+void    Host_Clock_Construct(Clock_Struct *clk, const char *name, Host_Fxn fxn, UInt32 timeout, UInt32 period, Bool startFlag, UArg arg);
+void    Host_Semaphore_Construct(Semaphore_Struct *sem, const char *name, Int count, Bool binary);
+void    Host_Task_Construct(Task_Struct *task, const char *name, Host_Fxn fxn, Int priority, SizeT stackSize, UArg arg0, UArg arg1);
+void    Host_Hwi_Construct(Hwi_Struct *hwi, const char *name, Int intNum, Host_Fxn fxn, Bool enableInt, UArg arg);
+void    Host_Timer_Construct(Timer_Struct *tmr, const char *name, Int id, Int intNum, Host_Fxn fxn, UInt32 periodUs, Bool oneShot, Bool autoStart, UArg arg);
+void    Host_Swi_addHookSet(void (*registerFxn)(Int), void (*beginFxn)(Swi_Handle), void (*endFxn)(Swi_Handle));
+/// called when Swi_disable() locks the scheduler and when it is unlocked again
+void    Host_Swi_lockHook(void (*fxn)(Bool locked));
+void    Host_Task_addHookSet(void (*registerFxn)(Int), void (*switchFxn)(Task_Handle, Task_Handle));
+void    Host_Hwi_addHookSet(void (*registerFxn)(Int), void (*beginFxn)(Hwi_Handle), void (*endFxn)(Hwi_Handle));
+
+/// generated from PDI_Razor.cfg by gen_cfg.py
+void    Host_Cfg_Create(void);
+
+void    Host_Run(UInt64 us);                // advance virtual time by <us>
+UInt64  Host_Now(void);                     // virtual time, microseconds
+void    Host_Hwi_raise(Int intNum);         // inject interrupt <intNum>, dispatch now
+void    Host_Hwi_pend(Int intNum);          // mark it pending, dispatched by Host_Run()
+void    Host_At(UInt64 us, void (*fxn)(UArg), UArg arg); // device event at virtual time <us>
+UInt64  Host_Ns(void);                      // host monotonic clock
+UInt64  Host_DevNs(void);                   // device clock, see above
+void    Host_DevNs_fixed(UInt32 ns);        // <ns> per read of the device clock, 0: host time
+Host_Stats *Host_Stats_first(void);
+void    Host_Stats_reset(void);
+void    Host_Report(FILE *out);
+
+#endif
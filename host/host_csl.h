@@ -0,0 +1,539 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_csl.h
+*-------------------------------------------------------------------------
+* Host stand-in for the TI CSL, <c6x.h> and board headers. The register
+* overlays, field macros and base addresses are the OMAP-L138 ones, for
+* the peripherals and fields the firmware touches. host_mmio.c maps a
+* page at each base address, so the firmware's register accesses land on
+* the peripheral models of host_dev.c exactly as they would on the part.
+* Field values that are only ever written (pin mux functions, pull-ups)
+* follow the data sheet where it matters and are otherwise arbitrary.
+*------------------------------------------------------------------------*/
+#ifndef _HOST_CSL
+#define _HOST_CSL
+
+#include "host_bios.h"
+#include "tistdtypes.h"
+
+typedef Int16                       CSL_Status;
+
+/*============================================================================*/
+/*                        FIELD MACROS (ti/csl/cslr.h)                        */
+/*============================================================================*/
+
+#define CSL_FMK(PER_REG_FIELD, val)                                         \
+    (((val) << CSL_##PER_REG_FIELD##_SHIFT) & CSL_##PER_REG_FIELD##_MASK)
+
+#define CSL_FEXT(reg, PER_REG_FIELD)                                        \
+    (((reg) & CSL_##PER_REG_FIELD##_MASK) >> CSL_##PER_REG_FIELD##_SHIFT)
+
+/* the field name is only ever pasted, never passed on: firmware headers
+ * define some CSL field names (TMR_TGCR_TIMMODE) as plain macros */
+#define CSL_FINS(reg, PER_REG_FIELD, val)                                   \
+    ((reg) = ((reg) & ~CSL_##PER_REG_FIELD##_MASK)                          \
+      | (((val) << CSL_##PER_REG_FIELD##_SHIFT) & CSL_##PER_REG_FIELD##_MASK))
+
+#define CSL_FMKT(PER_REG_FIELD, TOKEN)                                      \
+    ((CSL_##PER_REG_FIELD##_##TOKEN << CSL_##PER_REG_FIELD##_SHIFT)         \
+      & CSL_##PER_REG_FIELD##_MASK)
+
+#define CSL_FINST(reg, PER_REG_FIELD, TOKEN)                                \
+    ((reg) = ((reg) & ~CSL_##PER_REG_FIELD##_MASK)                          \
+      | ((CSL_##PER_REG_FIELD##_##TOKEN << CSL_##PER_REG_FIELD##_SHIFT)     \
+        & CSL_##PER_REG_FIELD##_MASK))
+
+#define CSL_FMKR(msb, lsb, val)                                             \
+    (((val) & ((1 << ((msb) - (lsb) + 1)) - 1)) << (lsb))
+
+#define CSL_FEXTR(reg, msb, lsb)                                            \
+    (((reg) >> (lsb)) & ((1 << ((msb) - (lsb) + 1)) - 1))
+
+#define CSL_FINSR(reg, msb, lsb, val)                                       \
+    ((reg) = ((reg) &~ (((1 << ((msb) - (lsb) + 1)) - 1) << (lsb)))         \
+    | CSL_FMKR(msb, lsb, val))
+
+/// StarterWare register access, used by Watchdog.c
+#define HWREG(x)                    (*((volatile unsigned int *)(UArg)(x)))
+
+/*============================================================================*/
+/*                              BASE ADDRESSES                                */
+/*============================================================================*/
+
+#define CSL_INTC_0_REGS             (0x01800000u)
+#define CSL_SYSCFG_0_REGS           (0x01C14000u)
+#define CSL_TMR_1_REGS              (0x01C21000u)
+#define CSL_I2C_0_DATA_CFG          (0x01C22000u)
+#define CSL_UART_2_REGS             (0x01D0D000u)
+#define CSL_USB_0_REGS              (0x01E00000u)
+#define CSL_GPIO_0_REGS             (0x01E26000u)
+#define CSL_PSC_1_REGS              (0x01E27000u)
+#define CSL_SYSCFG_1_REGS           (0x01E2C000u)
+#define CSL_TMR_3_REGS              (0x01F0D000u)
+#define CSL_EMIFA_0_REGS            (0x68000000u)
+
+/// PSC1 modules
+#define CSL_PSC_USB20               (1)
+#define CSL_PSC_GPIO                (3)
+#define CSL_PSC_I2C1                (11)
+#define CSL_PSC_UART2               (13)
+
+/*============================================================================*/
+/*                                    I2C                                     */
+/*============================================================================*/
+
+typedef struct CSL_I2cRegs
+{
+    volatile Uint32 ICOAR;
+    volatile Uint32 ICIMR;
+    volatile Uint32 ICSTR;
+    volatile Uint32 ICCLKL;
+    volatile Uint32 ICCLKH;
+    volatile Uint32 ICCNT;
+    volatile Uint32 ICDRR;
+    volatile Uint32 ICSAR;
+    volatile Uint32 ICDXR;
+    volatile Uint32 ICMDR;
+    volatile Uint32 ICIVR;
+    volatile Uint32 ICEMDR;
+    volatile Uint32 ICPSC;
+    volatile Uint32 REVID1;
+    volatile Uint32 REVID2;
+} CSL_I2cRegs, *CSL_I2cRegsOvly;
+
+#define CSL_I2C_ICIMR_ICRRDY_MASK (0x00000008u)
+#define CSL_I2C_ICIMR_ICRRDY_SHIFT (0x00000003u)
+#define CSL_I2C_ICIMR_ICRRDY_DISABLE (0x00000000u)
+#define CSL_I2C_ICIMR_ICRRDY_ENABLE (0x00000001u)
+#define CSL_I2C_ICIMR_ICXRDY_MASK (0x00000010u)
+#define CSL_I2C_ICIMR_ICXRDY_SHIFT (0x00000004u)
+#define CSL_I2C_ICIMR_ICXRDY_DISABLE (0x00000000u)
+#define CSL_I2C_ICIMR_ICXRDY_ENABLE (0x00000001u)
+
+#define CSL_I2C_ICSTR_NACK_MASK (0x00000002u)
+#define CSL_I2C_ICSTR_NACK_SHIFT (0x00000001u)
+#define CSL_I2C_ICSTR_ARDY_MASK (0x00000004u)
+#define CSL_I2C_ICSTR_ARDY_SHIFT (0x00000002u)
+#define CSL_I2C_ICSTR_ICRRDY_MASK (0x00000008u)
+#define CSL_I2C_ICSTR_ICRRDY_SHIFT (0x00000003u)
+#define CSL_I2C_ICSTR_ICXRDY_MASK (0x00000010u)
+#define CSL_I2C_ICSTR_ICXRDY_SHIFT (0x00000004u)
+#define CSL_I2C_ICSTR_SCD_MASK (0x00000020u)
+#define CSL_I2C_ICSTR_SCD_SHIFT (0x00000005u)
+#define CSL_I2C_ICSTR_BB_MASK (0x00001000u)
+#define CSL_I2C_ICSTR_BB_SHIFT (0x0000000Cu)
+#define CSL_I2C_ICSTR_BB_RESETVAL (0x00000000u)
+#define CSL_I2C_ICSTR_BB_FREE (0x00000000u)
+#define CSL_I2C_ICSTR_BB_BUSY (0x00000001u)
+#define CSL_I2C_ICSTR_BB_CLEAR (0x00000001u)
+#define CSL_I2C_ICSTR_RESETVAL (0x00000410u)
+
+#define CSL_I2C_ICCLKL_ICCL_MASK (0x0000FFFFu)
+#define CSL_I2C_ICCLKL_ICCL_SHIFT (0x00000000u)
+#define CSL_I2C_ICCLKH_ICCH_MASK (0x0000FFFFu)
+#define CSL_I2C_ICCLKH_ICCH_SHIFT (0x00000000u)
+#define CSL_I2C_ICCNT_ICDC_MASK (0x0000FFFFu)
+#define CSL_I2C_ICCNT_ICDC_SHIFT (0x00000000u)
+#define CSL_I2C_ICDRR_D_MASK (0x000000FFu)
+#define CSL_I2C_ICDRR_D_SHIFT (0x00000000u)
+#define CSL_I2C_ICSAR_SADDR_MASK (0x000003FFu)
+#define CSL_I2C_ICSAR_SADDR_SHIFT (0x00000000u)
+#define CSL_I2C_ICDXR_D_MASK (0x000000FFu)
+#define CSL_I2C_ICDXR_D_SHIFT (0x00000000u)
+#define CSL_I2C_ICPSC_IPSC_MASK (0x000000FFu)
+#define CSL_I2C_ICPSC_IPSC_SHIFT (0x00000000u)
+
+#define CSL_I2C_ICMDR_STB_MASK (0x00000010u)
+#define CSL_I2C_ICMDR_STB_SHIFT (0x00000004u)
+#define CSL_I2C_ICMDR_STB_DISABLE (0x00000000u)
+#define CSL_I2C_ICMDR_STB_ENABLE (0x00000001u)
+#define CSL_I2C_ICMDR_IRS_MASK (0x00000020u)
+#define CSL_I2C_ICMDR_IRS_SHIFT (0x00000005u)
+#define CSL_I2C_ICMDR_IRS_RESETVAL (0x00000000u)
+#define CSL_I2C_ICMDR_IRS_DISABLE (0x00000000u)
+#define CSL_I2C_ICMDR_IRS_ENABLE (0x00000001u)
+#define CSL_I2C_ICMDR_RM_MASK (0x00000080u)
+#define CSL_I2C_ICMDR_RM_SHIFT (0x00000007u)
+#define CSL_I2C_ICMDR_RM_RESETVAL (0x00000000u)
+#define CSL_I2C_ICMDR_RM_DISABLE (0x00000000u)
+#define CSL_I2C_ICMDR_RM_ENABLE (0x00000001u)
+#define CSL_I2C_ICMDR_TRX_MASK (0x00000200u)
+#define CSL_I2C_ICMDR_TRX_SHIFT (0x00000009u)
+#define CSL_I2C_ICMDR_TRX_RESETVAL (0x00000000u)
+#define CSL_I2C_ICMDR_TRX_RX_MODE (0x00000000u)
+#define CSL_I2C_ICMDR_TRX_TX_MODE (0x00000001u)
+#define CSL_I2C_ICMDR_MST_MASK (0x00000400u)
+#define CSL_I2C_ICMDR_MST_SHIFT (0x0000000Au)
+#define CSL_I2C_ICMDR_MST_RESETVAL (0x00000000u)
+#define CSL_I2C_ICMDR_MST_SLAVE_MODE     (0x00000000u)
+#define CSL_I2C_ICMDR_MST_MASTER_MODE    (0x00000001u)
+#define CSL_I2C_ICMDR_STP_MASK (0x00000800u)
+#define CSL_I2C_ICMDR_STP_SHIFT (0x0000000Bu)
+#define CSL_I2C_ICMDR_STP_RESETVAL (0x00000000u)
+#define CSL_I2C_ICMDR_STP_CLEAR (0x00000000u)
+#define CSL_I2C_ICMDR_STP_SET (0x00000001u)
+#define CSL_I2C_ICMDR_STT_MASK (0x00002000u)
+#define CSL_I2C_ICMDR_STT_SHIFT (0x0000000Du)
+#define CSL_I2C_ICMDR_STT_RESETVAL (0x00000000u)
+#define CSL_I2C_ICMDR_STT_CLEAR (0x00000000u)
+#define CSL_I2C_ICMDR_STT_SET (0x00000001u)
+
+#define CSL_I2C_ICIVR_INTCODE_MASK (0x00000007u)
+#define CSL_I2C_ICIVR_INTCODE_SHIFT (0x00000000u)
+#define CSL_I2C_ICIVR_INTCODE_RESETVAL (0x00000000u)
+#define CSL_I2C_ICIVR_INTCODE_NONE (0x00000000u)
+#define CSL_I2C_ICIVR_INTCODE_AL (0x00000001u)
+#define CSL_I2C_ICIVR_INTCODE_NACK (0x00000002u)
+#define CSL_I2C_ICIVR_INTCODE_ARDY (0x00000003u)
+#define CSL_I2C_ICIVR_INTCODE_ICRRDY (0x00000004u)
+#define CSL_I2C_ICIVR_INTCODE_ICXRDY (0x00000005u)
+#define CSL_I2C_ICIVR_INTCODE_SCD (0x00000006u)
+#define CSL_I2C_ICIVR_INTCODE_AAS (0x00000007u)
+
+/*============================================================================*/
+/*                                   UART                                     */
+/*============================================================================*/
+
+typedef struct CSL_UartRegs
+{
+    volatile Uint32 RBR;
+    volatile Uint32 IER;
+    volatile Uint32 IIR;
+    volatile Uint32 LCR;
+    volatile Uint32 MCR;
+    volatile Uint32 LSR;
+    volatile Uint32 MSR;
+    volatile Uint32 SCR;
+    volatile Uint32 DLL;
+    volatile Uint32 DLH;
+    volatile Uint32 REVID1;
+    volatile Uint32 REVID2;
+    volatile Uint32 PWREMU_MGMT;
+    volatile Uint32 MDR;
+} CSL_UartRegs, *CSL_UartRegsOvly;
+
+/// same offsets, as in the TI header
+#define THR                         RBR
+#define FCR                         IIR
+
+#define CSL_UART_RBR_DATA_MASK (0x000000FFu)
+#define CSL_UART_RBR_DATA_SHIFT (0x00000000u)
+#define CSL_UART_THR_DATA_MASK (0x000000FFu)
+#define CSL_UART_THR_DATA_SHIFT (0x00000000u)
+
+#define CSL_UART_IER_ERBI_MASK (0x00000001u)
+#define CSL_UART_IER_ERBI_SHIFT (0x00000000u)
+#define CSL_UART_IER_ERBI_ENABLE (0x00000001u)
+#define CSL_UART_IER_ETBEI_MASK (0x00000002u)
+#define CSL_UART_IER_ETBEI_SHIFT (0x00000001u)
+#define CSL_UART_IER_ETBEI_ENABLE (0x00000001u)
+#define CSL_UART_IER_ELSI_MASK (0x00000004u)
+#define CSL_UART_IER_ELSI_SHIFT (0x00000002u)
+#define CSL_UART_IER_ELSI_ENABLE (0x00000001u)
+
+#define CSL_UART_FCR_FIFOEN_MASK (0x00000001u)
+#define CSL_UART_FCR_FIFOEN_SHIFT (0x00000000u)
+#define CSL_UART_FCR_FIFOEN_ENABLE (0x00000001u)
+#define CSL_UART_FCR_RXCLR_MASK (0x00000002u)
+#define CSL_UART_FCR_RXCLR_SHIFT (0x00000001u)
+#define CSL_UART_FCR_RXCLR_CLR (0x00000001u)
+#define CSL_UART_FCR_TXCLR_MASK (0x00000004u)
+#define CSL_UART_FCR_TXCLR_SHIFT (0x00000002u)
+#define CSL_UART_FCR_TXCLR_CLR (0x00000001u)
+#define CSL_UART_FCR_DMAMODE1_MASK (0x00000008u)
+#define CSL_UART_FCR_DMAMODE1_SHIFT (0x00000003u)
+#define CSL_UART_FCR_DMAMODE1_ENABLE (0x00000001u)
+#define CSL_UART_FCR_RXFIFTL_MASK (0x000000C0u)
+#define CSL_UART_FCR_RXFIFTL_SHIFT (0x00000006u)
+#define CSL_UART_FCR_RXFIFTL_CHAR1 (0x00000000u)
+
+#define CSL_UART_LCR_WLS_MASK (0x00000003u)
+#define CSL_UART_LCR_WLS_SHIFT (0x00000000u)
+#define CSL_UART_LCR_WLS_8BITS (0x00000003u)
+#define CSL_UART_LCR_PEN_MASK (0x00000008u)
+#define CSL_UART_LCR_PEN_SHIFT (0x00000003u)
+#define CSL_UART_LCR_PEN_DISABLE (0x00000000u)
+#define CSL_UART_LCR_PEN_ENABLE (0x00000001u)
+#define CSL_UART_LCR_EPS_MASK (0x00000010u)
+#define CSL_UART_LCR_EPS_SHIFT (0x00000004u)
+#define CSL_UART_LCR_EPS_ODD (0x00000000u)
+#define CSL_UART_LCR_EPS_EVEN (0x00000001u)
+#define CSL_UART_LCR_SP_MASK (0x00000020u)
+#define CSL_UART_LCR_SP_SHIFT (0x00000005u)
+#define CSL_UART_LCR_SP_DISABLE (0x00000000u)
+#define CSL_UART_LCR_SP_ENABLE (0x00000001u)
+
+#define CSL_UART_MCR_RTS_MASK (0x00000002u)
+#define CSL_UART_MCR_RTS_SHIFT (0x00000001u)
+#define CSL_UART_MCR_RTS_ENABLE (0x00000001u)
+#define CSL_UART_MCR_LOOP_MASK (0x00000010u)
+#define CSL_UART_MCR_LOOP_SHIFT (0x00000004u)
+#define CSL_UART_MCR_LOOP_DISABLE (0x00000000u)
+#define CSL_UART_MCR_AFE_MASK (0x00000020u)
+#define CSL_UART_MCR_AFE_SHIFT (0x00000005u)
+#define CSL_UART_MCR_AFE_DISABLE (0x00000000u)
+
+#define CSL_UART_LSR_DR_MASK (0x00000001u)
+#define CSL_UART_LSR_THRE_MASK (0x00000020u)
+#define CSL_UART_LSR_TEMT_MASK (0x00000040u)
+#define CSL_UART_LSR_TEMT_SHIFT (0x00000006u)
+
+#define CSL_UART_DLL_DLL_MASK (0x000000FFu)
+#define CSL_UART_DLL_DLL_SHIFT (0x00000000u)
+#define CSL_UART_DLH_DLH_MASK (0x000000FFu)
+#define CSL_UART_DLH_DLH_SHIFT (0x00000000u)
+
+#define CSL_UART_PWREMU_MGMT_URRST_MASK (0x00002000u)
+#define CSL_UART_PWREMU_MGMT_URRST_SHIFT (0x0000000Du)
+#define CSL_UART_PWREMU_MGMT_URRST_RESET (0x00000000u)
+#define CSL_UART_PWREMU_MGMT_URRST_ENABLE (0x00000001u)
+#define CSL_UART_PWREMU_MGMT_UTRST_MASK (0x00004000u)
+#define CSL_UART_PWREMU_MGMT_UTRST_SHIFT (0x0000000Eu)
+#define CSL_UART_PWREMU_MGMT_UTRST_RESET (0x00000000u)
+#define CSL_UART_PWREMU_MGMT_UTRST_ENABLE (0x00000001u)
+
+/*============================================================================*/
+/*                                   GPIO                                     */
+/*============================================================================*/
+
+typedef struct
+{
+    volatile Uint32 DIR;
+    volatile Uint32 OUT_DATA;
+    volatile Uint32 SET_DATA;
+    volatile Uint32 CLR_DATA;
+    volatile Uint32 IN_DATA;
+    volatile Uint32 SET_RIS_TRIG;
+    volatile Uint32 CLR_RIS_TRIG;
+    volatile Uint32 SET_FAL_TRIG;
+    volatile Uint32 CLR_FAL_TRIG;
+    volatile Uint32 INTSTAT;
+} CSL_GpioBank_registersRegs;
+
+typedef struct CSL_GpioRegs
+{
+    volatile Uint32 REVID;
+    volatile Uint32 RSVD0;
+    volatile Uint32 BINTEN;
+    volatile Uint32 RSVD1;
+    CSL_GpioBank_registersRegs BANK_REGISTERS[5];
+} CSL_GpioRegs, *CSL_GpioHandle;
+
+#define CSL_GPIO_OUT_DATA_OUT5_MASK (0x00000020u)
+#define CSL_GPIO_OUT_DATA_OUT5_SHIFT (0x00000005u)
+
+/*============================================================================*/
+/*                                    PSC                                     */
+/*============================================================================*/
+
+typedef struct CSL_PscRegs
+{
+    volatile Uint32 REVID;
+    volatile Uint8  RSVD0[284];
+    volatile Uint32 PTCMD;
+    volatile Uint8  RSVD1[4];
+    volatile Uint32 PTSTAT;
+    volatile Uint8  RSVD2[1748];
+    volatile Uint32 MDSTAT[32];
+    volatile Uint8  RSVD3[384];
+    volatile Uint32 MDCTL[32];
+} CSL_PscRegs, *CSL_PscRegsOvly;
+
+#define CSL_PSC_PTCMD_GO0_MASK (0x00000001u)
+#define CSL_PSC_PTCMD_GO0_SHIFT (0x00000000u)
+#define CSL_PSC_PTCMD_GO0_SET (0x00000001u)
+#define CSL_PSC_MDSTAT_STATE_MASK (0x0000003Fu)
+#define CSL_PSC_MDSTAT_STATE_SHIFT (0x00000000u)
+#define CSL_PSC_MDSTAT_STATE_ENABLE (0x00000003u)
+#define CSL_PSC_MDCTL_NEXT_MASK (0x00000007u)
+#define CSL_PSC_MDCTL_NEXT_SHIFT (0x00000000u)
+#define CSL_PSC_MDCTL_NEXT_ENABLE (0x00000003u)
+#define CSL_PSC_MDCTL_LRST_MASK (0x00000100u)
+#define CSL_PSC_MDCTL_LRST_SHIFT (0x00000008u)
+#define CSL_PSC_MDCTL_LRST_DEASSERT (0x00000001u)
+
+/*============================================================================*/
+/*                               SYSCFG0/SYSCFG1                              */
+/*============================================================================*/
+
+typedef struct CSL_SyscfgRegs
+{
+    volatile Uint32 REVID;
+    volatile Uint8  RSVD0[284];
+    volatile Uint32 PINMUX0;
+    volatile Uint32 PINMUX1;
+    volatile Uint32 PINMUX2;
+    volatile Uint32 PINMUX3;
+    volatile Uint32 PINMUX4;
+    volatile Uint32 PINMUX5;
+    volatile Uint32 PINMUX6;
+    volatile Uint32 PINMUX7;
+    volatile Uint32 PINMUX8;
+    volatile Uint32 PINMUX9;
+    volatile Uint32 PINMUX10;
+    volatile Uint32 PINMUX11;
+    volatile Uint32 PINMUX12;
+    volatile Uint32 PINMUX13;
+    volatile Uint32 PINMUX14;
+    volatile Uint32 PINMUX15;
+    volatile Uint32 PINMUX16;
+    volatile Uint32 PINMUX17;
+    volatile Uint32 PINMUX18;
+    volatile Uint32 PINMUX19;
+} CSL_SyscfgRegs, *CSL_SyscfgRegsOvly;
+
+typedef struct CSL_Syscfg1Regs
+{
+    volatile Uint32 VTPIO_CTL;
+    volatile Uint32 DDR_SLEW;
+    volatile Uint32 DEEPSLEEP;
+    volatile Uint32 PUPD_ENA;
+    volatile Uint32 PUPD_SEL;
+    volatile Uint32 RXACTIVE;
+    volatile Uint32 PWRDN;
+} CSL_Syscfg1Regs, *CSL_Syscfg1RegsOvly;
+
+#define CSL_SYSCFG_PINMUX0_PINMUX0_27_24_MASK (0x0F000000u)
+#define CSL_SYSCFG_PINMUX0_PINMUX0_27_24_SHIFT (0x00000018u)
+#define CSL_SYSCFG_PINMUX0_PINMUX0_27_24_GPIO0_9 (0x00000008u)
+#define CSL_SYSCFG_PINMUX1_PINMUX1_3_0_MASK (0x0000000Fu)
+#define CSL_SYSCFG_PINMUX1_PINMUX1_3_0_SHIFT (0x00000000u)
+#define CSL_SYSCFG_PINMUX1_PINMUX1_3_0_GPIO0_7 (0x00000008u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_7_4_MASK (0x000000F0u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_7_4_SHIFT (0x00000004u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_7_4_TM64P1_IN12 (0x00000002u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_11_8_MASK (0x00000F00u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_11_8_SHIFT (0x00000008u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_11_8_I2C0_SCL (0x00000002u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_15_12_MASK (0x0000F000u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_15_12_SHIFT (0x0000000Cu)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_15_12_I2C0_SDA (0x00000002u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_19_16_MASK (0x000F0000u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_19_16_SHIFT (0x00000010u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_19_16_UART2_RXD (0x00000002u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_23_20_MASK (0x00F00000u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_23_20_SHIFT (0x00000014u)
+#define CSL_SYSCFG_PINMUX4_PINMUX4_23_20_UART2_TXD (0x00000002u)
+#define CSL_SYSCFG_PINMUX5_PINMUX5_7_4_MASK (0x000000F0u)
+#define CSL_SYSCFG_PINMUX5_PINMUX5_7_4_SHIFT (0x00000004u)
+#define CSL_SYSCFG_PINMUX5_PINMUX5_7_4_TM64P3_IN12 (0x00000002u)
+#define CSL_SYSCFG_PINMUX6_PINMUX6_11_8_MASK (0x00000F00u)
+#define CSL_SYSCFG_PINMUX6_PINMUX6_11_8_SHIFT (0x00000008u)
+#define CSL_SYSCFG_PINMUX6_PINMUX6_11_8_GPIO2_5 (0x00000008u)
+#define CSL_SYSCFG_PINMUX18_PINMUX18_23_20_MASK (0x00F00000u)
+#define CSL_SYSCFG_PINMUX18_PINMUX18_23_20_SHIFT (0x00000014u)
+#define CSL_SYSCFG_PINMUX18_PINMUX18_23_20_GPIO8_12 (0x00000008u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_15_12_MASK (0x0000F000u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_15_12_SHIFT (0x0000000Cu)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_15_12_GPIO6_3 (0x00000008u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_19_16_MASK (0x000F0000u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_19_16_SHIFT (0x00000010u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_19_16_GPIO6_2 (0x00000008u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_23_20_MASK (0x00F00000u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_23_20_SHIFT (0x00000014u)
+#define CSL_SYSCFG_PINMUX19_PINMUX19_23_20_GPIO6_1 (0x00000008u)
+
+#define CSL_SYSCFG1_PUPD_ENA_PUPDENA0_MASK (0x00000001u)
+#define CSL_SYSCFG1_PUPD_ENA_PUPDENA0_SHIFT (0x00000000u)
+#define CSL_SYSCFG1_PUPD_ENA_PUPDENA0_ENABLE (0x00000001u)
+#define CSL_SYSCFG1_PUPD_SEL_PUPDSEL0_MASK (0x00000001u)
+#define CSL_SYSCFG1_PUPD_SEL_PUPDSEL0_SHIFT (0x00000000u)
+#define CSL_SYSCFG1_PUPD_SEL_PUPDSEL0_PULLDOWN (0x00000000u)
+#define CSL_SYSCFG1_PUPD_SEL_PUPDSEL31_MASK (0x80000000u)
+#define CSL_SYSCFG1_PUPD_SEL_PUPDSEL31_SHIFT (0x0000001Fu)
+#define CSL_SYSCFG1_PUPD_SEL_PUPDSEL31_PULLDOWN (0x00000000u)
+
+/*============================================================================*/
+/*                                 TIMER64P                                   */
+/*============================================================================*/
+
+typedef struct CSL_TmrRegs
+{
+    volatile Uint32 REVID;
+    volatile Uint32 EMUMGT_CLKSPD;
+    volatile Uint32 GPINT_GPEN;
+    volatile Uint32 GPDATA_GPDIR;
+    volatile Uint32 CNTLO;
+    volatile Uint32 CNTHI;
+    volatile Uint32 PRDLO;
+    volatile Uint32 PRDHI;
+    volatile Uint32 TCR;
+    volatile Uint32 TGCR;
+    volatile Uint32 WDTCR;
+} CSL_TmrRegs, *CSL_TmrRegsOvly;
+
+#define CSL_TMR_TCR_ENAMODE_LO_MASK (0x000000C0u)
+#define CSL_TMR_TCR_ENAMODE_LO_SHIFT (0x00000006u)
+#define CSL_TMR_TCR_ENAMODE_LO_DISABLE (0x00000000u)
+#define CSL_TMR_TCR_ENAMODE_LO_ENABLE    	(0x00000001u)
+#define CSL_TMR_TCR_CLKSRC_LO_MASK (0x00000100u)
+#define CSL_TMR_TCR_CLKSRC_LO_SHIFT (0x00000008u)
+#define CSL_TMR_TCR_CLKSRC_LO_MAX (0x00000001u)
+#define CSL_TMR_TGCR_TIMLORS_MASK (0x00000001u)
+#define CSL_TMR_TGCR_TIMLORS_SHIFT (0x00000000u)
+#define CSL_TMR_TGCR_TIMLORS_RESET_ON (0x00000000u)
+#define CSL_TMR_TGCR_TIMLORS_RESET_OFF (0x00000001u)
+#define CSL_TMR_TGCR_TIMHIRS_MASK (0x00000002u)
+#define CSL_TMR_TGCR_TIMHIRS_SHIFT (0x00000001u)
+#define CSL_TMR_TGCR_TIMHIRS_RESET_ON (0x00000000u)
+#define CSL_TMR_TGCR_TIMHIRS_RESET_OFF (0x00000001u)
+#define CSL_TMR_TGCR_TIMMODE_MASK (0x0000000Cu)
+#define CSL_TMR_TGCR_TIMMODE_SHIFT (0x00000002u)
+#define CSL_TMR_TGCR_TIMMODE_RESETVAL (0x00000000u)
+
+/*============================================================================*/
+/*                                  EMIFA                                     */
+/*============================================================================*/
+
+typedef struct CSL_EmifaRegs
+{
+    volatile Uint32 MIDR;
+    volatile Uint32 AWCC;
+    volatile Uint32 SDCR;
+    volatile Uint32 SDRCR;
+    volatile Uint32 CE2CFG;
+    volatile Uint32 CE3CFG;
+    volatile Uint32 CE4CFG;
+    volatile Uint32 CE5CFG;
+    volatile Uint8  RSVD0[64];
+    volatile Uint32 NANDFCR;
+} CSL_EmifaRegs, *CSL_EmifaRegsOvly;
+
+#define CSL_EMIFA_CE4CFG_ASIZE_MASK (0x00000003u)
+#define CSL_EMIFA_CE4CFG_ASIZE_SHIFT (0x00000000u)
+#define CSL_EMIFA_CE4CFG_ASIZE_16BIT (0x00000001u)
+#define CSL_EMIFA_NANDFCR_CS4NAND_MASK (0x00000004u)
+#define CSL_EMIFA_NANDFCR_CS4NAND_SHIFT (0x00000002u)
+#define CSL_EMIFA_NANDFCR_CS4NAND_NAND_ENABLE (0x00000001u)
+
+/*============================================================================*/
+/*                      NOT MODELLED (only handles exist)                     */
+/*============================================================================*/
+
+typedef struct CSL_Usb_otgRegs      *CSL_Usb_otgRegsOvly;
+typedef struct CSL_IntcRegs         *CSL_IntcRegsOvly;
+
+/*============================================================================*/
+/*                          BOARD LIBRARY (ti/board)                          */
+/*============================================================================*/
+
+typedef Int32 Board_STATUS;
+
+Board_STATUS Board_moduleClockEnable(Uint32 moduleId);
+Board_STATUS Board_moduleClockSyncReset(Uint32 moduleId);
+
+#endif
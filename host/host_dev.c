@@ -0,0 +1,393 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_dev.c
+*-------------------------------------------------------------------------
+* UART2, GPIO, PSC, SYSCFG0/1, EMIFA and the two timers the firmware
+* programs directly, for the host build (see host_dev.h). The I2C bus is
+* in host_i2c.c.
+*
+* UART2 follows what UART_HWI_ISR() relies on: IIR reads RDA while the
+* RX FIFO holds data and ERBI is set, else THRE once (reading it clears
+* it), else "nothing pending"; LSR.TEMT is set when the last character
+* has left the shift register; RBR pops the RX FIFO. Every THR write
+* holds the transmitter for one character time at the programmed divisor
+* (150 MHz / 16 / divisor, 11 bits with parity and stop), and the
+* transmitter going empty raises THRE on the UART HWI if ETBEI is set.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_csl.h"
+#include "host_dev.h"
+
+#define UART_HWI        5           // PDI_Razor.cfg, UART_Hwi
+#define UART_CLK        150000000u
+#define UART_RX_MAX     512
+
+#define NAND_CS3        0x62000000u
+
+#define TMR_CLK         24000000u   // timer64 input, watchdog period base
+#define WD_KEY_PRE      0xA5C6u
+#define WD_KEY_ACTIVE   0xDA7Eu
+#define WD_WDEN         0x00004000u
+
+extern UInt32 EXTERNAL_RAM_START, EXTERNAL_RAM_END;
+/* through memory: an immediate operand cannot hold an address above 2 GB */
+static UInt32 *volatile extRam[2] = {&EXTERNAL_RAM_START, &EXTERNAL_RAM_END};
+
+/*============================================================================*/
+/*                                  UART2                                     */
+/*============================================================================*/
+
+static volatile CSL_UartRegs *uart;
+
+static struct
+{
+    Host_UartTx txFxn;
+    UInt64  txBusyUs;               // shift register busy until
+    Bool    thre;                   // THRE interrupt pending
+    UInt8   rx[UART_RX_MAX];        // bytes arrived, not yet read
+    UInt32  rxHead;
+    UInt32  rxN;
+    UInt64  rxNextUs;               // arrival time of the last injected byte
+    UInt32  rxQueued;               // injected, not yet arrived
+} u;
+
+UInt32 Host_Uart_charUs(void)
+{
+    UInt32 div = ((uart->DLH & 0xFF) << 8) | (uart->DLL & 0xFF);
+
+    if (div == 0) div = 1;
+
+    /* start, 8 data, parity, stop */
+    return (UInt32)((11ull * 16 * div * 1000000ull) / UART_CLK);
+}
+
+static void uartIrq(void)
+{
+    Bool rda = (uart->IER & CSL_UART_IER_ERBI_MASK) && u.rxN > 0;
+    Bool thre = (uart->IER & CSL_UART_IER_ETBEI_MASK) && u.thre;
+
+    if (rda || thre) Host_Hwi_pend(UART_HWI);
+}
+
+static void uartTxEmpty(UArg arg)
+{
+    (void)arg;
+
+    if (Host_Now() < u.txBusyUs) return;    // more was written since
+
+    u.thre = TRUE;
+    uartIrq();
+}
+
+static void uartRxArrive(UArg byte)
+{
+    if (u.rxQueued) u.rxQueued--;
+    if (u.rxN < UART_RX_MAX)
+    {
+        u.rx[(u.rxHead + u.rxN) % UART_RX_MAX] = (UInt8)byte;
+        u.rxN++;
+    }
+    uartIrq();
+}
+
+void Host_Uart_rx(const UInt8 *bytes, UInt32 n)
+{
+    UInt32 i;
+    UInt64 t = Host_Now() > u.rxNextUs ? Host_Now() : u.rxNextUs;
+
+    for (i=0; i<n; i++)
+    {
+        t += Host_Uart_charUs();
+        Host_At(t, uartRxArrive, bytes[i]);
+    }
+    u.rxNextUs  = t;
+    u.rxQueued += n;
+}
+
+void Host_Uart_tx(Host_UartTx fxn)
+{
+    u.txFxn = fxn;
+}
+
+Bool Host_Uart_idle(void)
+{
+    return Host_Now() >= u.txBusyUs && u.rxN == 0 && u.rxQueued == 0;
+}
+
+static void uartRead(void *ctx, UInt32 off)
+{
+    (void)ctx;
+
+    switch (off)
+    {
+    case offsetof(CSL_UartRegs, RBR):
+        if (u.rxN)
+        {
+            uart->RBR = u.rx[u.rxHead];
+            u.rxHead = (u.rxHead + 1) % UART_RX_MAX;
+            u.rxN--;
+        }
+        break;
+
+    case offsetof(CSL_UartRegs, IIR):
+        if ((uart->IER & CSL_UART_IER_ERBI_MASK) && u.rxN) uart->IIR = 0xC4;
+        else if ((uart->IER & CSL_UART_IER_ETBEI_MASK) && u.thre)
+        {
+            uart->IIR = 0xC2;
+            u.thre = FALSE;
+        }
+        else uart->IIR = 0xC1;
+        break;
+
+    case offsetof(CSL_UartRegs, LSR):
+        uart->LSR = (u.rxN ? 0x01 : 0)
+                  | (Host_Now() >= u.txBusyUs ? 0x60 : 0);
+        break;
+    }
+}
+
+static void uartWrite(void *ctx, UInt32 off, UInt32 val, UInt32 old)
+{
+    UInt64 now = Host_Now();
+
+    (void)ctx;
+
+    switch (off)
+    {
+    case offsetof(CSL_UartRegs, THR):
+        if (uart->LCR & 0x80) break;        // DLAB: divisor latch
+        if (u.txFxn) u.txFxn((UInt8)val);
+        u.txBusyUs = (u.txBusyUs > now ? u.txBusyUs : now) + Host_Uart_charUs();
+        u.thre = FALSE;
+        Host_At(u.txBusyUs, uartTxEmpty, 0);
+        break;
+
+    case offsetof(CSL_UartRegs, IER):
+        /* enabling ETBEI with the transmitter empty interrupts at once */
+        if ((val & CSL_UART_IER_ETBEI_MASK) && !(old & CSL_UART_IER_ETBEI_MASK) && now >= u.txBusyUs)
+            u.thre = TRUE;
+        uartIrq();
+        break;
+
+    case offsetof(CSL_UartRegs, FCR):
+        if (val & CSL_UART_FCR_RXCLR_MASK) u.rxN = 0;
+        if (val & CSL_UART_FCR_TXCLR_MASK) u.txBusyUs = now;
+        break;
+    }
+}
+
+/*============================================================================*/
+/*                                   GPIO                                     */
+/*============================================================================*/
+
+static volatile CSL_GpioRegs *gpio;
+
+void Host_Gpio_input(UInt32 pin, Bool level)
+{
+    volatile UInt32 *in = &gpio->BANK_REGISTERS[pin / 32].IN_DATA;
+
+    if (level) *in |= 1u << (pin % 32);
+    else *in &= ~(1u << (pin % 32));
+}
+
+Bool Host_Gpio_output(UInt32 pin)
+{
+    return (gpio->BANK_REGISTERS[pin / 32].OUT_DATA >> (pin % 32)) & 1;
+}
+
+static void gpioWrite(void *ctx, UInt32 off, UInt32 val, UInt32 old)
+{
+    UInt32 bank, reg;
+
+    (void)ctx; (void)old;
+
+    if (off < offsetof(CSL_GpioRegs, BANK_REGISTERS)) return;
+    bank = (off - offsetof(CSL_GpioRegs, BANK_REGISTERS)) / sizeof(CSL_GpioBank_registersRegs);
+    reg  = (off - offsetof(CSL_GpioRegs, BANK_REGISTERS)) % sizeof(CSL_GpioBank_registersRegs);
+    if (bank >= 5) return;
+
+    if (reg == offsetof(CSL_GpioBank_registersRegs, SET_DATA)) gpio->BANK_REGISTERS[bank].OUT_DATA |= val;
+    if (reg == offsetof(CSL_GpioBank_registersRegs, CLR_DATA)) gpio->BANK_REGISTERS[bank].OUT_DATA &= ~val;
+}
+
+/*============================================================================*/
+/*                                    PSC                                     */
+/*============================================================================*/
+
+static volatile CSL_PscRegs *psc;
+
+/* every module is always on: MDSTAT reads ENABLE */
+static void pscRead(void *ctx, UInt32 off)
+{
+    (void)ctx;
+
+    if (off >= offsetof(CSL_PscRegs, MDSTAT) && off < offsetof(CSL_PscRegs, RSVD3))
+        psc->MDSTAT[(off - offsetof(CSL_PscRegs, MDSTAT)) / 4] = CSL_PSC_MDSTAT_STATE_ENABLE;
+    if (off == offsetof(CSL_PscRegs, PTSTAT)) psc->PTSTAT = 0;
+}
+
+/*============================================================================*/
+/*                           TMR1 WATCHDOG, TMR3                              */
+/*============================================================================*/
+
+static volatile CSL_TmrRegs *tmr1;
+static volatile CSL_TmrRegs *tmr3;
+
+static struct
+{
+    UInt16  lastKey;
+    UInt32  kicks;
+    UInt64  kickUs;
+    void    (*onReset)(void);
+} wd;
+
+static Host_PulseSource pulses;
+static UInt64 tmr3Base;             // source count when CNT was zeroed
+static UInt64 tmr3Latch;            // 64-bit count at the last CNTLO read
+
+UInt32 Host_Wd_kicks(void)
+{
+    return wd.kicks;
+}
+
+void Host_Wd_onReset(void (*fxn)(void))
+{
+    wd.onReset = fxn;
+}
+
+static void wdReset(void)
+{
+    if (wd.onReset) wd.onReset();
+    else
+    {
+        fprintf(stderr, "host_dev: watchdog reset at %.6f s\n", Host_Now() / 1e6);
+        exit(3);
+    }
+}
+
+static UInt64 wdPeriodUs(void)
+{
+    UInt64 prd = ((UInt64)tmr1->PRDHI << 32) | tmr1->PRDLO;
+
+    return prd * 1000000ull / TMR_CLK;
+}
+
+static void wdExpire(UArg kick)
+{
+    if ((UInt32)kick == wd.kicks) wdReset();
+}
+
+static void tmr1Write(void *ctx, UInt32 off, UInt32 val, UInt32 old)
+{
+    UInt16 key = (UInt16)(val >> 16);
+
+    (void)ctx; (void)old;
+
+    if (off != offsetof(CSL_TmrRegs, WDTCR) || !(val & WD_WDEN)) return;
+
+    /* A5C6 then DA7E services it; any other key on an active watchdog
+       resets the device at once */
+    if (key == WD_KEY_PRE) {}
+    else if (key == WD_KEY_ACTIVE && wd.lastKey == WD_KEY_PRE)
+    {
+        wd.kicks++;
+        wd.kickUs = Host_Now();
+        Host_At(wd.kickUs + wdPeriodUs(), wdExpire, wd.kicks);
+    }
+    else if (wd.kicks) wdReset();
+
+    wd.lastKey = key;
+}
+
+/* a 100 kHz reference unless the test supplies one */
+static UInt32 defaultPulses(UInt64 ns)
+{
+    return (UInt32)(ns / 10000);
+}
+
+void Host_Tmr3_source(Host_PulseSource fxn)
+{
+    pulses = fxn;
+    tmr3Base = 0;
+}
+
+static UInt64 tmr3Count(void)
+{
+    UInt64 n = (pulses ? pulses : defaultPulses)(Host_DevNs());
+
+    return n - tmr3Base;
+}
+
+static void tmr3Read(void *ctx, UInt32 off)
+{
+    (void)ctx;
+
+    if (off == offsetof(CSL_TmrRegs, CNTLO))
+    {
+        tmr3Latch = tmr3Count();
+        tmr3->CNTLO = (UInt32)tmr3Latch;
+    }
+    if (off == offsetof(CSL_TmrRegs, CNTHI)) tmr3->CNTHI = (UInt32)(tmr3Latch >> 32);
+}
+
+static void tmr3Write(void *ctx, UInt32 off, UInt32 val, UInt32 old)
+{
+    (void)ctx; (void)old;
+
+    if (off == offsetof(CSL_TmrRegs, CNTLO) && val == 0)
+        tmr3Base = (pulses ? pulses : defaultPulses)(Host_DevNs());
+}
+
+/*============================================================================*/
+/*                                   SETUP                                    */
+/*============================================================================*/
+
+/* the power domains are on from reset (pscRead) */
+Board_STATUS Board_moduleClockEnable(Uint32 moduleId) { (void)moduleId; return 0; }
+Board_STATUS Board_moduleClockSyncReset(Uint32 moduleId) { (void)moduleId; return 0; }
+
+void Host_Dev_Init(void)
+{
+    static Bool done;
+
+    if (done) return;
+    done = TRUE;
+
+    uart = Host_Mmio_map(CSL_UART_2_REGS, sizeof(CSL_UartRegs), uartRead, uartWrite, NULL);
+    gpio = Host_Mmio_map(CSL_GPIO_0_REGS, sizeof(CSL_GpioRegs), NULL, gpioWrite, NULL);
+    psc  = Host_Mmio_map(CSL_PSC_1_REGS, sizeof(CSL_PscRegs), pscRead, NULL, NULL);
+    tmr1 = Host_Mmio_map(CSL_TMR_1_REGS, sizeof(CSL_TmrRegs), NULL, tmr1Write, NULL);
+    tmr3 = Host_Mmio_map(CSL_TMR_3_REGS, sizeof(CSL_TmrRegs), tmr3Read, tmr3Write, NULL);
+
+    /* configuration only: plain memory */
+    Host_Mmio_ram(CSL_SYSCFG_0_REGS, 0x1000);
+    Host_Mmio_ram(CSL_SYSCFG_1_REGS, 0x1000);
+    Host_Mmio_ram(CSL_EMIFA_0_REGS, 0x1000);
+    Host_Mmio_ram(CSL_INTC_0_REGS, 0x1000);
+    Host_Mmio_ram(CSL_USB_0_REGS, 0x1000);
+
+    /* DDR the firmware addresses by number: the util.c heap (Makefile
+       --defsym, as the TI linker places it) */
+    Host_Mmio_ram((UArg)extRam[0], (UArg)extRam[1] - (UArg)extRam[0]);
+
+    /* NAND command/address/data window (EMIFA CS3), written by the upgrade */
+    Host_Mmio_ram(NAND_CS3, 0x1000);
+
+    Host_I2c_Init();
+}
@@ -0,0 +1,193 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_dev.h
+*-------------------------------------------------------------------------
+* Peripheral models behind the register addresses of host_csl.h, for the
+* host build. Host_Dev_Init() maps every block the firmware touches
+* (host_mmio.c) and attaches the boards' I2C devices; a host program calls
+* it once before running firmware code.
+*
+*  - I2C0 controller (host_i2c.c): master transmit/receive, repeat mode,
+*    stop after ICCNT bytes, NACK from an absent address. Bytes move at
+*    once; the time they would take on a 400 kHz bus is accounted, not
+*    spent. Interrupts are not raised: the firmware polls.
+*  - I2C devices (host_i2c.c): LCD expander with an HD44780 behind it,
+*    MBVE button expander, the two ADS1112 ADCs, the AO DAC and the
+*    DS1340 RTC, each with byte and transaction counters.
+*  - UART2 (host_dev.c): transmitter timed by the baud divisor, RX bytes
+*    injected at character spacing, THRE/RDA interrupts on the Modbus
+*    HWI number.
+*  - GPIO, PSC, SYSCFG0/1, EMIFA (host_dev.c): registers as memory, plus
+*    the input pins the models drive and the power domains always on.
+*  - TMR1 watchdog and TMR3 frequency counter (host_dev.c): service-key
+*    kicks counted, an invalid key resets the board; TMR3 counts the
+*    pulses of a host-supplied oscillator.
+*  - NAND flash (host_nand.c), at the nand.h driver API: erase, program,
+*    lock ranges and bad blocks of the LCDK part.
+*  - Modbus RTU master (host_modbus.c) on the UART2 model, for the host
+*    programs that talk to the firmware the way a DCS does.
+*------------------------------------------------------------------------*/
+#ifndef _HOST_DEV
+#define _HOST_DEV
+
+#include "host_bios.h"
+
+/*============================================================================*/
+/*                             REGISTER MAPPING                               */
+/*============================================================================*/
+
+/// called before the firmware reads the word at <off>
+typedef void (*Host_MmioRead)(void *ctx, UInt32 off);
+/// called after the firmware wrote the word at <off>
+typedef void (*Host_MmioWrite)(void *ctx, UInt32 off, UInt32 val, UInt32 old);
+
+volatile void *Host_Mmio_map(UArg base, UInt32 size, Host_MmioRead onRead, Host_MmioWrite onWrite, void *ctx);
+void    *Host_Mmio_ram(UArg base, UInt32 size);
+UInt32  Host_Mmio_traps(void);
+/// in a fork() child: give it its own copy of the register blocks
+void    Host_Mmio_fork(void);
+
+/*============================================================================*/
+/*                                  I2C BUS                                   */
+/*============================================================================*/
+
+typedef struct Host_I2cDev
+{
+    const char          *name;
+    UInt8               addr;
+    void                (*start)(struct Host_I2cDev *dev, Bool read);
+    Bool                (*write)(struct Host_I2cDev *dev, UInt8 byte);  // TRUE: ACK
+    UInt8               (*read)(struct Host_I2cDev *dev);
+    void                (*stop)(struct Host_I2cDev *dev);
+    UInt32              xfers;      // transactions addressed to this device
+    UInt32              bytes;      // data bytes, either direction
+    struct Host_I2cDev  *next;
+} Host_I2cDev;
+
+typedef struct
+{
+    UInt32  starts;                 // start and repeated-start conditions
+    UInt32  bytes;                  // data bytes on the bus
+    UInt32  nacks;
+    UInt64  busNs;                  // time the traffic takes at 400 kHz
+} Host_I2cStats;
+
+void    Host_I2c_attach(Host_I2cDev *dev);
+Host_I2cDev *Host_I2c_find(UInt8 addr);
+void    Host_I2c_stats(Host_I2cStats *stats);
+void    Host_I2c_resetStats(void);
+
+/// 16x2 HD44780 behind the LCD expander (0x20)
+typedef struct
+{
+    char    line[2][17];            // what the glass shows, NUL terminated
+    UInt32  instructions;           // latched on E falling
+    UInt32  characters;
+    UInt32  updates;                // Host_Lcd_changed() calls that saw a change
+} Host_LcdState;
+
+void    Host_Lcd_get(Host_LcdState *lcd);
+Bool    Host_Lcd_changed(void);     // glass changed since the last call
+
+/// MBVE front panel (0x21): I2C_BUTTON_S/E/B/V mask of the held buttons
+void    Host_Buttons_set(UInt8 held);
+
+/// ADS1112 inputs, 0x48 (temperature, VREF) and 0x4A (density): code for
+/// the channel selected by the last config byte, before noise
+typedef Int32 (*Host_AdcInput)(UInt8 addr, UInt8 config);
+void    Host_Adc_input(Host_AdcInput fxn);
+void    Host_Adc_noise(double lsbRms, UInt32 seed);
+UInt32  Host_Adc_conversions(void);
+
+/// AO DAC (0x4C): last code written, and how many writes
+UInt16  Host_Dac_code(void);
+UInt32  Host_Dac_writes(void);
+/// the DAC output changes behind the firmware's back (brown-out, glitch)
+void    Host_Dac_upset(UInt16 code);
+
+/// DS1340 (0x68): time set at <epoch> seconds, oscillator error in ppm
+void    Host_Rtc_set(UInt32 epoch, double ppm);
+UInt32  Host_Rtc_now(void);
+
+/*============================================================================*/
+/*                               UART, PINS, TIMERS                           */
+/*============================================================================*/
+
+/// bytes the firmware wrote to THR, in order
+typedef void (*Host_UartTx)(UInt8 byte);
+void    Host_Uart_tx(Host_UartTx fxn);
+/// queue <n> bytes to arrive one character time apart, starting now
+void    Host_Uart_rx(const UInt8 *bytes, UInt32 n);
+UInt32  Host_Uart_charUs(void);     // one character at the programmed baud
+Bool    Host_Uart_idle(void);       // transmitter and RX queue empty
+
+/// GPIO pin (bank*16 + bit) driven by the outside world
+void    Host_Gpio_input(UInt32 pin, Bool level);
+Bool    Host_Gpio_output(UInt32 pin);
+
+/// TMR3: pulses counted by <dev ns> from the reference oscillator
+typedef UInt32 (*Host_PulseSource)(UInt64 ns);
+void    Host_Tmr3_source(Host_PulseSource fxn);
+
+/// TMR1 watchdog
+UInt32  Host_Wd_kicks(void);
+/// called when the firmware resets the board through the watchdog
+void    Host_Wd_onReset(void (*fxn)(void));
+
+/*============================================================================*/
+/*                                    NAND                                    */
+/*============================================================================*/
+
+typedef struct
+{
+    UInt32  reads;                  // pages
+    UInt32  programs;               // pages
+    UInt32  erases;                 // blocks
+    UInt32  locked;                 // erases and programs refused by the lock
+} Host_NandStats;
+
+void    Host_Nand_stats(Host_NandStats *stats);
+void    Host_Nand_resetStats(void);
+void    Host_Nand_blank(void);      // every block erased and good, all locked
+/// power loss after <ops> more programs and erases: the next one is dropped,
+/// or if <torn> a program lands on the first half of its page only, and
+/// <fxn>, which must not return, is called in its place
+void    Host_Nand_cut(UInt32 ops, Bool torn, void (*fxn)(void));
+
+/*============================================================================*/
+/*                               MODBUS MASTER                                */
+/*============================================================================*/
+
+/// one request and its reply, virtual time running meanwhile; registers
+/// are 1-based as in ModbusTables.h. FALSE on a timeout, a bad reply or
+/// an exception (Host_Mb_exception(), 0 if none)
+Bool    Host_Mb_writeInt(UInt8 slave, UInt16 reg, UInt16 val);     // 0x06
+Bool    Host_Mb_write32(UInt8 slave, UInt16 reg, UInt32 val);      // 0x10, one pair
+Bool    Host_Mb_writeFloat(UInt8 slave, UInt16 reg, float val);
+Bool    Host_Mb_read32(UInt8 slave, UInt16 reg, UInt32 *val);      // 0x03, one pair
+Bool    Host_Mb_readFloat(UInt8 slave, UInt16 reg, float *val);
+UInt8   Host_Mb_exception(void);
+UInt64  Host_Mb_lastUs(void);       // last request, first byte out to reply done
+
+/*============================================================================*/
+/*                                   SETUP                                    */
+/*============================================================================*/
+
+void    Host_Dev_Init(void);
+void    Host_I2c_Init(void);        // called by Host_Dev_Init()
+
+#endif
@@ -0,0 +1,1002 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_fatfs.c
+*-------------------------------------------------------------------------
+* FatFs stand-in for the host build (host_fatfs.h).
+*
+* The FAT is real: cluster chains are allocated, linked and followed
+* through the volume window, so they are on the medium. The directory
+* tree is kept in host memory (names do not fit 8.3 entries), but every
+* entry has its slot in its directory's clusters, and finding, adding,
+* listing and updating entries reads and writes those sectors through the
+* window as FatFs does. File data lives only on the medium.
+*
+* Each routine follows the sector access pattern of its FatFs R0.12
+* counterpart; the comments name the FatFs function being mirrored where
+* that is not obvious.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+#include "host_fatfs.h"
+#include "host_usb.h"
+
+#define SECT            512
+#define CLUST_SECT      8                                   // 4 KB clusters
+#define RSVD_SECT       32
+#define NUM_FATS        2
+#define VOL_SECT        HOST_USB_SECTORS
+#define FAT_SECT        ((VOL_SECT / CLUST_SECT * 4 + SECT - 1) / SECT)
+#define DATA_START      (RSVD_SECT + NUM_FATS * FAT_SECT)
+#define NUM_CLUST       ((VOL_SECT - DATA_START) / CLUST_SECT)
+#define ROOT_CLUST      2
+#define FSINFO_SECT     1
+#define ENT_PER_SECT    (SECT / 32)
+#define EOC             0x0FFFFFFF
+#define FS_FAT32        3
+
+#define FA_MODIFIED     0x40
+#define FA_DIRTY        0x80
+
+typedef struct Host_FfNode
+{
+    char                name[HOST_FF_NAME];
+    BYTE                attr;
+    DWORD               size;
+    DWORD               sclust;
+    WORD                fdate;
+    WORD                ftime;
+    struct Host_FfNode  *parent;
+    UINT                slot;       // entry in the parent
+    DWORD               entSect;    // sector holding that entry
+    struct Host_FfNode  **child;    // by slot; NULL is a free slot
+    UINT                numChild;
+    UINT                maxChild;
+} Node;
+
+static Node root = { "", AM_DIR, 0, ROOT_CLUST };
+static Node dot  = { ".", AM_DIR };          // first two slots of a subdirectory
+
+static const FATFS_Config *drive;           // bound by FATFS_open()
+static FATFS *vol;
+static Host_FfStats stats;
+
+/*============================================================================*/
+/*                                 DISK ACCESS                                */
+/*============================================================================*/
+
+static FRESULT diskRead(BYTE *buf, DWORD sect, UINT n)
+{
+    FATFS_Object *obj = (FATFS_Object *)drive->object;
+
+    stats.requests++;
+    if (drive->drvFxnTablePtr->readDrvFxn(obj->drvHandle, buf, sect, n) != RES_OK) return FR_DISK_ERR;
+    return FR_OK;
+}
+
+static FRESULT diskWrite(const BYTE *buf, DWORD sect, UINT n)
+{
+    FATFS_Object *obj = (FATFS_Object *)drive->object;
+
+    stats.requests++;
+    if (drive->drvFxnTablePtr->writeDrvFxn(obj->drvHandle, (uint8_t *)buf, sect, n) != RES_OK) return FR_DISK_ERR;
+    return FR_OK;
+}
+
+static DWORD clustSect(DWORD clst)
+{
+    return DATA_START + (clst - 2) * CLUST_SECT;
+}
+
+static void st32(BYTE *p, DWORD v)
+{
+    p[0] = (BYTE)v; p[1] = (BYTE)(v >> 8); p[2] = (BYTE)(v >> 16); p[3] = (BYTE)(v >> 24);
+}
+
+static DWORD ld32(const BYTE *p)
+{
+    return p[0] | (p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+/* sync_window(): a FAT sector goes to both copies */
+static FRESULT syncWindow(FATFS *fs)
+{
+    if (!fs->wflag) return FR_OK;
+
+    if (diskWrite(fs->win, fs->winsect, 1) != FR_OK) return FR_DISK_ERR;
+    stats.winWrites++;
+
+    if (fs->winsect >= RSVD_SECT && fs->winsect < RSVD_SECT + FAT_SECT)
+    {
+        if (diskWrite(fs->win, fs->winsect + FAT_SECT, 1) != FR_OK) return FR_DISK_ERR;
+        stats.winWrites++;
+    }
+
+    fs->wflag = 0;
+    return FR_OK;
+}
+
+/* move_window() */
+static FRESULT moveWindow(FATFS *fs, DWORD sect)
+{
+    if (sect == fs->winsect) return FR_OK;
+
+    if (syncWindow(fs) != FR_OK) return FR_DISK_ERR;
+    if (diskRead(fs->win, sect, 1) != FR_OK)
+    {
+        fs->winsect = 0xFFFFFFFF;
+        return FR_DISK_ERR;
+    }
+
+    fs->winsect = sect;
+    stats.winReads++;
+
+    return FR_OK;
+}
+
+/* sync_fs(): window, FSInfo if the free count moved, then CTRL_SYNC */
+static FRESULT syncFs(FATFS *fs)
+{
+    FATFS_Object *obj = (FATFS_Object *)drive->object;
+
+    if (syncWindow(fs) != FR_OK) return FR_DISK_ERR;
+
+    if (fs->fsi_flag)
+    {
+        memset(fs->win, 0, SECT);
+        st32(fs->win + 0, 0x41615252);
+        st32(fs->win + 484, 0x61417272);
+        st32(fs->win + 488, fs->free_clst);
+        st32(fs->win + 492, fs->last_clst);
+        fs->win[510] = 0x55; fs->win[511] = 0xAA;
+        fs->winsect = FSINFO_SECT;
+        if (diskWrite(fs->win, FSINFO_SECT, 1) != FR_OK) return FR_DISK_ERR;
+        stats.winWrites++;
+        fs->fsi_flag = 0;
+    }
+
+    stats.syncs++;
+    if (drive->drvFxnTablePtr->controlDrvFxn(obj->drvHandle, CTRL_SYNC, NULL) != RES_OK) return FR_DISK_ERR;
+
+    return FR_OK;
+}
+
+/*============================================================================*/
+/*                                     FAT                                    */
+/*============================================================================*/
+
+static FRESULT getFat(FATFS *fs, DWORD clst, DWORD *val)
+{
+    if (moveWindow(fs, RSVD_SECT + clst * 4 / SECT) != FR_OK) return FR_DISK_ERR;
+    *val = ld32(fs->win + clst * 4 % SECT) & 0x0FFFFFFF;
+
+    return FR_OK;
+}
+
+static FRESULT putFat(FATFS *fs, DWORD clst, DWORD val)
+{
+    if (moveWindow(fs, RSVD_SECT + clst * 4 / SECT) != FR_OK) return FR_DISK_ERR;
+    st32(fs->win + clst * 4 % SECT, val);
+    fs->wflag = 1;
+
+    return FR_OK;
+}
+
+/* create_chain(): the link after <clst> if there is one, else a new cluster
+   appended to it (<clst> 0: a new chain). *next is 0 when the disk is full. */
+static FRESULT createChain(FATFS *fs, DWORD clst, DWORD *next)
+{
+    DWORD c, v, scl;
+
+    *next = 0;
+    if (clst)
+    {
+        if (getFat(fs, clst, &v) != FR_OK) return FR_DISK_ERR;
+        if (v >= 2 && v < EOC - 7)
+        {
+            *next = v;
+            return FR_OK;
+        }
+    }
+
+    scl = fs->last_clst;
+    c = scl;
+    for (;;)
+    {
+        if (++c >= NUM_CLUST + 2) c = 2;
+        if (c == scl) return FR_OK;
+        if (getFat(fs, c, &v) != FR_OK) return FR_DISK_ERR;
+        if (v == 0) break;
+    }
+
+    if (putFat(fs, c, EOC) != FR_OK) return FR_DISK_ERR;
+    if (clst && putFat(fs, clst, c) != FR_OK) return FR_DISK_ERR;
+
+    fs->last_clst = c;
+    fs->free_clst--;
+    fs->fsi_flag = 1;
+    *next = c;
+
+    return FR_OK;
+}
+
+/* remove_chain() */
+static FRESULT removeChain(FATFS *fs, DWORD clst)
+{
+    DWORD next;
+
+    while (clst >= 2 && clst < EOC - 7)
+    {
+        if (getFat(fs, clst, &next) != FR_OK) return FR_DISK_ERR;
+        if (putFat(fs, clst, 0) != FR_OK) return FR_DISK_ERR;
+        fs->free_clst++;
+        fs->fsi_flag = 1;
+        clst = next;
+    }
+
+    return FR_OK;
+}
+
+/*============================================================================*/
+/*                                 DIRECTORIES                                */
+/*============================================================================*/
+
+/* dir_sdi()/dir_next(): sector of <slot>, one step on from the sector of
+   <slot>-1 in <*clst>/<*sect>; a new cluster is added if <stretch> */
+static FRESULT dirStep(FATFS *fs, Node *d, UINT slot, DWORD *clst, DWORD *sect, Bool stretch)
+{
+    DWORD next;
+    UINT i;
+
+    if (slot == 0)
+    {
+        *clst = d->sclust;
+        *sect = clustSect(*clst);
+        return FR_OK;
+    }
+
+    if (slot % ENT_PER_SECT) return FR_OK;
+    if ((slot / ENT_PER_SECT) % CLUST_SECT)
+    {
+        (*sect)++;
+        return FR_OK;
+    }
+
+    if (getFat(fs, *clst, &next) != FR_OK) return FR_DISK_ERR;
+    if (next < 2 || next >= EOC - 7)
+    {
+        if (!stretch) return FR_NO_FILE;
+        if (createChain(fs, *clst, &next) != FR_OK) return FR_DISK_ERR;
+        if (next == 0) return FR_DENIED;
+
+        /* dir_clear(): a new directory cluster is zeroed */
+        if (syncWindow(fs) != FR_OK) return FR_DISK_ERR;
+        memset(fs->win, 0, SECT);
+        for (i=0; i<CLUST_SECT; i++)
+        {
+            if (diskWrite(fs->win, clustSect(next) + i, 1) != FR_OK) return FR_DISK_ERR;
+            stats.winWrites++;
+        }
+        fs->winsect = clustSect(next);
+    }
+
+    *clst = next;
+    *sect = clustSect(next);
+
+    return FR_OK;
+}
+
+static void stampNow(Node *n)
+{
+    time_t t = Seconds_get();
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    n->fdate = (WORD)(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+    n->ftime = (WORD)((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2));
+}
+
+/* the 32 bytes of <n>'s entry, in the window */
+static FRESULT writeEntry(FATFS *fs, Node *n)
+{
+    BYTE *e;
+    UINT i;
+
+    if (moveWindow(fs, n->entSect) != FR_OK) return FR_DISK_ERR;
+
+    e = fs->win + (n->slot % ENT_PER_SECT) * 32;
+    memset(e, ' ', 11);
+    for (i=0; i<11 && n->name[i]; i++) e[i] = (BYTE)toupper((unsigned char)n->name[i]);
+    e[11] = n->attr;
+    memset(e + 12, 0, 20);
+    e[20] = (BYTE)(n->sclust >> 16); e[21] = (BYTE)(n->sclust >> 24);
+    e[22] = (BYTE)n->ftime; e[23] = (BYTE)(n->ftime >> 8);
+    e[24] = (BYTE)n->fdate; e[25] = (BYTE)(n->fdate >> 8);
+    e[26] = (BYTE)n->sclust; e[27] = (BYTE)(n->sclust >> 8);
+    st32(e + 28, (n->attr & AM_DIR) ? 0 : n->size);
+    fs->wflag = 1;
+
+    return FR_OK;
+}
+
+/* dir_find(): every entry up to the match is read through the window */
+static FRESULT dirFind(FATFS *fs, Node *d, const char *name, UINT len, Node **found)
+{
+    DWORD clst = 0, sect = 0;
+    UINT slot;
+    Node *c;
+
+    *found = NULL;
+    for (slot=0; slot<d->numChild; slot++)
+    {
+        if (dirStep(fs, d, slot, &clst, &sect, FALSE) != FR_OK) return FR_DISK_ERR;
+        if (moveWindow(fs, sect) != FR_OK) return FR_DISK_ERR;
+
+        c = d->child[slot];
+        if (c && c != &dot && strlen(c->name) == len && strncasecmp(c->name, name, len) == 0)
+        {
+            *found = c;
+            return FR_OK;
+        }
+    }
+
+    /* the end-of-directory mark is in the next slot */
+    if (dirStep(fs, d, slot, &clst, &sect, FALSE) == FR_OK) moveWindow(fs, sect);
+
+    return FR_NO_FILE;
+}
+
+/* dir_alloc() and dir_register(): first free slot, the directory grows a
+   cluster when it is full */
+static FRESULT dirRegister(FATFS *fs, Node *d, Node *n)
+{
+    DWORD clst = 0, sect = 0;
+    UINT slot;
+    FRESULT res;
+
+    for (slot=0; ; slot++)
+    {
+        res = dirStep(fs, d, slot, &clst, &sect, slot >= d->numChild);
+        if (res != FR_OK) return res;
+        if (moveWindow(fs, sect) != FR_OK) return FR_DISK_ERR;
+        if (slot >= d->numChild || d->child[slot] == NULL) break;
+    }
+
+    if (slot >= d->maxChild)
+    {
+        d->maxChild = d->maxChild ? d->maxChild * 2 : 64;
+        d->child = realloc(d->child, d->maxChild * sizeof(Node *));
+    }
+    while (d->numChild <= slot) d->child[d->numChild++] = NULL;
+
+    d->child[slot] = n;
+    n->parent  = d;
+    n->slot    = slot;
+    n->entSect = sect;
+
+    return writeEntry(fs, n);
+}
+
+static void freeTree(Node *d)
+{
+    UINT i;
+
+    for (i=0; i<d->numChild; i++)
+    {
+        if (d->child[i] == NULL || d->child[i] == &dot) continue;
+        freeTree(d->child[i]);
+        free(d->child[i]);
+    }
+
+    free(d->child);
+    d->child = NULL;
+    d->numChild = d->maxChild = 0;
+}
+
+/*============================================================================*/
+/*                                PATHS, VOLUME                               */
+/*============================================================================*/
+
+/* find_volume(): the first call after FATFS_open() initialises the drive
+   and reads the boot record and FSInfo */
+static FRESULT mount(FATFS **fs)
+{
+    FATFS_Object *obj;
+
+    if (drive == NULL) return FR_NOT_ENABLED;
+
+    obj = (FATFS_Object *)drive->object;
+    *fs = vol = &obj->filesystem;
+    if (vol->fs_type) return FR_OK;
+
+    if (drive->drvFxnTablePtr->initDrvFxn() != 0) return FR_NOT_READY;
+
+    vol->winsect = 0xFFFFFFFF;
+    vol->wflag = 0;
+    if (moveWindow(vol, 0) != FR_OK) return FR_DISK_ERR;
+    if (vol->win[510] != 0x55 || vol->win[511] != 0xAA || vol->win[82] != 'F') return FR_NO_FILESYSTEM;
+
+    if (moveWindow(vol, FSINFO_SECT) != FR_OK) return FR_DISK_ERR;
+    vol->free_clst = ld32(vol->win + 488);
+    vol->last_clst = ld32(vol->win + 492);
+    vol->fsi_flag  = 0;
+    vol->fs_type   = FS_FAT32;
+
+    return FR_OK;
+}
+
+/* follow_path(): <*dir> is the directory the last segment is in, <*node>
+   that segment (NULL: not there), <*name>/<*len> its name */
+static FRESULT follow(FATFS *fs, const char *path, Node **dir, Node **node, const char **name, UINT *len)
+{
+    Node *d = &root, *n = NULL;
+    const char *seg;
+    UINT l;
+    FRESULT res;
+
+    if (path[0] >= '0' && path[0] <= '9' && path[1] == ':')
+    {
+        if (path[0] != '0') return FR_INVALID_DRIVE;
+        path += 2;
+    }
+    while (*path == '/') path++;
+
+    for (;;)
+    {
+        seg = path;
+        while (*path && *path != '/') path++;
+        l = (UINT)(path - seg);
+        while (*path == '/') path++;
+
+        if (l == 0)
+        {
+            n = d;
+            break;
+        }
+        if (l >= HOST_FF_NAME) return FR_INVALID_NAME;
+
+        res = dirFind(fs, d, seg, l, &n);
+        if (res == FR_DISK_ERR) return res;
+        if (*path == 0) break;
+        if (n == NULL || !(n->attr & AM_DIR)) return FR_NO_PATH;
+        d = n;
+    }
+
+    *dir = d;
+    *node = n;
+    *name = seg;
+    *len = l;
+
+    return FR_OK;
+}
+
+void FATFS_init(void) {}
+
+FATFS_Error FATFS_open(uint32_t index, FATFS_Params params, FATFS_Handle *handle)
+{
+    const FATFS_Config *cfg = &FATFS_config[index];
+    FATFS_Object *obj = (FATFS_Object *)cfg->object;
+
+    if (index >= _VOLUMES || cfg->drvFxnTablePtr == NULL) return FATFS_ERR;
+    if (cfg->drvFxnTablePtr->openDrvFxn(index, params, &obj->drvHandle) != RES_OK) return FATFS_ERR;
+
+    memset(&obj->filesystem, 0, sizeof(obj->filesystem));
+    obj->driveNumber = index;
+    obj->isOpen = 1;
+    drive = cfg;
+    *handle = (FATFS_Handle)cfg;
+
+    return FATFS_OK;
+}
+
+FATFS_Error FATFS_close(FATFS_Handle handle)
+{
+    FATFS_Object *obj;
+
+    if (handle == NULL) return FATFS_ERR;
+
+    obj = (FATFS_Object *)handle->object;
+    handle->drvFxnTablePtr->closeDrvFxn(obj->drvHandle);
+    obj->filesystem.fs_type = 0;
+    obj->isOpen = 0;
+    if (drive == handle) drive = NULL;
+
+    return FATFS_OK;
+}
+
+/*============================================================================*/
+/*                                    FILES                                   */
+/*============================================================================*/
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode)
+{
+    FATFS *fs;
+    Node *d, *n;
+    const char *name;
+    UINT len;
+    FRESULT res;
+
+    fp->node = NULL;
+    if ((res = mount(&fs)) != FR_OK) return res;
+    if ((res = follow(fs, path, &d, &n, &name, &len)) != FR_OK) return res;
+    if (len == 0) return FR_INVALID_NAME;
+
+    if (n == NULL)
+    {
+        if (!(mode & (FA_CREATE_ALWAYS | FA_OPEN_ALWAYS | FA_CREATE_NEW))) return FR_NO_FILE;
+
+        n = calloc(1, sizeof(Node));
+        memcpy(n->name, name, len);
+        n->attr = AM_ARC;
+        stampNow(n);
+        if ((res = dirRegister(fs, d, n)) != FR_OK)
+        {
+            free(n);
+            return res;
+        }
+        mode |= FA_MODIFIED;
+    }
+    else
+    {
+        if (n->attr & AM_DIR) return FR_NO_FILE;
+        if (mode & FA_CREATE_NEW) return FR_EXIST;
+        if (mode & FA_CREATE_ALWAYS)
+        {
+            if (removeChain(fs, n->sclust) != FR_OK) return FR_DISK_ERR;
+            n->sclust = 0;
+            n->size = 0;
+            stampNow(n);
+            if (writeEntry(fs, n) != FR_OK) return FR_DISK_ERR;
+            mode |= FA_MODIFIED;
+        }
+    }
+
+    fp->fs    = fs;
+    fp->node  = n;
+    fp->flag  = mode & (FA_READ | FA_WRITE | FA_MODIFIED);
+    fp->fptr  = 0;
+    fp->fsize = n->size;
+    fp->clust = 0;
+    fp->sect  = 0;
+
+    return FR_OK;
+}
+
+static FRESULT flushBuf(FIL *fp)
+{
+    if (!(fp->flag & FA_DIRTY)) return FR_OK;
+    if (diskWrite(fp->buf, fp->sect, 1) != FR_OK) return FR_DISK_ERR;
+
+    stats.dataWrites++;
+    fp->flag &= ~FA_DIRTY;
+
+    return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+    const BYTE *p = buff;
+    DWORD clst, sect;
+    UINT csect, cc, wcnt;
+
+    *bw = 0;
+    if (fp->node == NULL || fp->fs != vol || !vol->fs_type) return FR_INVALID_OBJECT;
+    if (!(fp->flag & FA_WRITE)) return FR_DENIED;
+
+    while (btw)
+    {
+        if (fp->fptr % SECT == 0)
+        {
+            csect = (fp->fptr / SECT) % CLUST_SECT;
+            if (csect == 0)
+            {
+                if (fp->fptr == 0 && fp->node->sclust) clst = fp->node->sclust;
+                else if (createChain(fp->fs, fp->fptr ? fp->clust : 0, &clst) != FR_OK) return FR_DISK_ERR;
+                if (clst == 0) break;                       // disk full
+                if (fp->node->sclust == 0) fp->node->sclust = clst;
+                fp->clust = clst;
+            }
+            if (flushBuf(fp) != FR_OK) return FR_DISK_ERR;
+
+            sect = clustSect(fp->clust) + csect;
+            cc = btw / SECT;
+            if (cc)
+            {
+                /* whole sectors go straight from the caller's buffer */
+                if (csect + cc > CLUST_SECT) cc = CLUST_SECT - csect;
+                if (diskWrite(p, sect, cc) != FR_OK) return FR_DISK_ERR;
+                stats.dataWrites += cc;
+                if (fp->sect - sect < cc)
+                {
+                    memcpy(fp->buf, p + (fp->sect - sect) * SECT, SECT);
+                }
+                wcnt = cc * SECT;
+                goto advance;
+            }
+
+            /* a partial sector of existing data is read first */
+            if (fp->sect != sect && fp->fptr < fp->fsize)
+            {
+                if (diskRead(fp->buf, sect, 1) != FR_OK) return FR_DISK_ERR;
+                stats.dataReads++;
+            }
+            fp->sect = sect;
+        }
+
+        wcnt = SECT - fp->fptr % SECT;
+        if (wcnt > btw) wcnt = btw;
+        memcpy(fp->buf + fp->fptr % SECT, p, wcnt);
+        fp->flag |= FA_DIRTY;
+
+advance:
+        p += wcnt;
+        fp->fptr += wcnt;
+        *bw += wcnt;
+        btw -= wcnt;
+        if (fp->fptr > fp->fsize) fp->fsize = fp->fptr;
+    }
+
+    fp->flag |= FA_MODIFIED;
+
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+    BYTE *p = buff;
+    DWORD clst, sect;
+    UINT csect, cc, rcnt;
+
+    *br = 0;
+    if (fp->node == NULL || fp->fs != vol || !vol->fs_type) return FR_INVALID_OBJECT;
+    if (!(fp->flag & FA_READ)) return FR_DENIED;
+    if (btr > fp->fsize - fp->fptr) btr = fp->fsize - fp->fptr;
+
+    while (btr)
+    {
+        if (fp->fptr % SECT == 0)
+        {
+            csect = (fp->fptr / SECT) % CLUST_SECT;
+            if (csect == 0)
+            {
+                if (fp->fptr == 0) clst = fp->node->sclust;
+                else if (getFat(fp->fs, fp->clust, &clst) != FR_OK) return FR_DISK_ERR;
+                if (clst < 2 || clst >= EOC - 7) return FR_INT_ERR;
+                fp->clust = clst;
+            }
+
+            sect = clustSect(fp->clust) + csect;
+            cc = btr / SECT;
+            if (cc)
+            {
+                if (csect + cc > CLUST_SECT) cc = CLUST_SECT - csect;
+                if (diskRead(p, sect, cc) != FR_OK) return FR_DISK_ERR;
+                stats.dataReads += cc;
+                if ((fp->flag & FA_DIRTY) && fp->sect - sect < cc)
+                {
+                    memcpy(p + (fp->sect - sect) * SECT, fp->buf, SECT);
+                }
+                rcnt = cc * SECT;
+                goto advance;
+            }
+
+            if (fp->sect != sect)
+            {
+                if (flushBuf(fp) != FR_OK) return FR_DISK_ERR;
+                if (diskRead(fp->buf, sect, 1) != FR_OK) return FR_DISK_ERR;
+                stats.dataReads++;
+            }
+            fp->sect = sect;
+        }
+
+        rcnt = SECT - fp->fptr % SECT;
+        if (rcnt > btr) rcnt = btr;
+        memcpy(p, fp->buf + fp->fptr % SECT, rcnt);
+
+advance:
+        p += rcnt;
+        fp->fptr += rcnt;
+        *br += rcnt;
+        btr -= rcnt;
+    }
+
+    return FR_OK;
+}
+
+/* no expansion: an offset past the end stops at the end */
+FRESULT f_lseek(FIL *fp, DWORD ofs)
+{
+    const DWORD bcs = CLUST_SECT * SECT;
+    DWORD ifptr, clst, nsect = 0;
+
+    if (fp->node == NULL || fp->fs != vol || !vol->fs_type) return FR_INVALID_OBJECT;
+    if (ofs > fp->fsize) ofs = fp->fsize;
+
+    ifptr = fp->fptr;
+    fp->fptr = 0;
+    if (ofs == 0) return FR_OK;
+
+    if (ifptr > 0 && (ofs - 1) / bcs >= (ifptr - 1) / bcs)
+    {
+        /* same or later cluster: go on from the current one */
+        fp->fptr = (ifptr - 1) & ~(bcs - 1);
+        ofs -= fp->fptr;
+        clst = fp->clust;
+    }
+    else
+    {
+        clst = fp->node->sclust;
+        fp->clust = clst;
+    }
+
+    while (ofs > bcs)
+    {
+        if (getFat(fp->fs, clst, &clst) != FR_OK) return FR_DISK_ERR;
+        if (clst < 2 || clst >= EOC - 7) return FR_INT_ERR;
+        fp->fptr += bcs;
+        ofs -= bcs;
+        fp->clust = clst;
+    }
+    fp->fptr += ofs;
+    if (ofs % SECT) nsect = clustSect(clst) + ofs / SECT;
+
+    if (fp->fptr % SECT && nsect != fp->sect)
+    {
+        if (flushBuf(fp) != FR_OK) return FR_DISK_ERR;
+        if (diskRead(fp->buf, nsect, 1) != FR_OK) return FR_DISK_ERR;
+        stats.dataReads++;
+        fp->sect = nsect;
+    }
+
+    return FR_OK;
+}
+
+FRESULT f_sync(FIL *fp)
+{
+    if (fp->node == NULL || fp->fs != vol || !vol->fs_type) return FR_INVALID_OBJECT;
+    if (!(fp->flag & FA_MODIFIED)) return FR_OK;
+
+    if (flushBuf(fp) != FR_OK) return FR_DISK_ERR;
+
+    fp->node->size = fp->fsize;
+    stampNow(fp->node);
+    if (writeEntry(fp->fs, fp->node) != FR_OK) return FR_DISK_ERR;
+    fp->flag &= ~FA_MODIFIED;
+
+    return syncFs(fp->fs);
+}
+
+FRESULT f_close(FIL *fp)
+{
+    FRESULT res = f_sync(fp);
+
+    if (res == FR_OK) fp->node = NULL;
+    return res;
+}
+
+/* f_puts() batches through a small buffer; the sector traffic is the same */
+int f_puts(const TCHAR *str, FIL *fp)
+{
+    UINT n = (UINT)strlen(str), bw;
+
+    if (f_write(fp, str, n, &bw) != FR_OK || bw != n) return -1;
+    return (int)n;
+}
+
+TCHAR *f_gets(TCHAR *buff, int len, FIL *fp)
+{
+    int n = 0;
+    UINT rc;
+    TCHAR c;
+
+    while (n < len - 1)
+    {
+        if (f_read(fp, &c, 1, &rc) != FR_OK || rc != 1) break;
+        buff[n++] = c;
+        if (c == '\n') break;
+    }
+    buff[n] = 0;
+
+    return n ? buff : NULL;
+}
+
+/*============================================================================*/
+/*                             DIRECTORY LISTING                              */
+/*============================================================================*/
+
+FRESULT f_mkdir(const TCHAR *path)
+{
+    FATFS *fs;
+    Node *d, *n;
+    const char *name;
+    DWORD clst;
+    UINT len, i;
+    FRESULT res;
+
+    if ((res = mount(&fs)) != FR_OK) return res;
+    if ((res = follow(fs, path, &d, &n, &name, &len)) != FR_OK) return res;
+    if (n != NULL) return FR_EXIST;
+    if (len == 0) return FR_INVALID_NAME;
+
+    if (createChain(fs, 0, &clst) != FR_OK) return FR_DISK_ERR;
+    if (clst == 0) return FR_DENIED;
+
+    /* dir_clear(), then "." and ".." in the first sector */
+    if (syncWindow(fs) != FR_OK) return FR_DISK_ERR;
+    memset(fs->win, 0, SECT);
+    for (i=1; i<CLUST_SECT; i++)
+    {
+        if (diskWrite(fs->win, clustSect(clst) + i, 1) != FR_OK) return FR_DISK_ERR;
+        stats.winWrites++;
+    }
+    memset(fs->win, ' ', 11);
+    fs->win[0] = '.';
+    fs->win[11] = AM_DIR;
+    memcpy(fs->win + 32, fs->win, 32);
+    fs->win[33] = '.';
+    fs->winsect = clustSect(clst);
+    fs->wflag = 1;
+
+    n = calloc(1, sizeof(Node));
+    memcpy(n->name, name, len);
+    n->attr = AM_DIR;
+    n->sclust = clst;
+    stampNow(n);
+    n->maxChild = 64;
+    n->child = malloc(n->maxChild * sizeof(Node *));
+    n->child[0] = n->child[1] = &dot;
+    n->numChild = 2;
+
+    if ((res = dirRegister(fs, d, n)) != FR_OK)
+    {
+        free(n->child);
+        free(n);
+        return res;
+    }
+
+    return syncFs(fs);
+}
+
+FRESULT f_opendir(DIR *dp, const TCHAR *path)
+{
+    FATFS *fs;
+    Node *d, *n;
+    const char *name;
+    UINT len;
+    FRESULT res;
+
+    dp->node = NULL;
+    if ((res = mount(&fs)) != FR_OK) return res;
+    if ((res = follow(fs, path, &d, &n, &name, &len)) != FR_OK) return res;
+    if (n == NULL || !(n->attr & AM_DIR)) return FR_NO_PATH;
+
+    dp->fs    = fs;
+    dp->node  = n;
+    dp->index = 0;
+    dp->clust = 0;
+    dp->sect  = 0;
+
+    return FR_OK;
+}
+
+/* dir_read(): one window access per entry, free and dot entries skipped */
+FRESULT f_readdir(DIR *dp, FILINFO *fno)
+{
+    Node *d = dp->node, *c;
+    FRESULT res;
+
+    if (d == NULL || dp->fs != vol || !vol->fs_type) return FR_INVALID_OBJECT;
+
+    if (fno == NULL)
+    {
+        dp->index = 0;
+        return FR_OK;
+    }
+
+    while (dp->index <= d->numChild)
+    {
+        res = dirStep(dp->fs, d, dp->index, &dp->clust, &dp->sect, FALSE);
+        if (res == FR_NO_FILE) break;
+        if (res != FR_OK) return res;
+        if (moveWindow(dp->fs, dp->sect) != FR_OK) return FR_DISK_ERR;
+        if (dp->index == d->numChild) break;
+
+        c = d->child[dp->index++];
+        if (c == NULL || c == &dot) continue;
+
+        strcpy(fno->fname, c->name);
+        fno->fattrib = c->attr;
+        fno->fsize   = c->size;
+        fno->fdate   = c->fdate;
+        fno->ftime   = c->ftime;
+
+        return FR_OK;
+    }
+
+    dp->index = d->numChild + 1;            // at the end, and stays there
+    fno->fname[0] = 0;
+    return FR_OK;
+}
+
+FRESULT f_closedir(DIR *dp)
+{
+    dp->node = NULL;
+    return FR_OK;
+}
+
+/*============================================================================*/
+/*                                  HOST SIDE                                 */
+/*============================================================================*/
+
+void Host_Ff_format(void)
+{
+    BYTE s[SECT];
+
+    Host_Usb_erase();
+    freeTree(&root);
+    if (vol) vol->fs_type = 0;
+
+    /* boot record: FAT32, 512 B sectors, 8 per cluster */
+    memset(s, 0, SECT);
+    s[0] = 0xEB; s[1] = 0x58; s[2] = 0x90;
+    memcpy(s + 3, "MSDOS5.0", 8);
+    s[11] = SECT & 0xFF; s[12] = SECT >> 8;
+    s[13] = CLUST_SECT;
+    s[14] = RSVD_SECT; s[15] = 0;
+    s[16] = NUM_FATS;
+    s[21] = 0xF8;
+    st32(s + 32, VOL_SECT);
+    st32(s + 36, FAT_SECT);
+    st32(s + 44, ROOT_CLUST);
+    s[48] = FSINFO_SECT;
+    s[50] = 6;
+    s[66] = 0x29;
+    memcpy(s + 71, "RAZOR      ", 11);
+    memcpy(s + 82, "FAT32   ", 8);
+    s[510] = 0x55; s[511] = 0xAA;
+    Host_Usb_poke(0, s);
+    Host_Usb_poke(6, s);
+
+    memset(s, 0, SECT);
+    st32(s + 0, 0x41615252);
+    st32(s + 484, 0x61417272);
+    st32(s + 488, NUM_CLUST - 1);
+    st32(s + 492, ROOT_CLUST);
+    s[510] = 0x55; s[511] = 0xAA;
+    Host_Usb_poke(FSINFO_SECT, s);
+
+    /* media byte, reserved entry, root directory end of chain */
+    memset(s, 0, SECT);
+    st32(s + 0, 0x0FFFFFF8);
+    st32(s + 4, 0xFFFFFFFF);
+    st32(s + 8, EOC);
+    Host_Usb_poke(RSVD_SECT, s);
+    Host_Usb_poke(RSVD_SECT + FAT_SECT, s);
+}
+
+void Host_Ff_stats(Host_FfStats *s)
+{
+    *s = stats;
+}
+
+void Host_Ff_resetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,247 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_fatfs.h
+*-------------------------------------------------------------------------
+* Host stand-in for the TI FATFS driver (ti/fs/fatfs/FATFS.h) and the
+* FatFs API it wraps (ff.h, diskio.h), for the calls the firmware makes.
+*
+* host_fatfs.c keeps the directory tree in host memory but moves every
+* byte of file data, and every FAT and directory sector FatFs would touch,
+* through the disk driver that FATFS_open() binds (FATFS_config[0], i.e.
+* usb_fatfs_port_usbmsc.c over the block device of host_usb.c). It has
+* FatFs's two buffers: one sector window per volume for FAT and directory
+* sectors, one data sector per open file. The sector traffic of a logged
+* row, a directory scan or a firmware read is therefore what FatFs with
+* _FS_TINY=0 would issue, on a FAT32 volume laid out as a freshly
+* formatted 1 GB stick: 32 reserved sectors, two FATs, 4 KB clusters,
+* root directory in cluster 2. Long names are stored in one entry.
+*------------------------------------------------------------------------*/
+#ifndef _HOST_FATFS
+#define _HOST_FATFS
+
+#include <stdint.h>
+#include "host_bios.h"
+
+/*============================================================================*/
+/*                              FatFs (ff.h)                                  */
+/*============================================================================*/
+
+typedef uint8_t     BYTE;
+typedef uint16_t    WORD;
+typedef uint32_t    DWORD;
+typedef unsigned    UINT;
+typedef char        TCHAR;
+
+#define _VOLUMES            4
+#define _MAX_SS             512
+#define HOST_FF_NAME        64
+
+typedef enum
+{
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+    FR_MKFS_ABORTED,
+    FR_TIMEOUT,
+    FR_LOCKED,
+    FR_NOT_ENOUGH_CORE,
+    FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER
+} FRESULT;
+
+#define FA_READ             0x01
+#define FA_WRITE            0x02
+#define FA_OPEN_EXISTING    0x00
+#define FA_CREATE_NEW       0x04
+#define FA_CREATE_ALWAYS    0x08
+#define FA_OPEN_ALWAYS      0x10
+
+#define AM_RDO              0x01
+#define AM_HID              0x02
+#define AM_SYS              0x04
+#define AM_DIR              0x10
+#define AM_ARC              0x20
+
+struct Host_FfNode;
+
+typedef struct
+{
+    BYTE    fs_type;                // 0: not mounted
+    BYTE    wflag;                  // win[] dirty
+    BYTE    fsi_flag;               // free count changed, FSInfo to write
+    DWORD   winsect;
+    DWORD   last_clst;              // allocation hint
+    DWORD   free_clst;
+    BYTE    win[_MAX_SS];
+} FATFS;
+
+typedef struct
+{
+    FATFS               *fs;
+    struct Host_FfNode  *node;
+    BYTE    flag;                   // FA_READ/FA_WRITE, modified, buf[] dirty
+    DWORD   fptr;
+    DWORD   fsize;
+    DWORD   clust;                  // cluster holding fptr-1
+    DWORD   sect;                   // sector in buf[], 0: none
+    BYTE    buf[_MAX_SS];
+} FIL;
+
+typedef struct
+{
+    FATFS               *fs;
+    struct Host_FfNode  *node;
+    UINT    index;                  // next entry
+    DWORD   clust;                  // where it is
+    DWORD   sect;
+} DIR;
+
+typedef struct
+{
+    DWORD   fsize;
+    WORD    fdate;
+    WORD    ftime;
+    BYTE    fattrib;
+    TCHAR   fname[HOST_FF_NAME];
+} FILINFO;
+
+#define f_size(fp)          ((fp)->fsize)
+#define f_tell(fp)          ((fp)->fptr)
+#define f_eof(fp)           ((fp)->fptr == (fp)->fsize)
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, DWORD ofs);
+FRESULT f_sync(FIL *fp);
+FRESULT f_mkdir(const TCHAR *path);
+FRESULT f_opendir(DIR *dp, const TCHAR *path);
+FRESULT f_readdir(DIR *dp, FILINFO *fno);
+FRESULT f_closedir(DIR *dp);
+int     f_puts(const TCHAR *str, FIL *fp);
+TCHAR   *f_gets(TCHAR *buff, int len, FIL *fp);
+
+/*============================================================================*/
+/*                              DISK I/O (diskio.h)                           */
+/*============================================================================*/
+
+typedef BYTE DSTATUS;
+
+typedef enum
+{
+    RES_OK = 0,
+    RES_ERROR,
+    RES_WRPRT,
+    RES_NOTRDY,
+    RES_PARERR
+} DRESULT;
+
+#define STA_NOINIT          0x01
+#define STA_NODISK          0x02
+#define STA_PROTECT         0x04
+
+#define CTRL_SYNC           0
+#define GET_SECTOR_COUNT    1
+#define GET_SECTOR_SIZE     2
+#define GET_BLOCK_SIZE      3
+
+/*============================================================================*/
+/*                           TI FATFS DRIVER (FATFS.h)                        */
+/*============================================================================*/
+
+typedef int32_t (*FATFS_CloseDrvFxn)(void *handle);
+typedef int32_t (*FATFS_ControlDrvFxn)(void *handle, uint32_t cmd, void *arg);
+typedef int32_t (*FATFS_InitDrvFxn)(void);
+typedef int32_t (*FATFS_OpenDrvFxn)(uint32_t drvInst, void *params, void **handle);
+typedef int32_t (*FATFS_WriteDrvFxn)(void *handle, uint8_t *buf, uint32_t sector, uint32_t numSectors);
+typedef int32_t (*FATFS_ReadDrvFxn)(void *handle, uint8_t *buf, uint32_t sector, uint32_t numSectors);
+
+typedef struct
+{
+    FATFS_CloseDrvFxn   closeDrvFxn;
+    FATFS_ControlDrvFxn controlDrvFxn;
+    FATFS_InitDrvFxn    initDrvFxn;
+    FATFS_OpenDrvFxn    openDrvFxn;
+    FATFS_WriteDrvFxn   writeDrvFxn;
+    FATFS_ReadDrvFxn    readDrvFxn;
+} FATFS_DrvFxnTable;
+
+typedef struct
+{
+    uint32_t    drvInst;
+} FATFS_HwAttrs;
+
+typedef struct
+{
+    uint32_t    driveNumber;
+    void        *drvHandle;
+    FATFS       filesystem;
+    uint32_t    isOpen;
+} FATFS_Object;
+
+typedef struct
+{
+    FATFS_DrvFxnTable const *drvFxnTablePtr;
+    void                    *object;
+    void const              *hwAttrs;
+} FATFS_Config;
+
+typedef FATFS_Config        *FATFS_Handle;
+typedef void                *FATFS_Params;
+typedef int32_t             FATFS_Error;
+
+#define FATFS_OK            0
+#define FATFS_ERR           (-1)
+
+extern const FATFS_Config FATFS_config[];
+
+void        FATFS_init(void);
+FATFS_Error FATFS_open(uint32_t index, FATFS_Params params, FATFS_Handle *handle);
+FATFS_Error FATFS_close(FATFS_Handle handle);
+
+/*============================================================================*/
+/*                                  HOST SIDE                                 */
+/*============================================================================*/
+
+typedef struct
+{
+    UInt32  winReads;               // volume window misses (FAT, directory)
+    UInt32  winWrites;              // dirty windows written, both FAT copies
+    UInt32  dataReads;              // sectors read for file data
+    UInt32  dataWrites;             // sectors written for file data
+    UInt32  syncs;                  // CTRL_SYNC requests
+    UInt32  requests;               // disk_read and disk_write calls to the port
+} Host_FfStats;
+
+/// empty volume, as after a format; drops the directory tree
+void    Host_Ff_format(void);
+void    Host_Ff_stats(Host_FfStats *stats);
+void    Host_Ff_resetStats(void);
+
+#endif
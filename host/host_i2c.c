@@ -0,0 +1,680 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_i2c.c
+*-------------------------------------------------------------------------
+* I2C0 controller model and the devices on the Razor I2C bus.
+*
+* The controller is driven by ICMDR writes, as PDI_i2C.c drives it:
+*
+*  - IRS=0 holds it in reset; STT with IRS=1 starts a transaction to
+*    ICSAR in the direction of TRX (a repeated start if one is open).
+*  - STP written while idle is remembered and ends the next non-repeat-
+*    mode transaction after ICCNT bytes; in repeat mode STP ends the open
+*    transaction at once. The bit always reads back as 0, as it does once
+*    the stop has gone out. MST drops after every stop.
+*  - ICDXR bytes go straight to the device; ICDRR reads fetch the next
+*    byte while ICCNT allows and return the last one after that.
+*  - ICXRDY is always set; ICRRDY while a receive has bytes left; BB while
+*    a transaction is open; NACK when the address was not acknowledged
+*    (cleared by the next start or by writing 1).
+*  - ICDXR written while no transaction is open is dropped.
+*
+* Bytes move at once. What the traffic would cost on the 400 kHz bus (9
+* clocks a byte, plus start, address and stop) is added up in busNs.
+* ICIVR always reads NONE: the firmware polls, I2C interrupts are not
+* raised.
+*------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "host_csl.h"
+#include "host_dev.h"
+
+#define BIT_NS          2500u       // 400 kHz
+
+static volatile CSL_I2cRegs *regs;  // model view
+static Host_I2cDev *devs;
+static Host_I2cStats stats;
+
+static Bool active;                 // transaction open
+static Bool receiving;
+static Bool stopArmed;              // STP written, not yet acted on
+static Bool nack;
+static Bool scd;                    // stop seen
+static UInt32 count;                // bytes moved in this transaction
+static UInt8 lastRx;
+static Host_I2cDev *cur;            // NULL: address not acknowledged
+
+/*============================================================================*/
+/*                                CONTROLLER                                  */
+/*============================================================================*/
+
+Host_I2cDev *Host_I2c_find(UInt8 addr)
+{
+    Host_I2cDev *d;
+
+    for (d = devs; d; d = d->next) if (d->addr == addr) return d;
+
+    return NULL;
+}
+
+void Host_I2c_attach(Host_I2cDev *dev)
+{
+    dev->next = devs;
+    devs = dev;
+}
+
+void Host_I2c_stats(Host_I2cStats *out)
+{
+    *out = stats;
+}
+
+void Host_I2c_resetStats(void)
+{
+    Host_I2cDev *d;
+
+    memset(&stats, 0, sizeof(stats));
+    for (d = devs; d; d = d->next) d->xfers = d->bytes = 0;
+}
+
+static UInt32 transferLimit(void)
+{
+    UInt32 n = regs->ICCNT & CSL_I2C_ICCNT_ICDC_MASK;
+
+    return n ? n : 0x10000;
+}
+
+static Bool repeatMode(void)
+{
+    return (regs->ICMDR & CSL_I2C_ICMDR_RM_MASK) != 0;
+}
+
+static void stopBus(void)
+{
+    if (active && cur && cur->stop) cur->stop(cur);
+
+    active    = FALSE;
+    stopArmed = FALSE;
+    scd       = TRUE;
+    cur       = NULL;
+    stats.busNs += BIT_NS;
+
+    regs->ICMDR &= ~(CSL_I2C_ICMDR_STP_MASK | CSL_I2C_ICMDR_MST_MASK);
+}
+
+static void startBus(void)
+{
+    UInt8 addr = regs->ICSAR & 0x7F;
+
+    if (active && cur && cur->stop) cur->stop(cur);
+
+    active    = TRUE;
+    receiving = (regs->ICMDR & CSL_I2C_ICMDR_TRX_MASK) == 0;
+    count     = 0;
+    nack      = FALSE;
+    cur       = Host_I2c_find(addr);
+
+    /* repeat mode only stops on an STP written while it runs */
+    if (repeatMode()) stopArmed = FALSE;
+
+    stats.starts++;
+    stats.busNs += BIT_NS * 10;     // start + address/RW + ACK
+
+    if (cur == NULL)
+    {
+        nack = TRUE;
+        stats.nacks++;
+    }
+    else
+    {
+        cur->xfers++;
+        if (cur->start) cur->start(cur, receiving);
+    }
+
+    regs->ICMDR &= ~CSL_I2C_ICMDR_STT_MASK;
+}
+
+static void byteDone(void)
+{
+    count++;
+    stats.bytes++;
+    stats.busNs += BIT_NS * 9;
+    if (cur) cur->bytes++;
+
+    if (!repeatMode() && stopArmed && count >= transferLimit()) stopBus();
+}
+
+static void reset(void)
+{
+    active    = FALSE;
+    stopArmed = FALSE;
+    nack      = FALSE;
+    scd       = FALSE;
+    cur       = NULL;
+}
+
+static void i2cRead(void *ctx, UInt32 off)
+{
+    UInt32 st;
+
+    (void)ctx;
+
+    switch (off)
+    {
+    case offsetof(CSL_I2cRegs, ICSTR):
+        st = CSL_I2C_ICSTR_ICXRDY_MASK;
+        if (nack) st |= CSL_I2C_ICSTR_NACK_MASK;
+        if (scd) st |= CSL_I2C_ICSTR_SCD_MASK;
+        if (active) st |= CSL_I2C_ICSTR_BB_MASK;
+        else st |= CSL_I2C_ICSTR_ARDY_MASK;
+        if (active && receiving && count < transferLimit()) st |= CSL_I2C_ICSTR_ICRRDY_MASK;
+        regs->ICSTR = st;
+        break;
+
+    case offsetof(CSL_I2cRegs, ICDRR):
+        if (active && receiving && count < transferLimit())
+        {
+            lastRx = (cur && cur->read) ? cur->read(cur) : 0xFF;
+            byteDone();
+        }
+        regs->ICDRR = lastRx;
+        break;
+
+    case offsetof(CSL_I2cRegs, ICIVR):
+        regs->ICIVR = CSL_I2C_ICIVR_INTCODE_NONE;
+        break;
+    }
+}
+
+static void i2cWrite(void *ctx, UInt32 off, UInt32 val, UInt32 old)
+{
+    (void)ctx;
+
+    switch (off)
+    {
+    case offsetof(CSL_I2cRegs, ICSTR):
+        if (val & CSL_I2C_ICSTR_NACK_MASK) nack = FALSE;
+        if (val & CSL_I2C_ICSTR_SCD_MASK) scd = FALSE;
+        break;
+
+    case offsetof(CSL_I2cRegs, ICDXR):
+        if (active && !receiving)
+        {
+            if (cur && cur->write && !cur->write(cur, (UInt8)val))
+            {
+                nack = TRUE;
+                stats.nacks++;
+            }
+            byteDone();
+        }
+        break;
+
+    case offsetof(CSL_I2cRegs, ICMDR):
+        if (!(val & CSL_I2C_ICMDR_IRS_MASK))
+        {
+            if (old & CSL_I2C_ICMDR_IRS_MASK) reset();
+            break;
+        }
+
+        if ((val & CSL_I2C_ICMDR_STP_MASK) && !(old & CSL_I2C_ICMDR_STP_MASK)) stopArmed = TRUE;
+
+        if (active) receiving = (val & CSL_I2C_ICMDR_TRX_MASK) == 0;
+
+        if (val & CSL_I2C_ICMDR_STT_MASK) startBus();
+        else if (stopArmed && active && (repeatMode() || count >= transferLimit())) stopBus();
+
+        /* gone out, or remembered for the next transaction */
+        regs->ICMDR &= ~CSL_I2C_ICMDR_STP_MASK;
+        break;
+    }
+}
+
+/*============================================================================*/
+/*                        LCD EXPANDER AND HD44780 (0x20)                     */
+/*============================================================================*/
+
+/* the expander takes (data, control) byte pairs; control bit 0 is RS,
+   bit 1 RW and bit 2 E; the HD44780 latches on the falling edge of E */
+#define LCD_RS          0x01
+#define LCD_RW          0x02
+#define LCD_E           0x04
+
+static struct
+{
+    Host_I2cDev dev;
+    UInt8   phase;              // 0: data byte next, 1: control byte next
+    UInt8   data;
+    UInt8   ctrl;
+    UInt8   ddram[0x80];
+    UInt8   ac;                 // address counter
+    Bool    increment;
+    Bool    changed;
+    Host_LcdState st;
+} lcd;
+
+static void lcdStart(Host_I2cDev *dev, Bool read)
+{
+    (void)dev; (void)read;
+    lcd.phase = 0;
+}
+
+static void lcdStep(void)
+{
+    if (lcd.increment) lcd.ac = (lcd.ac == 0x27) ? 0x40 : (lcd.ac == 0x67) ? 0x00 : lcd.ac + 1;
+    else lcd.ac = (lcd.ac == 0x00) ? 0x67 : (lcd.ac == 0x40) ? 0x27 : lcd.ac - 1;
+}
+
+static void lcdLatch(void)
+{
+    UInt8 d = lcd.data;
+
+    if (lcd.ctrl & LCD_RW) return;
+
+    if (lcd.ctrl & LCD_RS)
+    {
+        if (lcd.ddram[lcd.ac] != d) lcd.changed = TRUE;
+        lcd.ddram[lcd.ac] = d;
+        lcdStep();
+        lcd.st.characters++;
+        return;
+    }
+
+    lcd.st.instructions++;
+    if (d & 0x80) lcd.ac = d & 0x7F;
+    else if (d & 0x40) {}                                   // CGRAM address
+    else if (d & 0x20) {}                                   // function set
+    else if (d & 0x10) {}                                   // cursor/display shift
+    else if (d & 0x08) {}                                   // display control
+    else if (d & 0x04) lcd.increment = (d & 0x02) != 0;     // entry mode
+    else if (d & 0x02) lcd.ac = 0;                          // home
+    else if (d & 0x01)                                      // clear
+    {
+        memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+        lcd.ac = 0;
+        lcd.increment = TRUE;
+        lcd.changed = TRUE;
+    }
+}
+
+static Bool lcdWrite(Host_I2cDev *dev, UInt8 byte)
+{
+    (void)dev;
+
+    if (lcd.phase == 0)
+    {
+        lcd.data  = byte;
+        lcd.phase = 1;
+        return TRUE;
+    }
+
+    if ((lcd.ctrl & LCD_E) && !(byte & LCD_E)) lcdLatch();
+    lcd.ctrl  = byte;
+    lcd.phase = 0;
+
+    return TRUE;
+}
+
+void Host_Lcd_get(Host_LcdState *out)
+{
+    Int i;
+
+    for (i=0; i<16; i++)
+    {
+        lcd.st.line[0][i] = (char)lcd.ddram[i];
+        lcd.st.line[1][i] = (char)lcd.ddram[0x40 + i];
+    }
+    lcd.st.line[0][16] = lcd.st.line[1][16] = '\0';
+
+    *out = lcd.st;
+}
+
+Bool Host_Lcd_changed(void)
+{
+    Bool changed = lcd.changed;
+
+    if (changed) lcd.st.updates++;
+    lcd.changed = FALSE;
+
+    return changed;
+}
+
+/*============================================================================*/
+/*                            MBVE BUTTONS (0x21)                             */
+/*============================================================================*/
+
+/* the first byte written selects the button line to drive; a held button
+   on that line pulls the sense input, GPIO 96 (bank 6 bit 0) */
+#define MBVE_SENSE_PIN  96
+
+static struct
+{
+    Host_I2cDev dev;
+    UInt8   phase;
+    UInt8   drive;
+    UInt8   held;
+} mbve;
+
+static void mbveSense(void)
+{
+    Host_Gpio_input(MBVE_SENSE_PIN, (mbve.drive & mbve.held) != 0);
+}
+
+static void mbveStart(Host_I2cDev *dev, Bool read)
+{
+    (void)dev; (void)read;
+    mbve.phase = 0;
+}
+
+static Bool mbveWrite(Host_I2cDev *dev, UInt8 byte)
+{
+    (void)dev;
+
+    if (mbve.phase++ == 0)
+    {
+        mbve.drive = byte;
+        mbveSense();
+    }
+
+    return TRUE;
+}
+
+void Host_Buttons_set(UInt8 held)
+{
+    mbve.held = held;
+    mbveSense();
+}
+
+/*============================================================================*/
+/*                          ADS1112 ADCs (0x48, 0x4A)                         */
+/*============================================================================*/
+
+typedef struct
+{
+    Host_I2cDev dev;
+    UInt8   config;
+    UInt8   out[3];
+    UInt8   pos;
+} Adc;
+
+static Adc adcTemp, adcDens;
+static Host_AdcInput adcInput;
+static double adcNoise;
+static UInt32 adcSeed = 1;
+static UInt32 adcConversions;
+
+/* 25 C on the RTD channel, mid-scale elsewhere */
+static Int32 adcDefault(UInt8 addr, UInt8 config)
+{
+    (void)addr; (void)config;
+    return 22898;
+}
+
+static double adcGauss(void)
+{
+    double u1, u2;
+
+    adcSeed = adcSeed * 1103515245u + 12345u;
+    u1 = ((adcSeed >> 8) + 1.0) / 16777217.0;
+    adcSeed = adcSeed * 1103515245u + 12345u;
+    u2 = (adcSeed >> 8) / 16777216.0;
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static void adcStart(Host_I2cDev *dev, Bool read)
+{
+    Adc *a = (Adc *)dev;
+    Int32 code;
+
+    a->pos = 0;
+    if (!read) return;
+
+    code = (adcInput ? adcInput : adcDefault)(dev->addr, a->config);
+    if (adcNoise > 0) code += (Int32)lround(adcNoise * adcGauss());
+    if (code > 32767) code = 32767;
+    if (code < -32768) code = -32768;
+
+    a->out[0] = (UInt8)((UInt32)code >> 8);
+    a->out[1] = (UInt8)code;
+    a->out[2] = a->config & 0x7F;   // ST/DRDY clear: conversion ready
+    adcConversions++;
+}
+
+static Bool adcWrite(Host_I2cDev *dev, UInt8 byte)
+{
+    ((Adc *)dev)->config = byte;
+    return TRUE;
+}
+
+static UInt8 adcRead(Host_I2cDev *dev)
+{
+    Adc *a = (Adc *)dev;
+
+    return a->out[a->pos < 2 ? a->pos++ : 2];
+}
+
+void Host_Adc_input(Host_AdcInput fxn)
+{
+    adcInput = fxn;
+}
+
+void Host_Adc_noise(double lsbRms, UInt32 seed)
+{
+    adcNoise = lsbRms;
+    adcSeed  = seed ? seed : 1;
+}
+
+UInt32 Host_Adc_conversions(void)
+{
+    return adcConversions;
+}
+
+/*============================================================================*/
+/*                               AO DAC (0x4C)                                */
+/*============================================================================*/
+
+static struct
+{
+    Host_I2cDev dev;
+    UInt8   in[3];
+    UInt8   pos;
+    UInt16  code;
+    UInt32  writes;
+} dac;
+
+static void dacStart(Host_I2cDev *dev, Bool read)
+{
+    (void)dev; (void)read;
+    dac.pos = 0;
+}
+
+static Bool dacWrite(Host_I2cDev *dev, UInt8 byte)
+{
+    (void)dev;
+
+    if (dac.pos < 3) dac.in[dac.pos++] = byte;
+    if (dac.pos == 3)
+    {
+        dac.code = (UInt16)((dac.in[1] << 8) | dac.in[2]);
+        dac.writes++;
+        dac.pos++;
+    }
+
+    return TRUE;
+}
+
+static UInt8 dacRead(Host_I2cDev *dev)
+{
+    UInt8 b;
+
+    (void)dev;
+
+    b = (dac.pos == 0) ? (UInt8)(dac.code >> 8) : (dac.pos == 1) ? (UInt8)dac.code : 0x10;
+    dac.pos++;
+
+    return b;
+}
+
+UInt16 Host_Dac_code(void)
+{
+    return dac.code;
+}
+
+UInt32 Host_Dac_writes(void)
+{
+    return dac.writes;
+}
+
+void Host_Dac_upset(UInt16 code)
+{
+    dac.code = code;
+}
+
+/*============================================================================*/
+/*                              DS1340 RTC (0x68)                             */
+/*============================================================================*/
+
+/* BCD time registers 0..6 with an auto-incrementing pointer; the clock
+   runs on virtual time scaled by the oscillator error */
+static struct
+{
+    Host_I2cDev dev;
+    UInt8   ptr;
+    Bool    first;
+    UInt32  epoch;              // seconds at setUs
+    UInt64  setUs;
+    double  ppm;
+} rtc;
+
+static UInt8 toBcd(UInt32 v)
+{
+    return (UInt8)(((v / 10) << 4) | (v % 10));
+}
+
+static UInt32 fromBcd(UInt8 v)
+{
+    return (v >> 4) * 10 + (v & 0x0F);
+}
+
+UInt32 Host_Rtc_now(void)
+{
+    double us = (double)(Host_Now() - rtc.setUs) * (1.0 + rtc.ppm * 1e-6);
+
+    return rtc.epoch + (UInt32)(us / 1e6);
+}
+
+void Host_Rtc_set(UInt32 epoch, double ppm)
+{
+    rtc.epoch = epoch;
+    rtc.setUs = Host_Now();
+    rtc.ppm   = ppm;
+}
+
+static UInt8 rtcField(UInt8 reg)
+{
+    time_t t = Host_Rtc_now();
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    switch (reg)
+    {
+    case 0:  return toBcd(tm.tm_sec);
+    case 1:  return toBcd(tm.tm_min);
+    case 2:  return toBcd(tm.tm_hour);
+    case 3:  return toBcd(tm.tm_wday + 1);
+    case 4:  return toBcd(tm.tm_mday);
+    case 5:  return toBcd(tm.tm_mon + 1);
+    case 6:  return toBcd(tm.tm_year % 100);
+    default: return 0;
+    }
+}
+
+static void rtcSetField(UInt8 reg, UInt8 v)
+{
+    time_t t = Host_Rtc_now();
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    switch (reg)
+    {
+    case 0: tm.tm_sec  = fromBcd(v & 0x7F); break;
+    case 1: tm.tm_min  = fromBcd(v & 0x7F); break;
+    case 2: tm.tm_hour = fromBcd(v & 0x3F); break;
+    case 4: tm.tm_mday = fromBcd(v & 0x3F); break;
+    case 5: tm.tm_mon  = fromBcd(v & 0x1F) - 1; break;
+    case 6: tm.tm_year = fromBcd(v) + 100; break;
+    default: return;
+    }
+    Host_Rtc_set((UInt32)timegm(&tm), rtc.ppm);
+}
+
+static void rtcStart(Host_I2cDev *dev, Bool read)
+{
+    (void)dev;
+    rtc.first = !read;
+}
+
+static Bool rtcWrite(Host_I2cDev *dev, UInt8 byte)
+{
+    (void)dev;
+
+    if (rtc.first) rtc.ptr = byte & 0x0F;
+    else rtcSetField(rtc.ptr++, byte);
+    rtc.first = FALSE;
+
+    return TRUE;
+}
+
+static UInt8 rtcRead(Host_I2cDev *dev)
+{
+    (void)dev;
+    return rtcField(rtc.ptr++);
+}
+
+/*============================================================================*/
+/*                                   SETUP                                    */
+/*============================================================================*/
+
+static void device(Host_I2cDev *dev, const char *name, UInt8 addr,
+                   void (*start)(Host_I2cDev *, Bool), Bool (*write)(Host_I2cDev *, UInt8),
+                   UInt8 (*read)(Host_I2cDev *))
+{
+    dev->name  = name;
+    dev->addr  = addr;
+    dev->start = start;
+    dev->write = write;
+    dev->read  = read;
+    Host_I2c_attach(dev);
+}
+
+void Host_I2c_Init(void)
+{
+    regs = Host_Mmio_map(CSL_I2C_0_DATA_CFG, sizeof(CSL_I2cRegs), i2cRead, i2cWrite, NULL);
+    regs->ICSTR = CSL_I2C_ICSTR_RESETVAL;
+
+    memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+    lcd.increment = TRUE;
+    Host_Rtc_set(1546300800u, 0.0);     // 2019-01-01 00:00:00
+
+    device(&lcd.dev,     "LCD",    0x20, lcdStart,  lcdWrite,  NULL);
+    device(&mbve.dev,    "MBVE",   0x21, mbveStart, mbveWrite, NULL);
+    device(&adcTemp.dev, "ADC",    0x48, adcStart,  adcWrite,  adcRead);
+    device(&adcDens.dev, "ADC2",   0x4A, adcStart,  adcWrite,  adcRead);
+    device(&dac.dev,     "DAC",    0x4C, dacStart,  dacWrite,  dacRead);
+    device(&rtc.dev,     "DS1340", 0x68, rtcStart,  rtcWrite,  rtcRead);
+}
@@ -0,0 +1,314 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_mmio.c
+*-------------------------------------------------------------------------
+* Memory-mapped peripheral registers on the host (x86-64 Linux).
+*
+* Each register block is one shared memory object mapped twice: at its
+* OMAP-L138 physical address with no access at all, which is the address
+* the firmware dereferences (CSL_*_REGS, host_csl.h), and read-write at
+* an address of the kernel's choosing, which is the model's view of the
+* same bytes. A firmware access faults (SIGSEGV). The handler lets the
+* model refresh the register before a read, opens the page and single-
+* steps the one instruction (EFLAGS.TF). The trap that follows (SIGTRAP)
+* hands the model the old and new value of a written word and closes the
+* page again. The firmware therefore builds unchanged, and every register
+* access it makes goes through the model, in program order.
+*
+* Nearly every register access gcc emits is a 32-bit mov (load, store or
+* store of an immediate) at a word address. The handler does those
+* itself through the view and skips the instruction, which saves the
+* trap and both page protection changes; anything else is single-
+* stepped.
+*
+* Models run inside the signal handlers. They must not call firmware code
+* or block; they change register contents, schedule completions with
+* Host_At() and raise interrupts with Host_Hwi_pend().
+*
+* Plain memory blocks (Host_Mmio_ram) are mapped read-write at their
+* physical address and never trap.
+*------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "host_dev.h"
+
+#define MAX_BLOCK   24
+#define PAGE        4096u
+#define TF          0x100           // EFLAGS trap flag
+#define PF_WRITE    0x2             // page-fault error code: write access
+
+typedef struct
+{
+    UArg            base;           // physical address, page aligned
+    UInt32          size;           // page multiple
+    volatile UInt8  *view;          // model's read-write view
+    Host_MmioRead   onRead;
+    Host_MmioWrite  onWrite;
+    void            *ctx;
+} Block;
+
+static Block blocks[MAX_BLOCK];
+static Int numBlocks;
+
+/* the access being single-stepped */
+static Block *stepBlock;
+static UInt32 stepOff;              // word aligned
+static UInt32 stepOld;
+static Bool stepWrite;
+
+static UInt32 traps;
+
+/* gregs index of each x86-64 register number (ModRM reg field with REX.R) */
+static const int GREG[16] =
+{
+    REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8,  REG_R9,  REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15
+};
+
+static Block *findBlock(UArg addr)
+{
+    Int i;
+
+    for (i=0; i<numBlocks; i++)
+        if (addr >= blocks[i].base && addr < blocks[i].base + blocks[i].size) return &blocks[i];
+
+    return NULL;
+}
+
+static UArg faultPc;                    // for addr2line, on a stray access
+
+static void die(const char *what, UArg addr)
+{
+    char msg[128];
+    Int n;
+
+    n = snprintf(msg, sizeof(msg), "host_mmio: %s at 0x%08lx, pc 0x%08lx\n", what,
+                 (unsigned long)addr, (unsigned long)faultPc);
+    if (write(2, msg, n) < 0) {}
+    signal(SIGSEGV, SIG_DFL);
+    abort();
+}
+
+/// a 32-bit mov to or from the word at <off>: 8B /r (load), 89 /r
+/// (store) or C7 /0 id (store immediate), with at most a REX prefix.
+/// Returns FALSE, having done nothing, for any other instruction.
+static Bool emulate(ucontext_t *ctx, Block *b, UInt32 off, Bool write)
+{
+    const UInt8 *p = (const UInt8 *)ctx->uc_mcontext.gregs[REG_RIP];
+    volatile UInt32 *reg = (volatile UInt32 *)(b->view + off);
+    UInt8 rex = 0, op, modrm, mod, rm;
+    UInt32 val, old;
+    Int r;
+
+    if ((*p & 0xF0) == 0x40) rex = *p++;
+    if (rex & 0x08) return FALSE;               // REX.W: 64-bit operand
+
+    op = *p++;
+    if (op != 0x8B && op != 0x89 && op != 0xC7) return FALSE;
+    if ((op == 0x8B) == write) return FALSE;
+
+    modrm = *p++;
+    mod = modrm >> 6;
+    rm  = modrm & 7;
+    r   = ((modrm >> 3) & 7) | ((rex & 0x04) ? 8 : 0);
+    if (mod == 3 || (op == 0xC7 && r != 0)) return FALSE;
+
+    /* the address is known (si_addr); only the length is needed */
+    if (rm == 4 && (*p++ & 7) == 5 && mod == 0) p += 4;     // SIB, no base
+    if (mod == 0 && rm == 5) p += 4;                        // RIP-relative
+    if (mod == 1) p += 1;
+    if (mod == 2) p += 4;
+
+    if (!write)
+    {
+        if (b->onRead) b->onRead(b->ctx, off);
+        ctx->uc_mcontext.gregs[GREG[r]] = *reg;             // zero-extends
+    }
+    else
+    {
+        if (op == 0xC7)
+        {
+            memcpy(&val, p, 4);
+            p += 4;
+        }
+        else val = (UInt32)ctx->uc_mcontext.gregs[GREG[r]];
+
+        old  = *reg;
+        *reg = val;
+        if (b->onWrite) b->onWrite(b->ctx, off, val, old);
+    }
+
+    ctx->uc_mcontext.gregs[REG_RIP] = (greg_t)p;
+    return TRUE;
+}
+
+static void onSegv(int sig, siginfo_t *si, void *uc)
+{
+    ucontext_t *ctx = (ucontext_t *)uc;
+    UArg addr = (UArg)si->si_addr;
+    Block *b;
+
+    (void)sig;
+
+    b = findBlock(addr);
+    if (b == NULL || stepBlock != NULL)
+    {
+        faultPc = ctx->uc_mcontext.gregs[REG_RIP];
+        die("access outside the modelled registers", addr);
+    }
+
+    stepOff   = (UInt32)(addr - b->base) & ~3u;
+    stepWrite = (ctx->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+    traps++;
+
+    if ((addr & 3) == 0 && emulate(ctx, b, stepOff, stepWrite)) return;
+
+    stepBlock = b;
+
+    if (!stepWrite && b->onRead) b->onRead(b->ctx, stepOff);
+    stepOld = *(volatile UInt32 *)(b->view + stepOff);
+
+    mprotect((void *)b->base, b->size, PROT_READ | PROT_WRITE);
+    ctx->uc_mcontext.gregs[REG_EFL] |= TF;
+}
+
+static void onTrap(int sig, siginfo_t *si, void *uc)
+{
+    ucontext_t *ctx = (ucontext_t *)uc;
+    Block *b = stepBlock;
+    UInt32 val;
+
+    (void)sig; (void)si;
+
+    if (b == NULL) die("unexpected trap", 0);
+
+    ctx->uc_mcontext.gregs[REG_EFL] &= ~TF;
+    mprotect((void *)b->base, b->size, PROT_NONE);
+    stepBlock = NULL;
+
+    if (stepWrite && b->onWrite)
+    {
+        val = *(volatile UInt32 *)(b->view + stepOff);
+        b->onWrite(b->ctx, stepOff, val, stepOld);
+    }
+}
+
+static void install(void)
+{
+    static Bool done;
+    static char altStack[64 * 1024];
+    struct sigaction sa;
+    stack_t ss;
+
+    if (done) return;
+    done = TRUE;
+
+    /* firmware tasks run on small ucontext stacks */
+    ss.ss_sp    = altStack;
+    ss.ss_size  = sizeof(altStack);
+    ss.ss_flags = 0;
+    sigaltstack(&ss, NULL);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_sigaction = onSegv;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = onTrap;
+    sigaction(SIGTRAP, &sa, NULL);
+}
+
+static void *mapAt(UArg addr, UInt32 size, int prot, int fd)
+{
+    void *p;
+
+    p = mmap((void *)addr, size, prot, MAP_SHARED | (addr ? MAP_FIXED_NOREPLACE : 0), fd, 0);
+    if (p == MAP_FAILED || (addr && (UArg)p != addr)) die("cannot map", addr);
+
+    return p;
+}
+
+volatile void *Host_Mmio_map(UArg base, UInt32 size, Host_MmioRead onRead, Host_MmioWrite onWrite, void *ctx)
+{
+    Block *b;
+    int fd;
+
+    if (numBlocks == MAX_BLOCK) die("too many register blocks", base);
+    install();
+
+    b = &blocks[numBlocks++];
+    b->base    = base & ~(UArg)(PAGE-1);
+    b->size    = (size + (base - b->base) + PAGE-1) & ~(PAGE-1);
+    b->onRead  = onRead;
+    b->onWrite = onWrite;
+    b->ctx     = ctx;
+
+    fd = memfd_create("host_mmio", 0);
+    if (fd < 0 || ftruncate(fd, b->size) < 0) die("memfd", base);
+    b->view = mapAt(0, b->size, PROT_READ | PROT_WRITE, fd);
+    mapAt(b->base, b->size, PROT_NONE, fd);
+    close(fd);
+
+    return b->view + (base - b->base);
+}
+
+void *Host_Mmio_ram(UArg base, UInt32 size)
+{
+    UArg start = base & ~(UArg)(PAGE-1);
+    void *p;
+
+    size = (size + (base - start) + PAGE-1) & ~(PAGE-1);
+    p = mmap((void *)start, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p == MAP_FAILED || (UArg)p != start) die("cannot map", base);
+
+    return (void *)base;
+}
+
+/* The register blocks are shared memory, so a fork() child would share
+   them with its parent: copy each one into a new object and map that at
+   both addresses instead. */
+void Host_Mmio_fork(void)
+{
+    Block *b;
+    void *p;
+    int fd;
+
+    for (b = blocks; b < blocks + numBlocks; b++)
+    {
+        fd = memfd_create("host_mmio", 0);
+        if (fd < 0 || ftruncate(fd, b->size) < 0) die("memfd", b->base);
+        if (write(fd, (const void *)b->view, b->size) != (ssize_t)b->size) die("memfd", b->base);
+
+        p = mmap((void *)b->view, b->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        if (p != (void *)b->view) die("cannot map", (UArg)b->view);
+        p = mmap((void *)b->base, b->size, PROT_NONE, MAP_SHARED | MAP_FIXED, fd, 0);
+        if (p != (void *)b->base) die("cannot map", b->base);
+        close(fd);
+    }
+}
+
+UInt32 Host_Mmio_traps(void)
+{
+    return traps;
+}
@@ -0,0 +1,177 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_modbus.c
+*-------------------------------------------------------------------------
+* Modbus RTU master on the UART2 model, for the host programs. A request
+* goes out one character time per byte (Host_Uart_rx) and virtual time
+* runs until the reply is complete, so ModbusRTU.c sees the frame, the
+* silence clocks and the reply exactly as from a real master.
+*
+* Register numbers are the 1-based ones of ModbusTables.h; on the wire
+* they are 0-based. Floats and long integers are one 32-bit big-endian
+* value per register pair.
+*------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "host_dev.h"
+
+#define MB_MAX          256
+#define MB_TIMEOUT_US   1000000     // the firmware answers within a few char times
+
+static struct
+{
+    UInt8   buf[MB_MAX];
+    UInt32  n;
+    UInt8   exception;
+    UInt64  lastUs;
+    Bool    hooked;
+} m;
+
+static void onTx(UInt8 byte)
+{
+    if (m.n < MB_MAX) m.buf[m.n++] = byte;
+}
+
+static UInt16 crc16(const UInt8 *p, UInt32 n)
+{
+    UInt16 crc = 0xFFFF;
+    UInt32 i, b;
+
+    for (i=0; i<n; i++)
+    {
+        crc ^= p[i];
+        for (b=0; b<8; b++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+
+    return crc;
+}
+
+/// send <req> (without CRC) and wait for a reply of <expect> bytes (with
+/// CRC), or an exception; FALSE on a timeout, bad CRC or exception
+static Bool transact(UInt8 *req, UInt32 n, UInt32 expect)
+{
+    UInt16 crc = crc16(req, n);
+    UInt64 start, step;
+
+    if (!m.hooked)
+    {
+        Host_Uart_tx(onTx);
+        m.hooked = TRUE;
+    }
+
+    req[n++] = crc & 0xFF;
+    req[n++] = crc >> 8;
+
+    m.n = 0;
+    m.exception = 0;
+    start = Host_Now();
+    step = Host_Uart_charUs();
+
+    Host_Uart_rx(req, n);
+    while (Host_Now() - start < MB_TIMEOUT_US)
+    {
+        Host_Run(step);
+        if (m.n >= 5 && (m.buf[1] & 0x80)) break;
+        if (m.n >= expect) break;
+    }
+    /* the last stop bit */
+    while (!Host_Uart_idle() && Host_Now() - start < MB_TIMEOUT_US) Host_Run(step);
+    m.lastUs = Host_Now() - start;
+
+    if (m.n >= 5 && (m.buf[1] & 0x80))
+    {
+        m.exception = m.buf[2];
+        return FALSE;
+    }
+    if (m.n < expect) return FALSE;
+
+    return crc16(m.buf, expect - 2) == (m.buf[expect-2] | (m.buf[expect-1] << 8));
+}
+
+static void putReg(UInt8 *p, UInt16 reg)
+{
+    p[0] = (UInt8)((reg - 1) >> 8);
+    p[1] = (UInt8)(reg - 1);
+}
+
+static void put32(UInt8 *p, UInt32 v)
+{
+    p[0] = (UInt8)(v >> 24);
+    p[1] = (UInt8)(v >> 16);
+    p[2] = (UInt8)(v >> 8);
+    p[3] = (UInt8)v;
+}
+
+Bool Host_Mb_writeInt(UInt8 slave, UInt16 reg, UInt16 val)
+{
+    UInt8 req[8] = {slave, 0x06};
+
+    putReg(req + 2, reg);
+    req[4] = (UInt8)(val >> 8);
+    req[5] = (UInt8)val;
+
+    return transact(req, 6, 8);
+}
+
+Bool Host_Mb_write32(UInt8 slave, UInt16 reg, UInt32 val)
+{
+    UInt8 req[13] = {slave, 0x10, 0, 0, 0, 2, 4};
+
+    putReg(req + 2, reg);
+    put32(req + 7, val);
+
+    return transact(req, 11, 8);
+}
+
+Bool Host_Mb_writeFloat(UInt8 slave, UInt16 reg, float val)
+{
+    UInt32 v;
+
+    memcpy(&v, &val, 4);
+    return Host_Mb_write32(slave, reg, v);
+}
+
+Bool Host_Mb_read32(UInt8 slave, UInt16 reg, UInt32 *val)
+{
+    UInt8 req[8] = {slave, 0x03, 0, 0, 0, 2};
+
+    putReg(req + 2, reg);
+    if (!transact(req, 6, 9) || m.buf[2] != 4) return FALSE;
+
+    *val = ((UInt32)m.buf[3] << 24) | ((UInt32)m.buf[4] << 16) | ((UInt32)m.buf[5] << 8) | m.buf[6];
+    return TRUE;
+}
+
+Bool Host_Mb_readFloat(UInt8 slave, UInt16 reg, float *val)
+{
+    UInt32 v;
+
+    if (!Host_Mb_read32(slave, reg, &v)) return FALSE;
+    memcpy(val, &v, 4);
+
+    return TRUE;
+}
+
+UInt8 Host_Mb_exception(void)
+{
+    return m.exception;
+}
+
+UInt64 Host_Mb_lastUs(void)
+{
+    return m.lastUs;
+}
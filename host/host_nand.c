@@ -0,0 +1,246 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_nand.c
+*-------------------------------------------------------------------------
+* NAND flash for the host build, at the level of the nand.h driver API
+* that nandwriter.c calls (Common/src/nand.c is not built: it drives the
+* EMIFA NAND controller a command cycle at a time).
+*
+* The part is the LCDK's 512 MB, 16-bit device: 4096 blocks of 64 pages
+* of 2 KB. Erased bytes read 0xFF; programming can only clear bits; a
+* block stays locked unless it lies in the range of the last
+* NAND_unProtectBlocks(), as on the chip, and a locked block fails to
+* erase or program. Blocks get their storage on first erase or program.
+*
+* Host_Nand_cut() models a power loss: the chosen program or erase does
+* not happen, or for a torn program only the first half of the page is
+* programmed, and the callback runs in its place and does not return.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_dev.h"
+#include "nand.h"
+
+#define NUM_BLOCKS      4096
+#define PAGES           64
+#define PAGE_BYTES      2048
+#define SPARE_BYTES     64
+
+static NAND_InfoObj info;
+static Uint8 *block[NUM_BLOCKS];
+static Bool bad[NUM_BLOCKS];
+static Uint32 unlockFirst, unlockLast;      // unlocked range, empty if first > last
+static Host_NandStats stats;
+static struct
+{
+    UInt32  left;                   // programs and erases before the cut
+    Bool    torn;
+    void    (*fxn)(void);
+} cut;
+
+static Uint8 *blockData(Uint32 blk)
+{
+    if (block[blk] == NULL)
+    {
+        block[blk] = malloc(PAGES * PAGE_BYTES);
+        memset(block[blk], 0xFF, PAGES * PAGE_BYTES);
+    }
+
+    return block[blk];
+}
+
+static Bool writable(Uint32 blk)
+{
+    if (blk >= NUM_BLOCKS || bad[blk]) return FALSE;
+    if (blk < unlockFirst || blk > unlockLast)
+    {
+        stats.locked++;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static Bool cutNow(void)
+{
+    if (cut.fxn == NULL) return FALSE;
+    if (cut.left)
+    {
+        cut.left--;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void powerLoss(void)
+{
+    void (*fxn)(void) = cut.fxn;
+
+    cut.fxn = NULL;
+    fxn();
+}
+
+/*============================================================================*/
+/*                                  DRIVER API                                */
+/*============================================================================*/
+
+NAND_InfoHandle NAND_open(Uint32 baseCSAddr, Uint8 busWidth)
+{
+    info.flashBase          = baseCSAddr;
+    info.busWidth           = busWidth;
+    info.numBlocks          = NUM_BLOCKS;
+    info.pagesPerBlock      = PAGES;
+    info.dataBytesPerPage   = PAGE_BYTES;
+    info.spareBytesPerPage  = SPARE_BYTES;
+    info.dataBytesPerOp     = 512;
+    info.spareBytesPerOp    = 16;
+    info.numOpsPerPage      = PAGE_BYTES / 512;
+    info.isLargePage        = TRUE;
+    info.isONFI             = TRUE;
+    info.currBlock          = -1;
+
+    return &info;
+}
+
+Uint32 NAND_reset(NAND_InfoHandle hNandInfo)
+{
+    (void)hNandInfo;
+    return E_PASS;
+}
+
+Uint32 NAND_badBlockCheck(NAND_InfoHandle hNandInfo, Uint32 blk)
+{
+    (void)hNandInfo;
+    return (blk < NUM_BLOCKS && !bad[blk]) ? E_PASS : E_FAIL;
+}
+
+Uint32 NAND_badBlockMark(NAND_InfoHandle hNandInfo, Uint32 blk)
+{
+    (void)hNandInfo;
+    if (blk < NUM_BLOCKS) bad[blk] = TRUE;
+    return E_PASS;
+}
+
+Uint32 NAND_readPage(NAND_InfoHandle hNandInfo, Uint32 blk, Uint32 page, Uint8 *dest)
+{
+    (void)hNandInfo;
+    if (blk >= NUM_BLOCKS || page >= PAGES) return E_FAIL;
+
+    if (block[blk]) memcpy(dest, block[blk] + page * PAGE_BYTES, PAGE_BYTES);
+    else memset(dest, 0xFF, PAGE_BYTES);
+    stats.reads++;
+
+    return E_PASS;
+}
+
+Uint32 NAND_writePage(NAND_InfoHandle hNandInfo, Uint32 blk, Uint32 page, Uint8 *src)
+{
+    Uint8 *p;
+    Uint32 i;
+
+    (void)hNandInfo;
+    if (page >= PAGES || !writable(blk)) return E_FAIL;
+
+    p = blockData(blk) + page * PAGE_BYTES;
+    if (cutNow())
+    {
+        if (cut.torn) for (i=0; i<PAGE_BYTES/2; i++) p[i] &= src[i];
+        powerLoss();
+    }
+    for (i=0; i<PAGE_BYTES; i++) p[i] &= src[i];
+    stats.programs++;
+
+    return E_PASS;
+}
+
+Uint32 NAND_verifyPage(NAND_InfoHandle hNandInfo, Uint32 blk, Uint32 page, Uint8 *src, Uint8 *dest)
+{
+    if (NAND_readPage(hNandInfo, blk, page, dest) != E_PASS) return E_FAIL;
+    return memcmp(src, dest, PAGE_BYTES) ? E_FAIL : E_PASS;
+}
+
+Uint32 NAND_eraseBlocks(NAND_InfoHandle hNandInfo, Uint32 startBlkNum, Uint32 blkCnt)
+{
+    Uint32 b;
+
+    (void)hNandInfo;
+    for (b=startBlkNum; b<startBlkNum+blkCnt; b++)
+    {
+        if (!writable(b)) return E_FAIL;
+        if (cutNow()) powerLoss();
+        memset(blockData(b), 0xFF, PAGES * PAGE_BYTES);
+        stats.erases++;
+    }
+
+    return E_PASS;
+}
+
+/* the count runs past the last block in nandwriter.c; the chip clips it */
+Uint32 NAND_unProtectBlocks(NAND_InfoHandle hNandInfo, Uint32 startBlkNum, Uint32 blkCnt)
+{
+    (void)hNandInfo;
+
+    unlockFirst = startBlkNum;
+    unlockLast  = startBlkNum + blkCnt - 1;
+    if (unlockLast >= NUM_BLOCKS) unlockLast = NUM_BLOCKS - 1;
+
+    return E_PASS;
+}
+
+void NAND_protectBlocks(NAND_InfoHandle hNandInfo)
+{
+    (void)hNandInfo;
+
+    unlockFirst = 1;
+    unlockLast  = 0;
+}
+
+/*============================================================================*/
+/*                                  HOST SIDE                                 */
+/*============================================================================*/
+
+void Host_Nand_stats(Host_NandStats *s)
+{
+    *s = stats;
+}
+
+void Host_Nand_resetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void Host_Nand_cut(UInt32 ops, Bool torn, void (*fxn)(void))
+{
+    cut.left = ops;
+    cut.torn = torn;
+    cut.fxn  = fxn;
+}
+
+void Host_Nand_blank(void)
+{
+    Uint32 b;
+
+    for (b=0; b<NUM_BLOCKS; b++)
+    {
+        free(block[b]);
+        block[b] = NULL;
+        bad[b] = FALSE;
+    }
+    NAND_protectBlocks(&info);
+}
@@ -0,0 +1,210 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_usb.c
+*-------------------------------------------------------------------------
+* USB host controller, mass storage class and stick for the host build
+* (host_usb.h). The medium is stored in 64 KB chunks allocated on first
+* write; unwritten sectors read as zeros, as on an erased stick.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_usb.h"
+
+#define SECT            512
+#define CHUNK_SECT      128
+#define NUM_CHUNK       (HOST_USB_SECTORS / CHUNK_SECT)
+
+tUSBHMSCInstance g_USBHMSCDevice[1];
+
+static UInt8 *chunk[NUM_CHUNK];
+static Bool present;
+static Bool enumerated;             // MSC_EVENT_OPEN delivered
+static UInt32 commandNs = 500000;   // CBW, status and the stick's own latency
+static UInt32 sectorNs  = 25000;    // 512 B at about 20 MB/s
+static Host_UsbStats stats;
+
+static UInt8 *sectorAt(UInt32 sector, Bool alloc)
+{
+    UInt8 **c = &chunk[sector / CHUNK_SECT];
+
+    if (*c == NULL)
+    {
+        if (!alloc) return NULL;
+        *c = calloc(CHUNK_SECT, SECT);
+    }
+
+    return *c + (sector % CHUNK_SECT) * SECT;
+}
+
+/*============================================================================*/
+/*                                  MEDIUM                                    */
+/*============================================================================*/
+
+void Host_Usb_peek(UInt32 sector, void *buf)
+{
+    UInt8 *s = sectorAt(sector, FALSE);
+
+    if (s) memcpy(buf, s, SECT);
+    else memset(buf, 0, SECT);
+}
+
+void Host_Usb_poke(UInt32 sector, const void *buf)
+{
+    memcpy(sectorAt(sector, TRUE), buf, SECT);
+}
+
+void Host_Usb_erase(void)
+{
+    UInt32 i;
+
+    for (i=0; i<NUM_CHUNK; i++)
+    {
+        free(chunk[i]);
+        chunk[i] = NULL;
+    }
+}
+
+void Host_Usb_attach(Bool plugged)
+{
+    present = plugged;
+}
+
+void Host_Usb_latency(UInt32 commandUs, UInt32 sectorUs)
+{
+    commandNs = commandUs * 1000;
+    sectorNs  = sectorUs * 1000;
+}
+
+void Host_Usb_stats(Host_UsbStats *s)
+{
+    *s = stats;
+}
+
+void Host_Usb_resetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/*============================================================================*/
+/*                          DRIVER, OSAL AND MSC CLASS                        */
+/*============================================================================*/
+
+USB_Handle USB_open(uint32_t instanceNo, USB_Params *params)
+{
+    static UInt8 controller;
+
+    (void)instanceNo;
+    params->usbHandle = &controller;
+
+    return params->usbHandle;
+}
+
+void USB_irqConfig(USB_Handle handle, USB_Params *params) { (void)handle; (void)params; }
+void USB_coreIrqHandler(USB_Handle handle, USB_Params *params) { (void)handle; (void)params; }
+
+void Osal_RegisterInterrupt_initParams(OsalRegisterIntrParams_t *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+int32_t Osal_RegisterInterrupt(OsalRegisterIntrParams_t *params, HwiP_Handle *handle)
+{
+    *handle = params;
+    return 0;
+}
+
+/* usb_osal.c spins on the usb_timer.c timer; here the delay passes in
+ * virtual time and there is no timer to set up */
+void usb_osalDelayMs(uint32_t delay_ms)
+{
+    Task_sleep(delay_ms * 1000 / Clock_tickPeriod);
+}
+
+void delayTimerSetup(void)
+{
+}
+
+unsigned int USBHMSCDriveOpen(unsigned int instance, unsigned int drive, tUSBHMSCCallback callback)
+{
+    (void)instance; (void)drive;
+
+    g_USBHMSCDevice[0].inUse    = 1;
+    g_USBHMSCDevice[0].callback = callback;
+
+    return (unsigned int)(UArg)&g_USBHMSCDevice[0];
+}
+
+int32_t USBHMSCDriveReady(unsigned int instance)
+{
+    (void)instance;
+    return (present && enumerated) ? 0 : -1;
+}
+
+uint32_t USBHCDMain(uint32_t instance, unsigned int msc)
+{
+    tUSBHMSCInstance *dev = &g_USBHMSCDevice[0];
+
+    (void)instance;
+
+    if (!dev->inUse) return 1;
+
+    if (present && !enumerated)
+    {
+        enumerated = TRUE;
+        if (dev->callback) dev->callback(msc, MSC_EVENT_OPEN, NULL);
+    }
+    else if (!present && enumerated)
+    {
+        enumerated = FALSE;
+        if (dev->callback) dev->callback(msc, MSC_EVENT_CLOSE, NULL);
+    }
+
+    return 0;
+}
+
+int32_t USBHMSCBlockRead(unsigned int instance, uint32_t sector, uint8_t *data, uint32_t count)
+{
+    uint32_t i;
+
+    (void)instance;
+    if (!present || !enumerated || sector + count > HOST_USB_SECTORS) return -1;
+
+    for (i=0; i<count; i++) Host_Usb_peek(sector + i, data + i * SECT);
+
+    stats.reads++;
+    stats.sectorsRead += count;
+    stats.busNs += commandNs + (UInt64)count * sectorNs;
+
+    return 0;
+}
+
+int32_t USBHMSCBlockWrite(unsigned int instance, uint32_t sector, uint8_t *data, uint32_t count)
+{
+    uint32_t i;
+
+    (void)instance;
+    if (!present || !enumerated || sector + count > HOST_USB_SECTORS) return -1;
+
+    for (i=0; i<count; i++) Host_Usb_poke(sector + i, data + i * SECT);
+
+    stats.writes++;
+    stats.sectorsWritten += count;
+    stats.busNs += commandNs + (UInt64)count * sectorNs;
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* host_usb.h
+*-------------------------------------------------------------------------
+* Host stand-in for the TI USB driver, the USB library's mass storage
+* host class, the OSAL interrupt registration and the FatFs port header,
+* for the calls Log.c and usb_fatfs_port_usbmsc.c make. gen_cfg.py
+* forwards every USB library header to this one.
+*
+* host_usb.c puts a USB stick behind it: a sparse 1 GB block device that
+* Host_Usb_attach() plugs in and pulls out. Enumeration completes on the
+* first USBHCDMain() call after the stick is plugged in. Block reads and
+* writes move the data at once; the time the bulk-only transport would
+* take (a command overhead plus a per-sector transfer time) is accounted
+* in Host_UsbStats, not spent.
+*------------------------------------------------------------------------*/
+#ifndef _HOST_USB
+#define _HOST_USB
+
+#include <stdint.h>
+#include "host_bios.h"
+
+/*============================================================================*/
+/*                       USB DRIVER AND OSAL (ti/drv/usb)                     */
+/*============================================================================*/
+
+#define USB_HOST_MSC_MODE                   2
+#define SYS_INT_USB0                        58
+#define OSAL_REGINT_INTVEC_EVENT_COMBINER   (-1)
+
+typedef void    *USB_Handle;
+typedef void    *HwiP_Handle;
+
+typedef struct
+{
+    uint32_t    usbMode;
+    uint32_t    instanceNo;
+    USB_Handle  usbHandle;
+} USB_Params;
+
+typedef struct
+{
+    struct
+    {
+        const char  *name;
+        int32_t     corepacEventNum;
+        int32_t     intVecNum;
+        void        (*isrRoutine)(uintptr_t arg);
+        uintptr_t   arg;
+    } corepacConfig;
+} OsalRegisterIntrParams_t;
+
+USB_Handle  USB_open(uint32_t instanceNo, USB_Params *params);
+void        USB_irqConfig(USB_Handle handle, USB_Params *params);
+void        USB_coreIrqHandler(USB_Handle handle, USB_Params *params);
+void        Osal_RegisterInterrupt_initParams(OsalRegisterIntrParams_t *params);
+int32_t     Osal_RegisterInterrupt(OsalRegisterIntrParams_t *params, HwiP_Handle *handle);
+void        usb_osalDelayMs(uint32_t delay_ms);
+void        delayTimerSetup(void);
+
+/*============================================================================*/
+/*                        MASS STORAGE HOST CLASS (usbhmsc.h)                 */
+/*============================================================================*/
+
+#define MSC_EVENT_OPEN      1
+#define MSC_EVENT_CLOSE     2
+
+typedef void (*tUSBHMSCCallback)(uint32_t ulInstance, uint32_t ulEvent, void *pvData);
+
+typedef struct
+{
+    uint32_t            inUse;
+    tUSBHMSCCallback    callback;
+} tUSBHMSCInstance;
+
+extern tUSBHMSCInstance g_USBHMSCDevice[];
+
+unsigned int USBHMSCDriveOpen(unsigned int instance, unsigned int drive, tUSBHMSCCallback callback);
+int32_t USBHMSCDriveReady(unsigned int instance);
+int32_t USBHMSCBlockRead(unsigned int instance, uint32_t sector, uint8_t *data, uint32_t count);
+int32_t USBHMSCBlockWrite(unsigned int instance, uint32_t sector, uint8_t *data, uint32_t count);
+uint32_t USBHCDMain(uint32_t instance, unsigned int msc);
+
+/*============================================================================*/
+/*                       FatFs PORT (fatfs_port_usbmsc.h)                     */
+/*============================================================================*/
+
+int32_t FATFSPortUSBDiskInitialize(void);
+uint32_t FATFSPortUSBDiskStatus(uint32_t drv);
+int32_t FATFSPortUSBDiskRead(void *drv, uint8_t *buff, uint32_t sector, uint32_t count);
+int32_t FATFSPortUSBDiskWrite(void *drv, uint8_t *buff, uint32_t sector, uint32_t count);
+int32_t FATFSPortUSBDiskIoctl(void *usbDrv, uint32_t ctrl, void *buff);
+int32_t FATFSPortUSBDiskClose(void *handle);
+int32_t FATFSPortUSBDiskOpen(uint32_t index, void *params, void **handle);
+
+/*============================================================================*/
+/*                                  HOST SIDE                                 */
+/*============================================================================*/
+
+#define HOST_USB_SECTORS    (2u * 1024 * 1024)      // 1 GB of 512 B sectors
+
+typedef struct
+{
+    UInt32  reads;                  // READ(10) commands
+    UInt32  writes;                 // WRITE(10) commands
+    UInt32  sectorsRead;
+    UInt32  sectorsWritten;
+    UInt64  busNs;                  // time the transport takes
+} Host_UsbStats;
+
+/// plug the stick in, or pull it out
+void    Host_Usb_attach(Bool present);
+/// bulk-only transport cost: per command, and per sector moved
+void    Host_Usb_latency(UInt32 commandUs, UInt32 sectorUs);
+void    Host_Usb_stats(Host_UsbStats *stats);
+void    Host_Usb_resetStats(void);
+/// the medium itself, bypassing the transport (formatting, checking)
+void    Host_Usb_peek(UInt32 sector, void *buf);
+void    Host_Usb_poke(UInt32 sector, const void *buf);
+void    Host_Usb_erase(void);
+
+#endif
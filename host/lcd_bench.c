@@ -0,0 +1,339 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* lcd_bench.c
+*-------------------------------------------------------------------------
+* Measures the LCD renderer of PDI_i2C.c (displayLcd() and its DDRAM
+* shadow) on the HD44780 and expander model of host_i2c.c, which counts
+* every byte the expander receives.
+*
+*   razor_lcd
+*
+* First displayLcd() is called directly with NUM_REPLAY lines, and the
+* bytes it queues for the expander are handed straight to the model.
+* Each line is an edit of what the line held before: a digit, a number, two separate
+* characters, a new text, the same text, a shorter one. After every call
+* the glass has to show the line padded with spaces. Each call is made
+* twice, once against the shadow and once after LCD_invalidateShadow(),
+* which rewrites the whole line as displayLcd() did before the shadow;
+* the shadowed call may never cost more bytes.
+*
+* Then the firmware runs and menu.c is driven through typical navigation
+* sequences with the MBVE buttons, each sequence once as is and once with
+* the shadow invalidated before every menu tick. For each it prints the
+* screen updates (ticks that changed the glass) and the LCD expander bus
+* bytes per update and per menu tick, and the bus time they take at
+* 400 kHz.
+*
+* Menus that draw a screen once, on entry, gain little; the homescreens,
+* which redraw their value every tick, gain most. The program fails on a
+* glass mismatch, on a shadowed call or sequence that costs more than
+* full rewrites, or if the sequences together do not at least halve the
+* bytes.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "PDI_I2C.h"
+#include "Menu.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         5000000     // logo is 21 menu ticks
+#define NUM_REPLAY      20000
+#define HOLD_TICKS      2           // a full button scan, see menu_sim.c
+#define DWELL_TICKS     10          // after each release
+#define BYTE_NS         22500       // 9 clocks at 400 kHz
+#define MIN_GAIN        2.0
+#define LCD_WIDTH       16
+
+typedef struct
+{
+    const char  *name;
+    const char  *keys;              // S(tep) V(alue) E(nter) B(ack), '.' waits
+} SEQUENCE;
+
+/// from the Watercut homescreen, back to it
+static const SEQUENCE sequences[] =
+{
+    {"idle on Watercut",        ".........."},
+    {"homescreens",             "VVVVVVVVV"},
+    {"operation menu",          "SVVVVVBB"},
+    {"edit and cancel",         "SEVVVVBBB"},
+    {"diagnostics",             "VVVVVVS..BB"},
+};
+
+#define NUM_SEQUENCES   (sizeof(sequences) / sizeof(sequences[0]))
+
+typedef struct
+{
+    UInt32  ticks;
+    UInt32  updates;
+    UInt32  bytes;
+} RESULT;
+
+static UInt64 menuTickUs;
+static int failures;
+
+static UInt32 lcdBytes(void)
+{
+    return Host_I2c_find(I2C_SLAVE_ADDR_XPANDR)->bytes;
+}
+
+/*============================================================================*/
+/*                                   REPLAY                                   */
+/*============================================================================*/
+
+/// the next text of a line, an edit of <s>
+static void edit(char *s)
+{
+    static const char *texts[] =
+    {
+        "Watercut", "  12.34 %", "Frequency", "1234.567 MHz", "Temperature",
+        "Diagnostics", "No Error", "Oil Adjust", "Stream 12", "Locked",
+    };
+    int len = (int)strlen(s), i, k;
+
+    switch (rand() % 6)
+    {
+        case 0 :                                    // one digit
+            if (len) s[rand() % len] = (char)('0' + rand() % 10);
+            break;
+        case 1 :                                    // a number
+            sprintf(s, "%8.3f MHz", rand() % 2000000 / 1000.0);
+            break;
+        case 2 :                                    // two separate characters
+            for (k=0; k<2 && len; k++) s[rand() % len] = (char)('A' + rand() % 26);
+            break;
+        case 3 :                                    // a new text
+            strcpy(s, texts[rand() % (sizeof(texts) / sizeof(texts[0]))]);
+            break;
+        case 4 :                                    // the same
+            break;
+        default:                                    // shorter, or padded
+            if (len > 1)
+            {
+                s[1 + rand() % (len - 1)] = '\0';
+                break;
+            }
+            for (i=0; i<LCD_WIDTH; i++) s[i] = (char)('!' + rand() % 94);
+            s[LCD_WIDTH] = '\0';
+            break;
+    }
+}
+
+/// displayLcd() queues the expander bytes in I2C_TXBUF for I2C_TX_Fxn;
+/// here they go straight to the expander model. Returns the bytes.
+static UInt32 show(const char *text, int line)
+{
+    Host_I2cDev *dev = Host_I2c_find(I2C_SLAVE_ADDR_XPANDR);
+    UInt32 n;
+
+    displayLcd(text, line);
+    n = (UInt32)I2C_TXBUF.n;
+
+    dev->start(dev, FALSE);
+    while (I2C_TXBUF.n > 0) dev->write(dev, BfrGet(&I2C_TXBUF));
+
+    return n;
+}
+
+static void checkGlass(const char *text, int line)
+{
+    Host_LcdState lcd;
+    char want[LCD_WIDTH+1];
+
+    memset(want, ' ', LCD_WIDTH);
+    want[LCD_WIDTH] = '\0';
+    memcpy(want, text, strlen(text));
+    Host_Lcd_get(&lcd);
+
+    if (strcmp(lcd.line[line], want) == 0) return;
+    if (failures++ < 10) printf("  MISMATCH line %d: [%s], expected [%s]\n", line, lcd.line[line], want);
+}
+
+/// virtual time stands still, so neither the menu nor I2C_TX_Fxn runs
+static void replay(void)
+{
+    static char text[2][LCD_WIDTH+1] = {"Watercut", "  0.00 %"};
+    UInt32 i, one, all, shadowed = 0, full = 0, worse = 0, same = 0;
+    Uint8 curStat = MENU.curStat, col = MENU.col, row = MENU.row;
+    int line;
+
+    MENU.curStat = 0;
+    MENU.col = MENU.row = 0;
+    LCD_invalidateShadow();
+    show(text[0], 0);
+    show(text[1], 1);
+
+    for (i=0; i<NUM_REPLAY; i++)
+    {
+        line = rand() & 1;
+        edit(text[line]);
+        if (text[line][0] == '\0') strcpy(text[line], "-");
+
+        one = show(text[line], line);
+        shadowed += one;
+        if (one == 0) same++;
+        checkGlass(text[line], line);
+
+        // the same text rewritten in full, as before the shadow
+        LCD_invalidateShadow();
+        all = show(text[line], line);
+        full += all;
+        if (one > all) worse++;
+        checkGlass(text[line], line);
+
+        // the other line's shadow is valid again after this
+        show(text[line ^ 1], line ^ 1);
+    }
+
+    printf("replay: %u lines, %u unchanged; LCD bus bytes per line %.1f shadowed, %.1f full (%.1fx)\n",
+        NUM_REPLAY, same, shadowed / (double)NUM_REPLAY, full / (double)NUM_REPLAY,
+        shadowed ? full / (double)shadowed : 0.0);
+    if (worse)
+    {
+        printf("  %u shadowed lines cost more than a full rewrite\n", worse);
+        failures++;
+    }
+
+    // what the menu drew last, at its own cursor
+    MENU.curStat = curStat;
+    MENU.col = col;
+    MENU.row = row;
+    LCD_invalidateShadow();
+}
+
+/*============================================================================*/
+/*                                NAVIGATION                                  */
+/*============================================================================*/
+
+static void tick(Bool full, RESULT *r)
+{
+    if (full) LCD_invalidateShadow();
+    Host_Run(menuTickUs);
+    r->ticks++;
+    if (Host_Lcd_changed()) r->updates++;
+}
+
+static void press(UInt8 mask, Bool full, RESULT *r)
+{
+    int i;
+
+    Host_Buttons_set(mask);
+    for (i=0; i<HOLD_TICKS; i++) tick(full, r);
+    Host_Buttons_set(I2C_BUTTON_NONE);
+    for (i=0; i<DWELL_TICKS; i++) tick(full, r);
+}
+
+static void home(void)
+{
+    RESULT r;
+    int n = 0;
+
+    while (MENU.state != MNU_HOMESCREEN_WTC && n++ < 16) press(I2C_BUTTON_B, FALSE, &r);
+    while (MENU.state != MNU_HOMESCREEN_WTC && n++ < 32) press(I2C_BUTTON_V, FALSE, &r);
+    if (MENU.state != MNU_HOMESCREEN_WTC)
+    {
+        fprintf(stderr, "razor_lcd: cannot get back to the Watercut homescreen (state %u)\n", MENU.state);
+        exit(1);
+    }
+}
+
+static void run(const SEQUENCE *seq, Bool full, RESULT *r)
+{
+    const char *k;
+    UInt32 b;
+
+    home();
+    memset(r, 0, sizeof(*r));
+    Host_Lcd_changed();
+    b = lcdBytes();
+
+    for (k = seq->keys; *k; k++)
+    {
+        switch (*k)
+        {
+            case 'S' : press(I2C_BUTTON_S, full, r); break;
+            case 'V' : press(I2C_BUTTON_V, full, r); break;
+            case 'E' : press(I2C_BUTTON_E, full, r); break;
+            case 'B' : press(I2C_BUTTON_B, full, r); break;
+            default  : press(I2C_BUTTON_NONE, full, r); break;
+        }
+    }
+
+    r->bytes = lcdBytes() - b;
+}
+
+static double per(UInt32 a, UInt32 b)
+{
+    return b ? a / (double)b : 0.0;
+}
+
+static void navigate(void)
+{
+    RESULT s, f;
+    UInt32 i, shadowed = 0, full = 0;
+
+    printf("\n%-18s ticks  updates  bytes/update      bytes/tick   bus ms/tick   gain\n", "sequence");
+    printf("%-18s               shadow    full  shadow   full  shadow  full\n", "");
+    for (i=0; i<NUM_SEQUENCES; i++)
+    {
+        run(&sequences[i], FALSE, &s);
+        run(&sequences[i], TRUE, &f);
+        shadowed += s.bytes;
+        full += f.bytes;
+
+        printf("%-18s %5u  %7u  %6.0f  %6.0f  %6.1f %6.1f  %6.2f %5.2f  %5.1fx\n",
+            sequences[i].name, s.ticks, s.updates, per(s.bytes, s.updates), per(f.bytes, f.updates),
+            per(s.bytes, s.ticks), per(f.bytes, f.ticks),
+            per(s.bytes, s.ticks) * BYTE_NS / 1e6, per(f.bytes, f.ticks) * BYTE_NS / 1e6,
+            per(f.bytes, s.bytes));
+
+        if (s.bytes > f.bytes)
+        {
+            printf("  %s: the shadow costs more bytes than full rewrites\n", sequences[i].name);
+            failures++;
+        }
+    }
+
+    printf("all sequences: %u LCD bus bytes shadowed, %u full (%.1fx)\n", shadowed, full, per(full, shadowed));
+    if (shadowed * MIN_GAIN > full)
+    {
+        printf("  the shadow saves less than half the bytes\n");
+        failures++;
+    }
+}
+
+int main(void)
+{
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    menuTickUs = (UInt64)Process_Menu_Clock->period * Clock_tickPeriod;
+    Host_Run(BOOT_US);
+
+    srand(1);
+    replay();
+    navigate();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* log_sim.c
+*-------------------------------------------------------------------------
+* Runs the USB data logger (logData() in Log.c) on the host shim and
+* reports what each logged row costs on the stick.
+*
+*   razor_log [-t seconds]
+*
+* Boot is main() on a blank NAND and a formatted stick, which is mounted
+* as the data logger screen does. Logging is then switched on for
+* <seconds> (default 600) of virtual time at the factory logging period.
+* The stick model (host_usb.c) charges every READ(10) and WRITE(10) a
+* command overhead plus a per-sector time.
+*
+* Per row, the program prints the disk_read and disk_write calls FatFs
+* made to the port, the USB commands the port issued for them through
+* its sector cache (usb_fatfs_port_usbmsc.c), and the bus time both
+* take; without the cache every call is one command. It also prints the
+* cache counters Log.c publishes.
+*
+* Afterwards the log file is read back through FatFs. The program fails
+* if no row was logged, if the file does not hold every row, or if the
+* cache does not at least halve the commands per row.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "host_usb.h"
+#include "host_fatfs.h"
+#include "Globals.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+extern uint32_t g_usbCacheHits;     // usb_fatfs_port_usbmsc.c
+extern uint32_t g_usbCacheMisses;
+extern uint32_t g_usbCacheFlushes;
+
+#define BOOT_US         10000000
+#define COMMAND_US      500         // host_usb.c defaults
+#define SECTOR_US       25
+#define MIN_GAIN        2.0
+
+static char line[512];
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_log: %s\n", what);
+    exit(1);
+}
+
+/// data rows in the day's log file under 0:PDI
+static UInt32 countRows(void)
+{
+    char path[80];
+    DIR dir;
+    FILINFO fno;
+    FIL f;
+    UInt32 rows = 0;
+
+    if (f_opendir(&dir, "0:PDI") != FR_OK) fail("no 0:PDI directory");
+    if (f_readdir(&dir, &fno) != FR_OK || fno.fname[0] == 0) fail("no log file");
+    sprintf(path, "0:PDI/%s", fno.fname);
+
+    if (f_open(&f, path, FA_READ) != FR_OK) fail("cannot open the log file");
+    while (f_gets(line, sizeof(line), &f))
+    {
+        if (line[0] >= '0' && line[0] <= '9') rows++;
+    }
+    f_close(&f);
+
+    return rows;
+}
+
+int main(int argc, char *argv[])
+{
+    Host_UsbStats usb;
+    Host_FfStats ff;
+    double seconds = 600.0, flatMs, busMs;
+    UInt32 i, rows, sectors, hits, misses, flushes;
+
+    for (i=1; i<(UInt32)argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i+1 < (UInt32)argc) seconds = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: razor_log [-t seconds]\n");
+            return 1;
+        }
+    }
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Ff_format();
+    Host_Usb_attach(TRUE);
+    Host_Usb_latency(COMMAND_US, SECTOR_US);
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    // as the data logger screen does
+    Swi_post(Swi_usbhMscDriveOpen);
+    Swi_post(Swi_enumerateUsb);
+    Host_Run(BOOT_US);
+    if (!isUsbMounted) fail("stick not mounted");
+
+    Host_Usb_resetStats();
+    Host_Ff_resetStats();
+    hits = g_usbCacheHits;
+    misses = g_usbCacheMisses;
+    flushes = g_usbCacheFlushes;
+
+    isLogData = TRUE;
+    usbStatus = 1;
+    Host_Run((UInt64)(seconds * 1e6));
+    isLogData = FALSE;
+    Host_Run(2000000);
+
+    Host_Usb_stats(&usb);
+    Host_Ff_stats(&ff);
+    hits = g_usbCacheHits - hits;
+    misses = g_usbCacheMisses - misses;
+    flushes = g_usbCacheFlushes - flushes;
+
+    rows = countRows();
+    if (rows == 0) fail("no row logged");
+
+    sectors = ff.winReads + ff.winWrites + ff.dataReads + ff.dataWrites;
+    flatMs = (ff.requests * (double)COMMAND_US + sectors * (double)SECTOR_US) / 1000.0;
+    busMs = usb.busNs / 1e6;
+
+    printf("%u rows in %.0f s, logging period %u s; %u us per command, %u us per sector\n\n",
+        rows, seconds, (UInt32)REG_LOGGING_PERIOD, COMMAND_US, SECTOR_US);
+    printf("per row           port calls   USB commands   bus ms\n");
+    printf("without cache     %10.2f   %12.2f   %6.2f\n",
+        ff.requests / (double)rows, ff.requests / (double)rows, flatMs / rows);
+    printf("with cache        %10.2f   %12.2f   %6.2f\n",
+        ff.requests / (double)rows, (usb.reads + usb.writes) / (double)rows, busMs / rows);
+    printf("\ncache: %u hits, %u misses, %u write-backs; %u CTRL_SYNC\n", hits, misses, flushes, ff.syncs);
+
+    // up to 7 rows wait in DATA_BUF
+    if (rows + 8 < seconds / REG_LOGGING_PERIOD) fail("rows missing from the log file");
+    if ((usb.reads + usb.writes) * MIN_GAIN > ff.requests) fail("the cache saves less than half the commands");
+
+    return 0;
+}
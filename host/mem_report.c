@@ -0,0 +1,256 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* mem_report.c
+*-------------------------------------------------------------------------
+* Runs the firmware on the host shim through a day in the life of a unit
+* and prints what the memory monitor (MemMonitor.c) publishes in
+* REG_MEM[] after every stage: the stack, heap and bump allocator
+* reservations of PDI_Razor.cfg, their peak and current use.
+*
+*   razor_mem
+*
+* The stages are idle after boot, a random walk of WALK_PRESSES button
+* presses through the menu, USB logging with a CSV scan, and Modbus
+* traffic. The host has no Idle loop, so the program calls
+* Mem_Monitor_Idle() where the Idle task would, once per stage, more
+* than MEM_PERIOD_S apart. The last table is read back over Modbus from
+* the extended block at MB_MEM, two registers a word.
+*
+* The task stacks are host stacks, painted by the shim as SYS/BIOS
+* paints them, but their frames are x86-64 frames: the peaks show which
+* work goes deep and how far the reservations are from it, not the
+* depth on the C674x. HWIs and SWIs run on the stack of whatever they
+* interrupt on the host, and the TI libraries that take blocks from
+* sysHeap are host models, so those words read zero here.
+*
+* The program fails if a peak ever drops, if a stack is used up to its
+* last word, if an allocation failed, or if Modbus does not return what
+* REG_MEM[] holds.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "host_usb.h"
+#include "host_fatfs.h"
+#include "Globals.h"
+#include "PDI_I2C.h"
+#include "Menu.h"
+#include "MemMonitor.h"
+#include "CsvIndex.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define SLAVE           1           // factory default REG_SLAVE_ADDRESS
+#define MB_WATERCUT     3           // ModbusTables.h
+#define MB_MEM          64393
+#define BOOT_US         10000000
+#define STAGE_US        ((MEM_PERIOD_S + 1) * 1000000)
+#define LOG_US          60000000
+#define WALK_PRESSES    300
+#define MB_REQUESTS     200
+#define NUM_STAGES      4
+
+static const char *STAGE_NAME[NUM_STAGES] = {"idle", "menu walk", "usb log+scan", "modbus"};
+
+static const struct
+{
+    const char  *name;
+    int         size, used, peak, fails;    // REG_MEM[] words, -1 if none
+} ROWS[] =
+{
+    {"Menu_task stack",     MEM_MENU_STACK, -1,             MEM_MENU_PEAK,  -1},
+    {"logData_task stack",  MEM_LOG_STACK,  -1,             MEM_LOG_PEAK,   -1},
+    {"Idle stack",          MEM_IDLE_STACK, -1,             MEM_IDLE_PEAK,  -1},
+    {"HWI/SWI stack",       MEM_HWI_STACK,  -1,             MEM_HWI_PEAK,   -1},
+    {"sysHeap",             MEM_HEAP_SIZE,  MEM_HEAP_USED,  MEM_HEAP_PEAK,  MEM_HEAP_FAILS},
+    {"UTIL_allocMem",       MEM_BUMP_SIZE,  MEM_BUMP_USED,  MEM_BUMP_PEAK,  MEM_BUMP_FAILS},
+};
+
+#define NUM_ROWS        (sizeof(ROWS) / sizeof(ROWS[0]))
+
+static double mem[NUM_STAGES][MEM_WORDS];
+static int failures;
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_mem: %s\n", what);
+    exit(1);
+}
+
+static void publish(int stage)
+{
+    Host_Run(STAGE_US);
+    Mem_Monitor_Idle();
+    memcpy(mem[stage], REG_MEM, sizeof(mem[stage]));
+}
+
+/// random presses of the four buttons, each held over a button scan
+static int walk(void)
+{
+    static const UInt8 BTN[] = {I2C_BUTTON_S, I2C_BUTTON_E, I2C_BUTTON_B, I2C_BUTTON_V};
+    UInt64 tickUs = (UInt64)Process_Menu_Clock->period * Clock_tickPeriod;
+    static Bool seen[65536];
+    int i, screens = 0;
+
+    srand(46);
+    for (i=0; i<WALK_PRESSES; i++)
+    {
+        Host_Buttons_set(BTN[rand() % 4]);
+        Host_Run(2 * tickUs);
+        Host_Buttons_set(I2C_BUTTON_NONE);
+        Host_Run(10 * tickUs);
+
+        if (!seen[MENU.state]) screens++;
+        seen[MENU.state] = TRUE;
+    }
+
+    return screens;
+}
+
+static void usbLog(void)
+{
+    Swi_post(Swi_usbhMscDriveOpen);
+    Swi_post(Swi_enumerateUsb);
+    Host_Run(BOOT_US);
+    if (!isUsbMounted) fail("stick not mounted");
+
+    isLogData = TRUE;
+    usbStatus = 1;
+    Host_Run(LOG_US);
+    isLogData = FALSE;
+
+    Csv_Index_Request();
+    Host_Run(BOOT_US);
+}
+
+static void modbus(void)
+{
+    float f;
+    int i;
+
+    for (i=0; i<MB_REQUESTS; i++)
+    {
+        if (!Host_Mb_readFloat(SLAVE, MB_WATERCUT, &f)) fail("no Modbus reply");
+    }
+}
+
+static void printCell(double v, Bool ok)
+{
+    if (ok) printf(" %12.0f", v);
+    else printf(" %12s", "-");
+}
+
+static void report(void)
+{
+    UInt32 r;
+    int s;
+
+    printf("REG_MEM[] after each stage, bytes; - where the host does not model it\n\n");
+    printf("%-20s %12s", "", "size");
+    for (s=0; s<NUM_STAGES; s++) printf(" %12s", STAGE_NAME[s]);
+    printf(" %7s\n", "peak %");
+
+    for (r=0; r<NUM_ROWS; r++)
+    {
+        const double *last = mem[NUM_STAGES-1];
+        Bool ok = last[ROWS[r].size] > 0;
+
+        printf("%-20s", ROWS[r].name);
+        printCell(last[ROWS[r].size], ok);
+        for (s=0; s<NUM_STAGES; s++) printCell(mem[s][ROWS[r].peak], ok);
+        if (ok) printf(" %7.2f\n", last[ROWS[r].peak] / last[ROWS[r].size] * 100);
+        else printf(" %7s\n", "-");
+
+        if (ROWS[r].used >= 0)
+        {
+            printf("%-20s %12s", "  in use", "");
+            for (s=0; s<NUM_STAGES; s++) printCell(mem[s][ROWS[r].used], ok);
+            printf("\n%-20s %12s", "  failed", "");
+            for (s=0; s<NUM_STAGES; s++) printf(" %12.0f", mem[s][ROWS[r].fails]);
+            printf("\n");
+        }
+    }
+}
+
+static void check(void)
+{
+    float f;
+    UInt32 r;
+    int s, i, bad = 0;
+
+    for (r=0; r<NUM_ROWS; r++)
+    {
+        for (s=1; s<NUM_STAGES; s++)
+        {
+            if (mem[s][ROWS[r].peak] >= mem[s-1][ROWS[r].peak]) continue;
+            printf("  %s: the peak dropped\n", ROWS[r].name);
+            failures++;
+            break;
+        }
+
+        if (mem[NUM_STAGES-1][ROWS[r].size] > 0 && mem[NUM_STAGES-1][ROWS[r].peak] >= mem[NUM_STAGES-1][ROWS[r].size])
+        {
+            printf("  %s: used up\n", ROWS[r].name);
+            failures++;
+        }
+        if (ROWS[r].fails >= 0 && mem[NUM_STAGES-1][ROWS[r].fails] != 0)
+        {
+            printf("  %s: allocations failed\n", ROWS[r].name);
+            failures++;
+        }
+    }
+
+    for (i=0; i<MEM_WORDS; i++)
+    {
+        if (!Host_Mb_readFloat(SLAVE, MB_MEM + 2*i, &f) || f != (float)REG_MEM[i]) bad++;
+    }
+    if (bad)
+    {
+        printf("  %d REG_MEM[] words read back wrong over Modbus\n", bad);
+        failures++;
+    }
+}
+
+int main(void)
+{
+    int screens;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Ff_format();
+    Host_Usb_attach(TRUE);
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    publish(0);
+    screens = walk();
+    publish(1);
+    usbLog();
+    publish(2);
+    modbus();
+    publish(3);
+
+    printf("menu walk: %d presses, %d menu states\n", WALK_PRESSES, screens);
+    report();
+    check();
+
+    return failures ? 1 : 0;
+}
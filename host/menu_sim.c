@@ -0,0 +1,592 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* menu_sim.c
+*-------------------------------------------------------------------------
+* Runs the unmodified menu.c on the host shim. The display and buttons
+* are PDI_i2C.c driving the LCD and MBVE expander models over the I2C
+* model (host_dev.h), so what is measured is the firmware's own renderer
+* and button scan, bus traffic included.
+*
+*   razor_menu [-n presses] [-w]
+*
+* Boot is main() on a blank NAND (factory defaults), followed by the
+* logo. The measurement side runs as on the target and shares the I2C
+* bus with the display and the buttons. Then:
+*
+*  - idle: 60 s on the Watercut homescreen, CPU and LCD expander bus
+*    bytes per menu tick.
+*  - keys: <presses> (default 50) VALUE presses through the homescreens,
+*    each at a different phase of the menu tick and of the button scan.
+*    Key-to-render latency is the virtual time from the button going
+*    down to the end of the first Menu_task tick that runs the new
+*    state's function, i.e. the tick that draws it.
+*  - walk (-w skips it): every button in every state reachable from the
+*    Watercut homescreen, with coverage counted against MENU_TABLE. Each
+*    press runs in a fork() of the simulator, with its own copy of the
+*    register blocks (Host_Mmio_fork), so a state is explored from an
+*    exact copy of the system that reached it and changed settings do not
+*    leak between branches. A state is explored again for a new
+*    screen (edit mode, the value or option shown) up to WALK_VARIANTS
+*    times, and always for a new value of a setting the tree branches
+*    on; that is how the states behind the density, relay and AO options
+*    are reached. The walk runs unlocked, as after the passcode, with a
+*    temperature alarm active and an oil capture on stream 1, which the
+*    measurement side would normally provide. A press that does not come
+*    back within WALK_PRESS_LIMIT of wall time is reported as a spin: on
+*    the target that is the watchdog reset (restart and factory reset
+*    confirm).
+*
+* CPU times are host times of the firmware C code, not C674x cycles; use
+* them to compare builds, not as a budget.
+*------------------------------------------------------------------------*/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#define truncate unistd_truncate	// Globals.h has its own truncate()
+#include <unistd.h>
+#undef truncate
+#include <xdc/cfg/global.h>
+#include "Globals.h"
+#include "PDI_I2C.h"
+#include "Menu.h"
+#include "host_dev.h"
+
+/* menu.c; Menu.h only declares it for menu.c itself */
+extern MENU_STATE MENU_TABLE[];
+
+int Razor_main(void);				// main.c, renamed by the Makefile
+
+#define BOOT_US				5000000		// logo is 21 menu ticks
+#define IDLE_US				60000000
+#define SETTLE_TICKS		10			// one blink period; a message takes 8
+#define SETTLE_MAX			40
+#define WALK_PRESS_LIMIT	2000000		// wall microseconds
+#define WALK_VARIANTS		4			// screens explored per state
+#define WALK_SETTINGS		4			// see branchSetting()
+#define WALK_TABLE_SIZE		(1 << 17)	// screen and budget keys, power of two
+#define WALK_MAX_NOTES		64
+
+#define LCD_LINES			2
+#define LCD_WIDTH			16
+
+static const UInt8 btnMask[4] = {I2C_BUTTON_S, I2C_BUTTON_V, I2C_BUTTON_E, I2C_BUTTON_B};
+static const char *btnName[4] = {"STEP", "VALUE", "ENTER", "BACK"};
+
+typedef struct
+{
+	UInt64	key;
+	UInt32	n;
+} WALK_SLOT;
+
+typedef struct
+{
+	Uint16	from;
+	Uint16	to;
+	Uint8	btn;
+} WALK_NOTE;
+
+/* shared by every process of the walk */
+typedef struct
+{
+	Uint8		reached[MAX_MENU_STATE+1];
+	WALK_SLOT	table[WALK_TABLE_SIZE];
+	UInt32		used;
+	UInt32		numScreens;
+	UInt32		presses;
+	int			numSpin;
+	WALK_NOTE	spin[WALK_MAX_NOTES];
+	int			numBlank;
+	WALK_NOTE	blank[WALK_MAX_NOTES];
+	int			numNoRow;
+	WALK_NOTE	noRow[WALK_MAX_NOTES];
+	int			numFail;
+} WALK;
+
+static WALK *walk;
+static UInt64 menuTickUs;
+
+/* screen after the last press, over one blink period */
+static char screen[LCD_LINES][LCD_WIDTH];
+
+/// what is on the glass: 16 characters and a terminating 0
+static const char *lcdLine(int line)
+{
+	static Host_LcdState lcd;
+
+	Host_Lcd_get(&lcd);
+	return lcd.line[line];
+}
+
+/// bus bytes to and from the LCD expander since boot
+static UInt32 lcdBytes(void)
+{
+	return Host_I2c_find(I2C_SLAVE_ADDR_XPANDR)->bytes;
+}
+
+static void note(WALK_NOTE *list, int *n, Uint16 from, Uint16 to, int btn)
+{
+	int i;
+
+	for (i=0; i<*n && i<WALK_MAX_NOTES; i++)
+		if (list[i].from == from && list[i].to == to && list[i].btn == btn) return;
+
+	if (*n < WALK_MAX_NOTES)
+	{
+		list[*n].from = from;
+		list[*n].to = to;
+		list[*n].btn = (Uint8)btn;
+	}
+	(*n)++;
+}
+
+static Bool inMenuTable(Uint16 state)
+{
+	int i;
+
+	for (i=0; MENU_TABLE[i].state != 0; i++)
+		if (MENU_TABLE[i].state == state) return TRUE;
+
+	return FALSE;
+}
+
+static Bool lcdBlank(void)
+{
+	int i, line;
+
+	for (line=0; line<LCD_LINES; line++)
+		for (i=0; i<LCD_WIDTH; i++)
+			if (screen[line][i] != ' ') return FALSE;
+
+	return TRUE;
+}
+
+/// keep the last character other than a space in every position, so a
+/// blinking field counts as shown
+static void collectScreen(void)
+{
+	int i, line;
+	char c;
+
+	for (line=0; line<LCD_LINES; line++)
+	{
+		for (i=0; i<LCD_WIDTH; i++)
+		{
+			c = lcdLine(line)[i];
+			if (c != ' ') screen[line][i] = c;
+		}
+	}
+}
+
+/* kinds of key in the walk table */
+#define KEY_SCREEN			0
+#define KEY_BUDGET			1
+#define KEY_SETTING			2
+
+static UInt64 fnv(UInt64 h, UInt32 v)
+{
+	return (h ^ v) * 0x100000001b3ull;
+}
+
+static UInt64 stateKey(int kind)
+{
+	return fnv(fnv(0xcbf29ce484222325ull, kind), MENU.state);
+}
+
+/// the settings the menu tree branches on
+static UInt32 branchSetting(int i)
+{
+	switch (i)
+	{
+		case 0 : return REG_RELAY_MODE;
+		case 1 : return REG_AO_MODE;
+		case 2 : return REG_OIL_DENS_CORR_MODE;
+		default: return REG_STATISTICS;
+	}
+}
+
+/// the state, the cursor mode, the branch settings and the screen
+/// without the blinking menu id
+static UInt64 screenKey(void)
+{
+	UInt64 h = stateKey(KEY_SCREEN);
+	int i, line, col;
+	char c;
+
+	h = fnv(h, MENU.curStat & LCD_CURS_ON);
+	for (i=0; i<WALK_SETTINGS; i++) h = fnv(h, branchSetting(i));
+
+	for (line=0; line<LCD_LINES; line++)
+	{
+		for (col=0; col<LCD_WIDTH; col++)
+		{
+			c = screen[line][col];
+			if (line == 0 && col == MENU.pos) c = ' ';
+			h = fnv(h, (Uint8)c);
+		}
+	}
+	return h;
+}
+
+/// counter for <key> in the shared table, NULL once the table is full
+static UInt32 *walkCount(UInt64 key)
+{
+	UInt32 i;
+
+	if (key == 0) key = 1;
+
+	for (i = (UInt32)key & (WALK_TABLE_SIZE-1); walk->table[i].key; i = (i+1) & (WALK_TABLE_SIZE-1))
+		if (walk->table[i].key == key) return &walk->table[i].n;
+
+	if (walk->used >= WALK_TABLE_SIZE / 2) return NULL;
+
+	walk->used++;
+	walk->table[i].key = key;
+	return &walk->table[i].n;
+}
+
+/// TRUE when the screen just reached is new and either its state has
+/// budget left or it is the first time the state is seen with one of the
+/// branch settings at this value. Budgeting the settings one at a time
+/// instead of as a tuple keeps the walk linear in the number of options.
+static Bool worthExploring(void)
+{
+	UInt32 *seen = walkCount(screenKey());
+	UInt32 *budget = walkCount(stateKey(KEY_BUDGET));
+	UInt32 *pair;
+	Bool newPair = FALSE;
+	int i;
+
+	if (!seen || !budget || *seen) return FALSE;
+
+	for (i=0; i<WALK_SETTINGS; i++)
+	{
+		pair = walkCount(fnv(fnv(stateKey(KEY_SETTING), i), branchSetting(i)));
+		if (pair && !*pair)
+		{
+			*pair = 1;
+			newPair = TRUE;
+		}
+	}
+
+	if (!newPair && *budget >= WALK_VARIANTS) return FALSE;
+
+	(*seen)++;
+	(*budget)++;
+	walk->numScreens++;
+	return TRUE;
+}
+
+/// two menu ticks down covers a full button scan (900 ticks) plus the
+/// tick that sees it. After the release the menu runs until the state has
+/// held for SETTLE_TICKS ticks, so a confirm or cancel message has gone
+/// back to its menu, and the screen is collected over those ticks.
+static void press(int btn)
+{
+	Uint16 state;
+	int held = 0, ticks = 0;
+
+	Host_Buttons_set(btnMask[btn]);
+	Host_Run(2 * menuTickUs);
+	Host_Buttons_set(I2C_BUTTON_NONE);
+
+	state = MENU.state;
+	memset(screen, ' ', sizeof(screen));
+
+	while (held < SETTLE_TICKS && ticks++ < SETTLE_MAX)
+	{
+		Host_Run(menuTickUs);
+
+		if (MENU.state != state)
+		{
+			state = MENU.state;
+			held = 0;
+			memset(screen, ' ', sizeof(screen));
+			continue;
+		}
+
+		collectScreen();
+		held++;
+	}
+}
+
+static void boot(void)
+{
+	Host_Dev_Init();
+	Host_Nand_blank();
+	Host_Cfg_Create();
+	Razor_main();
+
+	menuTickUs = (UInt64)Process_Menu_Clock->period * Clock_tickPeriod;
+
+	Host_Run(BOOT_US);
+}
+
+/// the HD44780 font above 0x7E (degree sign, arrows) prints as '.'
+static void showLcd(const char *label)
+{
+	char text[LCD_WIDTH+1];
+	int i, line;
+
+	for (line=0; line<LCD_LINES; line++)
+	{
+		for (i=0; i<=LCD_WIDTH; i++)
+		{
+			text[i] = lcdLine(line)[i];
+			if (text[i] && (text[i] < ' ' || text[i] > '~')) text[i] = '.';
+		}
+		printf("%-10s [%s]\n", line ? "" : label, text);
+	}
+}
+
+static void idle(void)
+{
+	Host_Stats *st = &Menu_task->st;
+	UInt32 bytes = lcdBytes();
+
+	Host_Stats_reset();
+	Host_Run(IDLE_US);
+	bytes = lcdBytes() - bytes;
+
+	printf("idle: %u menu ticks, %.2f us avg %.2f us max per tick, %.1f LCD bus bytes per tick\n",
+		st->runs, st->runs ? st->ns / 1e3 / st->runs : 0.0, st->maxNs / 1e3,
+		st->runs ? (double)bytes / st->runs : 0.0);
+}
+
+static void keys(int presses)
+{
+	Host_Stats *st = &Menu_task->st;
+	UInt64 t0, lat, latMin = ~0ull, latMax = 0, latSum = 0;
+	UInt32 runs, bytes;
+	Uint16 from;
+	int i, done = 0, missed = 0;
+
+	Host_Stats_reset();
+	bytes = lcdBytes();
+
+	for (i=0; i<presses; i++)
+	{
+		// walk the press across the menu tick and the 900 tick button scan
+		Host_Run(1 + (UInt64)i * 7919 % menuTickUs);
+
+		from = MENU.state;
+		t0 = Host_Now();
+		Host_Buttons_set(I2C_BUTTON_V);
+
+		while (MENU.state == from && Host_Now() - t0 < 4 * menuTickUs) Host_Run(Clock_tickPeriod);
+
+		if (MENU.state == from)
+		{
+			missed++;
+		}
+		else
+		{
+			// MENU.state changes at the end of a tick; the next one draws
+			runs = st->runs;
+			while (st->runs == runs) Host_Run(Clock_tickPeriod);
+
+			lat = Host_Now() - t0;
+			if (lat < latMin) latMin = lat;
+			if (lat > latMax) latMax = lat;
+			latSum += lat;
+			done++;
+		}
+
+		Host_Buttons_set(I2C_BUTTON_NONE);
+		Host_Run(2 * menuTickUs);
+	}
+
+	bytes = lcdBytes() - bytes;
+
+	printf("keys: %d VALUE presses, %d missed, key-to-render %.1f ms min %.1f ms avg %.1f ms max\n",
+		presses, missed, done ? latMin / 1e3 : 0.0, done ? latSum / 1e3 / done : 0.0, latMax / 1e3);
+	printf("      %u menu ticks, %.2f us avg %.2f us max per tick, %.1f LCD bus bytes per tick\n",
+		st->runs, st->runs ? st->ns / 1e3 / st->runs : 0.0, st->maxNs / 1e3,
+		st->runs ? (double)bytes / st->runs : 0.0);
+}
+
+/// try every button from the current state, each in its own fork, and
+/// continue from every state not seen before
+static void explore(void)
+{
+	static const struct itimerval limit = {{0, 0}, {WALK_PRESS_LIMIT / 1000000, WALK_PRESS_LIMIT % 1000000}};
+	static const struct itimerval off;
+	Uint16 from = MENU.state;
+	Uint16 to;
+	pid_t pid;
+	int btn, status;
+
+	for (btn=0; btn<4; btn++)
+	{
+		fflush(stdout);
+		pid = fork();
+
+		if (pid < 0)
+		{
+			walk->numFail++;
+			return;
+		}
+
+		if (pid == 0)
+		{
+			Host_Mmio_fork();
+			setitimer(ITIMER_REAL, &limit, NULL);
+			press(btn);
+			setitimer(ITIMER_REAL, &off, NULL);
+
+			walk->presses++;
+			to = MENU.state;
+
+			if (to > MAX_MENU_STATE || !inMenuTable(to)) note(walk->noRow, &walk->numNoRow, from, to, btn);
+			else
+			{
+				if (!walk->reached[to])
+				{
+					walk->reached[to] = 1;
+					if (lcdBlank()) note(walk->blank, &walk->numBlank, from, to, btn);
+				}
+				if (worthExploring()) explore();
+			}
+			_exit(0);
+		}
+
+		if (waitpid(pid, &status, 0) < 0) walk->numFail++;
+		else if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) note(walk->spin, &walk->numSpin, from, 0, btn);
+		else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) walk->numFail++;
+	}
+}
+
+static void printNotes(const char *what, WALK_NOTE *list, int n, Bool showTo)
+{
+	int i;
+
+	if (n == 0) return;
+	printf("      %d %s:", n, what);
+	for (i=0; i<n && i<WALK_MAX_NOTES; i++)
+	{
+		if (showTo) printf(" %u-%s->%u", list[i].from, btnName[list[i].btn], list[i].to);
+		else printf(" %u-%s", list[i].from, btnName[list[i].btn]);
+	}
+	printf("\n");
+}
+
+static int walkAll(void)
+{
+	static Uint8 counted[MAX_MENU_STATE+1];
+	int i, states = 0, reached = 0, n = 0;
+	UInt64 wall;
+
+	walk = mmap(NULL, sizeof(WALK), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (walk == MAP_FAILED)
+	{
+		perror("razor_menu: mmap");
+		return 1;
+	}
+	memset(walk, 0, sizeof(WALK));
+
+	// back to the Watercut homescreen the way a user would
+	while (MENU.state != MNU_HOMESCREEN_WTC && n++ < 16) press(BTN_BACK);
+	while (MENU.state != MNU_HOMESCREEN_WTC && n++ < 32) press(BTN_VALUE);
+	if (MENU.state != MNU_HOMESCREEN_WTC)
+	{
+		fprintf(stderr, "razor_menu: cannot get back to the Watercut homescreen (state %u)\n", MENU.state);
+		return 1;
+	}
+
+	// as after the technician has entered the passcode; locked, every
+	// FXN state of the configuration menu only shows "Locked"
+	COIL_UNLOCKED.val = TRUE;
+
+	// what Calculate.c would have left behind: an active alarm for the
+	// diagnostics screens and an oil capture on stream 1 for the sample ones
+	DIAGNOSTICS = ERR_TMP_HI;
+	// the row is exactly as wide as the text; Calculate.c's terminator
+	// lands in the next row
+	memcpy(STREAM_TIMESTAMP[0], "12:00 01/01/2024", MAX_LCD_WIDTH);
+
+
+	wall = Host_Ns();
+	walk->reached[MNU_HOMESCREEN_WTC] = 1;
+	memset(screen, ' ', sizeof(screen));
+	collectScreen();
+	worthExploring();
+	explore();
+	wall = Host_Ns() - wall;
+
+	for (i=0; MENU_TABLE[i].state != 0; i++)
+	{
+		if (counted[MENU_TABLE[i].state]) continue;
+		counted[MENU_TABLE[i].state] = 1;
+		states++;
+		if (walk->reached[MENU_TABLE[i].state]) reached++;
+	}
+
+	printf("walk: %u presses, %u screens in %.1f s wall, %d of %d MENU_TABLE states reached\n",
+		walk->presses, walk->numScreens, wall / 1e9, reached, states);
+
+	if (reached < states)
+	{
+		printf("      not reached:");
+		for (i=0; MENU_TABLE[i].state != 0; i++)
+		{
+			if (counted[MENU_TABLE[i].state] != 1) continue;
+			counted[MENU_TABLE[i].state] = 2;
+			if (!walk->reached[MENU_TABLE[i].state]) printf(" %u", MENU_TABLE[i].state);
+		}
+		printf("\n");
+	}
+
+	printNotes("spins (watchdog reset on the target)", walk->spin, walk->numSpin, FALSE);
+	printNotes("blank displays", walk->blank, walk->numBlank, TRUE);
+	printNotes("transitions to a state without a MENU_TABLE row", walk->noRow, walk->numNoRow, TRUE);
+	if (walk->numFail) printf("      %d presses crashed\n", walk->numFail);
+
+	return (walk->numBlank || walk->numNoRow || walk->numFail) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, presses = 50, rc = 0;
+	Bool doWalk = TRUE;
+
+	for (i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i+1 < argc) presses = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0) doWalk = FALSE;
+		else
+		{
+			fprintf(stderr, "usage: razor_menu [-n presses] [-w]\n");
+			return 1;
+		}
+	}
+
+	boot();
+	showLcd("boot");
+	idle();
+	showLcd("home");
+	keys(presses);
+
+	if (doWalk) rc = walkAll();
+
+	printf("\n");
+	Host_Report(stdout);
+
+	return rc;
+}
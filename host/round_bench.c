@@ -0,0 +1,395 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* round_bench.c
+*-------------------------------------------------------------------------
+* Compares the rounding and formatting helpers of Globals.c with
+* reference implementations, and measures them.
+*
+*   razor_round
+*
+* Legacy: Round_N, Round_N_Float, sigfig and truncate must return, bit
+* for bit, what the pow()/modf() versions they replaced returned (copied
+* below as old*), on NUM_LEGACY random doubles and floats at every n.
+*
+* Decimal: NUM_DECIMAL values are made from a random decimal mantissa of
+* 1 to 9 digits (half of them ending in 5, so that ties come up) and a
+* random exponent, and read with strtod(). Rounding that decimal by hand,
+* half up and half to even, gives the reference. Round_N_Even,
+* Round_N_Float_Even (on values of at most 6 digits) and sigfig_Even must
+* match it at every n, and fmtDouble and fmtDouble_Even at every sig
+* where they do not defer to sprintf() (%g prints an exponent). Round_N keeps its legacy
+* behaviour; the ties it rounds down are counted, not failed.
+*
+* Then it times the old functions, the table-based ones and sprintf("%g")
+* over the same values. The rates are host rates, not C674x ones; use
+* them to compare builds.
+*
+* The program fails on any mismatch.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+
+#define NUM_LEGACY      2000000
+#define NUM_DECIMAL     1000000
+#define BENCH_CALLS     4000000
+#define NUM_BENCH       4096
+
+static const UInt64 P10[] =
+{
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull
+};
+
+static int failures;
+static double bench[NUM_BENCH];
+static volatile double sink;
+static char text[64];
+
+/*============================================================================*/
+/*                        THE FUNCTIONS BEFORE THE TABLES                     */
+/*============================================================================*/
+
+static double oldRound_N(double v, int n)
+{
+    double a, ai;
+
+    if (n>6) return v;
+    else if (n<0) return v;
+
+    a = v*pow(10.0, (double)(n+1));
+
+    if(v<0.0) a -= 5.0;
+    else a += 5.0;
+
+    a /= 10.0;
+    modf(a, &ai);
+
+    return ai/pow(10.0, (double)n);
+}
+
+static float oldRound_N_Float(float v, int n)
+{
+    double a, ai;
+
+    if (n>6) return v;
+    else if (n<0) return v;
+
+    a = v*pow(10.0, (double)(n+1));
+
+    if(v<0.0) a -= 5.0;
+    else a += 5.0;
+
+    a /= 10.0;
+    modf(a, &ai);
+
+    return (float)(ai/pow(10.0, (double)n));
+}
+
+static double oldSigfig(double v, int n)
+{
+    int s;
+    double t;
+    double a;
+
+    if(n<1) return v;
+    else if (n>6) return v;
+    else if(v==0.0) return v;
+
+    if(v<0.0) s = -1;
+    else s = 1;
+
+    a = fabs(v);
+
+    t = pow(10.0, floor(log10(a))+1.0);
+
+    return (s*oldRound_N(a/t, n)*t);
+}
+
+static double oldTruncate(double v, int n)
+{
+    double a, ai;
+
+    if (n>6) return v;
+    else if (n<1) return v;
+
+    a = v*pow(10.0, (double)(n+1));
+
+    a /= 10.0;
+    modf(a, &ai);
+
+    return (ai/pow(10.0, (double)n));
+}
+
+/*============================================================================*/
+/*                                   CHECKS                                   */
+/*============================================================================*/
+
+static void mismatch(const char *what, double v, int n, const char *got, const char *want)
+{
+    if (failures++ < 10) printf("  MISMATCH %s(%.17g, %d): %s, expected %s\n", what, v, n, got, want);
+}
+
+static void same(const char *what, double v, int n, double got, double want)
+{
+    char g[32], w[32];
+
+    if (memcmp(&got, &want, sizeof(got)) == 0) return;
+    sprintf(g, "%.17g", got);
+    sprintf(w, "%.17g", want);
+    mismatch(what, v, n, g, w);
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * (rand() / (double)RAND_MAX);
+}
+
+static void checkLegacy(void)
+{
+    UInt32 i;
+    double v;
+    float f, got, want;
+    int n;
+
+    for (i=0; i<NUM_LEGACY; i++)
+    {
+        v = uniform(-1.0, 1.0) * pow(10.0, uniform(-6.0, 7.0));
+        f = (float)v;
+
+        for (n=-1; n<=7; n++)
+        {
+            same("Round_N", v, n, Round_N(v, n), oldRound_N(v, n));
+            same("sigfig", v, n, sigfig(v, n), oldSigfig(v, n));
+            same("truncate", v, n, truncate(v, n), oldTruncate(v, n));
+
+            got = Round_N_Float(f, n);
+            want = oldRound_N_Float(f, n);
+            if (memcmp(&got, &want, sizeof(got))) same("Round_N_Float", f, n, got, want);
+        }
+    }
+    printf("legacy:  %u random values, n = -1..7, %s\n", NUM_LEGACY, failures ? "FAILED" : "bit-exact");
+}
+
+/// m * 10^e rounded at 10^-n (n may be negative), ties up or to even
+static UInt64 decRound(UInt64 m, int e, int n, Bool even)
+{
+    UInt64 q, r, half;
+    int d = -n - e;
+
+    if (d <= 0) return m * P10[-d];
+    if (d > 18) return 0;
+
+    q = m / P10[d];
+    r = m % P10[d];
+    half = 5 * P10[d-1];
+    if (r > half || (r == half && (!even || (q & 1)))) q++;
+
+    return q;
+}
+
+/// q * 10^-n as a double, correctly rounded
+static double decValue(UInt64 q, int n, Bool neg)
+{
+    char buf[40];
+
+    sprintf(buf, "%s%llue%d", neg ? "-" : "", (unsigned long long)q, -n);
+    return strtod(buf, NULL);
+}
+
+/// q * 10^-n as %g would print it without an exponent
+static void decText(char *buf, UInt64 q, int n, Bool neg)
+{
+    char digits[32];
+    int len, k = 0;
+
+    if (neg && q != 0) buf[k++] = '-';
+    len = sprintf(digits, "%llu", (unsigned long long)q);
+
+    if (n <= 0)
+    {
+        memcpy(buf + k, digits, len);
+        k += len;
+        for (; n < 0; n++) buf[k++] = '0';
+        buf[k] = '\0';
+        return;
+    }
+
+    if (len <= n)
+    {
+        buf[k++] = '0';
+        buf[k++] = '.';
+        memset(buf + k, '0', n - len);
+        k += n - len;
+        memcpy(buf + k, digits, len);
+        k += len;
+    }
+    else
+    {
+        memcpy(buf + k, digits, len - n);
+        k += len - n;
+        buf[k++] = '.';
+        memcpy(buf + k, digits + len - n, n);
+        k += n;
+    }
+
+    while (buf[k-1] == '0') k--;
+    if (buf[k-1] == '.') k--;
+    buf[k] = '\0';
+}
+
+static void checkDecimal(void)
+{
+    UInt32 i, ties = 0, downs = 0, fmts = 0;
+    UInt64 m;
+    int e, n, digits, lead, sig, before = failures;
+    Bool neg;
+    double v, want, got;
+    float f;
+    char w[64];
+
+    for (i=0; i<NUM_DECIMAL; i++)
+    {
+        digits = 1 + rand() % 9;
+        m = (((UInt64)rand() << 31) | rand()) % P10[digits];
+        if (rand() & 1) m = m / 10 * 10 + 5;
+        if (m == 0) m = 5;
+        for (digits=1; m >= P10[digits]; digits++);
+
+        e = -10 + rand() % 13;
+        neg = rand() & 1;
+        v = decValue(m, -e, neg);
+        lead = digits - 1 + e;
+
+        for (n=0; n<=6; n++)
+        {
+            want = decValue(decRound(m, e, n, TRUE), n, neg);
+            same("Round_N_Even", v, n, Round_N_Even(v, n), want);
+
+            /// a float carries 6 digits
+            if (digits <= 6 && lead <= 6 - n && lead >= -4)
+            {
+                f = (float)v;
+                got = Round_N_Float_Even(f, n);
+                if ((float)want != (float)got) same("Round_N_Float_Even", f, n, (float)got, (float)want);
+            }
+
+            if (e < -n && -n - e <= 18 && m % P10[-n - e] == 5 * P10[-n - e - 1])
+            {
+                ties++;
+                want = decValue(decRound(m, e, n, FALSE), n, neg);
+                if (Round_N(v, n) != want) downs++;
+            }
+
+            if (n >= 1 && v != 0.0)
+            {
+                want = decValue(decRound(m, e, n - 1 - lead, TRUE), n - 1 - lead, neg);
+                got = sigfig_Even(v, n);
+                if (fabs(got - want) > 4.0 * DBL_EPSILON * fabs(want))
+                {
+                    char g[32], ws[32];
+                    sprintf(g, "%.17g", got);
+                    sprintf(ws, "%.17g", want);
+                    mismatch("sigfig_Even", v, n, g, ws);
+                }
+            }
+        }
+
+        /// fmtDouble defers to sprintf() where %g prints an exponent
+        for (sig=1; sig<=9; sig++)
+        {
+            if (fabs(v) < 1e-4 || fabs(v) >= pow(10.0, sig)) continue;
+            fmtDouble(text, v, sig);
+            if (strchr(text, 'e')) continue;
+            fmts++;
+
+            decText(w, decRound(m, e, sig - 1 - lead, FALSE), sig - 1 - lead, neg);
+            if (strcmp(text, w)) mismatch("fmtDouble", v, sig, text, w);
+
+            decText(w, decRound(m, e, sig - 1 - lead, TRUE), sig - 1 - lead, neg);
+            fmtDouble_Even(text, v, sig);
+            if (strcmp(text, w)) mismatch("fmtDouble_Even", v, sig, text, w);
+        }
+    }
+
+    printf("decimal: %u values, %u formats, %s; Round_N rounded %u of %u ties down (legacy)\n",
+        NUM_DECIMAL, fmts, failures > before ? "FAILED" : "exact", downs, ties);
+}
+
+/*============================================================================*/
+/*                                 BENCHMARK                                  */
+/*============================================================================*/
+
+static void bOldRound(double v)   { sink = oldRound_N(v, 3); }
+static void bRound(double v)      { sink = Round_N(v, 3); }
+static void bRoundEven(double v)  { sink = Round_N_Even(v, 3); }
+static void bOldSigfig(double v)  { sink = oldSigfig(v, 4); }
+static void bSigfig(double v)     { sink = sigfig(v, 4); }
+static void bSigfigEven(double v) { sink = sigfig_Even(v, 4); }
+static void bSprintf(double v)    { sink = sprintf(text, "%.6g", v); }
+static void bFmt(double v)        { sink = fmtDouble(text, v, 6); }
+static void bFmtEven(double v)    { sink = fmtDouble_Even(text, v, 6); }
+
+/// calls per second of <fxn>
+static double rate(void (*fxn)(double))
+{
+    UInt64 ns = Host_Ns();
+    UInt32 i;
+
+    for (i=0; i<BENCH_CALLS; i++) fxn(bench[i % NUM_BENCH]);
+    ns = Host_Ns() - ns;
+
+    return ns ? BENCH_CALLS * 1e9 / ns : 0.0;
+}
+
+static void row(const char *name, void (*old)(double), void (*half)(double), void (*even)(double))
+{
+    double o = rate(old), h = rate(half), e = rate(even);
+
+    printf("%-10s %10.2f %12.2f %12.2f %8.1fx\n", name, o / 1e6, h / 1e6, e / 1e6, h / o);
+}
+
+static void benchmark(void)
+{
+    UInt32 i;
+
+    for (i=0; i<NUM_BENCH; i++) bench[i] = uniform(-1.0, 1.0) * pow(10.0, uniform(-3.0, 5.0));
+
+    printf("\nMcalls/s   old/%%g   table half-up   table even   speed-up\n");
+    row("Round_N", bOldRound, bRound, bRoundEven);
+    row("sigfig", bOldSigfig, bSigfig, bSigfigEven);
+    row("fmtDouble", bSprintf, bFmt, bFmtEven);
+}
+
+int main(void)
+{
+    Host_Dev_Init();
+
+    srand(1);
+    checkLegacy();
+    checkDecimal();
+    benchmark();
+
+    return failures ? 1 : 0;
+}
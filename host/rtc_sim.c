@@ -0,0 +1,182 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* rtc_sim.c
+*-------------------------------------------------------------------------
+* Runs the time service (RtcTime.c, fed by the Read_RTC link of the I2C
+* daisy chain) on the host shim against a drifting DS1340 model, and
+* reports the RTC traffic and how closely the disciplined time follows
+* the RTC.
+*
+*   razor_rtc
+*
+* For each pair of REG_RTC_SYNC_PERIOD and RTC oscillator error the
+* program sets the RTC to 23:55 on New Year's Eve, restarts the service
+* and runs RUN_US of virtual time, so the day, month and year roll over.
+* Every SAMPLE_US it reads RTC_Time_Epoch() as a consumer would and
+* compares it with the RTC's own time to the microsecond (host_i2c.c runs
+* the model on virtual time scaled by the error). It also checks that
+* REG_RTC_EPOCH and the broken-down REG_RTC_* fields name the same second.
+*
+* A reading only places the time within its whole second, so the error
+* stays inside one second; where, depends on the phase of the reads
+* against the RTC's second. Reading on every pass catches the second
+* edge, reading rarely leaves the error where the first read put it.
+*
+* Sync period 0 reads the RTC on every pass of the daisy chain, as the
+* code did before the service; its RTC transactions per minute are the
+* baseline for the others.
+*
+* The program fails if the time ever goes backwards, if it strays from
+* the RTC by more than MAX_ERR_MS, if the fields disagree with the epoch,
+* or if a 60 s sync period does not cut the RTC traffic at least tenfold.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "RtcTime.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         10000000
+#define RUN_US          600000000   // 10 minutes
+#define SAMPLE_US       100000
+#define START_EPOCH     1704066900  // 2023-12-31 23:55:00
+#define MAX_ERR_MS      1500
+#define MIN_GAIN        10
+#define I2C_ADDR_RTC    0x68        // host_i2c.c
+
+typedef struct
+{
+    int     period;                 // REG_RTC_SYNC_PERIOD, s
+    double  ppm;                    // RTC oscillator error
+} SETTING;
+
+static const SETTING settings[] =
+{
+    {  0,   50.0},
+    { 10,   50.0},
+    { 60,   50.0},
+    { 60,  -50.0},
+    {300,  100.0},
+    {300, -100.0},
+};
+
+#define NUM_SETTINGS    (sizeof(settings) / sizeof(settings[0]))
+
+static int failures;
+
+static UInt32 rtcXfers(void)
+{
+    return Host_I2c_find(I2C_ADDR_RTC)->xfers;
+}
+
+/// the broken-down fields as epoch seconds
+static UInt32 fieldsEpoch(void)
+{
+    struct tm tm;
+
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_sec  = REG_RTC_SEC;
+    tm.tm_min  = REG_RTC_MIN;
+    tm.tm_hour = REG_RTC_HR;
+    tm.tm_mday = REG_RTC_DAY;
+    tm.tm_mon  = REG_RTC_MON - 1;
+    tm.tm_year = REG_RTC_YR + 100;
+
+    return (UInt32)timegm(&tm);
+}
+
+/// RTC xfers per minute
+static double run(const SETTING *s)
+{
+    UInt64 t0, t, est, last = 0;
+    double rtcMs, err, worst = 0, sum = 0;
+    UInt32 x, n = 0, back = 0, mismatch = 0;
+
+    REG_RTC_SYNC_PERIOD = s->period;
+    Host_Rtc_set(START_EPOCH, s->ppm);
+    t0 = Host_Now();
+    RTC_Time_Init();
+    x = rtcXfers();
+
+    // the first read steps the time; measure from the next sample on
+    Host_Run(2000000);
+
+    for (t=0; t<RUN_US; t+=SAMPLE_US)
+    {
+        Host_Run(SAMPLE_US);
+
+        est = RTC_Time_Epoch();
+        rtcMs = START_EPOCH * 1000.0 + (Host_Now() - t0) * (1.0 + s->ppm * 1e-6) / 1000.0;
+        err = (double)est - rtcMs;
+        if (err < 0 ? -err > worst : err > worst) worst = err < 0 ? -err : err;
+        sum += err;
+        n++;
+
+        if (est < last) back++;
+        last = est;
+
+        if (fieldsEpoch() != (UInt32)REG_RTC_EPOCH) mismatch++;
+    }
+
+    x = rtcXfers() - x;
+
+    printf("%6d %7.0f   %9.1f   %8.0f %8.0f   %5u %8u   %02d:%02d:%02d %02d/%02d/%02d\n",
+        s->period, s->ppm, x / ((RUN_US + 2000000) / 60e6), sum / n, worst, back, mismatch,
+        REG_RTC_HR, REG_RTC_MIN, REG_RTC_SEC, REG_RTC_MON, REG_RTC_DAY, REG_RTC_YR);
+
+    if (back || mismatch || worst > MAX_ERR_MS)
+    {
+        printf("  the time went backwards, strayed or disagreed with its fields\n");
+        failures++;
+    }
+
+    return x / ((RUN_US + 2000000) / 60e6);
+}
+
+int main(void)
+{
+    double perMin[NUM_SETTINGS];
+    UInt32 i;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    printf("RTC from 23:55:00 12/31/23 for %.0f min per setting; errors of RTC_Time_Epoch() against the RTC\n\n",
+        RUN_US / 60e6);
+    printf("period     ppm   RTC xfers/min   mean ms  worst ms   back  fields    end\n");
+    for (i=0; i<NUM_SETTINGS; i++) perMin[i] = run(&settings[i]);
+
+    // settings[2] syncs every 60 s, settings[0] on every pass
+    printf("\nRTC traffic at a 60 s sync period: %.1fx less than on every pass\n",
+        perMin[2] > 0 ? perMin[0] / perMin[2] : 0.0);
+    if (perMin[2] * MIN_GAIN > perMin[0])
+    {
+        printf("  less than %dx\n", MIN_GAIN);
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* sched_sim.c
+*-------------------------------------------------------------------------
+* Boots the firmware on the host shim and the peripheral models and runs
+* it for a span of virtual time, then prints the per-object statistics:
+* the shim's own, and the ones SchedStats.c published through its hooks
+* to REG_SCHED[] and REG_CPU[], as a Modbus master would read them.
+*
+*   razor_sched [-t seconds] [-n]
+*
+* The NAND starts blank, so main() takes the first-flash path (factory
+* defaults, stored to NAND). A freshly formatted FAT32 stick is plugged
+* in unless -n is given. Every Clock, Timer, Swi and Task then runs the
+* firmware's own code at the cfg rates; the I2C, UART, timer and
+* watchdog traffic goes to the models (host_dev.h).
+*
+* CPU times are host times of the firmware C code, not C674x cycles; use
+* them to compare builds, not as a budget.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "host_usb.h"
+#include "host_fatfs.h"
+#include "Globals.h"
+#include "SchedStats.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+/// SchedStats.h slots, named as the cfg objects they account
+static const char *SCHED_NAME[SCHED_NUM_OBJ][2] =
+{
+    {"TASK",  "idle"},
+    {"TASK",  "Menu_task"},
+    {"TASK",  "logData_task"},
+    {"TASK",  "other (main, driver tasks)"},
+    {"SWI",   "other (Clock SWI, driver SWIs)"},
+    {"SWI",   "Swi_I2C_RX"},
+    {"SWI",   "Swi_I2C_TX"},
+    {"SWI",   "Swi_Modbus_RX"},
+    {"SWI",   "Swi_writeNand"},
+    {"SWI",   "Swi_Poll"},
+    {"SWI",   "Swi_REG_OIL_SAMPLE"},
+    {"SWI",   "Swi_REG_STREAM"},
+    {"SWI",   "Swi_Set_REG_DENSITY_CAL_Unit"},
+    {"SWI",   "Swi_REG_OIL_ADJUST"},
+    {"SWI",   "Swi_Apply_Density_Adj"},
+    {"SWI",   "Swi_upgradeFirmware"},
+    {"SWI",   "Swi_uploadCsv"},
+    {"SWI",   "Swi_downloadCsv"},
+    {"SWI",   "Swi_Csv_Page"},
+    {"SWI",   "Swi_usbhMscDriveOpen"},
+    {"SWI",   "Swi_enumerateUsb"},
+    {"SWI",   "Swi_changeTime"},
+    {"SWI",   "Swi_bootDeferred"},
+    {"SWI",   "Swi_Event_Page"},
+    {"SWI",   "Swi_Curve_Build"},
+    {"SWI",   "Swi_Hist_Page"},
+    {"SWI",   "Swi_Hist_Save"},
+    {"SWI",   "Swi_Tot_Save"},
+    {"SWI",   "Swi_Sig_Save"},
+    {"HWI",   "other (Clock, timers, drivers)"},
+    {"HWI",   "UART_Hwi"},
+    {"HWI",   "I2C_Hwi"},
+};
+
+/// REG_SCHED[] (last Publish window) and REG_CPU[] (1 s, 10 s, 60 s)
+static void schedReport(FILE *out)
+{
+    const double *w, *c;
+    int i;
+
+    fprintf(out, "\nSchedStats.c: REG_SCHED[] over the last window, REG_CPU[] over 1/10/60 s\n");
+    fprintf(out, "%-5s %-44s %8s %8s %10s %7s %7s %7s\n",
+        "kind", "object", "runs", "load", "max_us", "1s", "10s", "60s");
+
+    for (i=0; i<SCHED_NUM_OBJ; i++)
+    {
+        w = &REG_SCHED[i*SCHED_WORDS];
+        c = &REG_CPU[i*SCHED_CPU_WORDS];
+        if (w[SCHED_W_RUNS] == 0 && c[SCHED_CPU_W_60S] == 0) continue;
+
+        fprintf(out, "%-5s %-44s %8.0f %7.2f%% %10.2f %6.2f%% %6.2f%% %6.2f%%\n",
+            SCHED_NAME[i][0], SCHED_NAME[i][1], w[SCHED_W_RUNS], w[SCHED_W_LOAD], w[SCHED_W_MAX_US],
+            c[SCHED_CPU_W_1S], c[SCHED_CPU_W_10S], c[SCHED_CPU_W_60S]);
+    }
+}
+
+static void report(FILE *out)
+{
+    Host_I2cStats i2c;
+    Host_NandStats nand;
+    Host_UsbStats usb;
+
+    Host_I2c_stats(&i2c);
+    Host_Nand_stats(&nand);
+    Host_Usb_stats(&usb);
+
+    fprintf(out, "\nI2C    %u starts, %u bytes, %u NACKs, %.3f s of bus time\n",
+        i2c.starts, i2c.bytes, i2c.nacks, i2c.busNs / 1e9);
+    fprintf(out, "NAND   %u page reads, %u page programs, %u block erases\n",
+        nand.reads, nand.programs, nand.erases);
+    fprintf(out, "USB    %u reads, %u writes (%u sectors), %.3f s of bus time\n",
+        usb.reads, usb.writes, usb.sectorsWritten, usb.busNs / 1e9);
+    fprintf(out, "WD     %u kicks\n", Host_Wd_kicks());
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+    double seconds = 60.0;
+    Bool stick = TRUE;
+    UInt64 wall;
+
+    for (i=1; i<argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i+1 < argc) seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0) stick = FALSE;
+        else
+        {
+            fprintf(stderr, "usage: razor_sched [-t seconds] [-n]\n");
+            return 1;
+        }
+    }
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    if (stick)
+    {
+        Host_Ff_format();
+        Host_Usb_attach(TRUE);
+    }
+
+    Host_Cfg_Create();
+    Razor_main();
+
+    wall = Host_Ns();
+    Host_Run((UInt64)(seconds * 1000000.0));
+    wall = Host_Ns() - wall;
+
+    printf("virtual %.3f s in %.3f s wall (x%.0f), tick %u us\n\n",
+        Host_Now() / 1e6, wall / 1e9, wall ? Host_Now() * 1e3 / wall : 0.0, Clock_tickPeriod);
+    Host_Report(stdout);
+    schedReport(stdout);
+    report(stdout);
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* sig_bench.c
+*-------------------------------------------------------------------------
+* Benchmark of the scripted process trajectories (SigGen.c) on the host
+* shim: what SigGen_Next() adds to a Poll, and whether a script and seed
+* give the same trajectory every time.
+*
+*   razor_sig
+*
+* After the firmware has booted, the program times CALLS calls of
+* SigGen_Next() on the factory script, best of REPEAT, in host ns per
+* call. It then plays the whole factory script once per REG_TWIN_MODE,
+* off, manual and script, and prints the host ns per Poll (the Swi_Poll
+* activations) and the COIL_OIL_PHASE changes. In script mode the
+* INVERT segment swings the watercut across REG_OIL_PHASE_CUTOFF, so the
+* real curve switch-over has to happen.
+*
+* The same script played twice with one seed has to give the same
+* trajectory, and with another seed a different one.
+*
+* The program fails if SigGen_Next() costs more than MAX_SHARE of the
+* mean Poll with the model off, if the script does not switch the oil
+* phase both ways, or if a trajectory is not reproducible.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "Twin.h"
+#include "SigGen.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         10000000
+#define SCRIPT_US       420000000   // the factory script, once
+#define POLL_US         500000
+#define CALLS           1000000
+#define REPEAT          5
+#define TRACE           2000        // calls compared for reproducibility
+#define SEED            12345
+#define MAX_SHARE       0.01
+
+static const char *MODE_NAME[] = {"off", "manual", "script"};
+
+static double trace[2][TRACE][3];
+static int failures;
+
+/// ns per SigGen_Next(), best of REPEAT
+static double nextNs(void)
+{
+    double wc, temp, dens, ns, best = 0;
+    UInt64 t0;
+    UInt32 i;
+    int k;
+
+    for (k=0; k<REPEAT; k++)
+    {
+        SigGen_Start(5.0, 40.0, 850.0);
+        t0 = Host_Ns();
+        for (i=0; i<CALLS; i++) SigGen_Next(&wc, &temp, &dens);
+        ns = (Host_Ns() - t0) / (double)CALLS;
+        if (k == 0 || ns < best) best = ns;
+    }
+
+    return best;
+}
+
+static void play(double *t)
+{
+    UInt32 i;
+
+    SigGen_Start(5.0, 40.0, 850.0);
+    for (i=0; i<TRACE; i++) SigGen_Next(&t[i*3], &t[i*3+1], &t[i*3+2]);
+}
+
+/// host ns per Poll over the factory script in <mode>; oil phase changes
+static double run(int mode, UInt32 *rises, UInt32 *falls)
+{
+    Host_Stats *st = &Swi_Poll->st;
+    UInt64 t;
+    int phase;
+
+    REG_TWIN_WC = 5.0;
+    REG_TWIN_TEMP = 40.0;
+    REG_TWIN_DENS = 850.0;
+    REG_TWIN_SALT = 0.0;
+    REG_TWIN_MODE = mode;
+    Host_Run(BOOT_US);
+
+    Host_Stats_reset();
+    *rises = *falls = 0;
+    phase = COIL_OIL_PHASE.val;
+
+    for (t=0; t<SCRIPT_US; t+=POLL_US)
+    {
+        Host_Run(POLL_US);
+        if (COIL_OIL_PHASE.val == phase) continue;
+        if (COIL_OIL_PHASE.val) (*rises)++;
+        else (*falls)++;
+        phase = COIL_OIL_PHASE.val;
+    }
+
+    return st->runs ? (double)st->ns / st->runs : 0;
+}
+
+int main(void)
+{
+    double next, poll[3];
+    UInt32 rises, falls;
+    UInt32 key;
+    int mode;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    // Poll and the script share SigGen.c; keep Poll out of the timing
+    key = Swi_disable();
+    next = nextNs();
+
+    REG_SIG_SEED = SEED;
+    play(&trace[0][0][0]);
+    play(&trace[1][0][0]);
+    if (memcmp(trace[0], trace[1], sizeof(trace[0])))
+    {
+        printf("  one seed gave two trajectories\n");
+        failures++;
+    }
+    REG_SIG_SEED = SEED + 1;
+    play(&trace[1][0][0]);
+    if (!memcmp(trace[0], trace[1], sizeof(trace[0])))
+    {
+        printf("  two seeds gave one trajectory\n");
+        failures++;
+    }
+    REG_SIG_SEED = SEED;
+    Swi_restore(key);
+
+    printf("SigGen_Next() on the factory script: %.1f host ns per call, best of %d x %d\n\n", next, REPEAT, CALLS);
+    printf("factory script, %.0f s per mode\n", SCRIPT_US / 1e6);
+    printf("REG_TWIN_MODE   ns per Poll   oil phase on  off\n");
+
+    for (mode=TWIN_MODE_OFF; mode<=TWIN_MODE_SCRIPT; mode++)
+    {
+        poll[mode] = run(mode, &rises, &falls);
+        printf("%-13s   %11.0f   %12u %4u\n", MODE_NAME[mode], poll[mode], rises, falls);
+
+        if (mode == TWIN_MODE_SCRIPT && (rises == 0 || falls == 0))
+        {
+            printf("  the script did not switch the oil phase both ways\n");
+            failures++;
+        }
+    }
+    REG_TWIN_MODE = TWIN_MODE_OFF;
+
+    printf("\nSigGen_Next() is %.3f %% of a Poll with the model off\n", poll[0] > 0 ? next / poll[0] * 100 : 0.0);
+    if (next > MAX_SHARE * poll[0])
+    {
+        printf("  more than %.0f %%\n", MAX_SHARE * 100);
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* stream_sim.c
+*-------------------------------------------------------------------------
+* Replays interleaved well streams through the per-stream process state
+* (StreamProfile.c) on the host shim, the process model of Twin.c
+* standing in for the separator, and reports the settling time of
+* REG_WATERCUT after each stream switch.
+*
+*   razor_stream
+*
+* NUM_STREAMS wells of different watercut take turns on the analyzer,
+* DWELL_US each, for ROUNDS rounds. A switch is what the operator's write
+* to REG_STREAM does, getStreamData() in Swi_REG_STREAM, with the twin's
+* watercut changed at the same moment. Every SAMPLE_US the program
+* compares REG_WATERCUT with the stream's watercut; the settling time is
+* the time until it stays within TWIN_SETTLE_PCT, the error the mean
+* absolute difference over the dwell. This is done for several
+* REG_PROC_AVGING settings.
+*
+* Each setting runs twice: with the profiles, and once more with the
+* state shared as it was before them. For that the program copies the
+* profile of the stream left into the one selected, and puts the
+* registers back, right at the switch, so the new stream carries on with
+* the old one's averages.
+*
+* With the profiles a stream picks up where it left off. It does not
+* settle at once, though: the first Poll after the switch still sees the
+* frequency the gate measured on the well before, and that one sample
+* goes into the new stream's average with weight 1/REG_PROC_AVGING. The
+* shared state starts the whole difference between the wells off.
+*
+* The program fails if, without averaging, a switch does not settle
+* within MAX_SETTLE_US, or if, with averaging, a revisit with the
+* profiles does not settle sooner than with the shared state and with at
+* least MIN_GAIN times less error.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <xdc/cfg/global.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "Utils.h"
+#include "Twin.h"
+#include "StreamProfile.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define BOOT_US         10000000
+#define DWELL_US        30000000
+#define SAMPLE_US       100000
+#define ROUNDS          4
+#define MAX_SETTLE_US   2000000
+#define MIN_GAIN        3.0
+
+typedef struct
+{
+    int     stream;                 // REG_STREAM
+    double  wc;                     // the well's watercut, %
+} WELL;
+
+static const WELL wells[] =
+{
+    { 1,  4.0},
+    { 7, 18.0},
+    {23, 10.0},
+    {60, 14.0},
+};
+
+#define NUM_STREAMS     (sizeof(wells) / sizeof(wells[0]))
+
+static const double averaging[] = {1, 5, MAXBUF};  // REG_PROC_AVGING
+
+#define NUM_AVERAGING   (sizeof(averaging) / sizeof(averaging[0]))
+
+static int failures;
+
+/// the operator selects <w>, and the separator routes it to the analyzer
+static void route(const WELL *w, Bool shared)
+{
+    STREAM_PROFILE *left = SP;
+    UInt32 key;
+
+    key = Swi_disable();
+
+    VAR_Update(&REG_STREAM, w->stream, CALC_UNIT);
+    getStreamData();
+    REG_TWIN_WC = w->wc;
+
+    // one state for all streams, as before the profiles
+    if (shared && SP != left)
+    {
+        *SP = *left;
+        REG_DENS_CORR               = left->densCorr;
+        REG_WATERCUT_AVG.calc_val   = left->wcAvg;
+        REG_TEMP_AVG.calc_val       = left->tempAvg;
+        COIL_OIL_PHASE.val          = left->isOilPhase;
+    }
+
+    Swi_restore(key);
+}
+
+typedef struct
+{
+    double  first;                  // mean settling time of the first visits, s
+    double  revisit;                // and of the revisits
+    double  worst;
+    double  err;                    // mean absolute error of the revisits, %
+} RESULT;
+
+/// settling time of REG_WATERCUT after switching to <w>, us; <err> gets
+/// the summed absolute error
+static UInt64 dwell(const WELL *w, Bool shared, double *err)
+{
+    UInt64 t, last = 0;
+    double e;
+
+    route(w, shared);
+    for (t=SAMPLE_US; t<=DWELL_US; t+=SAMPLE_US)
+    {
+        Host_Run(SAMPLE_US);
+        e = fabs(REG_WATERCUT.val - w->wc);
+        if (e > TWIN_SETTLE_PCT) last = t;
+        *err += e;
+    }
+
+    return last;
+}
+
+static void run(double avg, Bool shared, RESULT *res)
+{
+    UInt64 s, sumFirst = 0, sumRe = 0, worst = 0;
+    double err = 0, dummy = 0;
+    UInt32 r, i;
+
+    VAR_Update(&REG_PROC_AVGING, avg, CALC_UNIT);
+    Stream_Profile_Init();
+
+    for (r=0; r<ROUNDS; r++)
+    {
+        for (i=0; i<NUM_STREAMS; i++)
+        {
+            s = dwell(&wells[i], shared, r ? &err : &dummy);
+            if (r) sumRe += s;
+            else sumFirst += s;
+            if (s > worst) worst = s;
+        }
+    }
+
+    res->first = sumFirst / 1e6 / NUM_STREAMS;
+    res->revisit = sumRe / 1e6 / (NUM_STREAMS * (ROUNDS - 1));
+    res->worst = worst / 1e6;
+    res->err = err / (NUM_STREAMS * (ROUNDS - 1) * (DWELL_US / SAMPLE_US));
+}
+
+int main(void)
+{
+    RESULT res[2];
+    UInt32 i;
+    int shared;
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    REG_TWIN_TEMP = 40.0;
+    REG_TWIN_DENS = 850.0;
+    REG_TWIN_SALT = 0.0;
+    REG_TWIN_WC = wells[0].wc;
+    REG_TWIN_MODE = TWIN_MODE_MANUAL;
+    Host_Run(BOOT_US);
+
+    printf("%u streams,", (UInt32)NUM_STREAMS);
+    for (i=0; i<NUM_STREAMS; i++) printf(" %d at %.0f %%%s", wells[i].stream, wells[i].wc, i+1 < NUM_STREAMS ? "," : "");
+    printf("; %.0f s each, %d rounds\n", DWELL_US / 1e6, ROUNDS);
+    printf("REG_WATERCUT settling time after a switch, within %.1f %%; mean error of the revisits\n\n", TWIN_SETTLE_PCT);
+    printf("           %-35s   %-35s\n", "profiles", "shared state (before)");
+    printf("averaging  first s  revisit s  worst s  error %%   first s  revisit s  worst s  error %%\n");
+
+    for (i=0; i<NUM_AVERAGING; i++)
+    {
+        for (shared=0; shared<2; shared++) run(averaging[i], shared, &res[shared]);
+
+        printf("%9.0f  %7.1f  %9.1f  %7.1f  %7.3f   %7.1f  %9.1f  %7.1f  %7.3f\n", averaging[i],
+            res[0].first, res[0].revisit, res[0].worst, res[0].err,
+            res[1].first, res[1].revisit, res[1].worst, res[1].err);
+
+        if (averaging[i] <= 1)
+        {
+            if (res[0].worst * 1e6 <= MAX_SETTLE_US && res[1].worst * 1e6 <= MAX_SETTLE_US) continue;
+            printf("  a switch took longer than %.1f s to settle without averaging\n", MAX_SETTLE_US / 1e6);
+            failures++;
+        }
+        else if (res[0].revisit >= res[1].revisit || res[0].err * MIN_GAIN > res[1].err)
+        {
+            printf("  the profiles do not settle sooner, with %.0fx less error, than the shared state\n", MIN_GAIN);
+            failures++;
+        }
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* twin_sim.c
+*-------------------------------------------------------------------------
+* Drives the process model (Twin.c) over Modbus, on the host shim, the
+* way a bench operator would, and prints its step response.
+*
+*   razor_twin [-t seconds]
+*
+* Boot is main() on a blank NAND. The master first writes REG_TWIN_WC
+* locked (factory defaults are unlocked; the program locks) and expects
+* the exception. After the unlock it switches REG_TWIN_MODE to the
+* process model and applies a series of watercut steps and a salinity
+* step, each held for <seconds> (default 30) of virtual time. The steps
+* stay within the factory default oil curve, which covers about 0 to
+* 20 % watercut. For each step it prints what REG_TWIN[] recorded: the
+* measurement, AO and relay response and the Modbus round trip, next to
+* REG_WATERCUT and the watercut the master expects.
+*
+* REG_TWIN_* are password protected but volatile (REGPERM_PASSWD_VOL), so
+* no write of the run may reach the NAND; the program fails if one does.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "Globals.h"
+#include "Twin.h"
+
+int Razor_main(void);               // main.c, renamed by the Makefile
+
+#define SLAVE           1           // factory default REG_SLAVE_ADDRESS
+#define MB_TWIN_WC      193         // ModbusTables.h
+#define MB_TWIN_TEMP    195
+#define MB_TWIN_SALT    197
+#define MB_TWIN_DENS    199
+#define MB_TWIN_MODE    253
+#define BOOT_US         10000000
+
+typedef struct
+{
+    float   wc;
+    float   salt;
+} STEP;
+
+static const STEP steps[] =
+{
+    {5.0f, 0.0f}, {10.0f, 0.0f}, {20.0f, 0.0f}, {15.0f, 0.0f}, {15.0f, 0.5f}, {15.0f, 0.0f},
+};
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_twin: %s (exception %u)\n", what, Host_Mb_exception());
+    exit(1);
+}
+
+static void printMs(double ms)
+{
+    if (ms < 0) printf("       -");
+    else printf(" %7.0f", ms);
+}
+
+int main(int argc, char *argv[])
+{
+    Host_NandStats nand;
+    double seconds = 30.0;
+    UInt32 i;
+    int rc = 0;
+
+    for (i=1; i<(UInt32)argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i+1 < (UInt32)argc) seconds = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: razor_twin [-t seconds]\n");
+            return 1;
+        }
+    }
+
+    Host_Dev_Init();
+    Host_Nand_blank();
+    Host_Cfg_Create();
+    Razor_main();
+    Host_Run(BOOT_US);
+
+    // factory defaults are unlocked; as after the menu's lock
+    COIL_UNLOCKED.val = FALSE;
+    if (Host_Mb_writeFloat(SLAVE, MB_TWIN_WC, 50.0f)) fail("locked REG_TWIN_WC write accepted");
+    printf("locked:   REG_TWIN_WC write refused, exception %u\n", Host_Mb_exception());
+
+    // as after the technician has entered the passcode
+    COIL_UNLOCKED.val = TRUE;
+
+    Host_Nand_resetStats();
+
+    if (!Host_Mb_writeFloat(SLAVE, MB_TWIN_TEMP, 40.0f)) fail("REG_TWIN_TEMP write");
+    if (!Host_Mb_writeFloat(SLAVE, MB_TWIN_DENS, 850.0f)) fail("REG_TWIN_DENS write");
+    if (!Host_Mb_writeFloat(SLAVE, MB_TWIN_SALT, 0.0f)) fail("REG_TWIN_SALT write");
+    if (!Host_Mb_writeFloat(SLAVE, MB_TWIN_WC, 0.0f)) fail("REG_TWIN_WC write");
+    if (!Host_Mb_writeInt(SLAVE, MB_TWIN_MODE, TWIN_MODE_MANUAL)) fail("REG_TWIN_MODE write");
+    Host_Run((UInt64)(seconds * 1e6));
+
+    printf("unlocked: twin on, %.0f s per step\n\n", seconds);
+    printf("step  wc    salt   REG_WATERCUT    meas_ms   ao_ms relay_ms   mb_ms mb_max_ms cpu_%%\n");
+
+    for (i=0; i<sizeof(steps)/sizeof(steps[0]); i++)
+    {
+        if (!Host_Mb_writeFloat(SLAVE, MB_TWIN_SALT, steps[i].salt)) fail("REG_TWIN_SALT write");
+        if (!Host_Mb_writeFloat(SLAVE, MB_TWIN_WC, steps[i].wc)) fail("REG_TWIN_WC write");
+        Host_Run((UInt64)(seconds * 1e6));
+
+        printf("%4u %5.1f %5.1f %10.2f %%  ", i+1, steps[i].wc, steps[i].salt, REG_WATERCUT.val);
+        printMs(REG_TWIN[TWIN_M_MEAS_MS]);
+        printMs(REG_TWIN[TWIN_M_AO_MS]);
+        printMs(REG_TWIN[TWIN_M_RELAY_MS]);
+        printMs(REG_TWIN[TWIN_M_MB_MS]);
+        printf("  ");
+        printMs(REG_TWIN[TWIN_M_MB_MAX_MS]);
+        printf(" %5.1f\n", REG_TWIN[TWIN_M_CPU_PCT]);
+    }
+
+    if (!Host_Mb_writeInt(SLAVE, MB_TWIN_MODE, TWIN_MODE_OFF)) fail("REG_TWIN_MODE write");
+    Host_Run(1000000);
+
+    Host_Nand_stats(&nand);
+    printf("\nNAND     %u page programs, %u block erases during %u twin writes\n",
+        nand.programs, nand.erases, 6 + 2 * (UInt32)(sizeof(steps)/sizeof(steps[0])));
+    if (nand.programs || nand.erases) rc = 1;
+
+    printf("\n");
+    Host_Report(stdout);
+
+    return rc;
+}
@@ -0,0 +1,251 @@
+/*------------------------------------------------------------------------
+* This Information is proprietary to Phase Dynamics Inc, Richardson, Texas
+* and MAY NOT be copied by any method or incorporated into another program
+* without the express written consent of Phase Dynamics Inc. This information
+* or any portion thereof remains the property of Phase Dynamics Inc.
+* The information contained herein is believed to be accurate and Phase
+* Dynamics Inc assumes no responsibility or liability for its use in any way
+* and conveys no license or title under any patent or copyright and makes
+* no representation or warranty that this Information is free from patent
+* or copyright infringement.
+*
+* Copyright (c) 2018 Phase Dynamics Inc. ALL RIGHTS RESERVED.
+*------------------------------------------------------------------------*/
+
+
+/*------------------------------------------------------------------------
+* usb_bench.c
+*-------------------------------------------------------------------------
+* Drives the FatFs USB disk port (usb_fatfs_port_usbmsc.c) directly on
+* the stick model and reports its read throughput.
+*
+*   razor_usb
+*
+* Each pattern reads READ_BYTES from the stick in requests of a fixed
+* sector count, sequentially or at random sectors, the way FatFs calls
+* the port: one sector for the file and directory windows (f_gets, the
+* CSV index), four for the 2 KB chunks of a firmware upgrade, a cluster,
+* and a large direct f_read. For each it prints the READ(10) commands the
+* port issued and the MB/s the bulk-only transport allows for them
+* (host_usb.c: a command overhead plus a per-sector time), next to the
+* MB/s of the same requests issued one command each, as the port did
+* without the burst buffers.
+*
+* Every sector read is compared with the medium. Sectors written through
+* the port, one at a time (into the cache) and in a multi-sector write,
+* are read back through the burst buffers before and after CTRL_SYNC.
+*
+* Last, sector 0 is made a FAT32 boot record, so the port pins the FAT.
+* Data sectors that fill most of the cache must survive a walk over more
+* FAT sectors than the cache holds, as they do once the pinned share is
+* bounded (USB_CACHE_PINNED).
+*
+* The program fails on any mismatch, if a sequential pattern of requests
+* smaller than a burst issues more than one command per burst, or if any
+* pattern issues more commands than requests, or if the FAT walk
+* evicts a data sector.
+*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_bios.h"
+#include "host_dev.h"
+#include "host_usb.h"
+#include "host_fatfs.h"
+
+#define SECT            512
+#define SPAN_SECT       32768               // 16 MB the patterns read from
+#define READ_BYTES      (8u * 1024 * 1024)
+#define MAX_COUNT       64
+#define COMMAND_US      500                 // host_usb.c defaults
+#define SECTOR_US       25
+#define BURST_SECT      16                  // USB_BURST_SECTORS
+#define CACHE_SECT      16                  // USB_CACHE_SECTORS
+#define PINNED_SECT     4                   // USB_CACHE_PINNED
+#define FAT_START       32                  // pinning(): reserved sectors
+#define DATA_SECT       20000               // pinning(): past the FATs
+
+typedef struct
+{
+    const char  *name;
+    UInt32      count;                      // sectors per request
+    Bool        random;
+} PATTERN;
+
+static const PATTERN patterns[] =
+{
+    {"sequential",   1, FALSE},
+    {"sequential",   4, FALSE},
+    {"sequential",   8, FALSE},
+    {"sequential",  64, FALSE},
+    {"random",       1, TRUE},
+    {"random",       4, TRUE},
+};
+
+#define NUM_PATTERNS    (sizeof(patterns) / sizeof(patterns[0]))
+
+extern uint32_t g_usbCacheHits;             // usb_fatfs_port_usbmsc.c
+
+static UInt8 buf[MAX_COUNT * SECT], want[SECT];
+static int failures;
+
+static void fail(const char *what)
+{
+    fprintf(stderr, "razor_usb: %s\n", what);
+    exit(1);
+}
+
+static void fill(UInt8 *p, UInt32 sector, UInt32 gen)
+{
+    UInt32 i;
+
+    for (i=0; i<SECT; i++) p[i] = (UInt8)(sector * 7 + gen * 13 + i);
+}
+
+static void verify(const char *what, const UInt8 *p, UInt32 sector, UInt32 count)
+{
+    UInt32 i;
+
+    for (i=0; i<count; i++)
+    {
+        Host_Usb_peek(sector + i, want);
+        if (memcmp(p + i * SECT, want, SECT) == 0) continue;
+        if (failures++ < 10) printf("  MISMATCH %s: sector %u\n", what, sector + i);
+    }
+}
+
+static void readAt(const char *what, UInt32 sector, UInt32 count)
+{
+    if (FATFSPortUSBDiskRead(NULL, buf, sector, count) != RES_OK) fail("read failed");
+    verify(what, buf, sector, count);
+}
+
+/// <count>-sector requests, sequential or random, until READ_BYTES are read
+static Bool run(const PATTERN *p)
+{
+    UInt32 requests = READ_BYTES / SECT / p->count;
+    UInt32 i, sector = 0;
+    UInt64 flatNs;
+    Host_UsbStats s;
+    double mbs, flat;
+
+    FATFSPortUSBDiskClose(NULL);
+    if (FATFSPortUSBDiskInitialize() != 0) fail("stick not ready");
+    Host_Usb_resetStats();
+
+    for (i=0; i<requests; i++)
+    {
+        if (p->random) sector = (UInt32)rand() % (SPAN_SECT - p->count);
+        readAt(p->name, sector, p->count);
+        sector += p->count;
+    }
+
+    Host_Usb_stats(&s);
+    flatNs = (UInt64)requests * COMMAND_US * 1000 + (UInt64)READ_BYTES / SECT * SECTOR_US * 1000;
+    mbs = READ_BYTES / 1e6 / (s.busNs / 1e9);
+    flat = READ_BYTES / 1e6 / (flatNs / 1e9);
+
+    printf("%-10s %7u %9u %9u %9.2f %9.2f %7.1fx\n", p->name, p->count, requests, s.reads,
+        flat, mbs, mbs / flat);
+
+    if (s.reads > requests) return FALSE;
+    if (!p->random && p->count < BURST_SECT) return s.reads <= READ_BYTES / SECT / BURST_SECT + 1;
+
+    return TRUE;
+}
+
+/// writes through the cache and past it, read back through the bursts
+static void coherency(void)
+{
+    UInt8 w[8 * SECT];
+    UInt32 i, sector;
+
+    FATFSPortUSBDiskClose(NULL);
+    if (FATFSPortUSBDiskInitialize() != 0) fail("stick not ready");
+
+    // the burst buffers hold 101..116 and 117..132 after this
+    for (sector=100; sector<133; sector++) readAt("burst fill", sector, 1);
+
+    fill(w, 110, 1);
+    if (FATFSPortUSBDiskWrite(NULL, w, 110, 1) != RES_OK) fail("write failed");
+    for (i=0; i<8; i++) fill(w + i * SECT, 120 + i, 2);
+    if (FATFSPortUSBDiskWrite(NULL, w, 120, 8) != RES_OK) fail("write failed");
+
+    // sector 110 is only in the cache until CTRL_SYNC
+    if (FATFSPortUSBDiskRead(NULL, buf, 108, 4) != RES_OK) fail("read failed");
+    fill(want, 110, 1);
+    if (memcmp(buf + 2 * SECT, want, SECT) && failures++ < 10) printf("  MISMATCH cached write\n");
+    readAt("after write", 118, 8);
+
+    if (FATFSPortUSBDiskIoctl(NULL, CTRL_SYNC, NULL) != RES_OK) fail("sync failed");
+    readAt("after sync", 108, 4);
+    readAt("after sync", 118, 8);
+    for (sector=100; sector<140; sector++) readAt("after sync", sector, 1);
+}
+
+/// a FAT walk next to cached data sectors
+static Bool pinning(void)
+{
+    UInt8 vbr[SECT] = {0xEB, 0x58, 0x90};
+    UInt32 i, hits, keep = CACHE_SECT - PINNED_SECT;
+
+    vbr[11] = SECT & 0xFF;              // bytes per sector
+    vbr[12] = SECT >> 8;
+    vbr[13] = 8;                        // sectors per cluster
+    vbr[14] = FAT_START;                // reserved sectors
+    vbr[16] = 2;                        // FATs
+    vbr[37] = 2048 >> 8;                // FAT32 sectors per FAT
+    vbr[44] = 2;                        // root cluster
+    vbr[510] = 0x55;
+    vbr[511] = 0xAA;
+    Host_Usb_poke(0, vbr);
+
+    FATFSPortUSBDiskClose(NULL);
+    if (FATFSPortUSBDiskInitialize() != 0) fail("stick not ready");
+    readAt("boot record", 0, 1);
+
+    for (i=0; i<keep; i++) readAt("data", DATA_SECT + 2 * i, 1);
+    for (i=0; i<2 * CACHE_SECT; i++) readAt("FAT", FAT_START + 3 * i, 1);
+
+    hits = g_usbCacheHits;
+    for (i=0; i<keep; i++) readAt("data", DATA_SECT + 2 * i, 1);
+    hits = g_usbCacheHits - hits;
+
+    printf("pinning: %u of %u cached data sectors kept over a walk of %u FAT sectors\n",
+        hits, keep, 2 * CACHE_SECT);
+
+    return hits == keep;
+}
+
+int main(void)
+{
+    UInt32 i;
+    int rc = 0;
+
+    Host_Dev_Init();
+    Host_Usb_latency(COMMAND_US, SECTOR_US);
+    for (i=0; i<SPAN_SECT; i++)
+    {
+        fill(buf, i, 0);
+        Host_Usb_poke(i, buf);
+    }
+
+    USBHMSCDriveOpen(0, 0, NULL);
+    Host_Usb_attach(TRUE);
+    USBHCDMain(0, 0);
+
+    srand(1);
+    printf("%u KB per pattern; MB/s from the transport model, %u us per command, %u us per sector\n\n",
+        READ_BYTES / 1024, COMMAND_US, SECTOR_US);
+    printf("pattern    sectors  requests  commands  one-each    burst    gain\n");
+    for (i=0; i<NUM_PATTERNS; i++)
+    {
+        if (!run(&patterns[i])) rc = 1;
+    }
+
+    coherency();
+    printf("\ncoherency: %s\n", failures ? "FAILED" : "ok");
+    if (!pinning()) rc = 1;
+
+    return (failures || rc) ? 1 : 0;
+}
@@ -36,23 +36,44 @@
 #include "string.h"
 #include "device.h"
 #include "Globals.h"
+#include "BootProfile.h"
+#include "Watchdog.h"
 
 #define NANDWIDTH_16
 #define C6748_LCDK
 
 extern void delayTimerSetup(void);
+extern void Stream_Profile_Init(void);
 extern void Init_Data_Buffer(void);
+extern void ADC_Filter_Init(void);
+extern void RTC_Time_Init(void);
+extern void Relay_Init(void);
+extern void Event_Init(void);
+extern void Totalizer_Init(void);
+extern void Freq_Capture_Init(void);
+extern void Csv_Index_Init(void);
+extern void Sched_Stats_Init(void);
+extern void SigGen_Init(void);
+extern void Twin_Init(void);
+extern void Mem_Monitor_Init(void);
+extern void Curve_Table_Init(void);
+extern void Hist_Init(void);
 extern void resetGlobalVars(void);
 extern void upgradeFirmwareTask(void);
 
 static inline void Init_BoardClocks(void);
 static inline void initTimer3(void);
-static inline void initHardwareObjects(void);
+static inline void initI2cObjects(void);
+static inline void initModbusObjects(void);
 static inline void initSoftwareObjects(void);
 static inline void Init_All(void);
 
 int main (void)
 {
+    /* start-up profiler */
+    Boot_Prof_Start();
+    Boot_Prof_Mark(BOOT_PH_MAIN);
+
     /* suspend source register */
     SYSTEM->SUSPSRC &= ((1 << 27) | (1 << 22) | (1 << 20) | (1 << 5) | (1 << 16));
 
@@ -62,12 +83,15 @@ int main (void)
 
     /* initialize c6748 specific board */
     Init_BoardClocks();
+    Boot_Prof_Mark(BOOT_PH_CLOCKS);
 
     /* initialize psc */
 	Init_PSC();
+    Boot_Prof_Mark(BOOT_PH_PSC);
 
     /* pin muxing */
 	Init_PinMux();
+    Boot_Prof_Mark(BOOT_PH_PINMUX);
 
     /* initialize everything else */
 	Init_All();
@@ -75,8 +99,12 @@ int main (void)
     /* osal delay timer reset */
     delayTimerSetup();
 
-	/* setup watchdog */
+	/* setup watchdog and its supervisor */
 	setupWatchdog();
+	WD_Supervisor_Init();
+
+    /* runs as soon as the kernel is up */
+    Swi_post(Swi_bootDeferred);
 
     /* START TI-RTOS KERNEL */
 	BIOS_start();
@@ -87,6 +115,15 @@ int main (void)
 
 static inline void Init_All(void)
 {
+    // FINISH A FIRMWARE UPGRADE INTERRUPTED BY A POWER LOSS
+    // THE ROM MAY NOW START THE OTHER SLOT: LET THE WATCHDOG RESTART US
+	if (Resume_Firmware_Upgrade() == FW_RESUMED)
+	{
+		setupWatchdog();
+		WD_Restart();
+	}
+    Boot_Prof_Mark(BOOT_PH_FW_RESUME);
+
     // RESTORE ALL VALUES FROM NAND FLASH MEMORY
 	Restore_Vars_From_NAND();
 
@@ -101,9 +138,18 @@ static inline void Init_All(void)
 		Store_Vars_in_NAND();
 	}
 	else resetGlobalVars(); 
+    Boot_Prof_Mark(BOOT_PH_NAND_RESTORE);
 
 	// INITIALIZE HARDWARES 
-	initHardwareObjects();
+	// FAST START BRINGS UP THE MODBUS SLAVE FIRST AND LEAVES I2C TO bootDeferred()
+	if (!REG_BOOT_FAST)
+	{
+		initI2cObjects();
+    	Boot_Prof_Mark(BOOT_PH_I2C);
+	}
+
+	initModbusObjects();
+    Boot_Prof_Mark(BOOT_PH_MODBUS);
 
 	// INITIALIZE TIMER COUNTER
 	initTimer3();
@@ -116,13 +162,46 @@ static inline void Init_All(void)
 
 	/* start clock */
 	startClocks();
+    Boot_Prof_Mark(BOOT_PH_SOFTWARE);
+}
+
+
+/// one-shot SWI posted before BIOS_start()
+void bootDeferred(void)
+{
+	UInt swiKey, hwiKey;
+
+    Boot_Prof_Mark(BOOT_PH_BIOS);
+
+	if (REG_BOOT_FAST)
+	{
+		// the interrupts stay on, so the UART keeps receiving. The bring-up polls the
+		// I2C registers, so the Clock SWI (ADC, LCD and button clocks started by the
+		// init) waits until it is done, and the I2C HWI stays masked around the polled
+		// LCD and button transfers. Init_I2C() masks it itself while it resets the module.
+		swiKey = Swi_disable();
+		Init_I2C();
+
+		hwiKey = Hwi_disableInterrupt(6);
+		Init_LCD();
+		Init_MBVE();
+		Hwi_restoreInterrupt(6, hwiKey);
+
+		Swi_restore(swiKey);
+    	Boot_Prof_Mark(BOOT_PH_I2C);
+	}
+
+    Boot_Prof_Mark(BOOT_PH_DONE);
+	Boot_Prof_Publish();
 }
 
 
 void Init_BoardClocks(void)
 {
     Uint32 i;
-    for (i=0;i<5000000;i++);
+
+    // power-up settle delay; the rails are already up after a watchdog reset
+    if (!Boot_Prof_IsWarm()) for (i=0;i<5000000;i++);
 
     Board_moduleClockSyncReset(CSL_PSC_USB20);
     Board_moduleClockSyncReset(CSL_PSC_GPIO);
@@ -146,11 +225,25 @@ void Init_BoardClocks(void)
 
 static inline void initSoftwareObjects(void)
 {
+	Stream_Profile_Init();
 	Init_Data_Buffer();
+	ADC_Filter_Init();
+	RTC_Time_Init();
+	Relay_Init();
+	Event_Init();
+	Totalizer_Init();
+	Freq_Capture_Init();
+	Csv_Index_Init();
+	Sched_Stats_Init();
+	SigGen_Init();
+	Twin_Init();
+	Mem_Monitor_Init();
+	Curve_Table_Init();
+	Hist_Init();
 }
 
 
-static inline void initHardwareObjects(void)
+static inline void initI2cObjects(void)
 {
 	// Setup i2c registers and start i2c running (PDI_I2C.c)
 	Init_I2C();
@@ -160,7 +253,10 @@ static inline void initHardwareObjects(void)
 
 	// Initialize buttons (PDI_I2C.c)
 	Init_MBVE();
+}
 
+static inline void initModbusObjects(void)
+{
 	// Setup uart registers and start the uart running (ModbusRTU.c)
 	Init_Uart();
 
@@ -33,7 +33,12 @@
 #include "Errors.h"
 #include "Utils.h"
 #include "Watchdog.h"
+#include "Relay.h"
+#include "EventLog.h"
+#include "CsvIndex.h"
 #include "ModbusRTU.h"
+#include "SchedStats.h"
+#include "History.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -79,12 +84,42 @@ static const char * densityIndex[8]   = {KG_M3, KG_M3_15C, API, API_60F, LBS_FT3
 static const Uint8 densityUnit[8] 	 = {u_mpv_kg_cm, u_mpv_kg_cm_15C, u_mpv_deg_API, u_mpv_deg_API_60F, u_mpv_lbs_cf, u_mpv_lbs_cf_60F, u_mpv_sg, u_mpv_sg_15C};
 static const char * USB_CODE[18] 	 = {DISABLED,ENABLED,USB_ERROR2,USB_ERROR3,USB_ERROR4,USB_ERROR5,USB_ERROR6,USB_ERROR7,USB_ERROR8,USB_ERROR9,USB_ERROR10,USB_ERROR11,USB_ERROR12,USB_ERROR13,USB_ERROR14,USB_ERROR15,USB_ERROR16,USB_ERROR17};
 
+//////////////////////////////////////////////////////////////
+///	state dispatch index: MENU_TABLE row for each state ID
+//////////////////////////////////////////////////////////////
+
+static Uint8 MENU_INDEX[MAX_MENU_STATE+1];
+
+/// every MENU_TABLE row but the terminator needs a Uint8 index below
+/// MENU_INDEX_NONE; a longer table fails to compile here
+typedef char MENU_INDEX_FITS[(sizeof(MENU_TABLE)/sizeof(MENU_TABLE[0]) - 1 <= MENU_INDEX_NONE) ? 1 : -1];
+
 //////////////////////////////////////////////////////////////
 /// function definitions
 //////////////////////////////////////////////////////////////
 
+/// Build MENU_INDEX from MENU_TABLE so a state change is a single
+/// array lookup instead of a walk over the whole table.
+static void buildMenuIndex(void)
+{
+	int i;
+
+	memset(MENU_INDEX, MENU_INDEX_NONE, sizeof(MENU_INDEX));
+
+	for (i=0; MENU_TABLE[i].state != NULL; i++)
+	{
+		assert(MENU_TABLE[i].state <= MAX_MENU_STATE);
+
+		// first entry wins, same as the old linear search
+		if (MENU_INDEX[MENU_TABLE[i].state] == MENU_INDEX_NONE) 
+			MENU_INDEX[MENU_TABLE[i].state] = (Uint8)i;
+	}
+}
+
 void setupMenu (void)
 {
+	buildMenuIndex();
+
 	MENU.state			= MNU_HOMESCREEN_WTC; // set initial screen to Water Cut
 	MENU.dir 			= MNU_DIR_RIGHT;
 	MENU.debounceDone 	= TRUE;
@@ -114,7 +149,11 @@ ISR_Process_Menu (void)
 void 
 ISR_logData(void)
 {
-	if (isLogData) Semaphore_post(logData_sem);
+	if (isLogData)
+	{
+		WD_Expect(WD_CTX_LOG);
+		Semaphore_post(logData_sem);
+	}
 }
 
 //////////////////////////////////////////////////////////////
@@ -148,14 +187,14 @@ Process_Menu(void)
 	/// Start main loop
 	while (1)
 	{
-		/* Reset watchdog timer. Otherwise, resets the system. */
-     	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		/* heartbeat for the watchdog supervisor */
+     	WD_Checkin(WD_CTX_MENU);
 
         if (COIL_UPDATE_FACTORY_DEFAULT.val) storeUserDataToFactoryDefault();
 		if (!COIL_LOCKED_SOFT_FACTORY_RESET.val && !COIL_LOCKED_HARD_FACTORY_RESET.val) 
 		{
 			Swi_post(Swi_writeNand);
-			while(1);
+			WD_Restart();
 		}
 
 		Semaphore_pend(Menu_sem, BIOS_WAIT_FOREVER); 		// wait until next Menu_sem post
@@ -203,8 +242,6 @@ Process_Menu(void)
 						    MENU.debounceDone 	= FALSE;
 						    Clock_start(DebounceMBVE_Clock);	// start the debounce clock
 						    needRelayClick 		= TRUE;
-
-     						TimerWatchdogReactivate(CSL_TMR_1_REGS);
 					    }
 				    }
 				    else										// falling edge
@@ -236,21 +273,14 @@ Process_Menu(void)
 		if (MENU.state != nextState) 						// is menu changed?
 		{
 			MENU.state = nextState;							// next to current
-			i = 0;
+			i = (MENU.state <= MAX_MENU_STATE) ? MENU_INDEX[MENU.state] : MENU_INDEX_NONE;
 
-			while (MENU_TABLE[i].state != NULL) 					
+			if (i != MENU_INDEX_NONE) 						// found matching menu 
 			{ 
-				if (MENU_TABLE[i].state == MENU.state) 		// found matching menu 
-				{
-					MENU.id 	= MENU_TABLE[i].id+'0';		// int to txt
-					MENU.pos	= MENU_TABLE[i].pos;  	 	// blinking position
-					stateFxn 	= MENU_TABLE[i].fxnPtr;		// function pointer
-                    blinker     = 0;                        // reset blinker
-
-					break; 
-				}
-
-				i++;
+				MENU.id 	= MENU_TABLE[i].id+'0';			// int to txt
+				MENU.pos	= MENU_TABLE[i].pos;  	 		// blinking position
+				stateFxn 	= MENU_TABLE[i].fxnPtr;			// function pointer
+                blinker     = 0;                        	// reset blinker
 			}
 		}
 
@@ -259,9 +289,6 @@ Process_Menu(void)
 
         /// WILL BLINK MENU ID
         blinkMenu();
-
-		/// Reset watchdog timer. Otherwise, resets the system. 
-     	TimerWatchdogReactivate(CSL_TMR_1_REGS);
 	}
 }
 
@@ -492,6 +519,7 @@ onFxnEnterPressed(const int currentId, const double max, const double min, VAR *
         else if ((ivalue <= (int)max) && (ivalue >= (int)min))
         {
             *iregister = ivalue;
+            if (iregister != &REG_PASSWORD) Event_Activity(EVENT_MENU, currentId, ivalue);
    	        Swi_post(Swi_writeNand);
 			memcpy(lcdLine1,CHANGE_SUCCESS,16);
     		return currentId;
@@ -503,6 +531,7 @@ onFxnEnterPressed(const int currentId, const double max, const double min, VAR *
         if ((dvalue <= max) && (dvalue >= min))
         {
             *dregister = dvalue;
+            Event_Activity(EVENT_MENU, currentId, dvalue);
    	        Swi_post(Swi_writeNand);
 			memcpy(lcdLine1,CHANGE_SUCCESS,16);
     		return currentId;
@@ -513,6 +542,7 @@ onFxnEnterPressed(const int currentId, const double max, const double min, VAR *
         if ((dvalue <= max) && (dvalue >= min))
         {
             VAR_Update(vregister, dvalue, CALC_UNIT);
+            Event_Activity(EVENT_MENU, currentId, dvalue);
    	        Swi_post(Swi_writeNand);
 			memcpy(lcdLine1,CHANGE_SUCCESS,16);
     		return currentId;
@@ -1018,7 +1048,7 @@ mnuOperation_Sample(const Uint16 input)
 
 	switch (input)	
 	{
-        case BTN_VALUE 	: return onNextPressed(MNU_OPERATION_STREAM); // BACK TO MENU 1.1. WE DECIDED TO REMOVE MENU 1.5
+        case BTN_VALUE 	: return onNextPressed(MNU_OPERATION_HISTORY);
 		case BTN_STEP 	: return onMnuStepPressed(FXN_OPERATION_SAMPLE_STREAM,MNU_OPERATION_SAMPLE, SAMPLE);
 		case BTN_BACK 	: return onNextPressed(MNU_OPERATION);
 		default			: return MNU_OPERATION_SAMPLE;
@@ -1096,6 +1126,55 @@ fxnOperation_Sample_Value(const Uint16 input)
 	}
 }
 
+/// one 5 character column of the history page
+static void fmtHistCol(char* s, double v)
+{
+	if (v > 99999) v = 99999;
+	if (v < -9999) v = -9999;
+	sprintf(s, ((v > -100) && (v < 1000)) ? "%5.1f" : "%5.0f", v);
+}
+
+// MENU 1.5 History
+// min, mean and max of the last 24 hours - STEP picks the quantity
+Uint16 
+mnuOperation_History(const Uint16 input)
+{
+	if (I2C_TXBUF.n > 0) return MNU_OPERATION_HISTORY;
+
+	static Uint8 q = HIST_Q_WATERCUT;
+	const char histName[HIST_NUM_QTY] = {'W', 'T', 'F', 'R', 'D'};
+	HIST_STAT s;
+	Uint32 now;
+
+	if (isUpdateDisplay)
+	{
+		now = (Uint32)REG_RTC_EPOCH;
+
+		if ((now > 0) && Hist_Range(HIST_T_MINUTE, q, now - 86400, now, &s))
+		{
+			lcdLine1[0] = histName[q];
+			fmtHistCol(lcdLine1+1, s.min);
+			fmtHistCol(lcdLine1+6, s.mean);
+			fmtHistCol(lcdLine1+11, s.max);
+		}
+		else sprintf(lcdLine1, "%c%*s", histName[q], 15, "No Data");
+
+		updateDisplay(HISTORY, lcdLine1);
+	}
+
+	switch (input)	
+	{
+        case BTN_VALUE 	: return onNextPressed(MNU_OPERATION_STREAM);
+		case BTN_STEP 	: 
+			q++;
+			if (q >= HIST_NUM_QTY) q = HIST_Q_WATERCUT;
+			isUpdateDisplay = TRUE;
+			return MNU_OPERATION_HISTORY;
+		case BTN_BACK 	: return onNextPressed(MNU_OPERATION);
+		default			: return MNU_OPERATION_HISTORY;
+	}
+}
+
 // MENU 2.1
 Uint16 
 mnuConfig_Analyzer(const Uint16 input)
@@ -2338,7 +2417,7 @@ mnuConfig_Comm_Statistics(const Uint16 input)
 
 	switch (input)	
 	{
-        case BTN_VALUE 	: return onNextPressed(MNU_CFG_COMM_SLAVEADDR);
+        case BTN_VALUE 	: return onNextPressed(MNU_CFG_COMM_CPULOAD);
 		case BTN_STEP 	: return onMnuStepPressed(FXN_CFG_COMM_STATISTICS,FALSE,CFG_COMM_STATISTICS);
 		case BTN_BACK 	: return onNextPressed(MNU_CFG_COMM);
 		default			: return MNU_CFG_COMM_STATISTICS;
@@ -2376,6 +2455,48 @@ fxnConfig_Comm_Statistics(const Uint16 input)
 }
 
 
+// MENU 2.5.5
+// % load over the last 1 s, 10 s and 60 s - STEP picks the CPU total or one object
+Uint16 
+mnuConfig_Comm_CpuLoad(const Uint16 input)
+{
+	if (I2C_TXBUF.n > 0) return MNU_CFG_COMM_CPULOAD;
+
+	static Uint8 view = 0;
+	const char * cpuName[4] = {"CPU", "HWI", "MB", "Poll"};
+	const Uint8 cpuObj[4] = {SCHED_IDLE, SCHED_HWI_OTHER, SCHED_SWI_MODBUS_RX, SCHED_SWI_POLL};
+	double load[SCHED_CPU_WORDS];
+	int w;
+
+	for (w=0;w<SCHED_CPU_WORDS;w++)
+	{
+		load[w] = REG_CPU[cpuObj[view]*SCHED_CPU_WORDS+w];
+		if (view == 0) load[w] = 100.0 - load[w];	// busy = not idle
+		if (view == 1)								// every HWI slot
+		{
+			load[w] += REG_CPU[SCHED_HWI_UART*SCHED_CPU_WORDS+w];
+			load[w] += REG_CPU[SCHED_HWI_I2C*SCHED_CPU_WORDS+w];
+		}
+	}
+
+	sprintf(lcdLine1,"%-4s%4d%4d%4d",cpuName[view],(int)(load[0]+0.5),(int)(load[1]+0.5),(int)(load[2]+0.5));
+
+    if (isUpdateDisplay) updateDisplay(CFG_COMM_CPULOAD, lcdLine1); 
+    else displayLcd(lcdLine1,LCD1);
+
+	switch (input)	
+	{
+        case BTN_VALUE 	: return onNextPressed(MNU_CFG_COMM_SLAVEADDR);
+		case BTN_STEP 	: 
+			view++;
+			if (view > 3) view = 0;
+			return MNU_CFG_COMM_CPULOAD;
+		case BTN_BACK 	: return onNextPressed(MNU_CFG_COMM);
+		default			: return MNU_CFG_COMM_CPULOAD;
+	}
+}
+
+
 // MENU 2.6
 Uint16 
 mnuConfig_Relay(const Uint16 input)
@@ -2571,6 +2692,7 @@ fxnConfig_Relay_RelayStatus(const Uint16 input)
 			return FXN_CFG_RELAY_RELAYSTATUS;
         case BTN_ENTER  :  
             COIL_RELAY_MANUAL.val = index;
+            Relay_Notify();
             Swi_post(Swi_writeNand);
 			return onNextMessagePressed(FXN_CFG_RELAY_RELAYSTATUS, CHANGE_SUCCESS);
         case BTN_BACK   : return onFxnBackPressed(FXN_CFG_RELAY_RELAYSTATUS);
@@ -2660,7 +2782,7 @@ mnuConfig_DnsCorr_CorrEnable(const Uint16 input)
         if (REG_OIL_DENS_CORR_MODE == 1) VAR_Update(&REG_OIL_DENSITY, REG_OIL_DENSITY_AI, CALC_UNIT);
         else if (REG_OIL_DENS_CORR_MODE == 2) VAR_Update(&REG_OIL_DENSITY, REG_OIL_DENSITY_MODBUS, CALC_UNIT);
         else if (REG_OIL_DENS_CORR_MODE == 3) VAR_Update(&REG_OIL_DENSITY, REG_OIL_DENSITY_MANUAL, CALC_UNIT);
-		else DIAGNOSTICS &= ~(ERR_DNS_LO | ERR_DNS_HI);
+		else Event_Diag(0, ERR_DNS_LO | ERR_DNS_HI, 0);
 
 		updateDisplay(CFG_DNSCORR_CORRENABLE, lcdLine1);
     }
@@ -3663,7 +3785,7 @@ fxnSecurityInfo_Restart(const Uint16 input)
 		case BTN_STEP 	:
 			if (!isEntered) return FXN_SECURITYINFO_RESTART;
 			displayLcd("   RESTARTING   ",LCD1);
-			for (;;);
+			WD_Restart();
 		case BTN_BACK 	:
 			isEntered = FALSE;
 			return onNextPressed(MNU_SECURITYINFO_RESTART);
@@ -3715,7 +3837,7 @@ fxnSecurityInfo_FactReset(const Uint16 input)
             COIL_LOCKED_SOFT_FACTORY_RESET.val = FALSE;   // Unlock SOFT_RESET in reloadFactoryDefault()
             COIL_LOCKED_HARD_FACTORY_RESET.val = TRUE;    // lock HARD_RESET in reloadFactoryDefault()
             Swi_post(Swi_writeNand);
-			for (;;);
+			WD_Restart();
 		case BTN_ENTER 	:
 			isEntered = TRUE;
 			return FXN_SECURITYINFO_FACTRESET;
@@ -3754,7 +3876,6 @@ fxnSecurityInfo_Profile(const Uint16 input)
 
     if (isMessage) { return notifyMessageAndExit(FXN_SECURITYINFO_PROFILE, MNU_SECURITYINFO_PROFILE); }
 
-	const char delim[] = ".csv";
 	char csv_file[MAX_NAME_LENGTH];
 	static BOOL isDownload = TRUE;
 	static BOOL isSelected = FALSE;
@@ -3801,18 +3922,7 @@ fxnSecurityInfo_Profile(const Uint16 input)
 	{
 		if (isScanSuccess) 
     	{    
-        	int i = 0; 
-        	char csv_files[MAX_CSV_ARRAY_LENGTH];
-        	csv_files[0] = '\0';
-        	csv_file[0] = '\0';
-        	strcpy(csv_files, CSV_FILES);
-        	char *ptr = strtok(csv_files, delim);
-        	while (ptr != NULL)
-        	{
-            	if (csvIndex == i) sprintf(csv_file, "%s", ptr);
-            	ptr = strtok(NULL, delim);
-            	i++;
-        	}
+        	Csv_Index_Name(csvIndex, csv_file);
 
 			if (isSelected) blinkLcdLine1(csv_file,STEP_CONFIRM);
         	else blinkLcdLine1(csv_file,BLANK);
@@ -3851,8 +3961,7 @@ fxnSecurityInfo_Profile(const Uint16 input)
 			}
 			else
 			{
-				isScanCsvFiles = TRUE;
-				Swi_post(Swi_scanCsvFiles);
+				Csv_Index_Request();
 			}
             return FXN_SECURITYINFO_PROFILE;
         case BTN_BACK   : return onFxnBackPressed(FXN_SECURITYINFO_PROFILE);
@@ -39,40 +39,134 @@
 #include "device_nand.h"
 #include "Globals.h"
 #include "util.h"
+#include "Watchdog.h"
 #include <ti/fs/fatfs/ff.h>
 
 /************************************************************
 * FIRMWARE AND VARIABLE START BLOCK ADDRESS
 ************************************************************/
 #define PDI_RAZOR_FIRMWARE 		"0:pdi_razor_firmware.ais"
+#define PDI_RAZOR_FIRMWARE_CRC 	"0:pdi_razor_firmware.crc"
 #define ACCESS_DELAY			1000
 #define APP_START_BLK 			1
 #define VAR_START_BLK 			50
 
+/************************************************************
+* FIRMWARE SLOTS (blocks APP_START_BLK..VAR_START_BLK-1).
+* Slot A comes first, so the ROM starts it whenever it
+* holds an AIS header; slot B only once A's is erased.
+************************************************************/
+#define FW_SLOT_BLKS			24
+#define FW_SLOT_A				0
+#define FW_SLOT_B				1
+#define FW_SLOT_FIRST_BLK(s)	(APP_START_BLK + (s) * FW_SLOT_BLKS)
+#define FW_SLOT_LAST_BLK(s)		(FW_SLOT_FIRST_BLK(s) + FW_SLOT_BLKS - 1)
+#define FW_MARK_BLK				(VAR_START_BLK - 1)
+#define FW_UNLOCK_FIRST_BLK		APP_START_BLK	// both slots, the records and the variables,
+#define FW_UNLOCK_NUM_BLKS		(MAX_BLK_NUM - APP_START_BLK + 1)	// not the copies past MAX_BLK_NUM
+#define FW_AIS_MAGIC			0x41504954	// first word of an AIS image
+#define FW_CRC32_POLY			0x04C11DB7
+#define FW_REC_MAGIC			0x46575232	// "FWR2"; "FWRC" records described a boot slot copy
+#define FW_STATE_STAGED			1			// staged image verified, slot being made bootable
+#define FW_STATE_ACTIVE			2			// the ROM starts the staged slot
+
+/************************************************************
+* VARIABLE COPIES (the "CFG" section). The layout version
+* is part of the magic; bump it whenever a CFG variable is
+* added, removed, resized or moved, so that a copy of the
+* old layout is not read into the new one.
+************************************************************/
+#define CFG_FIRST_BLK			VAR_START_BLK
+#define CFG_NUM_BLKS			4			// round robin, one copy per block
+#define CFG_LAYOUT_VERSION		1
+#define CFG_NV_MAGIC			(0x43534E00 | CFG_LAYOUT_VERSION)	// "CSN" + version
+
+/************************************************************
+* HISTORY, TOTALIZER AND SCRIPT COPIES (past MAX_BLK_NUM, so
+* FW_commit() keeps them)
+************************************************************/
+#define HIST_FIRST_BLK			(MAX_BLK_NUM + 1)
+#define HIST_NUM_BLKS			8			// round robin, one copy per block
+#define HIST_NV_MAGIC			0x48534E31	// "HSN1"
+#define TOT_FIRST_BLK			(HIST_FIRST_BLK + HIST_NUM_BLKS)
+#define TOT_NUM_BLKS			4
+#define TOT_NV_MAGIC			0x54534E31	// "TSN1"
+#define SIG_FIRST_BLK			(TOT_FIRST_BLK + TOT_NUM_BLKS)
+#define SIG_NUM_BLKS			2
+#define SIG_NV_MAGIC			0x53534E31	// "SSN1"
+
 /************************************************************
 * Local Macro Declarations                                  *
 ************************************************************/
 
 #define NANDWIDTH_16
 #define MAX_BLK_NUM     		220
-#define SIZE_CFG        		52244
 #define FBASE           		0x62000000
 #define NANDStart       		0x62000000
 
+/************************************************************
+* Local Typedef Declarations                                *
+************************************************************/
+
+typedef struct
+{
+	Uint32 magic;
+	Uint32 seq;
+	Uint32 state;
+	Uint32 slot;		// FW_SLOT_A or FW_SLOT_B
+	Uint32 scratch;		// block holding the staged copy of image block 0
+	Uint32 pages;
+	Uint32 size;
+	Uint32 crc;			// CRC32 of the image
+	Uint32 recCrc;		// CRC32 of the fields above
+} FW_RECORD;
+
+#define FW_REC_CRC_LEN			(sizeof(FW_RECORD) - sizeof(Uint32))
+
+typedef struct
+{
+	Uint32 magic;
+	Uint32 seq;
+	Uint32 size;
+	Uint32 crc;			// CRC32 of the data
+	Uint32 recCrc;		// CRC32 of the fields above
+} NV_HEADER;
+
+#define NV_CRC_LEN				(sizeof(NV_HEADER) - sizeof(Uint32))
+
+/// blocks of one round robin of copies
+typedef struct
+{
+	Uint32 first;
+	Uint32 num;
+	Uint32 magic;
+} NV_RING;
+
+static const NV_RING CFG_RING = { CFG_FIRST_BLK, CFG_NUM_BLKS, CFG_NV_MAGIC };
+static const NV_RING HIST_RING = { HIST_FIRST_BLK, HIST_NUM_BLKS, HIST_NV_MAGIC };
+static const NV_RING TOT_RING = { TOT_FIRST_BLK, TOT_NUM_BLKS, TOT_NV_MAGIC };
+static const NV_RING SIG_RING = { SIG_FIRST_BLK, SIG_NUM_BLKS, SIG_NV_MAGIC };
+
 /************************************************************
 * Global Variable Definitions for page buffers              *
 ************************************************************/
 
 extern VUint32 __FAR__ DDRStart;
-static Uint8* gNandTx;
-static Uint8* gNandRx;
+
+/// the "CFG" section as linked (PDI_Razor.cmd)
+extern __FAR__ Uint8 CFG_START, CFG_END;
+#define CFG_SIZE				((Uint32)&CFG_END - (Uint32)&CFG_START)
+
+/// writeNand() is deferred while the upgrade owns the NAND
+static volatile BOOL isFwUpgrading = FALSE;
+static volatile BOOL isStorePending = FALSE;
 
 /************************************************************
 * Function Declarations                                     *
 ************************************************************/
 
-static Uint32 LOCAL_writeData(NAND_InfoHandle hNandInfo, Uint8 *srcBuf, Uint32 totalPageCnt);
-static Uint32 USB_writeData(NAND_InfoHandle hNandInfo, Uint8 *srcBuf, Uint32 totalPageCnt);
+static Uint32 NV_store(const NV_RING* ring, const Uint8* src, Uint32 size);
+static Uint32 NV_restore(const NV_RING* ring, Uint8* dst, Uint32 size);
 extern void UTIL_setCurrMemPtr(void *value);
 
 /************************************************************
@@ -87,362 +181,576 @@ static Uint8 DEVICE_ASYNC_MEM_IsNandReadyPin(ASYNC_MEM_InfoHandle hAsyncMemInfo)
 
 void writeNand(void)
 {
+	/// the firmware upgrade owns the NAND; it stores the variables when it is done
+	if (isFwUpgrading)
+	{
+		isStorePending = TRUE;
+		return;
+	}
+
 	Swi_disable();
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	WD_Service();
 	Store_Vars_in_NAND();
 	Swi_enable();
 }
 
 /****************************************************************************************
  * Store_Vars_in_NAND() writes all variables in the "CFG" data section into NAND flash	*
+ * The section is the one the linker placed (CFG_START..CFG_END), so the copy is the	*
+ * exact size of the variables. It goes into the next block of CFG_RING like the		*
+ * history and totalizer copies, so a power loss during a store leaves the previous		*
+ * copy intact.																			*
  ****************************************************************************************/
 void Store_Vars_in_NAND(void)
 {
-    Uint32 num_pages;
-    NAND_InfoHandle  hNandInfo;
-    Uint8 *heapPtr, *cfgPtr;
-    Int32 data_size = 0, alloc_size = 0, i = 0;
+	NV_store(&CFG_RING, (const Uint8*)&CFG_START, CFG_SIZE);
+}
 
-    UTIL_setCurrMemPtr(0);
 
-    // Initialize NAND Flash
-    hNandInfo = NAND_open((Uint32)NANDStart, BUS_16BIT );
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+/****************************************************************************************
+ * Restore_Vars_From_NAND() reads the newest intact copy of the "CFG" data section		*
+ * back into RAM. A copy of another layout (another CFG_LAYOUT_VERSION or size, or the	*
+ * headerless image of older firmware) is rejected: the section is then cleared and	*
+ * Init_All() finds no factory reset level, so the unit starts from factory defaults	*
+ * instead of from variables at shifted offsets.										*
+ ****************************************************************************************/
+Uint32 Restore_Vars_From_NAND(void)
+{
+	return NV_restore(&CFG_RING, (Uint8*)&CFG_START, CFG_SIZE);
+}
+
+
+/****************************************************************************************
+ * Firmware upgrade																		*
+ *																						*
+ * There are two firmware slots, A and B. The C6748 ROM boot loader starts the first	*
+ * block from APP_START_BLK on whose page 0 holds an AIS header, so it starts slot A	*
+ * while A has one and slot B otherwise. This assumes the ROM searches at least			*
+ * 2 * FW_SLOT_BLKS blocks, which the boot loader guide of the silicon revision in use	*
+ * has to confirm. The new image is streamed from USB into the slot the ROM does not	*
+ * start, while measurement keeps running, and is verified there with CRC32. Image		*
+ * block 0 is staged in a scratch block at the end of that slot, its AIS magic cleared	*
+ * so the ROM never starts it, and the slot's own block 0 stays erased. The slot only	*
+ * becomes bootable at the commit, when block 0 is copied in with page 0 last.			*
+ *																						*
+ * The switch from A to B is the erase of A's first block, once B has been verified;	*
+ * before it the ROM starts A, after it B. The switch from B to A is the program of		*
+ * page 0 of A's first block, so A is complete before the ROM can see it; this relies	*
+ * on the part accepting the pages of a block out of order, as SLC NAND does. A power	*
+ * loss in the middle of that one page program can leave a torn AIS header, the only	*
+ * state in which the board does not start; razor_fwcut (host/fwcut_sim.c) counts it.	*
+ * Anything else interrupted is finished by Resume_Firmware_Upgrade() from the commit	*
+ * record at the next start, or leaves the old image running.							*
+ ****************************************************************************************/
+
+/// streaming page buffer and CRC32 lookup table; the UTIL heap is owned by writeNand()
+static Uint8 fwPage[NAND_MAX_PAGE_SIZE];
+static Uint32 fwCrcLut[256];
+static BOOL isFwCrcLut = FALSE;
+
+/// heartbeat of the upgrade job; kicks directly while SWIs are disabled for the commit
+static inline void FW_progress(void)
+{
+	WD_Checkin(WD_CTX_JOB);
+	WD_Service();
+}
 
-    if (hNandInfo == NULL) return;
-    data_size = SIZE_CFG;
-    num_pages = 0;
-    while ((num_pages * hNandInfo->dataBytesPerPage) < data_size) 
+static void FW_crcInit(void)
+{
+	if (isFwCrcLut) return;
+	UTIL_buildCRC32Table(fwCrcLut, FW_CRC32_POLY);
+	isFwCrcLut = TRUE;
+}
+
+/// collect up to <n> good blocks of [first,last]; returns the number found
+static Uint32 FW_slotBlocks(NAND_InfoHandle hNandInfo, Uint32 first, Uint32 last, Uint32* blk, Uint32 n)
+{
+	Uint32 i, cnt = 0;
+
+	for (i=first; (i<=last) && (cnt<n); i++)
 	{
-		num_pages++;
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		if (NAND_badBlockCheck(hNandInfo,i) == E_PASS) blk[cnt++] = i;
 	}
 
-    // we want to allocate an even number of pages.
-    alloc_size = num_pages * hNandInfo->dataBytesPerPage;
+	return cnt;
+}
 
-    // setup pointer in RAM
-    hNandInfo = NAND_open((Uint32)NANDStart, BUS_16BIT );
-    heapPtr = (Uint8 *) UTIL_allocMem(alloc_size);
-    cfgPtr = (Uint8*) ADDR_DDR_CFG;
+static Uint32 FW_firstWord(const Uint8* page)
+{
+	Uint32 w;
+
+	memcpy(&w, page, sizeof(w));
+	return w;
+}
+
+static void FW_setFirstWord(Uint8* page, Uint32 w)
+{
+	memcpy(page, &w, sizeof(w));
+}
 
-    // copy data to heap
-    for (i=0; i<alloc_size; i++) 
+/// TRUE if the ROM would start the slot
+static BOOL FW_hasHeader(NAND_InfoHandle hNandInfo, Uint32 slot, Uint32* first)
+{
+	if (FW_slotBlocks(hNandInfo, FW_SLOT_FIRST_BLK(slot), FW_SLOT_LAST_BLK(slot), first, 1) == 0) return FALSE;
+	if (NAND_readPage(hNandInfo, *first, 0, fwPage) != E_PASS) return FALSE;
+
+	return (FW_firstWord(fwPage) == FW_AIS_MAGIC);
+}
+
+/// the slot the ROM starts
+static Uint32 FW_romSlot(NAND_InfoHandle hNandInfo)
+{
+	Uint32 first;
+
+	return FW_hasHeader(hNandInfo, FW_SLOT_A, &first) ? FW_SLOT_A : FW_SLOT_B;
+}
+
+/// page <p> of the image in the slot, or as staged: block 0 from the scratch block
+static Uint32 FW_readImagePage(NAND_InfoHandle hNandInfo, const FW_RECORD* rec, const Uint32* blk, Uint32 p, BOOL isStaged)
+{
+	Uint32 ppb = hNandInfo->pagesPerBlock;
+
+	if (!isStaged || (p >= ppb)) return NAND_readPage(hNandInfo, blk[p/ppb], p%ppb, fwPage);
+
+	if (NAND_readPage(hNandInfo, rec->scratch, p, fwPage) != E_PASS) return E_FAIL;
+	if (p == 0) FW_setFirstWord(fwPage, FW_AIS_MAGIC);
+
+	return E_PASS;
+}
+
+/// CRC32 of the first <size> bytes of the image
+static Uint32 FW_crcImage(NAND_InfoHandle hNandInfo, const FW_RECORD* rec, BOOL isStaged, Uint32* crc)
+{
+	Uint32 blk[FW_SLOT_BLKS];
+	Uint32 p, n, ppb, left;
+
+	ppb = hNandInfo->pagesPerBlock;
+	if (FW_slotBlocks(hNandInfo, FW_SLOT_FIRST_BLK(rec->slot), FW_SLOT_LAST_BLK(rec->slot), blk, FW_SLOT_BLKS) * ppb < rec->pages) return E_FAIL;
+
+	*crc = 0;
+	left = rec->size;
+
+	for (p=0; p<rec->pages; p++)
 	{
-		heapPtr[i]=cfgPtr[i];
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		if (p % ppb == 0) FW_progress();
+		if (FW_readImagePage(hNandInfo, rec, blk, p, isStaged) != E_PASS) return E_FAIL;
+
+		n = (left < hNandInfo->dataBytesPerPage) ? left : hNandInfo->dataBytesPerPage;
+		*crc = UTIL_calcCRC32(fwCrcLut, fwPage, n, *crc);
+		left -= n;
 	}
 
-    // Write the file data to the NAND flash
-    if (LOCAL_writeData(hNandInfo, heapPtr, num_pages) != E_PASS) return;
+	return E_PASS;
 }
 
-
-/****************************************************************************************
- * Restore_Vars_From_NAND() reads all data values stored in NAND memory and				*
- * writes them to the "CFG" data section in RAM											*
- ****************************************************************************************/
-Uint32 Restore_Vars_From_NAND(void)
+/// newest valid record of the commit block
+static Uint32 FW_readRecord(NAND_InfoHandle hNandInfo, FW_RECORD* rec, Uint32* nextPage)
 {
-    Uint8 *dataPtr;
-    Int32 data_size = 0;
-    NAND_InfoHandle hNandInfo;
-    Uint32 numBlks, num_pages, i, blockNum, pageNum, pageCnt;
+	FW_RECORD r;
+	Uint32 page, isFound = E_FAIL;
 
-    hNandInfo = NAND_open((Uint32)NANDStart, BUS_16BIT );
+	*nextPage = hNandInfo->pagesPerBlock;
+	if (NAND_badBlockCheck(hNandInfo,FW_MARK_BLK) != E_PASS) return E_FAIL;
 
-    data_size = SIZE_CFG;
-    num_pages = 0;
+	for (page=0; page<hNandInfo->pagesPerBlock; page++)
+	{
+		/// an erased page reads back all 1s or fails ECC; either way it ends the log
+		if (NAND_readPage(hNandInfo, FW_MARK_BLK, page, fwPage) != E_PASS) break;
+		memcpy(&r, fwPage, sizeof(r));
+		if (r.magic == 0xFFFFFFFF) break;
 
-    while ((num_pages * hNandInfo->dataBytesPerPage)  < data_size)  num_pages++;
+		if ((r.magic == FW_REC_MAGIC) &&
+			(r.recCrc == UTIL_calcCRC32(fwCrcLut, (Uint8*)&r, FW_REC_CRC_LEN, 0)))
+		{
+			*rec = r;
+			isFound = E_PASS;
+		}
+	}
 
-    gNandTx = (Uint8 *) UTIL_allocMem(NAND_MAX_PAGE_SIZE);
-    gNandRx = (Uint8 *) UTIL_allocMem(NAND_MAX_PAGE_SIZE);
+	*nextPage = page;
+	return isFound;
+}
 
-    for (i=0; i<NAND_MAX_PAGE_SIZE; i++)
-    {
-        gNandTx[i]=0xff;
-        gNandRx[i]=0xff;
-    }
+/// append a record to the commit block - a single page program is the commit point
+static Uint32 FW_writeRecord(NAND_InfoHandle hNandInfo, Uint32 state, FW_RECORD* rec)
+{
+	FW_RECORD last;
+	Uint32 page;
 
-    // Get total number of blocks needed
-    numBlks = 0;
-    while ((numBlks*hNandInfo->pagesPerBlock) < num_pages) numBlks++;
+	rec->seq = (FW_readRecord(hNandInfo, &last, &page) == E_PASS) ? last.seq + 1 : 1;
+	if (NAND_badBlockCheck(hNandInfo,FW_MARK_BLK) != E_PASS) return E_FAIL;
 
-    // Start in block 50
-    // Leave blocks 0-49 alone, reserved for the boot image + bad blocks
-    blockNum = VAR_START_BLK;
+	if (page >= hNandInfo->pagesPerBlock)
+	{
+		if (NAND_eraseBlocks(hNandInfo, FW_MARK_BLK, 1) != E_PASS) return E_FAIL;
+		page = 0;
+	}
 
-    while (blockNum < hNandInfo->numBlocks)
-    {
-        // Find first good block
-        if (NAND_badBlockCheck(hNandInfo,blockNum) != E_PASS) return E_FAIL;
+	rec->magic = FW_REC_MAGIC;
+	rec->state = state;
+	rec->recCrc = UTIL_calcCRC32(fwCrcLut, (Uint8*)rec, FW_REC_CRC_LEN, 0);
 
-        // Start writing in page 0 of current block
-        pageNum = 0;
-        pageCnt = 0;
+	memset(fwPage, 0xFF, hNandInfo->dataBytesPerPage);
+	memcpy(fwPage, rec, sizeof(*rec));
 
-        // Setup data pointer
-        dataPtr = (Uint8*)ADDR_DDR_CFG;
+	return NAND_writePage(hNandInfo, FW_MARK_BLK, page, fwPage);
+}
 
-        // Start page read loop
-        do
-        {
-            UTIL_waitLoop(200);
+/// copy image block 0 from the scratch block into the slot, page 0 last: programming
+/// that page makes the slot bootable. No block is marked bad here, as that would move
+/// the rest of the image.
+static Uint32 FW_copyHead(NAND_InfoHandle hNandInfo, const FW_RECORD* rec, Uint32 dst)
+{
+	Uint32 i, p, nPages;
 
-            if (NAND_readPage(hNandInfo, blockNum, pageNum, gNandRx) != E_PASS) return E_FAIL;
+	nPages = (rec->pages < hNandInfo->pagesPerBlock) ? rec->pages : hNandInfo->pagesPerBlock;
 
-            for (i=0;i<hNandInfo->dataBytesPerPage;i++)
-                dataPtr[i+pageNum*hNandInfo->dataBytesPerPage] = gNandRx[i];
+	FW_progress();
+	if (NAND_eraseBlocks(hNandInfo, dst, 1) != E_PASS) return E_FAIL;
 
-            pageNum++;
-            pageCnt++;
+	for (i=1; i<=nPages; i++)
+	{
+		p = i % nPages;
+		if (FW_readImagePage(hNandInfo, rec, NULL, p, TRUE) != E_PASS) return E_FAIL;
+		if (NAND_writePage(hNandInfo, dst, p, fwPage) != E_PASS) return E_FAIL;
+	}
 
-            if (pageNum == hNandInfo->pagesPerBlock)
-            {
-                // A block transition needs to take place; go to next good block
-                do
-                {
-                    blockNum++;
-                    if (blockNum > MAX_BLK_NUM) return E_FAIL;  //exceeded the "max" addressable block
-                }
-                while (NAND_badBlockCheck(hNandInfo,blockNum) != E_PASS);
+	return E_PASS;
+}
 
-                pageNum = 0;
-            }
-        } while (pageCnt < num_pages);
+/// make a verified staged image the one the ROM starts; every step can be repeated
+static Uint32 FW_commit(NAND_InfoHandle hNandInfo, FW_RECORD* rec)
+{
+	Uint32 crc, first, i;
 
-        break;
-    }
-    return E_PASS;
+	if ((FW_crcImage(hNandInfo, rec, FALSE, &crc) != E_PASS) || (crc != rec->crc))
+	{
+		if (FW_slotBlocks(hNandInfo, FW_SLOT_FIRST_BLK(rec->slot), FW_SLOT_LAST_BLK(rec->slot), &first, 1) == 0) return E_FAIL;
+		if (FW_copyHead(hNandInfo, rec, first) != E_PASS) return E_FAIL;
+		if (FW_crcImage(hNandInfo, rec, FALSE, &crc) != E_PASS) return E_FAIL;
+		if (crc != rec->crc) return E_FAIL;
+	}
+
+	/// the switch from A to B
+	if ((rec->slot == FW_SLOT_B) && FW_hasHeader(hNandInfo, FW_SLOT_A, &first))
+	{
+		FW_progress();
+		if (NAND_eraseBlocks(hNandInfo, first, 1) != E_PASS) return E_FAIL;
+	}
+
+	/// the stored variables are cleared as the global erase used to do
+	for (i=VAR_START_BLK; i<=MAX_BLK_NUM; i++)
+	{
+		FW_progress();
+		if (NAND_badBlockCheck(hNandInfo,i) == E_PASS) NAND_eraseBlocks(hNandInfo,i,1);
+	}
+
+	return FW_writeRecord(hNandInfo, FW_STATE_ACTIVE, rec);
 }
 
+/****************************************************************************************
+ * Variable, history, totalizer and script copies										*
+ *																						*
+ * History.c and Totalizer.c keep their state in retained RAM, which a power loss		*
+ * clears. From time to time they hand a copy to Store_Hist_in_NAND() and				*
+ * Store_Tot_in_NAND(); SigGen.c stores REG_SIG_SCRIPT[] and Store_Vars_in_NAND() the	*
+ * "CFG" section the same way. Each has its own ring of blocks, and each copy goes		*
+ * into the next block of the ring. The data pages are written first and the header	*
+ * page last, so a copy cut short by a reset has no valid header and the previous copy	*
+ * stays the newest. The variable ring is cleared by a firmware upgrade; the others lie	*
+ * past the variable area and survive it. fwPage is shared with the upgrade, which		*
+ * holds off the copies while it runs.													*
+ ****************************************************************************************/
 
-// Generic function to write a UBL or Application header and the associated data
-static Uint32 LOCAL_writeData(NAND_InfoHandle hNandInfo, Uint8 *srcBuf, Uint32 totalPageCnt)
+/// header of the copy in <blk>, which sits in the page after the data
+static Uint32 NV_readHeader(NAND_InfoHandle hNandInfo, const NV_RING* ring, Uint32 blk, Uint32 size, NV_HEADER* hdr)
 {
-	Uint32 blockNum,pageNum,pageCnt;
-  	Uint32 numBlks;
-  	Uint32 i;
-  	Uint8  *dataPtr;
+	Uint32 pages = (size + hNandInfo->dataBytesPerPage - 1) / hNandInfo->dataBytesPerPage;
 
-  	gNandTx = (Uint8 *) UTIL_allocMem(NAND_MAX_PAGE_SIZE);
-  	gNandRx = (Uint8 *) UTIL_allocMem(NAND_MAX_PAGE_SIZE);
+	if (NAND_badBlockCheck(hNandInfo,blk) != E_PASS) return E_FAIL;
+	if (NAND_readPage(hNandInfo, blk, pages, fwPage) != E_PASS) return E_FAIL;
+	memcpy(hdr, fwPage, sizeof(*hdr));
 
-  	for (i=0; i<NAND_MAX_PAGE_SIZE; i++)
-  	{
-    	gNandTx[i]=0xff;
-    	gNandRx[i]=0xff;
-  	}
+	if ((hdr->magic != ring->magic) || (hdr->size != size)) return E_FAIL;
+	if (hdr->recCrc != UTIL_calcCRC32(fwCrcLut, (Uint8*)hdr, NV_CRC_LEN, 0)) return E_FAIL;
 
-  	// Get total number of blocks needed
-  	numBlks = 0;
-  	while ((numBlks*hNandInfo->pagesPerBlock) < totalPageCnt) 
+	return E_PASS;
+}
+
+/// newest copy with a sequence number below <below>
+static Uint32 NV_newest(NAND_InfoHandle hNandInfo, const NV_RING* ring, Uint32 size, Uint32 below, Uint32* blk, NV_HEADER* hdr)
+{
+	NV_HEADER h;
+	Uint32 i, isFound = E_FAIL;
+
+	for (i=ring->first; i<ring->first+ring->num; i++)
 	{
-		numBlks++;
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		if (NV_readHeader(hNandInfo, ring, i, size, &h) != E_PASS) continue;
+		if (h.seq >= below) continue;
+		if ((isFound == E_PASS) && (h.seq <= hdr->seq)) continue;
+
+		*hdr = h;
+		*blk = i;
+		isFound = E_PASS;
 	}
 
-	// Start in block 50 : Leave blocks 0-49 alone -- reserved for the boot image + potential bad blocks
-	blockNum = 50;
+	return isFound;
+}
 
-  	// Unprotect all blocks of the device
-  	if (NAND_unProtectBlocks(hNandInfo, blockNum, (hNandInfo->numBlocks-1)) != E_PASS)
-  	{
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
-    	blockNum++;
-    	return E_FAIL;
-  	}
+/// erase <blk> and write the data pages, then the header page
+static Uint32 NV_writeCopy(NAND_InfoHandle hNandInfo, Uint32 blk, const Uint8* src, NV_HEADER* hdr)
+{
+	Uint32 p, n, pages, pageBytes, left;
 
-  	while (blockNum < hNandInfo->numBlocks)
-  	{
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	pageBytes = hNandInfo->dataBytesPerPage;
+	pages = (hdr->size + pageBytes - 1) / pageBytes;
+
+	if (NAND_eraseBlocks(hNandInfo, blk, 1) != E_PASS) return E_FAIL;
+
+	left = hdr->size;
+	for (p=0; p<=pages; p++)
+	{
+		memset(fwPage, 0xFF, pageBytes);
+
+		if (p < pages)
+		{
+			n = (left < pageBytes) ? left : pageBytes;
+			memcpy(fwPage, src + p*pageBytes, n);
+			left -= n;
+		}
+		else memcpy(fwPage, hdr, sizeof(*hdr));
 
-    	// Find first good block
-    	while (NAND_badBlockCheck(hNandInfo,blockNum) != E_PASS) 
+		if (NAND_writePage(hNandInfo, blk, p, fwPage) != E_PASS)
 		{
-			blockNum++;
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
+			NAND_reset(hNandInfo);
+			NAND_badBlockMark(hNandInfo, blk);
+			return E_FAIL;
 		}
+	}
 
-    	// Erase the current block
-    	NAND_eraseBlocks(hNandInfo,blockNum,1);
+	return E_PASS;
+}
 
-    	// Start writing in page 0 of current block
-    	pageNum = 0;
-    	pageCnt = 0;
+/// write <size> bytes into the next block of <ring>; SWIs disabled
+static Uint32 NV_store(const NV_RING* ring, const Uint8* src, Uint32 size)
+{
+	NAND_InfoHandle hNandInfo;
+	NV_HEADER hdr, last;
+	Uint32 blk, i, result;
 
-   		// Setup data pointer
-    	dataPtr = srcBuf;
+	if (isFwUpgrading) return E_FAIL;
 
-    	// Start page writing loop
-    	do
-    	{
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
-      		// Write the AIS image data to the NAND device
-      		if (NAND_writePage(hNandInfo, blockNum,  pageNum, dataPtr) != E_PASS)
-      		{
-        		NAND_reset(hNandInfo);
-        		NAND_badBlockMark(hNandInfo,blockNum);
-        		dataPtr -= pageNum * hNandInfo->dataBytesPerPage;
-        		blockNum++;
-        		continue;
-      		}
-
-      		UTIL_waitLoop(400);
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
-
-      		// Verify the page just written
-      		//if (NAND_verifyPage(hNandInfo, blockNum, pageNum, dataPtr, gNandRx) != E_PASS) {}
-
-      		pageNum++;
-      		pageCnt++;
-      		dataPtr +=  hNandInfo->dataBytesPerPage;
-
-      		if (pageNum == hNandInfo->pagesPerBlock)
-      		{
-        		// A block transition needs to take place; go to next good block
-        		do
-        		{
-					TimerWatchdogReactivate(CSL_TMR_1_REGS);
-          			blockNum++;
-        		}
-        		while (NAND_badBlockCheck(hNandInfo,blockNum) != E_PASS);
-
-        		// Erase the current block
-        		NAND_eraseBlocks(hNandInfo,blockNum,1);
-
-        		pageNum = 0;
-      		}
-    	} while (pageCnt < totalPageCnt);
-
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
-    	NAND_protectBlocks(hNandInfo);
-    	break;
-  	}
-  	return E_PASS;
-}
+	/// the UTIL heap only holds the NAND handle
+	UTIL_setCurrMemPtr(0);
+    hNandInfo = NAND_open((Uint32)NANDStart, BUS_16BIT );
+    if (hNandInfo == NULL) return E_FAIL;
+
+	/// data pages plus the header page in one block
+	if ((size + hNandInfo->dataBytesPerPage - 1) / hNandInfo->dataBytesPerPage >= hNandInfo->pagesPerBlock) return E_FAIL;
+
+	FW_crcInit();
+
+	hdr.seq = 1;
+	blk = ring->first + ring->num - 1;
+	if (NV_newest(hNandInfo, ring, size, 0xFFFFFFFF, &blk, &last) == E_PASS) hdr.seq = last.seq + 1;
+
+	/// the good block after the newest copy
+	for (i=0; i<ring->num; i++)
+	{
+		blk = ring->first + (blk + 1 - ring->first) % ring->num;
+		if (NAND_badBlockCheck(hNandInfo,blk) == E_PASS) break;
+	}
+	if (i == ring->num) return E_FAIL;
+
+	hdr.magic = ring->magic;
+	hdr.size = size;
+	hdr.crc = UTIL_calcCRC32(fwCrcLut, (Uint8*)src, size, 0);
+	hdr.recCrc = UTIL_calcCRC32(fwCrcLut, (Uint8*)&hdr, NV_CRC_LEN, 0);
 
+	if (NAND_unProtectBlocks(hNandInfo, ring->first, ring->num) != E_PASS) return E_FAIL;
+	result = NV_writeCopy(hNandInfo, blk, src, &hdr);
+	NAND_protectBlocks(hNandInfo);
 
-static Uint32 USB_writeData(NAND_InfoHandle hNandInfo, Uint8 *srcBuf, Uint32 totalPageCnt)
+	return result;
+}
+
+/// newest intact copy of <size> bytes in <ring>; <dst> is cleared if there is none
+static Uint32 NV_restore(const NV_RING* ring, Uint8* dst, Uint32 size)
 {
-	Uint32    blockNum,pageNum,pageCnt;
-  	Uint32    numBlks;
-  	Uint32    i;
-  	Uint8     *dataPtr;
+	NAND_InfoHandle hNandInfo;
+	NV_HEADER hdr;
+	Uint32 blk, p, n, pages, pageBytes, left, crc, below = 0xFFFFFFFF;
 
-  	gNandTx = (Uint8 *) UTIL_allocMem(NAND_MAX_PAGE_SIZE);
-  	gNandRx = (Uint8 *) UTIL_allocMem(NAND_MAX_PAGE_SIZE);
+	memset(dst, 0, size);
 
-  	for (i=0; i<NAND_MAX_PAGE_SIZE; i++)
-  	{
+	UTIL_setCurrMemPtr(0);
+    hNandInfo = NAND_open((Uint32)NANDStart, BUS_16BIT );
+    if (hNandInfo == NULL) return E_FAIL;
 
-    	gNandTx[i]=0xff;
-    	gNandRx[i]=0xff;
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
-  	}
+	pageBytes = hNandInfo->dataBytesPerPage;
+	pages = (size + pageBytes - 1) / pageBytes;
+	if (pages >= hNandInfo->pagesPerBlock) return E_FAIL;
 
-  	// Get total number of blocks needed
-  	numBlks = 0;
-  	while ( (numBlks*hNandInfo->pagesPerBlock) < totalPageCnt ) numBlks++;
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	FW_crcInit();
 
-  	// Start in block 1 (leave block 0 alone)
-  	blockNum = 1;
+	/// fall back to an older copy if the data of the newest does not check out
+	while (NV_newest(hNandInfo, ring, size, below, &blk, &hdr) == E_PASS)
+	{
+		below = hdr.seq;
+		left = size;
+		crc = 0;
 
-  	// Unprotect all blocks of the device
-  	while (NAND_unProtectBlocks(hNandInfo, blockNum, (hNandInfo->numBlocks-1)) != E_PASS) blockNum++;
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+		for (p=0; p<pages; p++)
+		{
+			if (NAND_readPage(hNandInfo, blk, p, fwPage) != E_PASS) break;
 
-   	// Find first good block
-   	while (NAND_badBlockCheck(hNandInfo,blockNum) != E_PASS) blockNum++;
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+			n = (left < pageBytes) ? left : pageBytes;
+			memcpy(dst + p*pageBytes, fwPage, n);
+			crc = UTIL_calcCRC32(fwCrcLut, fwPage, n, crc);
+			left -= n;
+		}
 
-   	// Erase the current block
-   	NAND_eraseBlocks(hNandInfo,blockNum,1);
+		if ((p == pages) && (crc == hdr.crc)) return E_PASS;
+	}
 
-   	// Start writing in page 0 of current block
-   	pageNum = 0;
-   	pageCnt = 0;
+	memset(dst, 0, size);
+	return E_FAIL;
+}
 
-   	// Setup data pointer
-   	dataPtr = srcBuf;
+/****************************************************************************************
+ * Store_Hist_in_NAND() writes <size> bytes of the trend store into the next history	*
+ * block. Call with SWIs disabled, like Store_Vars_in_NAND().							*
+ ****************************************************************************************/
+Uint32 Store_Hist_in_NAND(const Uint8* src, Uint32 size)
+{
+	return NV_store(&HIST_RING, src, size);
+}
 
-   	// Start page writing loop
-   	do
-   	{
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+/****************************************************************************************
+ * Restore_Hist_From_NAND() reads the newest intact copy of <size> bytes into <dst>.	*
+ * <dst> is cleared if there is none.													*
+ ****************************************************************************************/
+Uint32 Restore_Hist_From_NAND(Uint8* dst, Uint32 size)
+{
+	return NV_restore(&HIST_RING, dst, size);
+}
 
-   		/// write AIS image data to the NAND device
-   		if (NAND_writePage(hNandInfo, blockNum,  pageNum, dataPtr) != E_PASS)
-   		{
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
-       		NAND_reset(hNandInfo);
-       		NAND_badBlockMark(hNandInfo,blockNum);
-       		dataPtr -=  pageNum * hNandInfo->dataBytesPerPage;
-       		blockNum++;
-       		continue;
-   		}
+/****************************************************************************************
+ * Store_Tot_in_NAND() and Restore_Tot_From_NAND() do the same for the totals, in		*
+ * their own blocks, so a totalizer save does not rewrite the variable area.			*
+ ****************************************************************************************/
+Uint32 Store_Tot_in_NAND(const Uint8* src, Uint32 size)
+{
+	return NV_store(&TOT_RING, src, size);
+}
 
-   		for(i=0;i<ACCESS_DELAY;i++);
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+Uint32 Restore_Tot_From_NAND(Uint8* dst, Uint32 size)
+{
+	return NV_restore(&TOT_RING, dst, size);
+}
 
-   		pageNum++;
-   		pageCnt++;
-   		dataPtr +=  hNandInfo->dataBytesPerPage;
+/****************************************************************************************
+ * Store_Sig_in_NAND() and Restore_Sig_From_NAND() keep the process model script		*
+ * (REG_SIG_SCRIPT[]), 1 KB the variable area no longer carries.						*
+ ****************************************************************************************/
+Uint32 Store_Sig_in_NAND(const Uint8* src, Uint32 size)
+{
+	return NV_store(&SIG_RING, src, size);
+}
+
+Uint32 Restore_Sig_From_NAND(Uint8* dst, Uint32 size)
+{
+	return NV_restore(&SIG_RING, dst, size);
+}
+
+/// optional "<crc32 in hex>" next to the image
+static BOOL FW_readExpectedCrc(Uint32* crc)
+{
+	FIL fCrc;
+	char line[16] = {0};
+	BOOL isOk = FALSE;
+
+	if (f_open(&fCrc, PDI_RAZOR_FIRMWARE_CRC, FA_READ) != FR_OK) return FALSE;
+	if (f_gets(line, sizeof(line), &fCrc) != NULL)
+	{
+		*crc = (Uint32)strtoul(line, NULL, 16);
+		isOk = TRUE;
+	}
+	f_close(&fCrc);
+
+	return isOk;
+}
+
+static void FW_abort(NAND_InfoHandle hNandInfo, const char* msg)
+{
+	NAND_protectBlocks(hNandInfo);
+	displayLcd(msg,1);
+	WD_Job_End();
 
-		if (pageNum == hNandInfo->pagesPerBlock)
-   		{
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	isFwUpgrading = FALSE;
+	if (isStorePending)
+	{
+		isStorePending = FALSE;
+		Swi_post(Swi_writeNand);
+	}
+}
 
-       		/// A block transition needs to take place; go to next good block
-       		blockNum++;
-       		while (NAND_badBlockCheck(hNandInfo,blockNum) != E_PASS) blockNum++;
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
-        		
-       		/// Erase the current block
-       		NAND_eraseBlocks(hNandInfo,blockNum,1);
-       		pageNum = 0;
 
-   			for(i=0;i<ACCESS_DELAY;i++);
-   		}
+/****************************************************************************************
+ * Resume_Firmware_Upgrade() completes a commit that was cut short by a power loss		*
+ * (see above). Called once at start-up, before the variables are restored. Returns		*
+ * FW_RESUMED when the commit went through: the ROM may now start another image than	*
+ * the one running, so the caller restarts the board.									*
+ ****************************************************************************************/
+Uint32 Resume_Firmware_Upgrade(void)
+{
+	NAND_InfoHandle hNandInfo;
+	FW_RECORD rec;
+	Uint32 crc, page, result;
 
-		/// watchdog timer reactive
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
+    hNandInfo = NAND_open((Uint32)NANDStart, BUS_16BIT );
+    if (hNandInfo == NULL) return E_FAIL;
+
+	FW_crcInit();
+
+	if (FW_readRecord(hNandInfo, &rec, &page) != E_PASS) return E_PASS;
+	if (rec.state != FW_STATE_STAGED) return E_PASS;
 
-   	} while (pageCnt < totalPageCnt);
+	/// nothing to resume from if the staged copy itself is damaged
+	if ((FW_crcImage(hNandInfo, &rec, TRUE, &crc) != E_PASS) || (crc != rec.crc)) return E_FAIL;
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-   	NAND_protectBlocks(hNandInfo);
-  	return E_PASS;
+	if (NAND_unProtectBlocks(hNandInfo, FW_UNLOCK_FIRST_BLK, FW_UNLOCK_NUM_BLKS) != E_PASS) return E_FAIL;
+	result = FW_commit(hNandInfo, &rec);
+	NAND_protectBlocks(hNandInfo);
+
+	return (result == E_PASS) ? FW_RESUMED : E_FAIL;
 }
 
 
 void upgradeFirmware(void)
 {
 	NAND_InfoHandle hNandInfo;
-	Uint32 numPagesAIS;
-    Uint8 *aisPtr;
-    Int32 i, aisAllocSize, aisFileSize = 0;
+	FW_RECORD rec;
+	Uint32 blk[FW_SLOT_BLKS];
+	Uint32 p, ppb, nBlks, dst, pageBytes, crc, expectCrc, bytesRead = 0;
+    Int32 i;
     VUint16 *addr_flash;
     ASYNC_MEM_InfoHandle dummy;
 	FIL fPtr;
-
-	BYTE buffer[4096];
-	int index = 0;
-	int loop = 0;
+	BOOL isExpectCrc;
 	UINT br = 0;
 
 	/// open fw file
     if (f_open(&fPtr, PDI_RAZOR_FIRMWARE, FA_READ) != FR_OK) return;
-	
-    UTIL_setCurrMemPtr(0);
+
+	/// the tasks are blocked until the upgrade ends
+	WD_Job_Begin();
+
+    isExpectCrc = FW_readExpectedCrc(&expectCrc);
 
     /// reset command
     addr_flash = (VUint16 *)(FBASE + DEVICE_NAND_CLE_OFFSET);
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
     for (i=0;i<ACCESS_DELAY;i++);
 
     *addr_flash = (VUint16)0xFF;
@@ -450,95 +758,108 @@ void upgradeFirmware(void)
 	for (i=0;i<1000;i++)
 	{
 		if (DEVICE_ASYNC_MEM_IsNandReadyPin(dummy)) break;
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
 	}	
     
     /// write getinfo command
     addr_flash = (VUint16 *)(FBASE + DEVICE_NAND_ALE_OFFSET);
     *addr_flash = (VUint16)NAND_ONFIRDIDADD;
 
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
     for (i=0;i<ACCESS_DELAY;i++);
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
     for (i=0;i<4;i++) addr_flash = (VUint16 *)(FBASE);
 
     /// Initialize NAND Flash
     hNandInfo = NAND_open((Uint32)NANDStart, DEVICE_BUSWIDTH_16BIT);
-    if (hNandInfo == NULL) return;
+    if (hNandInfo == NULL) 
+	{
+		f_close(&fPtr);
+		WD_Job_End();
+		return;
+	}
 
-    /// Read file size
-    aisFileSize = f_size(&fPtr);
+	FW_crcInit();
 
-    /// get page size
-    numPagesAIS = 0;
-    while ( (numPagesAIS * hNandInfo->dataBytesPerPage)  < aisFileSize) numPagesAIS++;
+    ppb = hNandInfo->pagesPerBlock;
+    pageBytes = hNandInfo->dataBytesPerPage;
+    rec.size = f_size(&fPtr);
+    rec.pages = (rec.size + pageBytes - 1) / pageBytes;
 
-    /// We want to allocate an even number of pages.
-    aisAllocSize = numPagesAIS * hNandInfo->dataBytesPerPage;
+	/// display clear
+	LCD_setcursor(0,0);
+	displayLcd("FIRMWARE UPGRADE",0);	
 
-    /// Setup pointer in RAM
-    aisPtr = (Uint8 *) UTIL_allocMem(aisAllocSize);
+	/// from here on writeNand() waits for us
+	isFwUpgrading = TRUE;
 
-    /// Clear memory
-    for (i=0; i<aisAllocSize; i++) aisPtr[i]=0xFF;
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
+	/// the slot the ROM does not start; one good block more than the image for the scratch
+	rec.slot = (FW_romSlot(hNandInfo) == FW_SLOT_A) ? FW_SLOT_B : FW_SLOT_A;
+	nBlks = FW_slotBlocks(hNandInfo, FW_SLOT_FIRST_BLK(rec.slot), FW_SLOT_LAST_BLK(rec.slot), blk, FW_SLOT_BLKS);
 
-    /// Go to start of file
-    if (f_lseek(&fPtr,0) != FR_OK) return;
+    if ((rec.pages == 0) || (nBlks * ppb < rec.pages + ppb) ||
+		(NAND_unProtectBlocks(hNandInfo, FW_UNLOCK_FIRST_BLK, FW_UNLOCK_NUM_BLKS) != E_PASS))
+	{
+		f_close(&fPtr);
+		FW_abort(hNandInfo, "  IMAGE TOO BIG ");
+		return;
+	}
+	rec.scratch = blk[nBlks-1];
 
-	/// display clear
-	LCD_setcursor(0,0);
-	displayLcd("FIRMWARE UPGRADE",0);	
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-	for (i=0;i<ACCESS_DELAY;i++);
+	/// stream the image into the slot, block 0 into the scratch; clocks keep running
+	rec.crc = 0;
+	for (p=0; p<rec.pages; p++)
+	{
+		WD_Checkin(WD_CTX_JOB);
 
-	/// stop all clocks and timers excpet some required clocks
-	disableAllClocksAndTimers();
+		memset(fwPage, 0xFF, pageBytes);
+     	if ((f_read(&fPtr, fwPage, pageBytes, &br) != FR_OK) || (br == 0)) break;
+		rec.crc = UTIL_calcCRC32(fwCrcLut, fwPage, br, rec.crc);
+		bytesRead += br;
 
-	/// read file	
-	for (;;) {
-		for (i=0;i<5;i++) buffer[0] = '\0';
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
-     	if (f_read(&fPtr, buffer, sizeof(buffer), &br) != FR_OK) return;
-		if (br == 0) break; /* error or eof */
-		for (loop=0;loop<sizeof(buffer);loop++) 
+		/// block 0 of the slot stays erased until the commit
+		dst = (p < ppb) ? rec.scratch : blk[p/ppb];
+		if (p == 0)
 		{
-      		for (i=0;i<10;i++) aisPtr[index] = buffer[loop];
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
-	    	for (i=0;i<10;i++) sprintf(lcdLine1,"      %3d%%    ",index*100/aisAllocSize);
-			TimerWatchdogReactivate(CSL_TMR_1_REGS);
-			index++;
-   		}
-
-		/// watchdog timer reactive
-   		sprintf(lcdLine1,"      %3d%%    ",index*100/aisAllocSize);
-		displayLcd(lcdLine1,1);	
-		TimerWatchdogReactivate(CSL_TMR_1_REGS);
-   		for(i=0;i<ACCESS_DELAY;i++);
+			if (FW_firstWord(fwPage) != FW_AIS_MAGIC) break;
+			FW_setFirstWord(fwPage, 0);
+			if (NAND_eraseBlocks(hNandInfo, blk[0], 1) != E_PASS) break;
+		}
+
+		if ((p % ppb == 0) && (NAND_eraseBlocks(hNandInfo, dst, 1) != E_PASS)) break;
+		if (NAND_writePage(hNandInfo, dst, p%ppb, fwPage) != E_PASS)
+		{
+			NAND_reset(hNandInfo);
+			NAND_badBlockMark(hNandInfo, dst);
+			break;
+		}
+
+		/// progress once per block
+		if ((p % ppb == ppb-1) || (p == rec.pages-1))
+		{
+   			sprintf(lcdLine1,"      %3d%%    ",(int)((p+1)*100/rec.pages));
+			displayLcd(lcdLine1,1);	
+		}
     }
 
     f_close(&fPtr);
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-	for(i=0;i<ACCESS_DELAY;i++);
+
+	/// verify what actually landed in NAND
+	if ((p != rec.pages) || (bytesRead != rec.size) || (isExpectCrc && (expectCrc != rec.crc)) ||
+		(FW_crcImage(hNandInfo, &rec, TRUE, &crc) != E_PASS) || (crc != rec.crc))
+	{
+		FW_abort(hNandInfo, " UPGRADE FAILED ");
+		return;
+	}
 
 	/* download existing csv */
     downloadCsv();
-    TimerWatchdogReactivate(CSL_TMR_1_REGS);
-    for(i=0;i<ACCESS_DELAY*100;i++);
 
-	/* disable all interrupts while accessing flash memory */
+	/* disable all interrupts while the boot slot is switched */
+	disableAllClocksAndTimers();
 	Swi_disable();
 
-	/* global erase nand memory */
-	if (NAND_globalErase(hNandInfo) != E_PASS) return;
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-   	for(i=0;i<ACCESS_DELAY*100;i++);
-
-    /* Write the file data to the NAND flash */
-    if (USB_writeData(hNandInfo, aisPtr, numPagesAIS) != E_PASS) return;
-	TimerWatchdogReactivate(CSL_TMR_1_REGS);
-   	for(i=0;i<ACCESS_DELAY*100;i++);
+	/* commit: record the staged image, then make its slot the one the ROM starts */
+	if (FW_writeRecord(hNandInfo, FW_STATE_STAGED, &rec) == E_PASS) FW_commit(hNandInfo, &rec);
+	NAND_protectBlocks(hNandInfo);
 
 	/* force watchdog timer to expire*/
-    while(1); 
+    WD_Restart();
 }
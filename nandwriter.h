@@ -20,10 +20,18 @@
 
 #include "tistdtypes.h"
 
-#define ADDR_DDR_CFG		(0xC7FF33EC) //beginning of CFG section
+/// Resume_Firmware_Upgrade() switched the boot slot; restart to run it
+#define FW_RESUMED	(0x00000004u)
 
 void writeNand(void);
 void Store_Vars_in_NAND(void);
 Uint32 Restore_Vars_From_NAND(void);
+Uint32 Resume_Firmware_Upgrade(void);
+Uint32 Store_Hist_in_NAND(const Uint8* src, Uint32 size);
+Uint32 Restore_Hist_From_NAND(Uint8* dst, Uint32 size);
+Uint32 Store_Tot_in_NAND(const Uint8* src, Uint32 size);
+Uint32 Restore_Tot_From_NAND(Uint8* dst, Uint32 size);
+Uint32 Store_Sig_in_NAND(const Uint8* src, Uint32 size);
+Uint32 Restore_Sig_From_NAND(Uint8* dst, Uint32 size);
 
 #endif //_NANDWRITER_H_
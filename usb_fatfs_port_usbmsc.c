@@ -42,12 +42,265 @@
 #include "usbhost.h"
 #include "usbhmsc.h"
 #include <ti/fs/fatfs/ff.h>
+#include <string.h>
 
 extern tUSBHMSCInstance g_USBHMSCDevice[];
 
 static volatile
 uint32_t USBStat = STA_NOINIT;    /* Disk status */
 
+/*-----------------------------------------------------------------------*/
+/* Sector cache                                                          */
+/*                                                                       */
+/* Single-sector FatFs accesses (FAT, directory and file window I/O) go  */
+/* through a small write-back cache. Dirty sectors reach the stick on    */
+/* CTRL_SYNC (f_sync/f_close), on eviction, and on close. Sectors of the */
+/* FAT and the root directory are pinned: other sectors never evict them */
+/* while at most USB_CACHE_PINNED slots hold them. Beyond that a pinned  */
+/* sector replaces the least recently used pinned one, so the FAT of a   */
+/* large stick cannot take the slots data and directory sectors need.    */
+/* Multi-sector transfers bypass the cache but are kept coherent with it.*/
+/*                                                                       */
+/* Reads that continue the previous read sector for sector are served    */
+/* from two burst buffers. The first such read fetches USB_BURST_SECTORS */
+/* with one READ(10) into the older buffer, so a file read in windows or */
+/* in page-sized chunks costs one command per burst instead of one per   */
+/* call; the newer buffer stays valid for reads just behind the stream.  */
+/* Writes update the burst copies, so both stay coherent with the stick. */
+/*-----------------------------------------------------------------------*/
+
+#ifndef USB_CACHE_SECTORS
+#define USB_CACHE_SECTORS       16      /* Cache size in sectors */
+#endif
+#ifndef USB_CACHE_PINNED
+#define USB_CACHE_PINNED        4       /* Slots FAT and root directory sectors may keep */
+#endif
+#define USB_SECTOR_SIZE         512
+#define USB_CACHE_ALIGN         64      /* SOC_CACHELINE_SIZE, for USB DMA */
+#ifndef USB_BURST_SECTORS
+#define USB_BURST_SECTORS       16      /* Read-ahead burst in sectors */
+#endif
+
+typedef struct
+{
+    uint32_t sector;
+    uint32_t stamp;                     /* Last use, for LRU replacement */
+    uint8_t  isValid;
+    uint8_t  isDirty;
+} USBCacheTag;
+
+static uint8_t USBCacheData[USB_CACHE_SECTORS][USB_SECTOR_SIZE]
+                      __attribute__ ((aligned (USB_CACHE_ALIGN)));
+static USBCacheTag USBCacheTags[USB_CACHE_SECTORS];
+static uint32_t USBCacheClock = 0;
+
+typedef struct
+{
+    uint32_t sector;                    /* First sector held */
+    uint32_t count;                     /* Sectors held, 0 when empty */
+} USBBurstTag;
+
+static uint8_t USBBurstData[2][USB_BURST_SECTORS * USB_SECTOR_SIZE]
+                      __attribute__ ((aligned (USB_CACHE_ALIGN)));
+static USBBurstTag USBBurstTags[2];
+static uint32_t USBBurstNewer = 0;      /* Buffer filled last */
+static uint32_t USBBurstNext = 0;       /* Sector after the previous read */
+
+/* FAT and root directory sectors, learned from the volume boot record */
+static uint32_t USBPinStart = 0;
+static uint32_t USBPinEnd = 0;
+static uint32_t USBPinRootStart = 0;
+static uint32_t USBPinRootEnd = 0;
+
+/* Cache statistics, published by Log.c */
+uint32_t g_usbCacheHits = 0;
+uint32_t g_usbCacheMisses = 0;
+uint32_t g_usbCacheFlushes = 0;
+
+static uint8_t USBCacheIsPinned(uint32_t sector)
+{
+    return (((sector >= USBPinStart) && (sector < USBPinEnd)) ||
+            ((sector >= USBPinRootStart) && (sector < USBPinRootEnd)));
+}
+
+/* Learn the pinned region when FatFs reads a FAT volume boot record */
+static void USBCacheLearnVolume(const uint8_t* b, uint32_t sector)
+{
+    uint32_t rsvd, fatSize, rootSectors, dataStart, rootClust;
+
+    if ((b[510] != 0x55) || (b[511] != 0xAA)) return;
+    if ((b[0] != 0xEB) && (b[0] != 0xE9)) return;
+    if ((b[11] | (b[12] << 8)) != USB_SECTOR_SIZE) return;
+    if ((b[13] == 0) || (b[16] == 0)) return;
+
+    rsvd = b[14] | (b[15] << 8);
+    fatSize = b[22] | (b[23] << 8);
+    if (fatSize == 0) fatSize = b[36] | (b[37] << 8) | ((uint32_t)b[38] << 16) | ((uint32_t)b[39] << 24);
+    rootSectors = (((b[17] | (b[18] << 8)) * 32) + USB_SECTOR_SIZE - 1) / USB_SECTOR_SIZE;
+
+    USBPinStart = sector + rsvd;
+    USBPinEnd = USBPinStart + (b[16] * fatSize) + rootSectors;
+    dataStart = USBPinEnd;
+
+    /* FAT32 keeps the root directory in a cluster chain; pin its first cluster */
+    USBPinRootStart = USBPinRootEnd = 0;
+    if (rootSectors == 0)
+    {
+        rootClust = b[44] | (b[45] << 8) | ((uint32_t)b[46] << 16) | ((uint32_t)b[47] << 24);
+        if (rootClust >= 2)
+        {
+            USBPinRootStart = dataStart + (rootClust - 2) * b[13];
+            USBPinRootEnd = USBPinRootStart + b[13];
+        }
+    }
+}
+
+static int32_t USBCacheWriteBack(unsigned int ulMSCInstance, USBCacheTag* tag, uint8_t* data)
+{
+    if (!tag->isValid || !tag->isDirty) return RES_OK;
+
+    if (USBHMSCBlockWrite(ulMSCInstance, tag->sector, data, 1) != 0) return RES_ERROR;
+
+    tag->isDirty = 0;
+    g_usbCacheFlushes++;
+
+    return RES_OK;
+}
+
+static int32_t USBCacheFind(uint32_t sector)
+{
+    int32_t i;
+
+    for (i = 0; i < USB_CACHE_SECTORS; i++)
+    {
+        if (USBCacheTags[i].isValid && (USBCacheTags[i].sector == sector)) return i;
+    }
+
+    return -1;
+}
+
+/* Pick a slot for <sector>: the LRU pinned one if <sector> is pinned and
+   the pinned share is used up, else a free one, else the LRU unpinned one,
+   else the LRU one */
+static int32_t USBCacheVictim(unsigned int ulMSCInstance, uint32_t sector)
+{
+    int32_t i, lru = -1, lruPinned = -1, empty = -1, pinned = 0;
+
+    for (i = 0; i < USB_CACHE_SECTORS; i++)
+    {
+        if (!USBCacheTags[i].isValid)
+        {
+            if (empty < 0) empty = i;
+        }
+        else if (USBCacheIsPinned(USBCacheTags[i].sector))
+        {
+            pinned++;
+            if ((lruPinned < 0) || (USBCacheTags[i].stamp < USBCacheTags[lruPinned].stamp)) lruPinned = i;
+        }
+        else
+        {
+            if ((lru < 0) || (USBCacheTags[i].stamp < USBCacheTags[lru].stamp)) lru = i;
+        }
+    }
+
+    if (USBCacheIsPinned(sector) && (pinned >= USB_CACHE_PINNED) && (lruPinned >= 0)) lru = lruPinned;
+    else if (empty >= 0) return empty;
+    else if (lru < 0) lru = lruPinned;
+
+    if (USBCacheWriteBack(ulMSCInstance, &USBCacheTags[lru], USBCacheData[lru]) != RES_OK) return -1;
+
+    USBCacheTags[lru].isValid = 0;
+
+    return lru;
+}
+
+static void USBCacheTouch(int32_t i)
+{
+    USBCacheTags[i].stamp = ++USBCacheClock;
+}
+
+/* Write every dirty sector back to the stick */
+static int32_t USBCacheFlush(unsigned int ulMSCInstance)
+{
+    int32_t i, res = RES_OK;
+
+    for (i = 0; i < USB_CACHE_SECTORS; i++)
+    {
+        if (USBCacheWriteBack(ulMSCInstance, &USBCacheTags[i], USBCacheData[i]) != RES_OK) res = RES_ERROR;
+    }
+
+    return res;
+}
+
+/* Serve <count> sectors at <sector> from a burst buffer, fetching the next
+   burst when the read continues the previous one; RES_NOTRDY if the caller
+   has to read them from the stick itself */
+static int32_t USBBurstRead(unsigned int ulMSCInstance, uint8_t* buff, uint32_t sector, uint32_t count)
+{
+    USBBurstTag* tag;
+    uint32_t i, next = USBBurstNext;
+
+    USBBurstNext = sector + count;
+
+    for (i = 0; i < 2; i++)
+    {
+        tag = &USBBurstTags[i];
+        if (tag->count && (sector >= tag->sector) && (sector + count <= tag->sector + tag->count)) break;
+    }
+
+    if (i == 2)
+    {
+        if ((count >= USB_BURST_SECTORS) || (sector != next)) return RES_NOTRDY;
+
+        /* Ping-pong: refill the older buffer */
+        i = USBBurstNewer ^ 1;
+        tag = &USBBurstTags[i];
+        tag->count = 0;
+
+        /* The end of the stick fails here; the caller reads what it asked for */
+        if (USBHMSCBlockRead(ulMSCInstance, sector, USBBurstData[i], USB_BURST_SECTORS) != 0)
+            return RES_NOTRDY;
+
+        tag->sector = sector;
+        tag->count = USB_BURST_SECTORS;
+        USBBurstNewer = i;
+    }
+
+    memcpy(buff, USBBurstData[i] + (sector - tag->sector) * USB_SECTOR_SIZE, count * USB_SECTOR_SIZE);
+
+    return RES_OK;
+}
+
+/* Keep the burst copies of <count> sectors at <sector> as the stick will have them */
+static void USBBurstUpdate(const uint8_t* buff, uint32_t sector, uint32_t count)
+{
+    uint32_t i, s, e;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (!USBBurstTags[i].count) continue;
+
+        s = (sector > USBBurstTags[i].sector) ? sector : USBBurstTags[i].sector;
+        e = USBBurstTags[i].sector + USBBurstTags[i].count;
+        if (sector + count < e) e = sector + count;
+        if (s >= e) continue;
+
+        memcpy(USBBurstData[i] + (s - USBBurstTags[i].sector) * USB_SECTOR_SIZE,
+               buff + (s - sector) * USB_SECTOR_SIZE, (e - s) * USB_SECTOR_SIZE);
+    }
+}
+
+/* Drop everything, e.g. for a newly mounted stick */
+static void USBCacheInvalidate(void)
+{
+    memset(USBCacheTags, 0, sizeof(USBCacheTags));
+    memset(USBBurstTags, 0, sizeof(USBBurstTags));
+    USBBurstNext = 0;
+    USBCacheClock = 0;
+    USBPinStart = USBPinEnd = 0;
+    USBPinRootStart = USBPinRootEnd = 0;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Initialize Disk Drive                                                 */
 /*-----------------------------------------------------------------------*/
@@ -67,6 +320,9 @@ FATFSPortUSBDiskInitialize(void)
     /* Find out if drive is ready yet. */
     if (USBHMSCDriveReady(ulMSCInstance)) return(FR_NOT_READY);
 
+    /* The stick may have been swapped */
+    USBCacheInvalidate();
+
     /* Clear the not init flag. */
     USBStat &= ~STA_NOINIT;
 
@@ -107,11 +363,59 @@ int32_t FATFSPortUSBDiskRead (
 
     ulMSCInstance = (unsigned int)&g_USBHMSCDevice[0]; // no hub support so only one drive
 
-    /* READ BLOCK */
-    if (USBHMSCBlockRead(ulMSCInstance, sector, buff, count) == 0)
+    if (count == 1)
+    {
+        int32_t i = USBCacheFind(sector);
+
+        if (i >= 0) g_usbCacheHits++;
+        else
+        {
+            g_usbCacheMisses++;
+
+            i = USBCacheVictim(ulMSCInstance, sector);
+            if (i < 0) return RES_ERROR;
+
+            /* READ BLOCK */
+            if ((USBBurstRead(ulMSCInstance, USBCacheData[i], sector, 1) != RES_OK) &&
+                (USBHMSCBlockRead(ulMSCInstance, sector, USBCacheData[i], 1) != 0))
+                return RES_ERROR;
+
+            USBCacheTags[i].sector = sector;
+            USBCacheTags[i].isValid = 1;
+            USBCacheTags[i].isDirty = 0;
+
+            USBCacheLearnVolume(USBCacheData[i], sector);
+        }
+
+        USBCacheTouch(i);
+        memcpy(buff, USBCacheData[i], USB_SECTOR_SIZE);
+
         return RES_OK;
+    }
+    else
+    {
+        int32_t i;
+
+        g_usbCacheMisses += count;
+
+        /* READ BLOCK */
+        if ((USBBurstRead(ulMSCInstance, buff, sector, count) != RES_OK) &&
+            (USBHMSCBlockRead(ulMSCInstance, sector, buff, count) != 0))
+            return RES_ERROR;
+
+        /* Cached copies are never older than the stick */
+        for (i = 0; i < USB_CACHE_SECTORS; i++)
+        {
+            if (USBCacheTags[i].isValid && USBCacheTags[i].isDirty &&
+                (USBCacheTags[i].sector >= sector) && (USBCacheTags[i].sector < sector + count))
+            {
+                memcpy(buff + (USBCacheTags[i].sector - sector) * USB_SECTOR_SIZE,
+                       USBCacheData[i], USB_SECTOR_SIZE);
+            }
+        }
 
-    return RES_ERROR;
+        return RES_OK;
+    }
 }
 
 
@@ -134,11 +438,53 @@ int32_t FATFSPortUSBDiskWrite (
     if (USBStat & STA_NOINIT) return RES_NOTRDY;
     if (USBStat & STA_PROTECT) return RES_WRPRT;
 
-    /* WRITE BLOCK */
-    if(USBHMSCBlockWrite(ulMSCInstance, sector, (uint8_t *)buff, count) == 0)
+    if (count == 1)
+    {
+        int32_t i = USBCacheFind(sector);
+
+        if (i >= 0) g_usbCacheHits++;
+        else
+        {
+            /* The whole sector is overwritten, no need to read it first */
+            g_usbCacheMisses++;
+
+            i = USBCacheVictim(ulMSCInstance, sector);
+            if (i < 0) return RES_ERROR;
+
+            USBCacheTags[i].sector = sector;
+            USBCacheTags[i].isValid = 1;
+        }
+
+        memcpy(USBCacheData[i], buff, USB_SECTOR_SIZE);
+        USBCacheTags[i].isDirty = 1;
+        USBCacheTouch(i);
+        USBBurstUpdate(buff, sector, 1);
+
         return RES_OK;
+    }
+    else
+    {
+        int32_t i;
+
+        /* WRITE BLOCK */
+        if(USBHMSCBlockWrite(ulMSCInstance, sector, (uint8_t *)buff, count) != 0)
+            return RES_ERROR;
+
+        /* Refresh cached copies; the stick now holds the newest data */
+        for (i = 0; i < USB_CACHE_SECTORS; i++)
+        {
+            if (USBCacheTags[i].isValid &&
+                (USBCacheTags[i].sector >= sector) && (USBCacheTags[i].sector < sector + count))
+            {
+                memcpy(USBCacheData[i], buff + (USBCacheTags[i].sector - sector) * USB_SECTOR_SIZE,
+                       USB_SECTOR_SIZE);
+                USBCacheTags[i].isDirty = 0;
+            }
+        }
+        USBBurstUpdate(buff, sector, count);
 
-    return RES_ERROR;
+        return RES_OK;
+    }
 }
 
 /*-----------------------------------------------------------------------*/
@@ -158,7 +504,8 @@ int32_t FATFSPortUSBDiskIoctl (
     switch(ctrl)
     {
         case CTRL_SYNC:
-            return(RES_OK);
+            /* f_sync and f_close end up here */
+            return(USBCacheFlush((unsigned int)&g_USBHMSCDevice[0]));
 
         default:
             return(RES_PARERR);
@@ -170,7 +517,13 @@ int32_t FATFSPortUSBDiskIoctl (
 /*-----------------------------------------------------------------------*/
 int32_t FATFSPortUSBDiskClose(void* handle)
 {
-    return RES_OK;
+    int32_t res = RES_OK;
+
+    if (!(USBStat & STA_NOINIT)) res = USBCacheFlush((unsigned int)&g_USBHMSCDevice[0]);
+
+    USBCacheInvalidate();
+
+    return res;
 }
 
 /*-----------------------------------------------------------------------*/